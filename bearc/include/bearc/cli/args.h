@@ -33,11 +33,15 @@ typedef enum cli_flag {
     CLI_FLAG_PARSE_ONLY,
     CLI_FLAG_OUTPUT,
     CLI_FLAG_COMPACT_DIAGS,
+    CLI_FLAG_MEM_STATS,
+    CLI_FLAG_NO_COMPT_VM,
+    CLI_FLAG_COMPT_STACK,
     CLI_FLAG_ERR_DUPLICATE,
     CLI_FLAG_ERR_FILE_NAME_TOO_LONG,
     CLI_FLAG_ERR_TOO_MANY_INPUT_FILES,
     CLI_FLAG_ERR_NO_ARGUMENT_PROVIDED_TO_IMPORT_PATH,
     CLI_FLAG_ERR_NO_ARGUMENT_PROVIDED_TO_OUTPUT,
+    CLI_FLAG_ERR_BAD_ARGUMENT_TO_COMPT_STACK,
     CLI_FLAG__NUM,
 } cli_flag_e;
 
@@ -46,6 +50,7 @@ typedef struct bearc_args {
     bool flags[CLI_FLAG__NUM];
     char* input_file_name;
     char* output_file_name;
+    uint32_t compt_stack_kib; // 0 if not provided
     uint8_t import_path_cnt;
 } bearc_args_t;
 
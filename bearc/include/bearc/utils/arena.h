@@ -44,6 +44,18 @@ void* arena_alloc(arena_t* arena, size_t req_size_bytes);
 /// for testing purposes
 void arena_log_debug_info(arena_t* arena);
 
+/// memory accounting for an arena
+typedef struct arena_stats {
+    /// bytes malloc'd for all chunks, including chunk headers
+    size_t reserved;
+    /// bytes handed out (including alignment padding)
+    size_t used;
+    size_t chunk_cnt;
+} arena_stats_t;
+
+/// walks the chunk chain and sums up reserved/used bytes
+arena_stats_t arena_stats(const arena_t* arena);
+
 #ifdef __cplusplus
 }
 #endif
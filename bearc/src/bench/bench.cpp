@@ -0,0 +1,505 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+// micro-benchmarks for the core utility data structures
+// - keys are captured by lexing the .br files of a corpus (tests/projects by default), so string
+// keys are real identifiers and u32 keys are dense first-seen ids (just like hir::SymbolId), and
+// lookups replay the identifier stream in source order
+// - usage: bench [--csv] [--reps N] [--min-ops N] [corpus dirs or .br files...]
+// - run from the repo root, like the tests
+
+#include "compiler/hir/id_hash_map.hpp"
+#include "compiler/hir/indexing.hpp"
+#include "compiler/hir/node_vector.hpp"
+#include "compiler/lexer.h"
+#include "compiler/token.h"
+#include "utils/arena.h"
+#include "utils/data_arena.hpp"
+#include "utils/file_io.h"
+#include "utils/flatmapu32u32.h"
+#include "utils/mapu32u32.h"
+#include "utils/spill_arr.h"
+#include "utils/strimap.h"
+#include "utils/strintern.h"
+#include "utils/vector.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// identifiers of a corpus, in source order and deduplicated
+struct Corpus {
+    /// owns the copied identifier text (null-terminated, since strimap wants that)
+    std::vector<std::string> unique;
+    /// idx into unique for every identifier occurrence, in source order
+    std::vector<uint32_t> stream;
+    size_t file_cnt = 0;
+};
+
+struct BenchResult {
+    const char* structure;
+    const char* op;
+    size_t n;
+    double ns_per_op;
+};
+
+struct BenchConfig {
+    bool csv = false;
+    int reps = 5;
+    size_t min_ops = 200000;
+    std::vector<std::string> corpus_paths;
+};
+
+/// keeps the optimizer from throwing away benchmarked work
+volatile uint64_t sink = 0;
+
+void lex_into_corpus(const char* file_name, Corpus& corpus,
+                     std::unordered_map<std::string, uint32_t>& seen) {
+    src_buffer_t buf = src_buffer_from_file_create(file_name);
+    if (!buf.data) {
+        return;
+    }
+    vector_t tokens = lexer_tokenize_src_buffer(&buf);
+    for (size_t i = 0; i < tokens.size; i++) {
+        const auto* tkn = static_cast<const token_t*>(vector_at(&tokens, i));
+        if (tkn->type != TOK_IDENTIFIER) {
+            continue;
+        }
+        std::string id{tkn->start, tkn->len};
+        auto [it, inserted] = seen.try_emplace(id, static_cast<uint32_t>(corpus.unique.size()));
+        if (inserted) {
+            corpus.unique.push_back(std::move(id));
+        }
+        corpus.stream.push_back(it->second);
+    }
+    corpus.file_cnt++;
+    vector_destroy(&tokens);
+    src_buffer_destroy(&buf);
+}
+
+Corpus capture_corpus(const std::vector<std::string>& paths) {
+    Corpus corpus{};
+    std::unordered_map<std::string, uint32_t> seen{};
+    for (const auto& path : paths) {
+        std::error_code ec{};
+        if (std::filesystem::is_directory(path, ec)) {
+            std::vector<std::string> files{};
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(path, ec)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".br") {
+                    files.push_back(entry.path().string());
+                }
+            }
+            std::sort(files.begin(), files.end()); // stable stream across platforms
+            for (const auto& file : files) {
+                lex_into_corpus(file.c_str(), corpus, seen);
+            }
+        } else {
+            lex_into_corpus(path.c_str(), corpus, seen);
+        }
+    }
+    return corpus;
+}
+
+/// runs fn (which performs n ops) reps times and keeps the fastest run
+template <typename F> double time_ns_per_op(const BenchConfig& cfg, size_t n, F&& fn) {
+    double best = std::numeric_limits<double>::max();
+    for (int r = 0; r < cfg.reps; r++) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto stop = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        best = std::min(best, ns / static_cast<double>(std::max<size_t>(n, 1)));
+    }
+    return best;
+}
+
+class Bench {
+    const BenchConfig& cfg;
+    const Corpus& corpus;
+    std::vector<BenchResult> results{};
+    /// stream replayed until it has at least min_ops lookups
+    std::vector<uint32_t> lookups{};
+    /// unique identifiers, grown w/ a numeric suffix so growth paths are actually exercised
+    std::vector<std::string> keys{};
+
+  public:
+    Bench(const BenchConfig& cfg, const Corpus& corpus) : cfg{cfg}, corpus{corpus} {
+        keys = corpus.unique;
+        const size_t base_cnt = corpus.unique.size();
+        for (size_t gen = 1; keys.size() < cfg.min_ops / 8 && base_cnt != 0; gen++) {
+            for (size_t i = 0; i < base_cnt; i++) {
+                keys.push_back(corpus.unique[i] + "_" + std::to_string(gen));
+            }
+        }
+        // replay the stream, shifting into the later key generations each pass
+        while (lookups.size() < cfg.min_ops && !corpus.stream.empty()) {
+            const size_t pass = lookups.size() / corpus.stream.size();
+            const auto shift = static_cast<uint32_t>((pass * base_cnt) % keys.size());
+            for (const uint32_t idx : corpus.stream) {
+                lookups.push_back(static_cast<uint32_t>((idx + shift) % keys.size()));
+            }
+        }
+    }
+
+    void record(const char* structure, const char* op, size_t n, double ns_per_op) {
+        results.push_back(BenchResult{structure, op, n, ns_per_op});
+    }
+
+    void bench_arena() {
+        const size_t n = lookups.size();
+        record("arena", "alloc_token", n, time_ns_per_op(cfg, n, [&] {
+                   arena_t arena = arena_create(0x10000);
+                   for (size_t i = 0; i < n; i++) {
+                       auto* tkn = static_cast<token_t*>(arena_alloc(&arena, sizeof(token_t)));
+                       tkn->len = i;
+                   }
+                   sink = sink + arena.head->used;
+                   arena_destroy(&arena);
+               }));
+        record("arena", "alloc_str", n, time_ns_per_op(cfg, n, [&] {
+                   arena_t arena = arena_create(0x10000);
+                   for (size_t i = 0; i < n; i++) {
+                       const std::string& key = keys[lookups[i]];
+                       char* str = static_cast<char*>(arena_alloc(&arena, key.size() + 1));
+                       std::memcpy(str, key.c_str(), key.size() + 1);
+                   }
+                   sink = sink + arena.head->used;
+                   arena_destroy(&arena);
+               }));
+    }
+
+    void bench_data_arena() {
+        const size_t n = lookups.size();
+        record("DataArena", "alloc_type", n, time_ns_per_op(cfg, n, [&] {
+                   DataArena arena{0x10000};
+                   for (size_t i = 0; i < n; i++) {
+                       auto* slot = arena.alloc_type<uint64_t>();
+                       *slot = i;
+                   }
+                   sink = sink + arena.first_chunk_size();
+               }));
+    }
+
+    void bench_vector() {
+        const size_t n = lookups.size();
+        vector_t vec = vector_create(sizeof(uint32_t));
+        record("vector", "push_back_growth", n, time_ns_per_op(cfg, n, [&] {
+                   vector_destroy(&vec);
+                   vec = vector_create(sizeof(uint32_t));
+                   for (size_t i = 0; i < n; i++) {
+                       vector_push_back(&vec, &lookups[i]);
+                   }
+               }));
+        record("vector", "at_stream", n, time_ns_per_op(cfg, n, [&] {
+                   uint64_t acc = 0;
+                   for (size_t i = 0; i < n; i++) {
+                       acc += *static_cast<uint32_t*>(vector_at(&vec, lookups[i] % vec.size));
+                   }
+                   sink = sink + acc;
+               }));
+        record("vector", "iterate", n, time_ns_per_op(cfg, n, [&] {
+                   uint64_t acc = 0;
+                   for (size_t i = 0; i < vec.size; i++) {
+                       acc += static_cast<uint32_t*>(vec.data)[i];
+                   }
+                   sink = sink + acc;
+               }));
+        vector_destroy(&vec);
+    }
+
+    void bench_spill_arr() {
+        const size_t n = lookups.size();
+        // a spill_arr is normally short-lived on the stack, so measure both staying in the inline
+        // buffer and spilling
+        for (const size_t len : {static_cast<size_t>(SPILL_ARR_SIZE_8_T_ARR_CAP / 2), n}) {
+            const char* op = (len == n) ? "push_spilled" : "push_inline";
+            const size_t rounds = std::max<size_t>(n / len, 1);
+            record("spill_arr", op, rounds * len, time_ns_per_op(cfg, rounds * len, [&] {
+                       for (size_t r = 0; r < rounds; r++) {
+                           spill_arr_ptr_t sarr;
+                           spill_arr_ptr_init(&sarr);
+                           for (size_t i = 0; i < len; i++) {
+                               spill_arr_ptr_push(&sarr, (void*)&keys[lookups[i % n]]);
+                           }
+                           sink = sink + (uintptr_t)*spill_arr_ptr_at(&sarr, len - 1);
+                           spill_arr_ptr_destroy(&sarr);
+                       }
+                   }));
+        }
+    }
+
+    void bench_strimap() {
+        const size_t n = keys.size();
+        arena_t arena = arena_create(0x10000);
+        strimap_t map = strimap_create_from_arena(0, &arena);
+        record("strimap", "emplace_growth", n, time_ns_per_op(cfg, n, [&] {
+                   arena_destroy(&arena);
+                   arena = arena_create(0x10000);
+                   map = strimap_create_from_arena(0, &arena);
+                   for (size_t i = 0; i < n; i++) {
+                       strimap_emplace(&map, keys[i].c_str(), static_cast<int32_t>(i));
+                   }
+               }));
+        record("strimap", "viewn_stream", lookups.size(), time_ns_per_op(cfg, lookups.size(), [&] {
+                   uint64_t acc = 0;
+                   for (const uint32_t idx : lookups) {
+                       acc += *strimap_viewn(&map, keys[idx].data(), keys[idx].size());
+                   }
+                   sink = sink + acc;
+               }));
+        record("strimap", "iterate", n, time_ns_per_op(cfg, n, [&] {
+                   uint64_t acc = 0;
+                   for (strimap_iter_t it = strimap_iter_begin(&map); it.curr;
+                        strimap_iter_next(&it)) {
+                       acc += static_cast<uint64_t>(it.curr->val);
+                   }
+                   sink = sink + acc;
+               }));
+        arena_destroy(&arena);
+    }
+
+    void bench_strintern() {
+        const size_t n = keys.size();
+        arena_t table_arena = arena_create(0x10000);
+        arena_t str_arena = arena_create(0x10000);
+        strintern_t map = strintern_create_from_arenas(0, &table_arena, &str_arena);
+        record("strintern", "intern_growth", n, time_ns_per_op(cfg, n, [&] {
+                   arena_destroy(&table_arena);
+                   arena_destroy(&str_arena);
+                   table_arena = arena_create(0x10000);
+                   str_arena = arena_create(0x10000);
+                   map = strintern_create_from_arenas(0, &table_arena, &str_arena);
+                   bool inserted = false;
+                   for (size_t i = 0; i < n; i++) {
+                       strintern_intern(&map, keys[i].data(), keys[i].size(),
+                                        static_cast<int32_t>(i), &inserted);
+                   }
+               }));
+        record("strintern", "viewn_stream", lookups.size(),
+               time_ns_per_op(cfg, lookups.size(), [&] {
+                   uint64_t acc = 0;
+                   for (const uint32_t idx : lookups) {
+                       acc += *strintern_viewn(&map, keys[idx].data(), keys[idx].size());
+                   }
+                   sink = sink + acc;
+               }));
+        arena_destroy(&table_arena);
+        arena_destroy(&str_arena);
+    }
+
+    void bench_mapu32u32() {
+        // keys are 1-offset dense ids, like every hir::Id
+        const size_t n = keys.size();
+        arena_t arena = arena_create(0x10000);
+        mapu32u32_t map = mapu32u32_create_from_arena(0, &arena);
+        record("mapu32u32", "insert_growth", n, time_ns_per_op(cfg, n, [&] {
+                   arena_destroy(&arena);
+                   arena = arena_create(0x10000);
+                   map = mapu32u32_create_from_arena(0, &arena);
+                   for (uint32_t i = 0; i < n; i++) {
+                       mapu32u32_insert(&map, i + 1, i);
+                   }
+               }));
+        record("mapu32u32", "at_stream", lookups.size(), time_ns_per_op(cfg, lookups.size(), [&] {
+                   uint64_t acc = 0;
+                   for (const uint32_t idx : lookups) {
+                       acc += *mapu32u32_cat(&map, idx + 1);
+                   }
+                   sink = sink + acc;
+               }));
+        record("mapu32u32", "iterate", n, time_ns_per_op(cfg, n, [&] {
+                   uint64_t acc = 0;
+                   for (mapu32u32_iter_t it = mapu32u32_iter_begin(&map); it.curr;
+                        mapu32u32_iter_next(&it)) {
+                       acc += it.curr->val;
+                   }
+                   sink = sink + acc;
+               }));
+        arena_destroy(&arena);
+    }
+
+    void bench_flatmapu32u32() {
+        const size_t n = keys.size();
+        arena_t arena = arena_create(0x10000);
+        flatmapu32u32_t map = flatmapu32u32_create_from_arena(0, &arena);
+        record("flatmapu32u32", "insert_growth", n, time_ns_per_op(cfg, n, [&] {
+                   arena_destroy(&arena);
+                   arena = arena_create(0x10000);
+                   map = flatmapu32u32_create_from_arena(0, &arena);
+                   for (uint32_t i = 0; i < n; i++) {
+                       flatmapu32u32_insert(&map, i + 1, i);
+                   }
+               }));
+        record("flatmapu32u32", "at_stream", lookups.size(),
+               time_ns_per_op(cfg, lookups.size(), [&] {
+                   uint64_t acc = 0;
+                   for (const uint32_t idx : lookups) {
+                       acc += *flatmapu32u32_cat(&map, idx + 1);
+                   }
+                   sink = sink + acc;
+               }));
+        record("flatmapu32u32", "iterate", n, time_ns_per_op(cfg, n, [&] {
+                   uint64_t acc = 0;
+                   for (flatmapu32u32_iter_t it = flatmapu32u32_iter_begin(&map);
+                        !flatmapu32u32_iter_end(&it); flatmapu32u32_iter_next(&it)) {
+                       acc += it.curr->val;
+                   }
+                   sink = sink + acc;
+               }));
+        arena_destroy(&arena);
+    }
+
+    void bench_id_hash_map() {
+        using namespace hir;
+        const size_t n = keys.size();
+        const size_t m = lookups.size();
+        record("IdHashMap", "insert_lookup", n + m, time_ns_per_op(cfg, n + m, [&] {
+                   DataArena arena{0x10000};
+                   IdHashMap<SymbolId, DefId> map{arena, 0x100};
+                   for (HirId i = 0; i < n; i++) {
+                       map.insert(SymbolId{i + 1}, DefId{i + 1});
+                   }
+                   uint64_t acc = 0;
+                   for (const uint32_t idx : lookups) {
+                       acc += map.at(SymbolId{idx + 1}).as_id().val();
+                   }
+                   sink = sink + acc;
+               }));
+    }
+
+    void bench_id_vec_map() {
+        using namespace hir;
+        const size_t n = lookups.size();
+        NodeVector<Symbol> symbols{0x100};
+        record("NodeVector", "emplace_growth", keys.size(),
+               time_ns_per_op(cfg, keys.size(), [&] {
+                   symbols = NodeVector<Symbol>{0x100};
+                   for (const auto& key : keys) {
+                       (void)symbols.emplace_and_get_id(std::string_view{key});
+                   }
+               }));
+        record("NodeVector", "at_stream", n, time_ns_per_op(cfg, n, [&] {
+                   uint64_t acc = 0;
+                   for (const uint32_t idx : lookups) {
+                       acc += symbols.cat(SymbolId{idx + 1}).sv().size();
+                   }
+                   sink = sink + acc;
+               }));
+        IdVecMap<SymbolId, uint32_t> lens{0x100};
+        record("IdVecMap", "bump_growth", keys.size(), time_ns_per_op(cfg, keys.size(), [&] {
+                   lens = IdVecMap<SymbolId, uint32_t>{0x100};
+                   for (const auto& key : keys) {
+                       lens.bump(static_cast<uint32_t>(key.size()));
+                   }
+               }));
+        record("IdVecMap", "iterate", keys.size(), time_ns_per_op(cfg, keys.size(), [&] {
+                   uint64_t acc = 0;
+                   for (const uint32_t len : lens) {
+                       acc += len;
+                   }
+                   sink = sink + acc;
+               }));
+        record("IdVecMap", "iterate_runs", keys.size(), time_ns_per_op(cfg, keys.size(), [&] {
+                   uint64_t acc = 0;
+                   lens.for_each_run([&acc](std::span<const uint32_t> run) {
+                       for (const uint32_t len : run) {
+                           acc += len;
+                       }
+                   });
+                   sink = sink + acc;
+               }));
+        IdVector<SymbolId> sid_vec{0x100};
+        record("IdVector", "freeze_small_vec", n, time_ns_per_op(cfg, n, [&] {
+                   sid_vec = IdVector<SymbolId>{0x100};
+                   llvm::SmallVector<SymbolId> scratch{};
+                   for (const uint32_t idx : lookups) {
+                       scratch.push_back(SymbolId{idx + 1});
+                       // identifier paths are short, freeze every few ids like symbol_slice does
+                       if (scratch.size() == 3) {
+                           (void)sid_vec.freeze_small_vec(scratch);
+                           scratch.clear();
+                       }
+                   }
+               }));
+    }
+
+    void run() {
+        bench_arena();
+        bench_data_arena();
+        bench_vector();
+        bench_spill_arr();
+        bench_strimap();
+        bench_strintern();
+        bench_mapu32u32();
+        bench_flatmapu32u32();
+        bench_id_hash_map();
+        bench_id_vec_map();
+    }
+
+    void print() const {
+        if (cfg.csv) {
+            std::printf("structure,op,n,ns_per_op\n");
+            for (const auto& res : results) {
+                std::printf("%s,%s,%zu,%.3f\n", res.structure, res.op, res.n, res.ns_per_op);
+            }
+            return;
+        }
+        std::printf("corpus: %zu files, %zu identifiers (%zu unique) -> %zu keys, %zu lookups\n",
+                    corpus.file_cnt, corpus.stream.size(), corpus.unique.size(), keys.size(),
+                    lookups.size());
+        std::printf("%-16s %-20s %10s %12s\n", "structure", "op", "n", "ns/op");
+        for (const auto& res : results) {
+            std::printf("%-16s %-20s %10zu %12.3f\n", res.structure, res.op, res.n, res.ns_per_op);
+        }
+    }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig cfg{};
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--csv") == 0) {
+            cfg.csv = true;
+        } else if (std::strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            cfg.reps = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--min-ops") == 0 && i + 1 < argc) {
+            cfg.min_ops = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else {
+            cfg.corpus_paths.emplace_back(argv[i]);
+        }
+    }
+    if (cfg.corpus_paths.empty()) {
+        cfg.corpus_paths.emplace_back("tests/projects");
+    }
+
+    const Corpus corpus = capture_corpus(cfg.corpus_paths);
+    if (corpus.stream.empty()) {
+        std::fprintf(stderr, "bench: no identifiers found in corpus (run from the repo root?)\n");
+        token_maps_free();
+        return 1;
+    }
+
+    Bench bench{cfg, corpus};
+    bench.run();
+    bench.print();
+
+    token_maps_free();
+    return 0;
+}
@@ -11,6 +11,7 @@
 #include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 bool is_valid_cli_flag_long(const char* flag);
@@ -32,7 +33,10 @@ cli_flag_long_mapping_t cli_flag_long_map[] = {{"help", CLI_FLAG_HELP},
                                                {"compile", CLI_FLAG_COMPILE},
                                                {"parse-only", CLI_FLAG_PARSE_ONLY},
                                                {"output", CLI_FLAG_OUTPUT},
-                                               {"compact-diags", CLI_FLAG_COMPACT_DIAGS}};
+                                               {"compact-diags", CLI_FLAG_COMPACT_DIAGS},
+                                               {"mem-stats", CLI_FLAG_MEM_STATS},
+                                               {"no-compt-vm", CLI_FLAG_NO_COMPT_VM},
+                                               {"compt-stack", CLI_FLAG_COMPT_STACK}};
 static bool is_valid_cli_flag_short(const char* arg) {
     return strlen(arg) == 2 && arg[0] == '-' && short_flag_map[(unsigned char)arg[1]];
 }
@@ -81,10 +85,28 @@ static void do_output_file(int argc, char** argv, bearc_args_t* args, int* count
     }
 }
 
+// a positive KiB count, anything else is flagged as bad
+static void do_compt_stack(int argc, char** argv, bearc_args_t* args, int* count) {
+    if (*count + 1 >= argc || is_flag(argv[*count + 1])) {
+        args->flags[CLI_FLAG_ERR_BAD_ARGUMENT_TO_COMPT_STACK] = true;
+        return;
+    }
+    (*count)++;
+    char* end = NULL;
+    const unsigned long kib = strtoul(argv[*count], &end, 10);
+    if (argv[*count][0] < '0' || argv[*count][0] > '9' || *end != '\0' || kib == 0
+        || kib > UINT32_MAX) {
+        args->flags[CLI_FLAG_ERR_BAD_ARGUMENT_TO_COMPT_STACK] = true;
+        return;
+    }
+    args->compt_stack_kib = (uint32_t)kib;
+}
+
 bearc_args_t parse_cli_args(int argc, char** argv) {
     bearc_args_t args = {.flags = {0},
                          .input_file_name = NULL,
                          .output_file_name = NULL,
+                         .compt_stack_kib = 0,
                          .import_paths = {0},
                          .import_path_cnt = 0};
     int count = 1;
@@ -115,6 +137,9 @@ bearc_args_t parse_cli_args(int argc, char** argv) {
             if (flag == CLI_FLAG_OUTPUT) {
                 do_output_file(argc, argv, &args, &count);
             }
+            if (flag == CLI_FLAG_COMPT_STACK) {
+                do_compt_stack(argc, argv, &args, &count);
+            }
             args.flags[flag] = true;
         } else {
             if (strlen(argv[count]) >= 2 && argv[count][0] == '-') {
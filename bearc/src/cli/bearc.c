@@ -34,6 +34,7 @@ void warn_duplicate_flag(void);
 void warn_too_many_input_files(void);
 void warn_no_arg_for_import_path(void);
 void warn_no_arg_for_output(void);
+void warn_bad_arg_for_compt_stack(void);
 // checks if the args are otherwise empty besides the specified flag
 bool cli_args_otherwise_empty(bearc_args_t* args, cli_flag_e flag);
 
@@ -71,6 +72,11 @@ int bearc_compile_from_args(int argc, char** argv) {
         err = true;
     }
 
+    if (args.flags[CLI_FLAG_ERR_BAD_ARGUMENT_TO_COMPT_STACK]) {
+        warn_bad_arg_for_compt_stack();
+        err = true;
+    }
+
     // no compilation options
     if (args.flags[CLI_FLAG_HELP]) {
         if (!cli_args_otherwise_empty(&args, CLI_FLAG_HELP)) {
@@ -150,12 +156,16 @@ void cli_help(void) {
           "        [--pretty-print]  print a syntax tree diagram\n"
           "        [--file-graph]    list all compiled files with their dependencies\n"
           "        [--parse-only]    stop compilation after parsing\n"
-          "        [--compact-diags] print diagnostics that are vertically compact\n";
+          "        [--compact-diags] print diagnostics that are vertically compact\n"
+          "        [--mem-stats]     report compiler memory usage by structure, file, and phase\n"
+          "        [--no-compt-vm]   evaluate compt calls with the tree-walking interpreter only\n";
     const char* flags_w_args_title = "flags with arguments:\n";
     const char* flags_w_args
         = "        [--import-path | -I] <import_dirs...>  supply import paths\n"
           "        [--compile | -c]     <root_file>       compile from a root file\n"
           "        [--output | -o]      <output_file>     specify an output file\n"
+          "        [--compt-stack]      <kib>             bound a compt call's stack, 8192 "
+          "by default\n"
 
         ;
     const char* options_color = ansi_bold_yellow();
@@ -227,3 +237,8 @@ void warn_no_arg_for_import_path(void) {
 void warn_no_arg_for_output(void) {
     printf("%s(bearc)%s no argument provided for output\n", ansi_bold(), ansi_reset());
 }
+
+void warn_bad_arg_for_compt_stack(void) {
+    printf("%s(bearc)%s compt-stack expects a positive size in KiB\n", ansi_bold(),
+           ansi_reset());
+}
@@ -9,15 +9,18 @@
 #include "compiler/ast/ast.h"
 #include "compiler/lexer.h"
 #include "compiler/parser/parse_stmt.h"
+#include "utils/alloc_stats.h"
 #include "utils/file_io.h"
 
 br_ast_t ast_create_from_file(const char* file_name) {
+    const alloc_phase_e prev_phase = alloc_stats_set_phase(ALLOC_PHASE_LEX);
     src_buffer_t src_buffer = src_buffer_from_file_create(file_name);
 
     compiler_error_list_t error_list = compiler_error_list_create(&src_buffer);
 
     br_ast_t ast = {{0}, {0}, {0}, NULL, error_list};
     if (!src_buffer.data) {
+        alloc_stats_set_phase(prev_phase);
         return ast;
     }
 
@@ -29,6 +32,7 @@ br_ast_t ast_create_from_file(const char* file_name) {
     // ----------------------------------------------------
 
     // ---------------------- PARSING ---------------------
+    alloc_stats_set_phase(ALLOC_PHASE_PARSE);
     // init error list for error tracking
 #define PARSER_ARENA_CHUNK_SIZE_BASE 0x20000
 #define PARSER_ARENA_CHUNK_SIZE_SCALE_FACTOR 8
@@ -40,6 +44,7 @@ br_ast_t ast_create_from_file(const char* file_name) {
     ast.src_buffer = src_buffer;
     ast.arena = arena;
     ast.tokens = tkn_vec;
+    alloc_stats_set_phase(prev_phase);
     return ast;
 }
 
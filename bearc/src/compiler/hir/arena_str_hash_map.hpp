@@ -11,40 +11,70 @@
 
 #include "compiler/hir/indexing.hpp"
 #include "utils/data_arena.hpp"
-#include "utils/strimap.h"
+#include "utils/strintern.h"
+#include <concepts>
 #include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
 
 namespace hir {
 
+// string -> Id map, backed by a stored-hash interner (see utils/strintern.h)
+// - keys are copied contiguously into str_arena, the table itself lives in table_arena
 template <hir::IsId I> class StrIdHashMap {
     static constexpr size_t DEFAULT_ARENA_STR_HASH_MAP_SIZE = 0x800;
 
   public:
-    StrIdHashMap(DataArena& arena)
-        : arena{arena},
-          map{strimap_create_from_arena(DEFAULT_ARENA_STR_HASH_MAP_SIZE, arena.arena())} {}
-    void emplace(const char* key, I id) { strimap_emplace(&map, key, id.val()); }
-    bool contains(const char* key) { return strimap_contains(&map, key); }
-    OptId<I> at(const char* key) {
-        auto* id = strimap_at(&map, key);
+    StrIdHashMap(DataArena& table_arena, DataArena& str_arena)
+        : map{strintern_create_from_arenas(DEFAULT_ARENA_STR_HASH_MAP_SIZE, table_arena.arena(),
+                                           str_arena.arena())} {}
+    void emplace(const char* key, I id) {
+        strintern_emplace(&map, key, std::strlen(key), id.val());
+    }
+    bool contains(const char* key) const {
+        return strintern_viewn(&map, key, std::strlen(key)) != nullptr;
+    }
+    OptId<I> at(const char* key) { return atn(key, std::strlen(key)); }
+    OptId<I> atn(const char* key, size_t len) {
+        auto* id = strintern_atn(&map, key, len);
         if (!id) {
             return OptId<I>{};
         }
-        return OptId<I>{static_cast<HirId>(*id)};
+        return OptId<I>{I{static_cast<HirId>(*id)}};
     }
-    OptId<I> atn(const char* key, size_t len) {
-        auto* id = strimap_atn(&map, key, len);
+    OptId<I> atn(const char* key, size_t len) const {
+        const auto* id = strintern_viewn(&map, key, len);
         if (!id) {
             return OptId<I>{};
         }
         return OptId<I>{I{static_cast<HirId>(*id)}};
     }
-    void remove(const char* key) { strimap_remove(&map, key); }
-    void rehash(size_t size) { strimap_rehash(&map, size); }
+    /// returns the id for key, calling make_id w/ the interned (null-terminated, stable) copy of
+    /// key to produce one if key hasn't been seen yet, all w/ a single hash + probe
+    template <typename F>
+        requires std::same_as<std::invoke_result_t<F, std::string_view>, I>
+    I intern(const char* key, size_t len, F&& make_id) {
+        bool inserted = false;
+        strintern_slot_t* slot
+            = strintern_intern(&map, key, len, static_cast<int32_t>(HIR_ID_NONE), &inserted);
+        if (inserted) {
+            // slot stays valid since make_id doesn't touch this map
+            slot->val = static_cast<int32_t>(make_id(std::string_view{slot->str, slot->len}).val());
+        }
+        return I{static_cast<HirId>(slot->val)};
+    }
+    void remove(const char* key) { strintern_remove(&map, key, std::strlen(key)); }
+    void rehash(size_t size) { strintern_rehash(&map, size); }
+    [[nodiscard]] size_t size() const noexcept { return map.size; }
+    [[nodiscard]] size_t capacity() const noexcept { return map.capacity; }
+    /// bytes of the live slot table, the interned strings live in str_arena
+    [[nodiscard]] size_t table_bytes() const noexcept {
+        return map.capacity * sizeof(strintern_slot_t);
+    }
 
   private:
-    DataArena& arena;
-    strimap_t map;
+    strintern_t map;
 };
 
 } // namespace hir
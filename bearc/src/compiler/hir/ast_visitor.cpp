@@ -57,7 +57,7 @@ OptId<DefId> FileAstVisitor::register_top_level_stmt(ScopeId scope, ast_stmt_t*
         if (stmt->type == AST_STMT_COMPT_MODIFIER) {
             if (compt) {
                 const token_t* prefix_tkn = stmt->first;
-                Span span = Span(file, context.ast(file).buffer(), prefix_tkn);
+                Span span = Span(context, file, prefix_tkn);
                 auto did0 = context.emplace_diagnostic(span, diag_code::redundant_compt_qualifier,
                                                        diag_type::error);
                 auto did1 = context.emplace_diagnostic(
@@ -73,7 +73,7 @@ OptId<DefId> FileAstVisitor::register_top_level_stmt(ScopeId scope, ast_stmt_t*
         if (stmt->type == AST_STMT_STATIC_MODIFIER) {
             if (statik) {
                 const token_t* prefix_tkn = stmt->first;
-                Span span = Span(file, context.ast(file).buffer(), prefix_tkn);
+                Span span = Span(context, file, prefix_tkn);
                 auto did0 = context.emplace_diagnostic(span, diag_code::redundant_static_qualifier,
                                                        diag_type::error);
                 auto did1 = context.emplace_diagnostic(
@@ -101,7 +101,7 @@ OptId<DefId> FileAstVisitor::register_top_level_stmt(ScopeId scope, ast_stmt_t*
                 const token_t* prefix_tkn_first = stmt->first;
                 const token_t* prefix_tkn_last = stmt->stmt.alignaz.align_expr->last;
                 Span span
-                    = Span(file, context.ast(file).buffer(), prefix_tkn_first, prefix_tkn_last);
+                    = Span(context, file, prefix_tkn_first, prefix_tkn_last);
                 auto did0 = context.emplace_diagnostic(span, diag_code::multiple_alignas_on_one_def,
                                                        diag_type::error);
                 auto did1 = context.emplace_diagnostic(
@@ -125,10 +125,10 @@ OptId<DefId> FileAstVisitor::register_top_level_stmt(ScopeId scope, ast_stmt_t*
             // meaning try_align_pref had to return the default value
             if (align_pref == 0) {
                 auto did0 = context.emplace_diagnostic(
-                    Span(file, context.ast(file).buffer(), expr->first, expr->last),
+                    Span(context, file, expr->first, expr->last),
                     diag_code::invalid_alignas, diag_type::error);
                 auto did1 = context.emplace_diagnostic(
-                    Span(file, context.ast(file).buffer(), expr->first, expr->last),
+                    Span(context, file, expr->first, expr->last),
                     diag_code::alignas_expr_must_be_a_valid_uint_lit, diag_type::help);
                 context.link_diagnostic(did0, did1);
             }
@@ -155,27 +155,31 @@ OptId<DefId> FileAstVisitor::register_top_level_stmt(ScopeId scope, ast_stmt_t*
         OptId<DefId> existing = Scope::look_up_local_namespace(context, scope, name);
 
         bool existing_module
-            = existing.has_value()
-              && std::holds_alternative<DefModule>(context.def(existing.as_id()).value);
+            = existing.has_value() && context.def(existing.as_id()).holds<DefModule>();
 
         DefId mod_def
             = existing_module
                   ? existing.as_id()
                   : context.register_top_level_def(
                         name, pub, compt, /*not generic*/ false, statik,
-                        Span(file, context.ast(file).buffer(), /* just name token! */ name_tkn),
+                        Span(context, file, /* just name token! */ name_tkn),
                         stmt,
                         parent); // just make span with name token otherwise it will be too long
+        const Scope::Sizes mod_sizes = scope_sizes_for(stmt->stmt.module.decls);
         ScopeId mod_scope = existing_module
-                                ? get<DefModule>(context.def(existing.as_id()).value).scope
-                                : context.make_scope(scope);
+                                ? context.def(existing.as_id()).as<DefModule>(context).scope
+                                : context.make_scope(scope, mod_sizes);
+        if (existing_module) {
+            context.scope(mod_scope).reserve_more(mod_sizes);
+        }
+        context.record_scope_span(Span(context, file, first_tkn, last_tkn), mod_scope);
         // warn capitalized_mod if the mod is new and capitalized
         if (!existing_module && is_capital(name_tkn)) {
-            context.emplace_diagnostic(Span(file, context.ast(file).buffer(), name_tkn),
+            context.emplace_diagnostic(Span(context, file, name_tkn),
                                        diag_code::capitalized_mod, diag_type::warning);
         }
-        context.def(mod_def).set_value(DefModule{.scope = mod_scope});
-        context.scope(scope).insert_namespace(name, mod_def);
+        context.def(mod_def).set_value(context, DefModule{.scope = mod_scope});
+        context.insert_namespace(scope, name, mod_def);
         register_top_level_stmts(mod_scope, stmt->stmt.module.decls, mod_def,
                                  abi); // pass in this module def as parent
 
@@ -186,7 +190,7 @@ OptId<DefId> FileAstVisitor::register_top_level_stmt(ScopeId scope, ast_stmt_t*
         auto maybe_abi = abi_for_extern_stmt(stmt);
         // ensure valid specified abi
         if (!maybe_abi.has_value()) {
-            Span span{file, context.ast(file).buffer(), stmt->stmt.extern_block.extern_language};
+            Span span{context, file, stmt->stmt.extern_block.extern_language};
             auto did0
                 = context.emplace_diagnostic(span, diag_code::invalid_extern_lang, diag_type::error,
                                              DiagnosticSymbolAfterMessage{context.symbol_id(
@@ -239,7 +243,7 @@ OptId<DefId> FileAstVisitor::register_top_level_stmt(ScopeId scope, ast_stmt_t*
         }
 
         if (no_struct) {
-            context.emplace_diagnostic(Span(file, context.ast(file).buffer(), prefix),
+            context.emplace_diagnostic(Span(context, file, prefix),
                                        diag_code::no_matching_struct_for_method, diag_type::error);
         }
     }
@@ -263,11 +267,11 @@ OptId<DefId> FileAstVisitor::register_top_level_stmt(ScopeId scope, ast_stmt_t*
     // redefintion guard
     if (already_defined.has_value()) {
         // do diagnostics for the redefinition
-        auto d1 = context.emplace_diagnostic(Span(file, context.ast(file).buffer(), name_tkn),
+        auto d1 = context.emplace_diagnostic(Span(context, file, name_tkn),
                                              diag_code::redefinition, diag_type::error);
-        auto orig_file = context.def(already_defined.as_id()).span.file_id;
+        auto orig_file = context.def(already_defined.as_id()).span(context).file_id(context);
         auto* t = top_level_info_for(context.def_ast_node(already_defined.as_id())).name_tkn;
-        auto d2 = context.emplace_diagnostic(Span(orig_file, context.ast(orig_file).buffer(), t),
+        auto d2 = context.emplace_diagnostic(Span(context, orig_file, t),
                                              diag_code::previous_def_here, diag_type::note);
         context.link_diagnostic(d1, d2);
         return OptId<DefId>{};
@@ -276,29 +280,31 @@ OptId<DefId> FileAstVisitor::register_top_level_stmt(ScopeId scope, ast_stmt_t*
     // no issues, so register definition
     DefId def = context.register_top_level_def(
         name, pub, compt, statik, is_generic,
-        Span(file, context.ast(file).buffer(), first_tkn, last_tkn), stmt, parent);
+        Span(context, file, first_tkn, last_tkn), stmt, parent);
     // register into a scope
     if (!info.do_not_insert_in_scope) {
         switch (kind) {
         case scope_kind::variable:
-            context.scope(scope).insert_variable(name, def);
+            context.insert_variable(scope, name, def);
             break;
         case scope_kind::type: {
-            context.scope(scope).insert_type(name, def);
+            context.insert_type(scope, name, def);
             // delay resolution (don't clutter scope tree with unspecialized/dead definitions)
             if (is_generic) {
                 break;
             }
             // if the type (namely a variant field decl) doesn't have statements then the scope
-            // needn't be large
+            // needn't be large, otherwise presize it from its fields
             const bool is_small_scope = !stmts.has_value();
-            ScopeId types_scope
-                = (is_small_scope) ? context.make_small_scope(scope) : context.make_scope(scope);
+            ScopeId types_scope = (is_small_scope)
+                                      ? context.make_small_scope(scope)
+                                      : context.make_scope(scope, scope_sizes_for(stmts.value()));
 
-            context.defs_to_scopes_for_types().insert(def, types_scope);
+            context.register_type_scope(def, types_scope);
+            context.record_scope_span(Span(context, file, first_tkn, last_tkn), types_scope);
             // warn on lowercase structure definition
             if (is_lower(name_tkn)) {
-                context.emplace_diagnostic(Span(file, context.ast(file).buffer(), name_tkn),
+                context.emplace_diagnostic(Span(context, file, name_tkn),
                                            diag_code::lowercase_structure, diag_type::warning);
             }
             // try to parse fields
@@ -346,7 +352,7 @@ void FileAstVisitor::register_top_level_stmts_registering_ordered_members(
     if (def_vec.empty()) {
         const ast_stmt_t* st = context.def_ast_node(parent_def);
         const ast_stmt_type_e statement_type = st->type;
-        const Span span{file, context.ast(file).buffer(), top_level_info_for(st).name_tkn};
+        const Span span{context, file, top_level_info_for(st).name_tkn};
         diag_code code = diag_code::empty_variant;
         switch (statement_type) {
         case AST_STMT_STRUCT_DEF:
@@ -372,6 +378,54 @@ void FileAstVisitor::register_top_level_stmts_registering_ordered_members(
         context.register_ordered_defs(parent_def, def_vec);
     }
 }
+Scope::Sizes FileAstVisitor::scope_sizes_for(ast_slice_of_stmts_t stmts) {
+    Scope::Sizes sizes{};
+    for (size_t i = 0; i < stmts.len; i++) {
+        const ast_stmt_t* stmt = stmts.start[i];
+        // see through the same prefix wrappers register_top_level_stmt does
+        if (stmt->type == AST_STMT_VISIBILITY_MODIFIER) {
+            stmt = stmt->stmt.vis_modifier.stmt;
+        }
+        while (stmt->type == AST_STMT_COMPT_MODIFIER || stmt->type == AST_STMT_STATIC_MODIFIER
+               || stmt->type == AST_STMT_ALIGNAS_MODIFIER) {
+            if (stmt->type == AST_STMT_COMPT_MODIFIER) {
+                stmt = stmt->stmt.compt_modifier.stmt;
+            } else if (stmt->type == AST_STMT_STATIC_MODIFIER) {
+                stmt = stmt->stmt.static_modifier.stmt;
+            } else {
+                stmt = stmt->stmt.alignaz.inner;
+            }
+        }
+        if (stmt->type == AST_STMT_MODULE) {
+            ++sizes.namespaces;
+            continue;
+        }
+        if (stmt->type == AST_STMT_EXTERN_BLOCK) {
+            const Scope::Sizes inner = scope_sizes_for(stmt->stmt.extern_block.decls);
+            sizes.namespaces += inner.namespaces;
+            sizes.variables += inner.variables;
+            sizes.types += inner.types;
+            continue;
+        }
+        const TopLevelInfo info = top_level_info_for(stmt);
+        if (info.name_tkn == nullptr || info.do_not_insert_in_scope) {
+            continue;
+        }
+        switch (info.kind) {
+        case scope_kind::namespacee:
+            ++sizes.namespaces;
+            break;
+        case scope_kind::variable:
+            ++sizes.variables;
+            break;
+        case scope_kind::type:
+            ++sizes.types;
+            break;
+        }
+    }
+    return sizes;
+}
+
 TopLevelInfo FileAstVisitor::top_level_info_for(const ast_stmt_t* stmt) {
     scope_kind kind = scope_kind::variable;
     token_t* scope_prefix_tkn = nullptr;
@@ -40,6 +40,8 @@ class FileAstVisitor {
                                                               ast_slice_of_stmts_t stmts,
                                                               OptId<DefId> parent, abi_lang abi);
     static TopLevelInfo top_level_info_for(const ast_stmt_t* stmt);
+    /// counts the entries that registering stmts will insert into their scope, per table
+    static Scope::Sizes scope_sizes_for(ast_slice_of_stmts_t stmts);
 
   public:
     FileAstVisitor(Context& context, FileId file) : context(context), file(file) {}
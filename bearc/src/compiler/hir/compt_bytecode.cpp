@@ -0,0 +1,670 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#include "compiler/hir/compt_bytecode.hpp"
+#include "compiler/ast/expr.h"
+#include "compiler/ast/stmt.h"
+#include "compiler/hir/context.hpp"
+#include "compiler/hir/def.hpp"
+#include "compiler/hir/exec.hpp"
+#include "compiler/hir/exec_ops.hpp"
+#include "compiler/hir/indexing.hpp"
+#include "compiler/hir/span.hpp"
+#include "compiler/hir/type.hpp"
+#include "compiler/token.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace hir {
+
+void append_compt_memo_key(const ConstantValue& value, llvm::SmallVectorImpl<uint64_t>& key) {
+    const uint64_t bits = std::visit(
+        [](auto v) -> uint64_t {
+            using T = decltype(v);
+            if constexpr (std::is_same_v<T, SymbolId>) {
+                return v.val(); // interned, so equal strs share a SymbolId
+            } else if constexpr (std::is_same_v<T, float>) {
+                return std::bit_cast<uint32_t>(v);
+            } else if constexpr (std::is_same_v<T, double>) {
+                return std::bit_cast<uint64_t>(v);
+            } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
+                return 0;
+            } else {
+                return static_cast<uint64_t>(v);
+            }
+        },
+        value);
+    key.push_back(value.index());
+    key.push_back(bits);
+}
+
+// the builtins whose constants round trip through ExecConst::type_builtin
+static std::optional<builtin_type> vm_builtin(const Context& context, OptId<TypeId> maybe_tid) {
+    if (maybe_tid.empty()) {
+        return std::nullopt;
+    }
+    const Type& type = context.type(maybe_tid.as_id());
+    if (!type.holds<TypeBuiltin>()) {
+        return std::nullopt;
+    }
+    const builtin_type bt = type.as<TypeBuiltin>(context).type;
+    switch (bt) {
+    case builtin_type::usize:
+    case builtin_type::voidd:
+    case builtin_type::nullpointer:
+        return std::nullopt;
+    default:
+        return bt;
+    }
+}
+
+static bool is_var(const Context& context, OptId<TypeId> maybe_tid) {
+    return maybe_tid.has_value() && context.type(maybe_tid.as_id()).holds<TypeVar>();
+}
+
+/// what a param's arg is converted to, none for a `var` param
+static std::optional<builtin_type> param_into(const Context& context, const DefFunction& func,
+                                              HirSize i) {
+    return vm_builtin(context, context.def(func.params.get(i)).as<DefVariable>(context).type_id);
+}
+
+/// a pure (`=>`) free function from builtin (or `var`) params to a builtin (or untyped) result,
+/// see ComptProgramTable
+static bool vm_callable(const Context& context, DefId did) {
+    const Def& def = context.def(did);
+    if (!def.holds<DefFunction>() || def.generic
+        || context.resol_state_of(did) != Def::resol_state::resolved) {
+        return false;
+    }
+    const DefFunction& func = def.as<DefFunction>(context);
+    if (func.takes_self
+        || (func.return_type.has_value() && !vm_builtin(context, func.return_type).has_value())
+        || !context.def_ast_node(did)->stmt.fn_decl.only_expr) {
+        return false;
+    }
+    for (HirSize i = 0; i < func.params.len(); i++) {
+        const Def& param = context.def(func.params.get(i));
+        if (!param.holds<DefVariable>()) {
+            return false;
+        }
+        const OptId<TypeId> tid = param.as<DefVariable>(context).type_id;
+        if (!vm_builtin(context, tid).has_value() && !is_var(context, tid)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// lowers a function body the way ComptExprSolver walks it, into being the builtin the
+/// tree-walker would convert the expr to
+class ComptCompiler {
+    Context& context;
+    ComptProgram& program;
+    const DefFunction& func;
+    ScopeId scope;
+
+  public:
+    ComptCompiler(Context& context, ComptProgram& program)
+        : context{context}, program{program},
+          func{context.def(program.func).as<DefFunction>(context)},
+          scope{context.containing_scope(program.func)} {}
+
+    void compile_body() {
+        program.param_cnt = func.params.len();
+        program.reg_cnt = program.param_cnt;
+        const ast_expr_t* body = context.def_ast_node(program.func)->stmt.fn_decl.expr;
+        const uint32_t result = expr(body, vm_builtin(context, func.return_type));
+        emit(compt_op::ret, 0, 0, result);
+    }
+
+  private:
+    uint32_t fresh() { return program.reg_cnt++; }
+
+    size_t emit(compt_op op, uint8_t sub, uint32_t dst, uint32_t a = 0, uint32_t b = 0) {
+        program.code.push_back(ComptInstr{op, sub, dst, a, b});
+        return program.code.size() - 1;
+    }
+
+    [[nodiscard]] uint32_t here() const { return static_cast<uint32_t>(program.code.size()); }
+
+    /// anything past a bail is unreachable, so its register is never read
+    uint32_t bail() {
+        emit(compt_op::bail, 0, 0);
+        return fresh();
+    }
+
+    uint32_t def_idx(DefId did) {
+        program.defs.push_back(did);
+        return static_cast<uint32_t>(program.defs.size() - 1);
+    }
+
+    uint32_t converted(uint32_t src, std::optional<builtin_type> into) {
+        if (!into.has_value()) {
+            return src;
+        }
+        const uint32_t dst = fresh();
+        emit(compt_op::convert, static_cast<uint8_t>(into.value()), dst, src);
+        return dst;
+    }
+
+    [[nodiscard]] std::optional<uint32_t> param_reg(SymbolId name) const {
+        for (HirSize i = 0; i < func.params.len(); i++) {
+            if (context.def(func.params.get(i)).name == name) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /// a plain (unscoped) name the tree-walker would find w/o reporting it as hidden
+    [[nodiscard]] OptId<DefId> visible_variable(SymbolId name) const {
+        const OptId<DefId> maybe_did = context.look_up_variable(scope, name);
+        if (maybe_did.empty()) {
+            return {};
+        }
+        const Def& def = context.def(maybe_did.as_id());
+        if (def.pub) {
+            return maybe_did;
+        }
+        const OptId<DefId> seen = context.look_up_variable(scope, def.name);
+        if (param_reg(def.name).has_value() || seen.empty()
+            || !(seen.as_id() == maybe_did.as_id())) {
+            return {};
+        }
+        return maybe_did;
+    }
+
+    uint32_t expr(const ast_expr_t* e, std::optional<builtin_type> into) {
+        switch (e->type) {
+        case AST_EXPR_ID:
+            return id(e, into);
+        case AST_EXPR_LITERAL: {
+            ExecConst value = ExecConst::from_literal(context, e->expr.literal.tkn);
+            if (into.has_value()) {
+                const auto maybe_converted = value.try_safe_convert_to(into.value());
+                if (!maybe_converted.has_value()) {
+                    return bail();
+                }
+                value = maybe_converted.value();
+            }
+            program.consts.push_back(value);
+            const uint32_t dst = fresh();
+            emit(compt_op::load_const, 0, dst, static_cast<uint32_t>(program.consts.size() - 1));
+            return dst;
+        }
+        case AST_EXPR_BINARY:
+            return binary(e, into);
+        case AST_EXPR_PRE_UNARY: {
+            const token_type_e t = e->expr.unary.op->type;
+            const auto maybe_op = token_to_unary_op(e->expr.unary.op);
+            if ((t != TOK_BOOL_NOT && t != TOK_PLUS && t != TOK_MINUS && t != TOK_BIT_NOT)
+                || !maybe_op.has_value()) {
+                return bail();
+            }
+            const uint32_t inner = expr(e->expr.unary.expr, std::nullopt);
+            const uint32_t dst = fresh();
+            emit(compt_op::unary, static_cast<uint8_t>(maybe_op.value()), dst, inner);
+            return converted(dst, into);
+        }
+        case AST_EXPR_TERNARY_IF: {
+            const uint32_t cond = expr(e->expr.ternary_if.condition, builtin_type::boolean);
+            const uint32_t dst = fresh();
+            const size_t to_else = emit(compt_op::jump_if_false, 0, 0, cond);
+            emit(compt_op::move, 0, dst, expr(e->expr.ternary_if.happy_expr, into));
+            const size_t to_end = emit(compt_op::jump, 0, 0);
+            program.code[to_else].b = here();
+            emit(compt_op::move, 0, dst, expr(e->expr.ternary_if.else_expr, into));
+            program.code[to_end].a = here();
+            return dst;
+        }
+        case AST_EXPR_GROUPING:
+            return expr(e->expr.grouping.expr, into);
+        case AST_EXPR_COMPT:
+            return expr(e->expr.compt_expr.inner, into);
+        case AST_EXPR_FN_CALL:
+            return call(e, into);
+        default:
+            return bail();
+        }
+    }
+
+    uint32_t id(const ast_expr_t* e, std::optional<builtin_type> into) {
+        const token_ptr_slice_t slice = e->expr.id.slice;
+        if (slice.len != 1) {
+            return bail();
+        }
+        const SymbolId name = context.symbol_id(slice.start[0]);
+        if (const auto reg = param_reg(name); reg.has_value()) {
+            return converted(reg.value(), into);
+        }
+        const OptId<DefId> maybe_did = visible_variable(name);
+        if (maybe_did.empty()) {
+            return bail();
+        }
+        const uint32_t dst = fresh();
+        emit(compt_op::load_global, 0, dst, def_idx(maybe_did.as_id()));
+        return converted(dst, into);
+    }
+
+    uint32_t binary(const ast_expr_t* e, std::optional<builtin_type> into) {
+        const ComptBinaryOp maybe_op{e->expr.binary.op};
+        if (!maybe_op.holds<binary_op>()) {
+            return bail();
+        }
+        const binary_op op = maybe_op.as<binary_op>();
+        const uint32_t lhs = expr(e->expr.binary.lhs, std::nullopt);
+        const uint32_t dst = fresh();
+        // only `&&` short circuits, mirroring the tree-walker
+        std::optional<size_t> short_circuit{};
+        if (op == binary_op::bool_and) {
+            short_circuit = emit(compt_op::and_short, 0, dst, lhs);
+        }
+        const uint32_t rhs = expr(e->expr.binary.rhs, std::nullopt);
+        emit(compt_op::binary, static_cast<uint8_t>(op), dst, lhs, rhs);
+        if (short_circuit.has_value()) {
+            program.code[short_circuit.value()].b = here();
+        }
+        return converted(dst, into);
+    }
+
+    uint32_t call(const ast_expr_t* e, std::optional<builtin_type> into) {
+        const ast_expr_t* called = e->expr.fn_call.left_expr;
+        if (called->type != AST_EXPR_ID || called->expr.id.slice.len != 1) {
+            return bail();
+        }
+        const SymbolId name = context.symbol_id(called->expr.id.slice.start[0]);
+        if (param_reg(name).has_value()) {
+            return bail();
+        }
+        const OptId<DefId> maybe_did = visible_variable(name);
+        if (maybe_did.empty() || !vm_callable(context, maybe_did.as_id())) {
+            return bail();
+        }
+        const DefFunction& callee = context.def(maybe_did.as_id()).as<DefFunction>(context);
+        const ast_slice_of_exprs_t args = e->expr.fn_call.args;
+        // a typed call whose result the tree-walker would reject as the wrong builtin
+        if (args.len != callee.params.len()
+            || (into.has_value() && callee.return_type.has_value()
+                && into != vm_builtin(context, callee.return_type))) {
+            return bail();
+        }
+        llvm::SmallVector<uint32_t, 8> arg_regs;
+        for (size_t i = 0; i < args.len; i++) {
+            arg_regs.push_back(expr(args.start[i], param_into(context, callee, i)));
+        }
+        const uint32_t args_start = program.reg_cnt;
+        for (const uint32_t arg : arg_regs) {
+            emit(compt_op::move, 0, fresh(), arg);
+        }
+        const uint32_t dst = fresh();
+        program.call_sites.emplace_back(here(), e);
+        emit(compt_op::call, 0, dst, args_start, def_idx(maybe_did.as_id()));
+        // an untyped call's result has to already be exactly into
+        if (into.has_value() && callee.return_type.empty()) {
+            emit(compt_op::expect_type, static_cast<uint8_t>(into.value()), 0, dst);
+        }
+        return dst;
+    }
+};
+
+std::optional<uint32_t> ComptProgramTable::program_idx(Context& context, DefId func) {
+    if (def_programs.size() < func.val()) {
+        def_programs.resize(func.val(), NOT_COMPILED);
+    }
+    const uint32_t slot = def_programs[func.val() - 1];
+    if (slot == NOT_COMPILABLE) {
+        return std::nullopt;
+    }
+    if (slot != NOT_COMPILED) {
+        return slot - 1;
+    }
+    // an unresolved function may still become callable, so that isn't remembered
+    if (context.resol_state_of(func) != Def::resol_state::resolved) {
+        return std::nullopt;
+    }
+    if (!vm_callable(context, func)) {
+        def_programs[func.val() - 1] = NOT_COMPILABLE;
+        return std::nullopt;
+    }
+    ComptProgram program{};
+    program.func = func;
+    ComptCompiler{context, program}.compile_body();
+    programs.push_back(std::move(program));
+    def_programs[func.val() - 1] = static_cast<uint32_t>(programs.size());
+    return static_cast<uint32_t>(programs.size() - 1);
+}
+
+size_t ComptProgramTable::reserved_bytes() const noexcept {
+    size_t bytes = (def_programs.capacity() * sizeof(uint32_t))
+                   + (programs.capacity() * sizeof(ComptProgram));
+    for (const ComptProgram& program : programs) {
+        bytes += (program.code.capacity() * sizeof(ComptInstr))
+                 + (program.consts.capacity() * sizeof(ExecConst))
+                 + (program.defs.capacity() * sizeof(DefId))
+                 + (program.call_sites.capacity() * sizeof(program.call_sites[0]));
+    }
+    return bytes;
+}
+
+size_t ComptProgramTable::used_bytes() const noexcept {
+    size_t bytes
+        = (def_programs.size() * sizeof(uint32_t)) + (programs.size() * sizeof(ComptProgram));
+    for (const ComptProgram& program : programs) {
+        bytes += (program.code.size() * sizeof(ComptInstr))
+                 + (program.consts.size() * sizeof(ExecConst))
+                 + (program.defs.size() * sizeof(DefId))
+                 + (program.call_sites.size() * sizeof(program.call_sites[0]));
+    }
+    return bytes;
+}
+
+// mirrors ComptExprSolver::guard_try_converge_types
+static void converge(ExecConst& lhs, binary_op op, ExecConst& rhs) {
+    if (lhs.holds_same_variant_type(rhs)) {
+        return;
+    }
+    if (lhs.has_binary_op(op)) {
+        rhs = rhs.try_safe_convert_to(lhs.type_builtin()).value_or(rhs);
+    } else if (rhs.has_binary_op(op)) {
+        lhs = lhs.try_safe_convert_to(rhs.type_builtin()).value_or(lhs);
+    }
+}
+
+static bool viable(const ExecConst& lhs, binary_op op, const ExecConst& rhs) {
+    return lhs.has_binary_op(op) && rhs.has_binary_op(op);
+}
+
+// mirrors ComptExprSolver::solve_binary_compt_exec on two constants, minus the diagnostics
+static std::optional<ExecConst> eval_binary(Context& context, binary_op op, ExecConst lhs,
+                                            ExecConst rhs) {
+    switch (op) {
+    case binary_op::bit_or:
+    case binary_op::bit_and:
+    case binary_op::bit_xor:
+    case binary_op::left_bitshift:
+    case binary_op::right_shift_logical:
+    case binary_op::right_shift_arithmetic:
+        converge(lhs, op, rhs);
+        if (!lhs.holds_same_variant_type(rhs)) {
+            return std::nullopt;
+        }
+        if (op == binary_op::right_shift_logical) {
+            lhs = lhs.try_down_convert_to(builtin_type::u64).value_or(lhs);
+            converge(lhs, op, rhs);
+        } else if (op == binary_op::right_shift_arithmetic) {
+            lhs = lhs.try_down_convert_to(builtin_type::i64).value_or(lhs);
+            converge(lhs, op, rhs);
+        }
+        if (!viable(lhs, op, rhs)) {
+            return std::nullopt;
+        }
+        switch (op) {
+        case binary_op::bit_or:
+            return ExecConst::bit_or(lhs, rhs);
+        case binary_op::bit_and:
+            return ExecConst::bit_and(lhs, rhs);
+        case binary_op::bit_xor:
+            return ExecConst::bit_xor(lhs, rhs);
+        case binary_op::left_bitshift:
+            return ExecConst::bit_lsh(lhs, rhs);
+        case binary_op::right_shift_logical:
+            return ExecConst::bit_rshl(lhs, rhs);
+        default:
+            return ExecConst::bit_rsha(lhs, rhs);
+        }
+    case binary_op::bool_or:
+    case binary_op::bool_and: {
+        const auto maybe_lhs = lhs.try_safe_convert_to(builtin_type::boolean);
+        const auto maybe_rhs = rhs.try_safe_convert_to(builtin_type::boolean);
+        if (!maybe_lhs.has_value() || !maybe_rhs.has_value()
+            || !maybe_lhs->holds_same_variant_type(maybe_rhs.value())
+            || !viable(maybe_lhs.value(), op, maybe_rhs.value())) {
+            return std::nullopt;
+        }
+        return (op == binary_op::bool_and)
+                   ? ExecConst::bool_and(maybe_lhs.value(), maybe_rhs.value())
+                   : ExecConst::bool_or(maybe_lhs.value(), maybe_rhs.value());
+    }
+    default:
+        break;
+    }
+
+    converge(lhs, op, rhs);
+    if (!lhs.holds_same_variant_type(rhs) || !viable(lhs, op, rhs)) {
+        return std::nullopt;
+    }
+    switch (op) {
+    case binary_op::plus:
+        return ExecConst::plus(context, lhs, rhs);
+    case binary_op::minus:
+        return ExecConst::minus(lhs, rhs);
+    case binary_op::multiply:
+        return ExecConst::multiply(lhs, rhs);
+    case binary_op::divide:
+        return rhs.equals_zero() ? std::nullopt : ExecConst::divide(lhs, rhs);
+    case binary_op::modulo:
+        return rhs.equals_zero() ? std::nullopt : ExecConst::mod(lhs, rhs);
+    case binary_op::greater_than:
+        return ExecConst::greater_than(lhs, rhs);
+    case binary_op::less_than:
+        return ExecConst::less_than(lhs, rhs);
+    case binary_op::greater_than_or_equal:
+        return ExecConst::greater_than_or_equal(lhs, rhs);
+    case binary_op::less_than_or_equal:
+        return ExecConst::less_than_or_equal(lhs, rhs);
+    case binary_op::bool_equal:
+        return ExecConst::equal(lhs, rhs);
+    case binary_op::bool_not_equal:
+        return ExecConst::not_equal(lhs, rhs);
+    default:
+        std::unreachable();
+    }
+}
+
+// mirrors ComptExprSolver::solve_preunary_exec, minus the diagnostics
+static std::optional<ExecConst> eval_unary(unary_op op, ExecConst inner) {
+    switch (op) {
+    case unary_op::plus:
+        return ExecConst::preunary_plus(inner);
+    case unary_op::minus:
+        return ExecConst::preunary_minus(inner);
+    case unary_op::bool_not: {
+        const auto maybe_bool = inner.try_down_convert_to(builtin_type::boolean);
+        return maybe_bool.has_value() ? ExecConst::preunary_bool_not(maybe_bool.value())
+                                      : std::nullopt;
+    }
+    case unary_op::bit_not:
+        return ExecConst::preunary_bit_not(inner);
+    case unary_op::inc:
+    case unary_op::dec:
+        break;
+    }
+    return std::nullopt;
+}
+
+std::optional<ExecConst> ComptVm::load_global(DefId did) {
+    if (context.resol_state_of(did) != Def::resol_state::resolved) {
+        return std::nullopt; // left for the tree-walker to resolve (or report as circular)
+    }
+    context.promote_mention_state_of(did, Def::mention_state::mentioned);
+    const Def& def = context.def(did);
+    if (!def.holds<DefVariable>() || !def.compt) {
+        return std::nullopt;
+    }
+    const OptId<ExecId> compt_value = def.as<DefVariable>(context).compt_value;
+    if (compt_value.empty()) {
+        return std::nullopt;
+    }
+    return context.exec(compt_value.as_id()).try_as<ExecConst>(context);
+}
+
+void ComptVm::frame_key(uint32_t start, uint32_t cnt) {
+    key.clear();
+    for (uint32_t i = 0; i < cnt; i++) {
+        append_compt_memo_key(regs[start + i].value, key);
+    }
+}
+
+bool ComptVm::push_frame(DefId func, uint32_t args_start, uint32_t arg_cnt, uint32_t ret_dst) {
+    ComptProgramTable& table = context.compt_programs();
+    const std::optional<uint32_t> maybe_idx = table.program_idx(context, func);
+    if (!maybe_idx.has_value() || table.program(maybe_idx.value()).param_cnt != arg_cnt) {
+        return false;
+    }
+    const uint32_t reg_cnt = table.program(maybe_idx.value()).reg_cnt;
+    const size_t bytes = ((frames.size() + 1) * sizeof(Frame))
+                         + ((regs.size() + reg_cnt) * sizeof(ExecConst));
+    if (bytes > stack_limit) {
+        Overflow overflow{.caller = {}, .callee = func, .call_site = nullptr};
+        if (!frames.empty()) {
+            const ComptProgram& caller = table.program(frames.back().program);
+            // the caller's pc is already past its call instr
+            const auto site = std::ranges::lower_bound(
+                caller.call_sites, frames.back().pc - 1, {},
+                &std::pair<uint32_t, const ast_expr_t*>::first);
+            overflow.caller = caller.func;
+            overflow.call_site = site->second;
+        }
+        last_overflow = overflow;
+        return false;
+    }
+    const auto base = static_cast<uint32_t>(regs.size());
+    regs.resize(base + reg_cnt, ExecConst{false});
+    std::copy_n(regs.begin() + args_start, arg_cnt, regs.begin() + base);
+    frames.push_back(Frame{maybe_idx.value(), 0, base, ret_dst});
+    return true;
+}
+
+std::optional<ExecConst> ComptVm::call(DefId func, const llvm::SmallVectorImpl<ExecConst>& args,
+                                       size_t max_stack_bytes) {
+    stack_limit = max_stack_bytes;
+    last_overflow.reset();
+    frames.clear();
+    regs.assign(args.begin(), args.end());
+    if (!push_frame(func, 0, static_cast<uint32_t>(args.size()), 0)) {
+        return std::nullopt;
+    }
+    const ComptProgramTable& table = context.compt_programs();
+    for (;;) {
+        Frame& frame = frames.back();
+        const ComptProgram& program = table.program(frame.program);
+        const ComptInstr in = program.code[frame.pc++];
+        // re-derived every step, since a call can grow regs
+        ExecConst* r = regs.data() + frame.base;
+        switch (in.op) {
+        case compt_op::load_const:
+            r[in.dst] = program.consts[in.a];
+            break;
+        case compt_op::load_global: {
+            const auto value = load_global(program.defs[in.a]);
+            if (!value.has_value()) {
+                return std::nullopt;
+            }
+            r[in.dst] = value.value();
+            break;
+        }
+        case compt_op::move:
+            r[in.dst] = r[in.a];
+            break;
+        case compt_op::convert: {
+            const auto value = r[in.a].try_safe_convert_to(static_cast<builtin_type>(in.sub));
+            if (!value.has_value()) {
+                return std::nullopt;
+            }
+            r[in.dst] = value.value();
+            break;
+        }
+        case compt_op::binary: {
+            const auto value
+                = eval_binary(context, static_cast<binary_op>(in.sub), r[in.a], r[in.b]);
+            if (!value.has_value()) {
+                return std::nullopt;
+            }
+            r[in.dst] = value.value();
+            break;
+        }
+        case compt_op::unary: {
+            const auto value = eval_unary(static_cast<unary_op>(in.sub), r[in.a]);
+            if (!value.has_value()) {
+                return std::nullopt;
+            }
+            r[in.dst] = value.value();
+            break;
+        }
+        case compt_op::and_short: {
+            const auto maybe_bool = r[in.a].try_safe_convert_to(builtin_type::boolean);
+            if (maybe_bool.has_value() && !maybe_bool->as<bool>()) {
+                r[in.dst] = ExecConst{false};
+                frame.pc = in.b;
+            }
+            break;
+        }
+        case compt_op::expect_type:
+            if (r[in.a].type_builtin() != static_cast<builtin_type>(in.sub)) {
+                return std::nullopt;
+            }
+            break;
+        case compt_op::jump:
+            frame.pc = in.a;
+            break;
+        case compt_op::jump_if_false: {
+            const auto maybe_bool = r[in.a].try_as<bool>();
+            if (!maybe_bool.has_value()) {
+                return std::nullopt;
+            }
+            if (!maybe_bool.value()) {
+                frame.pc = in.b;
+            }
+            break;
+        }
+        case compt_op::call: {
+            const DefId callee = program.defs[in.b];
+            const DefFunction& callee_func = context.def(callee).as<DefFunction>(context);
+            if (callee_func.poisoned()) {
+                return std::nullopt;
+            }
+            const uint32_t arg_cnt = callee_func.params.len();
+            frame_key(frame.base + in.a, arg_cnt);
+            if (const auto memo = context.memoized_compt_call(callee, key); memo.has_value()) {
+                if (!memo->value.has_value()) {
+                    return std::nullopt; // poisoned (the tree-walker reports where) or no constant
+                }
+                r[in.dst] = memo->value.value();
+                break;
+            }
+            if (!push_frame(callee, frame.base + in.a, arg_cnt, in.dst)) {
+                return std::nullopt;
+            }
+            break;
+        }
+        case compt_op::ret: {
+            const ExecConst value = r[in.a];
+            const Frame done = frame;
+            frame_key(done.base, program.param_cnt);
+            context.memoize_compt_call(program.func, key, value);
+            frames.pop_back();
+            regs.resize(done.base, ExecConst{false});
+            if (frames.empty()) {
+                return value;
+            }
+            regs[frames.back().base + done.ret_dst] = value;
+            break;
+        }
+        case compt_op::bail:
+            return std::nullopt;
+        }
+    }
+}
+
+} // namespace hir
@@ -0,0 +1,148 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#ifndef COMPILER_HIR_COMPT_BYTECODE_HPP
+#define COMPILER_HIR_COMPT_BYTECODE_HPP
+
+#include "compiler/ast/expr.h"
+#include "compiler/hir/exec.hpp"
+#include "compiler/hir/indexing.hpp"
+#include "compiler/hir/type.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace hir {
+
+class Context;
+
+/// appends a constant's two words (constant kind, bits) to a key for Context::memoized_compt_call
+void append_compt_memo_key(const ConstantValue& value, llvm::SmallVectorImpl<uint64_t>& key);
+
+enum class compt_op : uint8_t {
+    load_const,    // dst = consts[a]
+    load_global,   // dst = compt value of the variable defs[a]
+    move,          // dst = a
+    convert,       // dst = a safely converted to (builtin_type)sub
+    expect_type,   // bail unless a is exactly (builtin_type)sub
+    binary,        // dst = a (binary_op)sub b
+    unary,         // dst = (unary_op)sub a
+    and_short,     // if a is contextually false, dst = false and jump to b
+    jump,          // jump to a
+    jump_if_false, // if a is false, jump to b
+    call,          // dst = defs[b](a, a + 1, ...)
+    ret,           // return a
+    bail,          // hand the whole call back to the tree-walker
+};
+
+struct ComptInstr {
+    compt_op op;
+    uint8_t sub = 0;
+    uint32_t dst = 0;
+    uint32_t a = 0;
+    uint32_t b = 0;
+};
+
+/// register bytecode for a pure compt function, its params live in registers [0, param_cnt)
+struct ComptProgram {
+    DefId func;
+    uint32_t param_cnt = 0;
+    uint32_t reg_cnt = 0;
+    std::vector<ComptInstr> code;
+    std::vector<ExecConst> consts;
+    /// globals read and functions called
+    std::vector<DefId> defs;
+    /// every call instr's pc and call expr, in pc order, for overflow diagnostics
+    std::vector<std::pair<uint32_t, const ast_expr_t*>> call_sites;
+};
+
+/**
+ * hir::ComptProgramTable, every pure compt function's bytecode, compiled on its first call
+ * - only functions of builtin (or `var`) params to a builtin (or untyped) result compile, and
+ * within a body anything the vm doesn't cover (or that's already known to be an error) compiles
+ * to a bail
+ * - programs are never invalidated since a resolved function's body never changes
+ */
+class ComptProgramTable {
+  public:
+    /// idx of func's program, none if func can't run on the vm (yet, for unresolved functions)
+    [[nodiscard]] std::optional<uint32_t> program_idx(Context& context, DefId func);
+    [[nodiscard]] const ComptProgram& program(uint32_t idx) const { return programs[idx]; }
+    [[nodiscard]] size_t size() const noexcept { return programs.size(); }
+    [[nodiscard]] size_t reserved_bytes() const noexcept;
+    [[nodiscard]] size_t used_bytes() const noexcept;
+
+  private:
+    static constexpr uint32_t NOT_COMPILED = 0;
+    static constexpr uint32_t NOT_COMPILABLE = UINT32_MAX;
+    /// DefId - 1 -> program idx + 1, or one of the markers above
+    std::vector<uint32_t> def_programs;
+    std::vector<ComptProgram> programs;
+};
+
+/**
+ * hir::ComptVm, runs compt calls over ComptProgramTable's bytecode
+ * - frames and registers live in flat heap vectors, so a call is a push rather than a recursion
+ * and call depth is bounded by those vectors' bytes instead of the C++ stack
+ * - every finished call is memoized as a plain constant (see Context::memoize_compt_call), so
+ * the only exec a vm call leaves behind is the outermost result the solver materializes
+ * - nothing is ever reported, on any error or anything unsupported the vm bails and the caller
+ * reruns the call on the tree-walker, which then reports exactly what it always has, the only
+ * exception being an overflow, which the caller reports from overflow()
+ */
+class ComptVm {
+  public:
+    /// see Context::compt_stack_bytes
+    static constexpr size_t DEFAULT_STACK_BYTES = size_t{8} << 20;
+
+    /// the call that didn't fit, call_site is in caller's body (none for the outermost call)
+    struct Overflow {
+        OptId<DefId> caller;
+        DefId callee;
+        const ast_expr_t* call_site;
+    };
+
+    explicit ComptVm(Context& context) : context{context} {}
+
+    /// func's result for args, none if the vm bailed or overflowed max_stack_bytes
+    [[nodiscard]] std::optional<ExecConst> call(DefId func,
+                                                const llvm::SmallVectorImpl<ExecConst>& args,
+                                                size_t max_stack_bytes);
+    /// set if the last call gave up because it ran out of stack
+    [[nodiscard]] const std::optional<Overflow>& overflow() const noexcept {
+        return last_overflow;
+    }
+
+  private:
+    struct Frame {
+        uint32_t program;
+        uint32_t pc;
+        uint32_t base;
+        uint32_t ret_dst; // in the caller's registers
+    };
+    Context& context;
+    std::vector<Frame> frames;
+    std::vector<ExecConst> regs;
+    llvm::SmallVector<uint64_t, 8> key;
+    size_t stack_limit = 0;
+    std::optional<Overflow> last_overflow;
+
+    /// false if func has no program or its frame would overflow, see overflow()
+    [[nodiscard]] bool push_frame(DefId func, uint32_t args_start, uint32_t arg_cnt,
+                                  uint32_t ret_dst);
+    /// memo key of a call whose args are in regs [start, start + cnt)
+    void frame_key(uint32_t start, uint32_t cnt);
+    [[nodiscard]] std::optional<ExecConst> load_global(DefId did);
+};
+
+} // namespace hir
+
+#endif // !COMPILER_HIR_COMPT_BYTECODE_HPP
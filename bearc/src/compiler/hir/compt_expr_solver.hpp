@@ -12,6 +12,7 @@
 #include "compiler/ast/expr.h"
 #include "compiler/ast/params.h"
 #include "compiler/ast/stmt.h"
+#include "compiler/hir/compt_bytecode.hpp"
 #include "compiler/hir/context.hpp"
 #include "compiler/hir/def.hpp"
 #include "compiler/hir/diagnostic.hpp"
@@ -24,6 +25,7 @@
 #include "compiler/hir/type.hpp"
 #include "compiler/token.h"
 #include "def_visitor.hpp"
+#include "utils/alloc_phase.hpp"
 #include <cassert>
 #include <optional>
 #include <utility>
@@ -33,35 +35,63 @@ template <IsDefVisitor V> class ComptExprSolver {
     Context& context;
     V& def_visitor;
     HirSize call_depth = 0;
+    /// pure compt calls try the vm first, the tree-walker is the fallback and the reference
+    ComptVm vm;
+    /// set once the vm bails, so the calls nested under the one it gave up on aren't retried
+    bool vm_bailed = false;
+    // heap traffic while a solver is alive counts as compt evaluation
+    AllocPhaseScope alloc_phase{ALLOC_PHASE_COMPT};
 
   public:
-    static constexpr HirSize MAX_COMPT_CALL_FRAMES = 100; // TODO increase once memoization is added
-
-    ComptExprSolver(Context& ctx, V& def_visitor) : context{ctx}, def_visitor{def_visitor} {}
+    ComptExprSolver(Context& ctx, V& def_visitor)
+        : context{ctx}, def_visitor{def_visitor}, vm{ctx} {}
 
     [[nodiscard]] Context& get_context() { return this->context; }
 
+    /// entry point for solving a compt expr from outside the solver
+    /// - intermediates land in a fresh scratch generation and only the resulting value is promoted
+    /// into the permanent exec table, whereas solve_expr and friends hand out scratch ExecIds that
+    /// die w/ the generation
+    [[nodiscard]] OptId<ExecId> solve_top_level_expr(FileId fid, ScopeId scope,
+                                                     const ast_expr_t* expr,
+                                                     OptId<TypeId> maybe_into_tid) {
+        ScratchGeneration generation{context};
+        return context.promote_scratch_exec(solve_expr(fid, scope, expr, maybe_into_tid));
+    }
+
+    /// like solve_top_level_expr, but for an expr of some builtin type (e.g. an array size)
+    [[nodiscard]] OptId<ExecId>
+    solve_top_level_builtin_expr(FileId fid, ScopeId scope, const ast_expr_t* expr,
+                                 std::optional<builtin_type> into_builtin, OptId<TypeId> into_tid) {
+        ScratchGeneration generation{context};
+        return context.promote_scratch_exec(
+            solve_builtin_compt_expr(fid, scope, expr, into_builtin, into_tid));
+    }
+
     [[nodiscard]] OptId<ExecId> solve_expr(FileId fid, ScopeId scope, const ast_expr_t* expr) {
         return solve_expr(fid, scope, expr, std::nullopt);
     }
 
     [[nodiscard]] OptId<TypeId> infer_type_from_compt_expr(FileId fid, ScopeId scope,
                                                            const ast_expr_t* expr) {
+        // only the type is kept, so nothing gets promoted
+        ScratchGeneration generation{context};
 
         if (expr->type == AST_EXPR_ID) {
             auto sid = context.symbol_slice(expr->expr.id.slice);
             Span span{context, fid, expr->first, expr->last};
             auto maybe_did = context.look_up_scoped_variable(scope, sid, span);
             if (maybe_did.empty()) {
-                context.emplace_diagnostic(span, diag_code::use_of_undeclared_identifier,
-                                           diag_type::error);
+                auto d0 = context.emplace_diagnostic(span, diag_code::use_of_undeclared_identifier,
+                                                     diag_type::error);
+                context.suggest_name_for(d0, scope, sid, span);
                 return std::nullopt;
             }
             const Def& def = context.def(maybe_did.as_id());
             if (!def.holds<DefVariable>()) {
                 return std::nullopt;
             }
-            return def.as<DefVariable>().type_id;
+            return def.as<DefVariable>(context).type_id;
         }
 
         OptId<ExecId> maybe_eid = solve_expr(fid, scope, expr);
@@ -76,13 +106,25 @@ template <IsDefVisitor V> class ComptExprSolver {
     }
 
     [[nodiscard]] OptId<TypeId> infer_type_from_exec(ExecId eid) {
+        if (const OptId<TypeId> cached = context.cached_exec_type(eid); cached.has_value()) {
+            return cached;
+        }
+        const OptId<TypeId> maybe_tid = infer_uncached_type_from_exec(eid);
+        if (maybe_tid.has_value()) {
+            context.cache_exec_type(eid, maybe_tid.as_id());
+        }
+        return maybe_tid;
+    }
+
+    // failures aren't cached, so each query still reports that the type can't be inferred
+    [[nodiscard]] OptId<TypeId> infer_uncached_type_from_exec(ExecId eid) {
         const Exec& exec = context.exec(eid);
         if (exec.holds<ExecExprComptConstant>()) {
-            auto bin_type = exec.as<ExecExprComptConstant>().type_builtin();
+            auto bin_type = exec.as<ExecExprComptConstant>(context).type_builtin();
             return context.emplace_type(TypeBuiltin{.type = bin_type}, Span::generated(), false);
         }
         if (exec.holds<ExecExprStructInit>()) {
-            auto struct_did = exec.as<ExecExprStructInit>().struct_def_id;
+            auto struct_did = exec.as<ExecExprStructInit>(context).struct_def_id;
 
             return context.emplace_type(
                 TypeStruct{.def_id = struct_did,
@@ -91,7 +133,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                 Span::generated(), false);
         }
         if (exec.holds<ExecExprListLiteral>()) {
-            auto list_exec = exec.as<ExecExprListLiteral>();
+            auto list_exec = exec.as<ExecExprListLiteral>(context);
             auto maybe_contained_type = list_exec.elem_type_id;
             if (maybe_contained_type.empty()) {
                 return std::nullopt;
@@ -107,17 +149,17 @@ template <IsDefVisitor V> class ComptExprSolver {
                 Span::generated(), false);
         }
         if (exec.holds<ExecFnPtr>()) {
-            return exec.as<ExecFnPtr>().fn_ptr_tid;
+            return exec.as<ExecFnPtr>(context).fn_ptr_tid;
         }
         if (exec.holds<ExecExprUnionInit>()) {
             return context.emplace_type(
-                TypeUnion{.def_id = exec.as<ExecExprUnionInit>().union_def_id}, Span::generated(),
-                false);
+                TypeUnion{.def_id = exec.as<ExecExprUnionInit>(context).union_def_id},
+                Span::generated(), false);
         }
         if (exec.holds<ExecExprVariantInit>()) {
             return context.emplace_type(
                 TypeVariant{
-                    .def_id = exec.as<ExecExprVariantInit>().variant_def_id,
+                    .def_id = exec.as<ExecExprVariantInit>(context).variant_def_id,
                     .gen_args_slice = {},
                     .maybe_canon_gen_args_id = {},
                 },
@@ -131,8 +173,8 @@ template <IsDefVisitor V> class ComptExprSolver {
         return std::nullopt;
     }
 
-    // solves a top level compt expr (this is primarily for array sizing & builtin types for top
-    // level generic instantiation with compt parameterizations)
+    // solves a compt expr (this is primarily for array sizing & builtin types for top level
+    // generic instantiation with compt parameterizations), the result is a scratch exec
     [[nodiscard]] OptId<ExecId> solve_expr(FileId fid, ScopeId scope, const ast_expr_t* expr,
                                            OptId<TypeId> maybe_into_tid) {
 
@@ -190,12 +232,12 @@ template <IsDefVisitor V> class ComptExprSolver {
                 if (maybe_tid.has_value()) {
                     const Type& ty = context.type(maybe_tid.as_id());
                     if (ty.holds<TypeBuiltin>()
-                        and ty.as<TypeBuiltin>().type == builtin_type::nullpointer) {
+                        and ty.as<TypeBuiltin>(context).type == builtin_type::nullpointer) {
                         return maybe_eid.as_id();
                     }
                 }
             }
-            auto inner_tid = into_type.as<TypePtr>().inner;
+            auto inner_tid = into_type.as<TypePtr>(context).inner;
             auto inner = context.type(inner_tid);
             auto d0 = context.emplace_diagnostic(
                 into_type.span, diag_code::pointers_are_not_assignable_at_compt, diag_type::error);
@@ -221,7 +263,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             // guard diff type
             if (!context.equivalent_type(into_tid, maybe_tid.as_id())) {
                 context.emplace_diagnostic_with_message_value(
-                    Span(fid, context.ast(fid).buffer(), expr->first, expr->last),
+                    Span(context, fid, expr->first, expr->last),
                     diag_code::cannot_convert_value_of_type, diag_type::error,
                     DiagnosticTypeToType{.from = maybe_tid.as_id(), .to = into_tid});
                 return std::nullopt;
@@ -247,7 +289,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             // guard diff type
             if (!context.equivalent_type(into_tid, list_type)) {
                 context.emplace_diagnostic_with_message_value(
-                    Span(fid, context.ast(fid).buffer(), expr->first, expr->last),
+                    Span(context, fid, expr->first, expr->last),
                     diag_code::cannot_convert_value_of_type, diag_type::error,
                     DiagnosticTypeToType{.from = list_type, .to = into_tid});
                 return std::nullopt;
@@ -275,7 +317,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             // guard diff type
             if (!context.equivalent_type(into_tid, fnp_tid)) {
                 context.emplace_diagnostic_with_message_value(
-                    Span(fid, context.ast(fid).buffer(), expr->first, expr->last),
+                    Span(context, fid, expr->first, expr->last),
                     diag_code::cannot_convert_value_of_type, diag_type::error,
                     DiagnosticTypeToType{.from = fnp_tid, .to = into_tid});
                 return std::nullopt;
@@ -338,12 +380,45 @@ template <IsDefVisitor V> class ComptExprSolver {
                                        diag_type::error);
             return OptId<ExecId>{};
         }
-        builtin_type into_builtin_type = into_type.as<TypeBuiltin>().type;
+        builtin_type into_builtin_type = into_type.as<TypeBuiltin>(context).type;
         return solve_builtin_compt_expr(fid, scope, expr, into_builtin_type, into_tid);
     }
 
+    /// every exec the solver makes is a compt intermediate, see Context::emplace_scratch_exec
+    [[nodiscard]] ExecId emplace_scratch_exec(const ExecValue& value, Span span, bool compt) {
+        return context.emplace_scratch_exec(value, span, compt);
+    }
+    [[nodiscard]] ExecId emplace_scratch_compt_exec(const ExecValue& value, Span span) {
+        return context.emplace_scratch_exec(value, span, true);
+    }
+
     void enter_compt_fn() { ++call_depth; }
 
+    /// same as the tree-walker's overflow, at the call that didn't fit, plus where func was called
+    /// if it isn't the function that overflowed
+    void report_vm_overflow(FileId fid, const ast_expr_t* expr, DefId func_did,
+                            const ComptVm::Overflow& overflow) {
+        const Def& callee = context.def(overflow.callee);
+        const Span call_span
+            = overflow.caller.has_value()
+                  ? Span{context, context.def_to_file_id(overflow.caller.as_id()),
+                         overflow.call_site}
+                  : Span{context, fid, expr};
+        auto d0 = context.emplace_diagnostic_with_message_value(
+            call_span, diag_code::only_message_value_is_meaningful, diag_type::error,
+            DiagnosticComptStackOverflow{.function_sid = callee.name});
+        auto d1 = context.emplace_diagnostic_with_message_value(
+            callee.span(context), diag_code::declared_here, diag_type::note,
+            DiagnosticSymbolBeforeMessage{.sid = callee.name});
+        context.link_diagnostic(d0, d1);
+        context.def(overflow.callee).template as<DefFunction>(context).poison_infinite_recursion();
+        if (overflow.callee != func_did) {
+            context.emplace_diagnostic_with_message_value(
+                Span{context, fid, expr}, diag_code::called_here, diag_type::note,
+                DiagnosticSymbolBeforeMessage{.sid = context.def(func_did).name});
+        }
+    }
+
     void exit_compt_fn() { --call_depth; }
 
     [[nodiscard]] OptId<ExecId> solve_builtin_compt_expr(FileId fid, ScopeId scope,
@@ -351,8 +426,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                                                          std::optional<builtin_type> into_builtin,
                                                          OptId<TypeId> into_tid) {
         auto emplace_e = [this, fid, expr](ExecValue val) {
-            return context.register_exec(
-                context, val, Span(fid, context.ast(fid).buffer(), expr->first, expr->last), true);
+            return emplace_scratch_exec(val, Span(context, fid, expr->first, expr->last), true);
         };
 
         auto visit_def
@@ -360,7 +434,7 @@ template <IsDefVisitor V> class ComptExprSolver {
 
         if (into_tid.has_value() && !into_builtin.has_value()
             && context.type(into_tid.as_id()).template holds<TypeBuiltin>()) {
-            into_builtin = context.type(into_tid.as_id()).template as<TypeBuiltin>().type;
+            into_builtin = context.type(into_tid.as_id()).template as<TypeBuiltin>(context).type;
         }
 
         auto cannot_conv = [this, fid, expr, into_builtin]() {
@@ -406,7 +480,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                 cannot_conv_from(inffered_tid);
                 return std::nullopt;
             }
-            if (inffered_type.template as<TypeBuiltin>().type != into_builtin.value()) {
+            if (inffered_type.template as<TypeBuiltin>(context).type != into_builtin.value()) {
                 cannot_conv_from(inffered_tid);
                 return std::nullopt;
             }
@@ -416,7 +490,7 @@ template <IsDefVisitor V> class ComptExprSolver {
         std::optional<ExecConst> maybe_value;
         switch (expr->type) {
         case AST_EXPR_ID: {
-            Span id_span{fid, context.ast(fid).buffer(), expr->expr.id.slice.start[0],
+            Span id_span{context, fid, expr->expr.id.slice.start[0],
                          expr->expr.id.slice.start[expr->expr.id.slice.len - 1]};
             auto maybe_def = context.look_up_scoped_variable(
                 scope, context.symbol_slice(expr->expr.id.slice), id_span);
@@ -427,88 +501,44 @@ template <IsDefVisitor V> class ComptExprSolver {
                 if (def.holds<DefVariable>()) {
                     if (!def.compt) {
                         auto diag_id = context.emplace_diagnostic(
-                            Span(fid, context.ast(fid).buffer(), expr->first, expr->last),
+                            Span(context, fid, expr->first, expr->last),
                             diag_code::cannot_init_with_non_compt_value, diag_type::error,
                             DiagnosticSubCode{.sub_code = diag_code::not_a_compile_time_constant});
                         auto sub_diag_id = context.emplace_diagnostic(
-                            def.span, diag_code::declared_here_without_compt, diag_type::note);
+                            def.span(context), diag_code::declared_here_without_compt,
+                            diag_type::note);
                         context.link_diagnostic(diag_id, sub_diag_id);
                         return std::nullopt;
                     }
-                    if (!def.as<DefVariable>().compt_value.has_value()) {
+                    if (!def.as<DefVariable>(context).compt_value.has_value()) {
                         return std::nullopt; // this is already malformed (already been
                                              // reported, so just return none)
                     }
-                    auto exec = context.exec(def.as<DefVariable>().compt_value.as_id());
+                    auto exec = context.exec(def.as<DefVariable>(context).compt_value.as_id());
 
-                    maybe_value = exec.template try_as<ExecConst>();
+                    maybe_value = exec.template try_as<ExecConst>(context);
                 }
             } else {
                 auto sid_slice = context.symbol_slice(expr->expr.id.slice);
-                context.emplace_diagnostic(
-                    Span(fid, context.ast(fid).buffer(), expr->first, expr->last),
-                    diag_code::use_of_undeclared_identifier, diag_type::error,
+                const Span id_span(context, fid, expr->first, expr->last);
+                auto d0 = context.emplace_diagnostic(
+                    id_span, diag_code::use_of_undeclared_identifier, diag_type::error,
                     DiagnosticIdentifierAfterMessage{.sid_slice = sid_slice},
                     DiagnosticSubCode{.sub_code = diag_code::not_declared_in_this_scope});
+                context.suggest_name_for(d0, scope, sid_slice, id_span);
                 return std::nullopt;
             }
             break;
         }
-        case AST_EXPR_LITERAL: {
-            const token_t* tkn = expr->expr.literal.tkn;
-            switch (tkn->type) {
-            case TOK_CHAR_LIT:
-                maybe_value = ExecConst{tkn->val.character};
-                break;
-            // try as i32 if possible
-            case TOK_INT_LIT: {
-                maybe_value = ExecConst{tkn->val.signed_integral};
-                auto maybe_signed = maybe_value->try_safe_convert_to(builtin_type::i32);
-                if (maybe_signed.has_value()) {
-                    maybe_value = maybe_signed;
-                }
-            } break;
-                // try as i32 and then i64 if possible
-            case TOK_UINT_LIT: {
-                maybe_value = ExecConst{tkn->val.unsigned_integral};
-                auto maybe_signed = maybe_value->try_safe_convert_to(builtin_type::i32);
-                if (maybe_signed.has_value()) {
-                    maybe_value = maybe_signed;
-                } else {
-                    maybe_signed = maybe_value->try_safe_convert_to(builtin_type::i64);
-                    if (maybe_signed.has_value()) {
-                        maybe_value = maybe_signed;
-                    }
-                }
-                break;
-            }
-            case TOK_FLOAT_LIT:
-                maybe_value = ExecConst{tkn->val.floating};
-                break;
-            case TOK_STR_LIT:
-                maybe_value = ExecConst{context.symbol_id_for_str_lit_tkn(tkn)};
-                break;
-            case TOK_BOOL_LIT_FALSE:
-                maybe_value = ExecConst{false};
-                break;
-            case TOK_BOOL_LIT_TRUE:
-                maybe_value = ExecConst{true};
-                break;
-            case TOK_NULL_LIT:
-                maybe_value = ExecConst{nullptr};
-                break;
-            default:
-                std::unreachable();
-                break;
-            }
+        case AST_EXPR_LITERAL:
+            maybe_value = ExecConst::from_literal(context, expr->expr.literal.tkn);
             break;
-        }
         case AST_EXPR_BINARY: {
             auto maybe_eid = solve_expr_binary(fid, scope, expr);
             if (maybe_eid.has_value()) {
                 const Exec& exec = context.exec(maybe_eid.as_id());
                 if (exec.holds<ExecConst>()) {
-                    maybe_value = exec.as<ExecConst>();
+                    maybe_value = exec.as<ExecConst>(context);
                 } else {
                     maybe_value = std::nullopt;
                 }
@@ -531,13 +561,13 @@ template <IsDefVisitor V> class ComptExprSolver {
                 maybe_inner = solve_builtin_compt_expr(fid, scope, expr->expr.unary.expr,
                                                        std::nullopt, std::nullopt);
             } else {
-                Span span{fid, context.ast(fid).buffer(), expr->expr.unary.op};
+                Span span{context, fid, expr->expr.unary.op};
                 auto d0 = context.emplace_diagnostic(span, diag_code::operator_not_viable_at_compt,
                                                      diag_type::error);
                 // be more helpful for ++ and -- at compt
                 if ((t == TOK_INC || t == TOK_DEC) && maybe_inner.has_value()) {
                     auto d1 = context.emplace_diagnostic(
-                        Span{fid, context.ast(fid).buffer(), expr->expr.unary.expr->first,
+                        Span{context, fid, expr->expr.unary.expr->first,
                              expr->expr.unary.expr->last},
                         diag_code::immutable_value_is_not_assignable, diag_type::note,
                         DiagnosticNoOtherInfo{});
@@ -551,7 +581,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             // guard malformed ops
             if (!maybe_op.has_value()) {
                 context.emplace_diagnostic(
-                    Span{fid, context.ast(fid).buffer(), expr->expr.unary.op},
+                    Span{context, fid, expr->expr.unary.op},
                     diag_code::operator_not_viable_at_compt, diag_type::error);
                 return std::nullopt;
             }
@@ -564,7 +594,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                 return std::nullopt;
             }
 
-            Span op_span = Span{fid, context.ast(fid).buffer(), expr->expr.unary.op};
+            Span op_span = Span{context, fid, expr->expr.unary.op};
 
             OptId<ExecId> maybe_eid = solve_preunary_exec(op, op_span, maybe_inner.as_id());
 
@@ -575,7 +605,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                 if (!exec.template holds<ExecConst>()) {
                     cooked = true;
                 } else {
-                    maybe_value = exec.template as<ExecConst>();
+                    maybe_value = exec.template as<ExecConst>(context);
                 }
             } else {
                 cooked = true;
@@ -590,13 +620,13 @@ template <IsDefVisitor V> class ComptExprSolver {
             token_type_e t = expr->expr.unary.op->type;
             OptId<ExecId> maybe_inner = solve_builtin_compt_expr(fid, scope, expr->expr.unary.expr,
                                                                  into_builtin, into_tid);
-            Span op_span{fid, context.ast(fid).buffer(), expr->expr.unary.op};
+            Span op_span{context, fid, expr->expr.unary.op};
             auto d0 = context.emplace_diagnostic(op_span, diag_code::operator_not_viable_at_compt,
                                                  diag_type::error);
             // be more helpful for ++ and -- at compt
             if ((t == TOK_INC || t == TOK_DEC) && maybe_inner.has_value()) {
                 auto d1 = context.emplace_diagnostic(
-                    Span{fid, context.ast(fid).buffer(), expr->expr.unary.expr->first,
+                    Span{context, fid, expr->expr.unary.expr->first,
                          expr->expr.unary.expr->last},
                     diag_code::immutable_value_is_not_assignable, diag_type::note);
                 context.link_diagnostic(d0, d1);
@@ -649,7 +679,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                 return {}; // poisoned
             }
             if (context.exec(maybe_eid.as_id()).template holds<ExecConst>()) {
-                maybe_value = context.exec(maybe_eid.as_id()).template as<ExecConst>();
+                maybe_value = context.exec(maybe_eid.as_id()).template as<ExecConst>(context);
             } else if (into_tid.has_value()) {
                 context.emplace_diagnostic_with_message_value(
                     Span{context, fid, expr}, diag_code::cannot_convert_expression_to_type,
@@ -669,7 +699,7 @@ template <IsDefVisitor V> class ComptExprSolver {
         case AST_EXPR_INVALID:
             // not a valid compile-time expr
             context.emplace_diagnostic(
-                Span(fid, context.ast(fid).buffer(), expr->first, expr->last),
+                Span(context, fid, expr->first, expr->last),
                 diag_code::cannot_resolve_at_compt, diag_type::error);
             return std::nullopt;
         }
@@ -690,7 +720,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                                 : context.emplace_type(TypeBuiltin{.type = into_builtin.value()},
                                                        Span::generated(), false);
                 context.emplace_diagnostic(
-                    Span(fid, context.ast(fid).buffer(), expr->first, expr->last),
+                    Span(context, fid, expr->first, expr->last),
                     diag_code::cannot_convert_value_of_type, diag_type::error,
                     DiagnosticTypeToType{.from = from, .to = to}, DiagnosticNoOtherInfo{});
 
@@ -700,7 +730,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             assert(maybe_converted.value().matches_type(into_builtin.value()));
             return emplace_e(maybe_converted.value());
         }
-        context.emplace_diagnostic(Span(fid, context.ast(fid).buffer(), expr->first, expr->last),
+        context.emplace_diagnostic(Span(context, fid, expr->first, expr->last),
                                    diag_code::cannot_resolve_at_compt, diag_type::error);
         // as to not duplicate compt errors from bubbling up
         return std::nullopt;
@@ -716,22 +746,23 @@ template <IsDefVisitor V> class ComptExprSolver {
         auto visit_def
             = [this](DefId did) { return context.def(def_visitor.visit_as_dependent(did)); };
 
-        auto expr_span = Span(fid, context.ast(fid).buffer(), expr->first, expr->last);
+        auto expr_span = Span(context, fid, expr->first, expr->last);
 
         OptId<ExecId> maybe_eid{};
 
         switch (expr->type) {
         case AST_EXPR_ID: {
-            Span id_span{fid, context.ast(fid).buffer(), expr->expr.id.slice.start[0],
+            Span id_span{context, fid, expr->expr.id.slice.start[0],
                          expr->expr.id.slice.start[expr->expr.id.slice.len - 1]};
             auto maybe_def = context.look_up_scoped_variable(
                 scope, context.symbol_slice(expr->expr.id.slice), id_span);
             if (!maybe_def.has_value()) {
                 auto sid_slice = context.symbol_slice(expr->expr.id.slice);
-                context.emplace_diagnostic(
+                auto d0 = context.emplace_diagnostic(
                     expr_span, diag_code::use_of_undeclared_identifier, diag_type::error,
                     DiagnosticIdentifierAfterMessage{.sid_slice = sid_slice},
                     DiagnosticSubCode{.sub_code = diag_code::not_declared_in_this_scope});
+                context.suggest_name_for(d0, scope, sid_slice, expr_span);
                 return std::nullopt;
             }
             // happy path, canonicalize compt value
@@ -743,13 +774,13 @@ template <IsDefVisitor V> class ComptExprSolver {
                     DiagnosticTypeAfterMessage{.tid = into_tid}, DiagnosticNoOtherInfo{});
                 return std::nullopt;
             }
-            const auto& def_variable = def.as<DefVariable>();
+            const auto& def_variable = def.as<DefVariable>(context);
             if (!def.compt) {
                 auto d0 = context.emplace_diagnostic(
                     expr_span, diag_code::cannot_init_with_non_compt_value, diag_type::error,
                     DiagnosticSubCode{.sub_code = diag_code::not_a_compile_time_constant});
                 auto d1 = context.emplace_diagnostic(
-                    def.span, diag_code::declared_here_without_compt, diag_type::note);
+                    def.span(context), diag_code::declared_here_without_compt, diag_type::note);
                 context.link_diagnostic(d0, d1);
                 return {};
             }
@@ -775,15 +806,16 @@ template <IsDefVisitor V> class ComptExprSolver {
 
             auto id_slice = expr->expr.struct_init.id;
             auto sid_slice = context.symbol_slice(expr->expr.struct_init.id);
-            Span id_span{fid, context.ast(fid).buffer(), expr->expr.struct_init.id.start[0],
+            Span id_span{context, fid, expr->expr.struct_init.id.start[0],
                          expr->expr.struct_init.id.start[expr->expr.id.slice.len - 1]};
             OptId<DefId> maybe_did = context.look_up_scoped_type(scope, sid_slice, id_span);
 
             if (!maybe_did.has_value()) {
-                context.emplace_diagnostic(
+                auto d0 = context.emplace_diagnostic(
                     expr_span, diag_code::use_of_undeclared_identifier, diag_type::error,
                     DiagnosticIdentifierAfterMessage{.sid_slice = sid_slice},
                     DiagnosticSubCode{.sub_code = diag_code::not_declared_in_this_scope});
+                context.suggest_name_for(d0, scope, sid_slice, expr_span);
                 return std::nullopt;
             }
 
@@ -799,14 +831,14 @@ template <IsDefVisitor V> class ComptExprSolver {
 
             if (maybe_struct_did.empty()) {
                 auto did0 = context.emplace_diagnostic(
-                    Span(fid, context.ast(fid).buffer(), id_slice.start[0],
+                    Span(context, fid, id_slice.start[0],
                          id_slice.start[id_slice.len - 1]),
                     diag_code::is_not_a_struct, diag_type::error,
                     DiagnosticIdentifierBeforeMessage{.sid_slice = sid_slice},
                     DiagnosticNoOtherInfo{});
 
                 const Def& def = context.def(did);
-                auto did1 = context.emplace_diagnostic(def.span, diag_code::declared_here,
+                auto did1 = context.emplace_diagnostic(def.span(context), diag_code::declared_here,
                                                        diag_type::note);
                 context.link_diagnostic(did0, did1);
                 return std::nullopt;
@@ -870,8 +902,8 @@ template <IsDefVisitor V> class ComptExprSolver {
             }
             if (const Exec& exec = context.exec(eid);
                 exec.holds<ExecExprStructInit>() && into_type.holds<TypeStruct>()
-                && (exec.as<ExecExprStructInit>().struct_def_id
-                    == into_type.as<TypeStruct>().def_id)) {
+                && (exec.as<ExecExprStructInit>(context).struct_def_id
+                    == into_type.as<TypeStruct>(context).def_id)) {
                 return eid;
             }
             OptId<TypeId> maybe_inferred_etid = infer_type_from_exec(eid);
@@ -892,9 +924,10 @@ template <IsDefVisitor V> class ComptExprSolver {
     [[nodiscard]] OptId<ExecId> handle_union_init(FileId fid, ScopeId scope, DefId union_did,
                                                   const ast_expr_t* expr) {
         assert(context.def(union_did).template holds<DefUnion>());
-        const auto member_dids = context.def(union_did).template as<DefUnion>().ordered_members;
+        const auto member_dids
+            = context.def(union_did).template as<DefUnion>(context).ordered_members;
         auto sid_slice = context.symbol_slice(expr->expr.struct_init.id);
-        Span id_span{fid, context.ast(fid).buffer(), expr->expr.struct_init.id.start[0],
+        Span id_span{context, fid, expr->expr.struct_init.id.start[0],
                      expr->expr.struct_init.id.start[expr->expr.id.slice.len - 1]};
         const ast_slice_of_exprs_t init_slice = expr->expr.struct_init.member_inits;
         if (init_slice.len > 1) {
@@ -928,7 +961,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                 DiagnosticIdentifierAfterMessage{.sid_slice = sid_slice},
                 DiagnosticSubCode{.sub_code = diag_code::use_of_undeclared_identifier});
             auto d1 = context.emplace_diagnostic_with_message_value(
-                context.def(union_did).span, diag_code::declared_here, diag_type::note,
+                context.def(union_did).span(context), diag_code::declared_here, diag_type::note,
                 DiagnosticSymbolAfterMessage{.sid = context.def(union_did).name});
             context.link_diagnostic(d0, d1);
             return {};
@@ -943,13 +976,13 @@ template <IsDefVisitor V> class ComptExprSolver {
                 Span{context, fid, member_init->expr.struct_member_init.assign_op},
                 diag_code::compt_values_cannot_be_moved, diag_type::error);
         }
-        TypeId needed_tid = context.def(matched_did).template as<DefVariable>().type_id;
+        TypeId needed_tid = context.def(matched_did).template as<DefVariable>(context).type_id;
         OptId<ExecId> maybe_val
             = solve_expr(fid, scope, member_init->expr.struct_member_init.value, needed_tid);
         if (maybe_val.empty()) {
             return {}; // poisoned
         }
-        return context.emplace_compt_exec(
+        return emplace_scratch_compt_exec(
             ExecExprUnionInit{.member_init = maybe_val.as_id(),
                               .union_def_id = union_did,
                               .active_member_idx = context.def(matched_did).member_idx,
@@ -960,7 +993,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                                                    const ast_expr_t* expr, TypeId into_tid) {
         const auto member_dids = context.ordered_defs_for(struct_did);
         auto sid_slice = context.symbol_slice(expr->expr.struct_init.id);
-        Span id_span{fid, context.ast(fid).buffer(), expr->expr.struct_init.id.start[0],
+        Span id_span{context, fid, expr->expr.struct_init.id.start[0],
                      expr->expr.struct_init.id.start[expr->expr.id.slice.len - 1]};
         const ast_slice_of_exprs_t init_slice = expr->expr.struct_init.member_inits;
 
@@ -985,7 +1018,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             }
 
             assert(member.holds<DefVariable>());
-            const auto& member_as_var = member.as<DefVariable>();
+            const auto& member_as_var = member.as<DefVariable>(context);
 
             const TypeId member_type = member_as_var.type_id;
             const OptId<ExecId> default_val = member_as_var.compt_value;
@@ -997,11 +1030,11 @@ template <IsDefVisitor V> class ComptExprSolver {
                     ExecExprStructMemberInit init{
                         .field_def = member_did, .value = default_val.as_id(), .move = false};
                     member_init_execs.emplace_back(
-                        context.register_exec(context, init, Span::generated(), true));
+                        emplace_scratch_exec(init, Span::generated(), true));
                 } else {
                     cooked = true;
                     context.emplace_diagnostic(
-                        Span(fid, context.ast(fid).buffer(), expr->last),
+                        Span(context, fid, expr->last),
                         diag_code::struct_field_not_initialized, diag_type::error,
                         DiagnosticSymbolAfterMessage{.sid = context.def(member_dids.get(i)).name},
                         DiagnosticNoOtherInfo{});
@@ -1018,13 +1051,13 @@ template <IsDefVisitor V> class ComptExprSolver {
             const token_t* assign_op = member_init_expr->expr.struct_member_init.id;
 
             if (assign_op->type == TOK_ASSIGN_MOVE) {
-                context.emplace_diagnostic(Span(fid, context.ast(fid).buffer(), assign_op),
+                context.emplace_diagnostic(Span(context, fid, assign_op),
                                            diag_code::compt_values_cannot_be_moved,
                                            diag_type::error);
             }
             const ast_expr_t* proposed_val = member_init_expr->expr.struct_member_init.value;
-            const Span proposed_member_span = Span(fid, context.ast(fid).buffer(),
-                                                   member_init_expr->first, member_init_expr->last);
+            const Span proposed_member_span
+                = Span(context, fid, member_init_expr->first, member_init_expr->last);
 
             const SymbolId true_name = member.name;
             if (context.symbol_id(proposed_member_name_tkn) != true_name) {
@@ -1042,7 +1075,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                 continue;
             }
             // emplace the init execs
-            member_init_execs.emplace_back(context.emplace_exec(
+            member_init_execs.emplace_back(emplace_scratch_exec(
                 ExecExprStructMemberInit{
                     .field_def = member_did, .value = hopefully_exec.as_id(), .move = false},
                 proposed_member_span, true));
@@ -1051,19 +1084,19 @@ template <IsDefVisitor V> class ComptExprSolver {
             cooked = true;
             const token_t* first = init_slice.start[member_dids.len()]->first;
             const token_t* last = init_slice.start[init_slice.len - 1]->last;
-            context.emplace_diagnostic(Span(fid, context.ast(fid).buffer(), first, last),
+            context.emplace_diagnostic(Span(context, fid, first, last),
                                        diag_code::too_many_initializers_given_for_struct_init,
                                        diag_type::error);
         }
         if (cooked) {
             context.emplace_diagnostic(
-                context.def(struct_did).span, diag_code::declared_here, diag_type::note,
+                context.def(struct_did).span(context), diag_code::declared_here, diag_type::note,
                 DiagnosticIdentifierBeforeMessage{.sid_slice = sid_slice}, DiagnosticNoOtherInfo{});
             return std::nullopt;
         }
         // type check before returning here! but only if the into type isn't var!
         if (!context.type(into_tid).template holds<TypeVar>()) {
-            if (auto into_did = context.type(into_tid).template as<TypeStruct>().def_id;
+            if (auto into_did = context.type(into_tid).template as<TypeStruct>(context).def_id;
                 struct_did != into_did) {
                 context.emplace_diagnostic(
                     Span{context, fid, expr}, diag_code::cannot_convert_value_of_type,
@@ -1074,7 +1107,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                                        .gen_args_slice = {},
                                        .maybe_canon_gen_args_id = {}},
                             Span(
-                                fid, context.ast(fid).buffer(), expr->expr.struct_init.id.start[0],
+                                context, fid, expr->expr.struct_init.id.start[0],
                                 expr->expr.struct_init.id.start[expr->expr.struct_init.id.len - 1]),
                             false),
                         .to = into_tid},
@@ -1084,15 +1117,15 @@ template <IsDefVisitor V> class ComptExprSolver {
         }
 
         // all good, set the exec
-        return context.emplace_exec(
-            ExecExprStructInit{.member_inits = context.freeze_id_vec(member_init_execs),
+        return emplace_scratch_exec(
+            ExecExprStructInit{.member_inits = context.freeze_scratch_exec_ids(member_init_execs),
                                .struct_def_id = struct_did},
             Span{context, fid, expr}, true);
     }
     [[nodiscard]] OptId<ExecId> solve_compt_cast(FileId fid, ScopeId scope, ExecId eid,
                                                  const ast_expr_t* into_expr) {
         if (into_expr->type != AST_EXPR_TYPE) {
-            auto span = Span{fid, context.ast(fid).buffer(), into_expr->first, into_expr->last};
+            auto span = Span{context, fid, into_expr->first, into_expr->last};
             auto d0 = context.emplace_diagnostic(span, diag_code::invalid_cast, diag_type::error);
             auto d1 = context.emplace_diagnostic(
                 span, diag_code::parentheses_should_be_used_for_chained_casts, diag_type::note,
@@ -1119,8 +1152,8 @@ template <IsDefVisitor V> class ComptExprSolver {
                 DiagnosticTypeAfterMessage{.tid = into_tid});
             return std::nullopt;
         }
-        auto into_builtin = type.as<TypeBuiltin>().type;
-        auto from_constant = exec.as<ExecConst>();
+        auto into_builtin = type.as<TypeBuiltin>(context).type;
+        auto from_constant = exec.as<ExecConst>(context);
 
         // allow string casts by converting to symbol id
         std::optional<ExecConst> maybe_converted
@@ -1130,13 +1163,13 @@ template <IsDefVisitor V> class ComptExprSolver {
             context.emplace_diagnostic_with_message_value(
                 exec.span, diag_code::cannot_convert_expression_to_type, diag_type::error,
                 DiagnosticTypeAfterMessage{.tid = into_tid});
-            ExecConst eecc = exec.as<ExecConst>();
+            ExecConst eecc = exec.as<ExecConst>(context);
             context.emplace_diagnostic_with_message_value(
                 exec.span, diag_code::guaranteed_narrowing_of_compt_value, diag_type::note,
                 DiagnosticSymbolAfterMessage(eecc.to_symbol_id(context)));
             return std::nullopt;
         }
-        return context.emplace_exec(maybe_converted.value(), exec.span, /*compt*/ true);
+        return emplace_scratch_exec(maybe_converted.value(), exec.span, /*compt*/ true);
     }
 
     [[nodiscard]] OptId<ExecId> solve_binary_compt_exec(ExecId lhs_eid, binary_op op,
@@ -1266,8 +1299,8 @@ template <IsDefVisitor V> class ComptExprSolver {
     [[nodiscard]] OptId<ExecId> handle_binary_scalar(const Exec& lhs, binary_op op,
                                                      const Exec& rhs) {
 
-        auto lhs_val = lhs.as<ExecConst>();
-        auto rhs_val = rhs.as<ExecConst>();
+        auto lhs_val = lhs.as<ExecConst>(context);
+        auto rhs_val = rhs.as<ExecConst>(context);
 
         // converge types, if possible
         guard_try_converge_types(/* & */ lhs_val, op, /* & */ rhs_val);
@@ -1336,14 +1369,14 @@ template <IsDefVisitor V> class ComptExprSolver {
             return std::nullopt;
         }
         // all good so exec up
-        return context.emplace_exec(maybe_value.value(), Span::combine(lhs.span, rhs.span),
+        return emplace_scratch_exec(maybe_value.value(), Span::combine(lhs.span, rhs.span),
                                     /*compt*/ true);
     }
 
     [[nodiscard]] OptId<ExecId> handle_binary_bitwise(const Exec& lhs, binary_op op,
                                                       const Exec& rhs) {
-        auto lhs_val = lhs.as<ExecConst>();
-        auto rhs_val = rhs.as<ExecConst>();
+        auto lhs_val = lhs.as<ExecConst>(context);
+        auto rhs_val = rhs.as<ExecConst>(context);
 
         // converge types, if possible
         guard_try_converge_types(lhs_val, op, rhs_val);
@@ -1397,7 +1430,7 @@ template <IsDefVisitor V> class ComptExprSolver {
 
         if (maybe_value.has_value()) {
 
-            return context.emplace_exec(maybe_value.value(), Span::combine(lhs.span, rhs.span),
+            return emplace_scratch_exec(maybe_value.value(), Span::combine(lhs.span, rhs.span),
                                         /*compt*/ true);
         }
 
@@ -1406,8 +1439,8 @@ template <IsDefVisitor V> class ComptExprSolver {
 
     [[nodiscard]] OptId<ExecId> handle_binary_bool_conj_disj(const Exec& lhs, binary_op op,
                                                              const Exec& rhs) {
-        auto lhs_val = lhs.as<ExecConst>();
-        auto rhs_val = rhs.as<ExecConst>();
+        auto lhs_val = lhs.as<ExecConst>(context);
+        auto rhs_val = rhs.as<ExecConst>(context);
 
         // converge types to BOOL, if possible
 
@@ -1466,7 +1499,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             return std::nullopt;
         }
         // all good so exec up
-        return context.emplace_exec(maybe_value.value(), Span::combine(lhs.span, rhs.span),
+        return emplace_scratch_exec(maybe_value.value(), Span::combine(lhs.span, rhs.span),
                                     /*compt*/ true);
     }
     [[nodiscard]] OptId<ExecId> solve_preunary_exec(unary_op op, Span op_span, ExecId eid) {
@@ -1476,7 +1509,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             return std::nullopt;
         }
 
-        ExecConst inner_val = inner_exec.as<ExecConst>();
+        ExecConst inner_val = inner_exec.as<ExecConst>(context);
 
         // try make inner for !<expr> into a bool
         if (op == unary_op::bool_not) {
@@ -1518,7 +1551,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             return std::nullopt;
         }
         // all good so exec up
-        return context.emplace_exec(maybe_value.value(), Span::combine(op_span, inner_exec.span),
+        return emplace_scratch_exec(maybe_value.value(), Span::combine(op_span, inner_exec.span),
                                     /*compt*/ true);
     }
 
@@ -1539,7 +1572,7 @@ template <IsDefVisitor V> class ComptExprSolver {
 
         auto cond_exec = maybe_cond_exec.as_id();
 
-        auto maybe_cond_const = context.exec(cond_exec).template try_as<ExecConst>();
+        auto maybe_cond_const = context.exec(cond_exec).template try_as<ExecConst>(context);
 
         if (!maybe_cond_const.has_value()) {
             return std::nullopt;
@@ -1565,7 +1598,7 @@ template <IsDefVisitor V> class ComptExprSolver {
     [[nodiscard]] OptId<ExecId> solve_list(FileId fid, ScopeId scope, const ast_expr_t* expr,
                                            OptId<TypeId> maybe_into_tid) {
 
-        Span expr_span{fid, context.ast(fid).buffer(), expr->first, expr->last};
+        Span expr_span{context, fid, expr->first, expr->last};
 
         auto guard_exec_type = [this, fid, expr, expr_span,
                                 maybe_into_tid](OptId<ExecId> maybe_eid) -> OptId<ExecId> {
@@ -1601,7 +1634,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             auto eid = maybe_eid.as_id();
             auto exec = context.exec(eid);
             if (exec.template holds<ExecExprListLiteral>()) {
-                return context.emplace_exec(exec.value, expr_span, true);
+                return emplace_scratch_exec(exec.value(context), expr_span, true);
             }
             break;
         }
@@ -1647,7 +1680,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                                                     OptId<TypeId> maybe_into_type) {
         assert(list_expr->type == AST_EXPR_LIST_LITERAL);
 
-        Span whole_list_span{fid, context.ast(fid).buffer(), list_expr->first, list_expr->last};
+        Span whole_list_span{context, fid, list_expr->first, list_expr->last};
 
         ast_expr_list_literal_t list = list_expr->expr.list_literal;
 
@@ -1661,7 +1694,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             TypeId into_type = maybe_into_type.as_id();
             const Type& type = context.type(into_type);
             if (type.holds<TypeArr>()) {
-                auto inner_tid = type.as<TypeArr>().inner;
+                auto inner_tid = type.as<TypeArr>(context).inner;
 
                 maybe_elem_into_type = inner_tid;
             }
@@ -1669,7 +1702,7 @@ template <IsDefVisitor V> class ComptExprSolver {
 
         // guard empty
         if (list_slice.len == 0) {
-            return context.emplace_exec(ExecExprListLiteral{.elems = IdSlice<ExecId>{},
+            return emplace_scratch_exec(ExecExprListLiteral{.elems = IdSlice<ExecId>{},
                                                             .elem_type_id = maybe_elem_into_type,
                                                             .compt = true},
                                         whole_list_span, true);
@@ -1690,7 +1723,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             elem_execs.push_back(maybe_exec.as_id());
         }
 
-        IdSlice<ExecId> elem_slice = context.freeze_id_vec(elem_execs);
+        IdSlice<ExecId> elem_slice = context.freeze_scratch_exec_ids(elem_execs);
 
         OptId<TypeId> maybe_first_type = infer_type_from_exec(context.exec_id(elem_slice.begin()));
 
@@ -1753,7 +1786,7 @@ template <IsDefVisitor V> class ComptExprSolver {
         }
 
         // fine, homogeneous, so return
-        return context.emplace_exec(
+        return emplace_scratch_exec(
             ExecExprListLiteral{.elems = elem_slice, .elem_type_id = type_for_list, .compt = true},
             whole_list_span, true);
     }
@@ -1770,13 +1803,14 @@ template <IsDefVisitor V> class ComptExprSolver {
         }
         if (maybe_did.empty()) {
 
-            context.emplace_diagnostic(Span{context, fid, id_slice},
-                                       diag_code::use_of_undeclared_identifier, diag_type::error);
+            auto d0 = context.emplace_diagnostic(expr_span, diag_code::use_of_undeclared_identifier,
+                                                 diag_type::error);
+            context.suggest_name_for(d0, scope, sid_slice, expr_span);
             return std::nullopt;
         }
         auto did = maybe_did.as_id();
         const Def& def = context.def(def_visitor.visit_as_transparent(did));
-        if (def.holds<DefVariable>() && def.as<DefVariable>().compt_value.has_value()
+        if (def.holds<DefVariable>() && def.as<DefVariable>(context).compt_value.has_value()
             && def.compt) {
 
             if (!def.compt) {
@@ -1784,7 +1818,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                     expr_span, diag_code::cannot_resolve_at_compt, diag_type::error,
                     DiagnosticSubCode{.sub_code = diag_code::not_a_compile_time_constant});
                 auto d1 = context.emplace_diagnostic_with_message_value(
-                    def.span, diag_code::declared_here_without_compt, diag_type::note,
+                    def.span(context), diag_code::declared_here_without_compt, diag_type::note,
                     DiagnosticIdentifierBeforeMessage{.sid_slice = sid_slice});
                 context.link_diagnostic(d0, d1);
                 return std::nullopt;
@@ -1792,15 +1826,15 @@ template <IsDefVisitor V> class ComptExprSolver {
 
             // right thing, we good
             // (make new exec w/ same val since we need to update the span loc!)
-            auto orig_exec = context.exec(def.as<DefVariable>().compt_value.as_id());
-            return context.emplace_exec(orig_exec.value, expr_span, true);
+            auto orig_exec = context.exec(def.as<DefVariable>(context).compt_value.as_id());
+            return emplace_scratch_exec(orig_exec.value(context), expr_span, true);
         }
         // we hit a def corresponding to a function, so a compt function pointer is quite
         // helpful here.
         // TODO this doesn't consider generics
         if (def.holds<DefFunction>()) {
-            const DefFunction& func_def = def.as<DefFunction>();
-            return context.emplace_compt_exec(
+            const DefFunction& func_def = def.as<DefFunction>(context);
+            return emplace_scratch_compt_exec(
                 ExecFnPtr{.func_def_id = did,
                           .fn_ptr_tid
                           = context.emplace_type(TypeFnPtr{.param_types = func_def.param_types,
@@ -1811,7 +1845,7 @@ template <IsDefVisitor V> class ComptExprSolver {
         // TODO this doesn't consider generics
         if (def.holds<DefVariantField>()) {
 
-            const DefVariantField var_field = def.as<DefVariantField>();
+            const DefVariantField var_field = def.as<DefVariantField>(context);
 
             if (var_field.members.len() != 0) {
                 context.emplace_diagnostic_with_message_value(
@@ -1822,9 +1856,9 @@ template <IsDefVisitor V> class ComptExprSolver {
                         .got_sid = context.symbol_id(std::to_string(0))});
                 return {};
             }
-            ExecId payload = context.emplace_compt_exec(
+            ExecId payload = emplace_scratch_compt_exec(
                 ExecVariantFieldInit{.member_inits = {}, .variant_field_def_id = did}, expr_span);
-            return context.emplace_compt_exec(
+            return emplace_scratch_compt_exec(
                 ExecExprVariantInit{.payload_init = payload,
                                     .variant_def_id = def.parent.as_id(),
                                     .active_member_idx = def.member_idx},
@@ -1834,7 +1868,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             expr_span, diag_code::cannot_resolve_at_compt, diag_type::error,
             DiagnosticSubCode{.sub_code = diag_code::not_a_compile_time_constant});
         auto d1 = context.emplace_diagnostic_with_message_value(
-            def.span, diag_code::declared_here, diag_type::note,
+            def.span(context), diag_code::declared_here, diag_type::note,
             DiagnosticIdentifierBeforeMessage{.sid_slice = sid_slice});
         context.link_diagnostic(d0, d1);
         return std::nullopt;
@@ -1860,7 +1894,7 @@ template <IsDefVisitor V> class ComptExprSolver {
 
         const bool same_type_bool_val = context.equivalent_type(lhs_tid, rhs_tid);
 
-        return context.emplace_exec(ExecExprComptConstant{same_type_bool_val},
+        return emplace_scratch_exec(ExecExprComptConstant{same_type_bool_val},
                                     Span{context, fid, same_type_expr->first, same_type_expr->last},
                                     true);
     }
@@ -1877,9 +1911,9 @@ template <IsDefVisitor V> class ComptExprSolver {
 
         auto tid = maybe_tid.as_id();
 
-        SymbolId sid = context.symbol_id(type_to_string_as_mentioned(context, tid));
+        SymbolId sid = context.type_name_as_mentioned(tid);
 
-        return context.emplace_exec(ExecExprComptConstant{sid},
+        return emplace_scratch_exec(ExecExprComptConstant{sid},
                                     Span{context, fid, tts_expr->first, tts_expr->last}, true);
     }
     [[nodiscard]] OptId<ExecId> handle_static_assert(FileId fid, ScopeId scope,
@@ -1896,11 +1930,11 @@ template <IsDefVisitor V> class ComptExprSolver {
 
         const Exec& inner_exec = context.exec(maybe_eid.as_id());
 
-        if (!inner_exec.holds<ExecConst>() || !inner_exec.as<ExecConst>().holds<bool>()) {
+        if (!inner_exec.holds<ExecConst>() || !inner_exec.as<ExecConst>(context).holds<bool>()) {
             return std::nullopt; // poisoned
         }
 
-        const auto bool_val = inner_exec.as<ExecConst>().as<bool>();
+        const auto bool_val = inner_exec.as<ExecConst>(context).as<bool>();
 
         if (!bool_val) {
             context.emplace_diagnostic(
@@ -1908,7 +1942,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                 DiagnosticSubCode{.sub_code = diag_code::condition_is_false});
         }
 
-        return context.emplace_exec(ExecConst{bool_val}, Span{context, fid, sass_expr}, true);
+        return emplace_scratch_exec(ExecConst{bool_val}, Span{context, fid, sass_expr}, true);
     }
     [[nodiscard]] OptId<ExecId> solve_expr_binary(FileId fid, ScopeId scope,
                                                   const ast_expr_t* expr) {
@@ -1981,7 +2015,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                 }
             }
 
-            if (lhs_exec.holds<ExecConst>() && lhs_exec.as<ExecConst>().holds<SymbolId>()
+            if (lhs_exec.holds<ExecConst>() && lhs_exec.as<ExecConst>(context).holds<SymbolId>()
                 && rhs->type == AST_EXPR_ID) {
                 const auto id_slice = rhs->expr.id.slice;
                 if (matches_len_builtin(id_slice)) {
@@ -1993,7 +2027,8 @@ template <IsDefVisitor V> class ComptExprSolver {
             // [1, 2, 3].len() => should be just `len`
             // "123123123".len() => should be just `len`
             if (((lhs_exec.holds<ExecExprListLiteral>())
-                 || (lhs_exec.holds<ExecConst>() && lhs_exec.as<ExecConst>().holds<SymbolId>()))
+                 || (lhs_exec.holds<ExecConst>()
+                     && lhs_exec.as<ExecConst>(context).holds<SymbolId>()))
                 && rhs->type == AST_EXPR_FN_CALL
                 && rhs->expr.fn_call.left_expr->type == AST_EXPR_ID) {
                 const auto id_slice = rhs->expr.fn_call.left_expr->expr.id.slice;
@@ -2016,7 +2051,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             if (lhs_exec.holds<ExecExprUnionInit>()) {
                 {
                     const Def& union_def = context.def(def_visitor.visit_as_transparent(
-                        lhs_exec.as<ExecExprUnionInit>().union_def_id));
+                        lhs_exec.as<ExecExprUnionInit>(context).union_def_id));
                     assert(union_def.holds<DefUnion>());
                 }
                 token_ptr_slice_t id_slice = rhs_expr->expr.id.slice;
@@ -2026,31 +2061,33 @@ template <IsDefVisitor V> class ComptExprSolver {
                 }
 
                 auto maybe_mem_var = context.look_up_variable(
-                    context.def(lhs_exec.as<ExecExprUnionInit>().union_def_id)
-                        .template as<DefUnion>()
+                    context.def(lhs_exec.as<ExecExprUnionInit>(context).union_def_id)
+                        .template as<DefUnion>(context)
                         .scope,
                     context.symbol_id(id_slice.start[0]));
 
                 if (maybe_mem_var.empty()) {
                     const Def& union_def
-                        = context.def(lhs_exec.as<ExecExprUnionInit>().union_def_id);
+                        = context.def(lhs_exec.as<ExecExprUnionInit>(context).union_def_id);
                     Span spn{context, fid, id_slice};
                     auto d0 = context.emplace_diagnostic_with_message_value(
                         spn, diag_code::does_not_name_a_field_of_union, diag_type::error,
                         DiagnosticSymbolAfterMessage{.sid = union_def.name});
                     auto d1 = context.emplace_diagnostic_with_message_value(
-                        union_def.span, diag_code::declared_here, diag_type::note,
+                        union_def.span(context), diag_code::declared_here, diag_type::note,
                         DiagnosticSymbolBeforeMessage{.sid = union_def.name});
                     context.link_diagnostic(d0, d1);
                     return {};
                 }
 
-                const Def& union_def = context.def(lhs_exec.as<ExecExprUnionInit>().union_def_id);
+                const Def& union_def
+                    = context.def(lhs_exec.as<ExecExprUnionInit>(context).union_def_id);
                 const Def& var_def = context.def(maybe_mem_var.as_id());
-                if (var_def.member_idx != lhs_exec.as<ExecExprUnionInit>().active_member_idx) {
+                if (var_def.member_idx
+                    != lhs_exec.as<ExecExprUnionInit>(context).active_member_idx) {
                     const Def& curr_member
-                        = context.def(union_def.as<DefUnion>().ordered_members.get(
-                            lhs_exec.as<ExecExprUnionInit>().active_member_idx));
+                        = context.def(union_def.as<DefUnion>(context).ordered_members.get(
+                            lhs_exec.as<ExecExprUnionInit>(context).active_member_idx));
                     DiagLinker dlinker{context};
                     dlinker.link(context.emplace_diagnostic_with_message_value(
                         Span{context, fid, id_slice}, diag_code::compt_union_does_not_hold_field,
@@ -2059,12 +2096,13 @@ template <IsDefVisitor V> class ComptExprSolver {
                         Span{context, fid, id_slice}, diag_code::compt_union_holds_field,
                         diag_type::note, DiagnosticSymbolAfterMessage{curr_member.name}));
                     dlinker.link(context.emplace_diagnostic_with_message_value(
-                        union_def.span, diag_code::declared_here, diag_type::note,
+                        union_def.span(context), diag_code::declared_here, diag_type::note,
                         DiagnosticSymbolBeforeMessage{.sid = union_def.name}));
                     return {};
                 }
 
-                const Exec& mem_exec = context.exec(lhs_exec.as<ExecExprUnionInit>().member_init);
+                const Exec& mem_exec
+                    = context.exec(lhs_exec.as<ExecExprUnionInit>(context).member_init);
 
                 if (!exec_is_compt_viable(mem_exec)) {
 
@@ -2073,7 +2111,8 @@ template <IsDefVisitor V> class ComptExprSolver {
                                                diag_type::error);
                     return std::nullopt;
                 }
-                return context.emplace_exec(mem_exec.value, Span{context, fid, expr}, true);
+                return emplace_scratch_exec(mem_exec.value(context), Span{context, fid, expr},
+                                            true);
             }
 
             if (!lhs_exec.holds<ExecExprStructInit>()) {
@@ -2086,7 +2125,8 @@ template <IsDefVisitor V> class ComptExprSolver {
                 context.link_diagnostic(d0, d1);
                 return std::nullopt;
             }
-            const Def& struct_def = context.def(lhs_exec.as<ExecExprStructInit>().struct_def_id);
+            const Def& struct_def
+                = context.def(lhs_exec.as<ExecExprStructInit>(context).struct_def_id);
 
             if (rhs_expr->type == AST_EXPR_ID) {
                 assert(struct_def.holds<DefStruct>());
@@ -2106,10 +2146,10 @@ template <IsDefVisitor V> class ComptExprSolver {
                 const Def& var_def = context.def(maybe_mem_var.as_id());
 
                 const Exec& mem_exec = context.exec(
-                    lhs_exec.as<ExecExprStructInit>().member_inits.get(var_def.member_idx));
+                    lhs_exec.as<ExecExprStructInit>(context).member_inits.get(var_def.member_idx));
 
                 const Exec& mem_exec_val
-                    = context.exec(mem_exec.as<ExecExprStructMemberInit>().value);
+                    = context.exec(mem_exec.as<ExecExprStructMemberInit>(context).value);
 
                 if (!exec_is_compt_viable(mem_exec_val)) {
 
@@ -2118,7 +2158,8 @@ template <IsDefVisitor V> class ComptExprSolver {
                                                diag_type::error);
                     return std::nullopt;
                 }
-                return context.emplace_exec(mem_exec_val.value, Span{context, fid, expr}, true);
+                return emplace_scratch_exec(mem_exec_val.value(context), Span{context, fid, expr},
+                                            true);
             }
             if (rhs_expr->type == AST_EXPR_FN_CALL) {
                 return solve_fn_call(fid, scope, rhs_expr, lhs_eid);
@@ -2139,17 +2180,18 @@ template <IsDefVisitor V> class ComptExprSolver {
                 const Exec& lhs_exec = context.exec(lhs.as_id());
                 if (lhs_exec.holds<ExecConst>() && lhs_exec.holds<ExecConst>()) {
                     const std::optional<ExecConst> econst
-                        = lhs_exec.as<ExecConst>().try_safe_convert_to(builtin_type::boolean);
+                        = lhs_exec.as<ExecConst>(context).try_safe_convert_to(
+                            builtin_type::boolean);
                     if (econst.has_value()) {
                         const bool bval = econst.value().as<bool>();
                         // false && ____ => always false
                         if ((op == binary_op::bool_and) && !bval) {
-                            return context.emplace_compt_exec(ExecConst{false},
+                            return emplace_scratch_compt_exec(ExecConst{false},
                                                               Span{context, fid, expr});
                         }
                         // true || ____ => always true
                         if ((op == binary_op::bool_or) && bval) {
-                            return context.emplace_compt_exec(ExecConst{false},
+                            return emplace_scratch_compt_exec(ExecConst{false},
                                                               Span{context, fid, expr});
                         }
                     }
@@ -2178,7 +2220,21 @@ template <IsDefVisitor V> class ComptExprSolver {
         defined = context.defined(scope, context.symbol_slice(id_slice), span,
                                   expr->expr.defined.member);
 
-        return context.emplace_exec(ExecConst{defined}, span, true);
+        return emplace_scratch_exec(ExecConst{defined}, span, true);
+    }
+    /// flattens a call's args into a key for Context::memoized_compt_call, two words (constant
+    /// kind, bits) per arg, false if any arg isn't a builtin constant since aggregates aren't
+    /// worth hashing deeply
+    [[nodiscard]] bool canonical_compt_args(const llvm::SmallVectorImpl<ExecId>& args,
+                                            llvm::SmallVectorImpl<uint64_t>& key) {
+        for (const ExecId arg : args) {
+            const Exec& exec = context.exec(arg);
+            if (!exec.holds<ExecConst>()) {
+                return false;
+            }
+            append_compt_memo_key(exec.as<ExecConst>(context).value, key);
+        }
+        return true;
     }
     [[nodiscard]] bool exec_is_compt_viable(const Exec& exec) {
         return exec.holds_any_of<ExecConst, ExecExprStructInit, ExecExprListLiteral,
@@ -2216,8 +2272,8 @@ template <IsDefVisitor V> class ComptExprSolver {
             const Span fn_name_span{context, fid, id_tok};
 
             maybe_func_did = context.look_up_member_function_guarding_hid(
-                context.def(exec.as<ExecExprStructInit>().struct_def_id), func_name, fn_name_span,
-                scope);
+                context.def(exec.as<ExecExprStructInit>(context).struct_def_id), func_name,
+                fn_name_span, scope);
             if (maybe_func_did.empty()) {
                 return std::nullopt;
             }
@@ -2225,7 +2281,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             const Def& func_def = context.def(func_did);
             assert(func_def.holds<DefFunction>());
 
-            func = func_def.as<DefFunction>();
+            func = func_def.as<DefFunction>(context);
 
             if (!func.takes_self) {
                 auto d0 = context.emplace_diagnostic(Span{context, fid, called},
@@ -2247,7 +2303,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                 return std::nullopt;
             }
 
-            func_span = func_def.span;
+            func_span = func_def.span(context);
             func_symbol = func_def.name;
         } else {
             const ast_expr_t* called = expr->expr.fn_call.left_expr;
@@ -2273,8 +2329,9 @@ template <IsDefVisitor V> class ComptExprSolver {
                 }
 
                 // no corresponding variant either, so this is just the use_of_undeclared_identifier
-                context.emplace_diagnostic(called_span, diag_code::use_of_undeclared_identifier,
-                                           diag_type::error);
+                auto d0 = context.emplace_diagnostic(
+                    called_span, diag_code::use_of_undeclared_identifier, diag_type::error);
+                context.suggest_name_for(d0, scope, sid_slice, called_span);
 
                 return std::nullopt;
             }
@@ -2289,8 +2346,8 @@ template <IsDefVisitor V> class ComptExprSolver {
                     DiagnosticSubCode{.sub_code = diag_code::not_a_function});
                 return std::nullopt;
             }
-            func = called_def.as<DefFunction>();
-            func_span = called_def.span;
+            func = called_def.as<DefFunction>(context);
+            func_span = called_def.span(context);
             func_symbol = called_def.name;
         }
 
@@ -2307,11 +2364,12 @@ template <IsDefVisitor V> class ComptExprSolver {
 
             const auto param_index = i + mt_param_adjustment;
 
-            OptId<TypeId> maybe_into_tid = (param_index < params.len())
-                                               ? OptId<TypeId>{context.def(params.get(param_index))
-                                                                   .template as<DefVariable>()
-                                                                   .type_id}
-                                               : std::nullopt;
+            OptId<TypeId> maybe_into_tid
+                = (param_index < params.len())
+                      ? OptId<TypeId>{context.def(params.get(param_index))
+                                          .template as<DefVariable>(context)
+                                          .type_id}
+                      : std::nullopt;
 
             OptId<ExecId> maybe_arg_eid = solve_expr(fid, scope, arg, maybe_into_tid);
             if (maybe_arg_eid.empty()) {
@@ -2363,13 +2421,51 @@ template <IsDefVisitor V> class ComptExprSolver {
             return std::nullopt; // just in case
         }
 
-        if (context.def(func_did).template as<DefFunction>().posioned) {
+        if (context.def(func_did).template as<DefFunction>(context).posioned) {
             return std::nullopt; // already posioned so don't even try it
         }
 
-        // mark that we're starting another call
-        enter_compt_fn();
-        if (call_depth > MAX_COMPT_CALL_FRAMES) {
+        // a pure compt fn's result only depends on its args, so a repeat call is a look up
+        llvm::SmallVector<uint64_t, 8> memo_key;
+        const bool memoizable
+            = fn_stmt->stmt.fn_decl.only_expr && canonical_compt_args(arg_vec, memo_key);
+        if (memoizable) {
+            if (auto memo = context.memoized_compt_call(func_did, memo_key); memo.has_value()) {
+                if (memo->poisoned()) {
+                    return std::nullopt; // its errors have already been reported
+                }
+                if (memo->value.has_value()) {
+                    return emplace_scratch_exec(memo->value.value(), Span{context, fid, expr},
+                                                true);
+                }
+                return emplace_scratch_exec(context.exec(memo->exec.as_id()).value(context),
+                                            Span{context, fid, expr}, true);
+            }
+        }
+
+        if (call_depth == 0) {
+            vm_bailed = false;
+        }
+        if (memoizable && !vm_bailed && !context.has_flag(CLI_FLAG_NO_COMPT_VM)) {
+            llvm::SmallVector<ExecConst, 8> args;
+            for (const ExecId arg : arg_vec) {
+                args.push_back(context.exec(arg).as<ExecConst>(context));
+            }
+            // the vm memoizes the call itself
+            const auto value = vm.call(func_did, args, context.compt_stack_bytes());
+            if (value.has_value()) {
+                return emplace_scratch_exec(value.value(), Span{context, fid, expr}, true);
+            }
+            if (vm.overflow().has_value()) {
+                // rerunning on the tree-walker would only overflow the C++ stack sooner
+                report_vm_overflow(fid, expr, func_did, vm.overflow().value());
+                context.memoize_compt_call(func_did, memo_key, OptId<ExecId>{});
+                return std::nullopt;
+            }
+            vm_bailed = true; // the tree-walker reports whatever went wrong
+        }
+
+        auto report_overflow = [&]() {
             auto d0 = context.emplace_diagnostic_with_message_value(
                 Span{context, fid, expr}, diag_code::only_message_value_is_meaningful,
                 diag_type::error, DiagnosticComptStackOverflow{.function_sid = func_symbol});
@@ -2379,73 +2475,107 @@ template <IsDefVisitor V> class ComptExprSolver {
 
             context.link_diagnostic(d0, d1);
 
-            // poison before exit to prevent cascading diags
-            context.def(func_did).template as<DefFunction>().poison_infinite_recursion();
+            // poison to prevent cascading diags
+            context.def(func_did).template as<DefFunction>(context).poison_infinite_recursion();
+        };
 
-            exit_compt_fn();
+        auto walk = [&]() -> OptId<ExecId> {
+            // mark that we're starting another call
+            enter_compt_fn();
+            if (!context.compt_stack().has_room()) {
+                report_overflow();
+                exit_compt_fn();
+                return std::nullopt;
+            }
 
-            return std::nullopt;
-        }
+            ScopeId temp_scope = context.make_compt_func_temp_scope(
+                context.containing_scope(func_did), params.len());
 
-        ScopeId temp_scope
-            = context.make_compt_func_temp_scope(context.containing_scope(func_did), params.len());
+            for (HirSize i = 0; i < params.len(); i++) {
+                const Def& param_def = context.def(params.get(i));
+                assert(param_def.holds<DefVariable>());
+                const DefVariable& param_var = param_def.as<DefVariable>(context);
+                ExecId eid = arg_vec[i];
+                const auto param = context.make_compt_param_def(
+                    param_def.name, param_def.span(context), func_did,
+                    DefVariable{.type_id = param_var.type_id, .compt_value = eid});
+                context.insert_compt_param(temp_scope, context.def(params.get(i)).name, param);
+            }
 
-        for (HirSize i = 0; i < params.len(); i++) {
-            const Def& param_def = context.def(params.get(i));
-            assert(param_def.holds<DefVariable>());
-            const DefVariable& param_var = param_def.as<DefVariable>();
-            ExecId eid = arg_vec[i];
-            const auto param = context.register_compt_def(
-                param_def.name, param_def.span, func_did,
-                DefVariable{.type_id = param_var.type_id, .compt_value = eid});
-            context.insert_variable(temp_scope, context.def(params.get(i)).name, param);
-        }
+            if (!fn_stmt->stmt.fn_decl.only_expr) {
+                auto d0 = context.emplace_diagnostic(
+                    Span{context, fid, expr}, diag_code::cannot_evaluate_non_pure_expr_fn_at_compt,
+                    diag_type::error);
+                auto d1 = context.emplace_diagnostic_with_message_value(
+                    func_span, diag_code::declared_here, diag_type::note,
+                    DiagnosticSymbolBeforeMessage{.sid = func_symbol});
+                context.link_diagnostic(d0, d1);
+                if (context.def(func_did).compt) {
+                    auto d2 = context.emplace_diagnostic_with_message_value(
+                        func_span,
+                        diag_code::declare_using_pure_expression_syntax_replacing_body_with,
+                        diag_type::help,
+                        DiagnosticSymbolAfterMessage{
+                            .sid = context.symbol_id<"=> (Expression)">()});
+                    context.link_diagnostic(d1, d2);
+                }
+                context.def(func_did).template as<DefFunction>(context).poison();
+                context.release_compt_func_temp_scope(temp_scope);
+                exit_compt_fn();
+                return std::nullopt;
+            }
 
-        if (!fn_stmt->stmt.fn_decl.only_expr) {
-            auto d0 = context.emplace_diagnostic(
-                Span{context, fid, expr}, diag_code::cannot_evaluate_non_pure_expr_fn_at_compt,
-                diag_type::error);
-            auto d1 = context.emplace_diagnostic_with_message_value(
-                func_span, diag_code::declared_here, diag_type::note,
-                DiagnosticSymbolBeforeMessage{.sid = func_symbol});
-            context.link_diagnostic(d0, d1);
-            if (context.def(func_did).compt) {
-                auto d2 = context.emplace_diagnostic_with_message_value(
-                    func_span, diag_code::declare_using_pure_expression_syntax_replacing_body_with,
-                    diag_type::help,
-                    DiagnosticSymbolAfterMessage{.sid = context.symbol_id<"=> (Expression)">()});
-                context.link_diagnostic(d1, d2);
+            const ast_expr_t* body_expr = fn_stmt->stmt.fn_decl.expr;
+
+            OptId<ExecId> maybe_eid = solve_expr(fid, temp_scope, body_expr, func.return_type);
+            // nothing outlives the call that names its params, so the scope is free for the next
+            context.release_compt_func_temp_scope(temp_scope);
+
+            // try to get proper return type if possible
+            if (maybe_eid.has_value() && func.return_type.has_value()) {
+                maybe_eid = try_convert_to(maybe_eid.as_id(), func.return_type.as_id());
             }
-            context.def(func_did).template as<DefFunction>().poison();
+
+            // mark that we're done
             exit_compt_fn();
-            return std::nullopt;
-        }
 
-        const ast_expr_t* body_expr = fn_stmt->stmt.fn_decl.expr;
+            if (memoizable) {
+                if (maybe_eid.has_value() && context.exec(maybe_eid.as_id()).holds<ExecConst>()) {
+                    context.memoize_compt_call(
+                        func_did, memo_key,
+                        context.exec(maybe_eid.as_id()).template as<ExecConst>(context));
+                } else {
+                    context.memoize_compt_call(func_did, memo_key,
+                                               context.promote_scratch_exec(maybe_eid));
+                }
+            }
 
-        OptId<ExecId> maybe_eid = solve_expr(fid, temp_scope, body_expr, func.return_type);
+            const bool poisoned = context.def(func_did).template as<DefFunction>(context).posioned;
+            if (!poisoned && maybe_eid.empty()) {
+                context.emplace_diagnostic_with_message_value(
+                    Span{context, fid, expr}, diag_code::called_here, diag_type::note,
+                    DiagnosticSymbolBeforeMessage{.sid = func_symbol});
+                return std::nullopt;
+            }
 
-        // try to get proper return type if possible
-        if (maybe_eid.has_value() && func.return_type.has_value()) {
-            maybe_eid = try_convert_to(maybe_eid.as_id(), func.return_type.as_id());
-        }
+            if (maybe_eid.empty()) {
+                return std::nullopt;
+            }
 
-        // mark that we're done
-        exit_compt_fn();
+            return emplace_scratch_exec(context.exec(maybe_eid.as_id()).value(context),
+                                        Span{context, fid, expr}, true);
+        };
 
-        if (!context.def(func_did).template as<DefFunction>().posioned && maybe_eid.empty()) {
-            context.emplace_diagnostic_with_message_value(
-                Span{context, fid, expr}, diag_code::called_here, diag_type::note,
-                DiagnosticSymbolBeforeMessage{.sid = func_symbol});
-            return std::nullopt;
+        // the walk recurses on the C++ stack, so the outermost walked call moves onto a stack
+        // --compt-stack's bytes bound (see ComptStack) and every nested one just checks it
+        if (context.compt_stack().active()) {
+            return walk();
         }
-
-        if (maybe_eid.empty()) {
-            return std::nullopt;
+        OptId<ExecId> result;
+        if (!context.compt_stack().run(context.compt_stack_bytes(), [&] { result = walk(); })) {
+            report_overflow(); // not even one frame's worth could be had
         }
-
-        return context.emplace_exec(context.exec(maybe_eid.as_id()).value, Span{context, fid, expr},
-                                    true);
+        return result;
     }
 
     [[nodiscard]] OptId<ExecId> try_convert_to(ExecId eid, TypeId tid) {
@@ -2464,11 +2594,12 @@ template <IsDefVisitor V> class ComptExprSolver {
         if (!type.holds<TypeBuiltin>()) {
             return std::nullopt;
         }
-        auto conv = exec.as<ExecConst>().try_safe_convert_to(type.as<TypeBuiltin>().type);
+        auto conv = exec.as<ExecConst>(context).try_safe_convert_to(
+            type.as<TypeBuiltin>(context).type);
         if (!conv.has_value()) {
             return std::nullopt;
         }
-        return context.emplace_exec(ExecConst{conv.value()}, exec.span, exec.compt);
+        return emplace_scratch_exec(ExecConst{conv.value()}, exec.span, exec.compt);
     }
     [[nodiscard]] OptId<ExecId> solve_expr_borrow(FileId fid, ScopeId scope, const ast_expr_t* expr,
                                                   OptId<TypeId> maybe_into_tid) {
@@ -2497,7 +2628,7 @@ template <IsDefVisitor V> class ComptExprSolver {
         const Exec& ordered_exec = context.exec(maybe_lhs_eid.as_id());
 
         if (ordered_exec.holds<ExecExprListLiteral>()) {
-            ExecExprListLiteral list = ordered_exec.as<ExecExprListLiteral>();
+            ExecExprListLiteral list = ordered_exec.as<ExecExprListLiteral>(context);
             OptId<ExecId> maybe_idx
                 = solve_expr(fid, scope, expr->expr.subscript.subexpr,
                              context.emplace_type(TypeBuiltin{.type = builtin_type::usize},
@@ -2507,7 +2638,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             }
             const auto idx_eid = maybe_idx.as_id();
             const Exec& idx_exec = context.exec(idx_eid);
-            const usize idx = idx_exec.as<ExecConst>().as<usize>();
+            const usize idx = idx_exec.as<ExecConst>(context).as<usize>();
 
             if (idx >= list.len()) {
                 context.emplace_diagnostic_with_message_value(
@@ -2519,10 +2650,11 @@ template <IsDefVisitor V> class ComptExprSolver {
                 return std::nullopt;
             }
             const Exec& exec = context.exec(list.elems.get(idx));
-            return context.emplace_exec(exec.value, Span{context, fid, expr}, true);
+            return emplace_scratch_exec(exec.value(context), Span{context, fid, expr}, true);
         }
-        if (ordered_exec.holds<ExecConst>() && ordered_exec.as<ExecConst>().holds<SymbolId>()) {
-            SymbolId sid = ordered_exec.as<ExecConst>().as<SymbolId>();
+        if (ordered_exec.holds<ExecConst>()
+            && ordered_exec.as<ExecConst>(context).holds<SymbolId>()) {
+            SymbolId sid = ordered_exec.as<ExecConst>(context).as<SymbolId>();
             OptId<ExecId> maybe_idx
                 = solve_expr(fid, scope, expr->expr.subscript.subexpr,
                              context.emplace_type(TypeBuiltin{.type = builtin_type::usize},
@@ -2532,7 +2664,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             }
             const auto idx_eid = maybe_idx.as_id();
             const Exec& idx_exec = context.exec(idx_eid);
-            const usize idx = idx_exec.as<ExecConst>().as<usize>();
+            const usize idx = idx_exec.as<ExecConst>(context).as<usize>();
 
             const std::string_view sv = context.symbol(sid);
 
@@ -2545,7 +2677,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                                              = context.symbol_id(std::to_string(sv.size()))});
                 return std::nullopt;
             }
-            return context.emplace_exec(ExecConst{sv.at(idx)}, Span{context, fid, expr}, true);
+            return emplace_scratch_exec(ExecConst{sv.at(idx)}, Span{context, fid, expr}, true);
         }
 
         OptId<TypeId> maybe_tid = infer_type_from_exec(lhs_eid);
@@ -2560,13 +2692,13 @@ template <IsDefVisitor V> class ComptExprSolver {
     }
     [[nodiscard]] OptId<ExecId> solve_list_len(const Exec& list_exec, Span len_span) {
         assert(list_exec.holds<ExecExprListLiteral>());
-        return context.emplace_exec(ExecConst{list_exec.as<ExecExprListLiteral>().len()},
+        return emplace_scratch_exec(ExecConst{list_exec.as<ExecExprListLiteral>(context).len()},
                                     Span::combine(list_exec.span, len_span), true);
     }
     [[nodiscard]] OptId<ExecId> solve_str_len(const Exec& str_exec, Span len_span) {
-        assert(str_exec.holds<ExecConst>() && str_exec.as<ExecConst>().holds<SymbolId>());
-        return context.emplace_exec(
-            ExecConst{context.symbol(str_exec.as<ExecConst>().as<SymbolId>()).size()},
+        assert(str_exec.holds<ExecConst>() && str_exec.as<ExecConst>(context).holds<SymbolId>());
+        return emplace_scratch_exec(
+            ExecConst{context.symbol(str_exec.as<ExecConst>(context).as<SymbolId>()).size()},
             Span::combine(str_exec.span, len_span), true);
     }
     // two Execs holding ExecExprListLiteral and a binary op holding bool_equal or
@@ -2575,13 +2707,13 @@ template <IsDefVisitor V> class ComptExprSolver {
                                               binary_op eq_neq) {
         assert(list1.holds_same<ExecExprListLiteral>(list2));
         assert(bin_op_is_eq_neq(eq_neq));
-        ExecExprListLiteral l1 = list1.as<ExecExprListLiteral>();
-        ExecExprListLiteral l2 = list2.as<ExecExprListLiteral>();
+        ExecExprListLiteral l1 = list1.as<ExecExprListLiteral>(context);
+        ExecExprListLiteral l2 = list2.as<ExecExprListLiteral>(context);
 
         // decides true/false for == and != based on equality
         auto emplace_val_based_on_eq = [this, eq_neq, &list1, &list2](const bool eq) {
             const bool cond = (eq_neq == binary_op::bool_equal) ? eq : !eq;
-            return context.emplace_compt_exec(ExecConst{cond},
+            return emplace_scratch_compt_exec(ExecConst{cond},
                                               Span::combine(list1.span, list2.span));
         };
 
@@ -2610,8 +2742,8 @@ template <IsDefVisitor V> class ComptExprSolver {
                 return std::nullopt;
             }
             const Exec& exec = context.exec(eid.as_id());
-            assert(exec.holds<ExecConst>() && exec.as<ExecConst>().holds<bool>());
-            const bool eq = exec.as<ExecConst>().as<bool>();
+            assert(exec.holds<ExecConst>() && exec.as<ExecConst>(context).holds<bool>());
+            const bool eq = exec.as<ExecConst>(context).as<bool>();
             if (!eq) {
                 return emplace_val_based_on_eq(false);
             }
@@ -2624,13 +2756,13 @@ template <IsDefVisitor V> class ComptExprSolver {
                                                 binary_op eq_neq) {
         assert(list1.holds_same<ExecExprStructInit>(list2));
         assert(bin_op_is_eq_neq(eq_neq));
-        ExecExprStructInit s1 = list1.as<ExecExprStructInit>();
-        ExecExprStructInit s2 = list2.as<ExecExprStructInit>();
+        ExecExprStructInit s1 = list1.as<ExecExprStructInit>(context);
+        ExecExprStructInit s2 = list2.as<ExecExprStructInit>(context);
 
         // decides true/false for == and != based on equality
         auto emplace_val_based_on_eq = [this, eq_neq, &list1, &list2](const bool eq) {
             const bool cond = (eq_neq == binary_op::bool_equal) ? eq : !eq;
-            return context.emplace_compt_exec(ExecConst{cond},
+            return emplace_scratch_compt_exec(ExecConst{cond},
                                               Span::combine(list1.span, list2.span));
         };
 
@@ -2661,18 +2793,18 @@ template <IsDefVisitor V> class ComptExprSolver {
         }
         for (HirSize i = 0; i < s1.member_inits.len(); i++) {
             const auto e1 = context.exec(s1.member_inits.get(i))
-                                .template as<ExecExprStructMemberInit>()
+                                .template as<ExecExprStructMemberInit>(context)
                                 .value;
             const auto e2 = context.exec(s2.member_inits.get(i))
-                                .template as<ExecExprStructMemberInit>()
+                                .template as<ExecExprStructMemberInit>(context)
                                 .value;
             const OptId<ExecId> eid = solve_binary_compt_exec(e1, binary_op::bool_equal, e2);
             if (eid.empty()) {
                 return std::nullopt;
             }
             const Exec& exec = context.exec(eid.as_id());
-            assert(exec.holds<ExecConst>() && exec.as<ExecConst>().holds<bool>());
-            const bool eq = exec.as<ExecConst>().as<bool>();
+            assert(exec.holds<ExecConst>() && exec.as<ExecConst>(context).holds<bool>());
+            const bool eq = exec.as<ExecConst>(context).as<bool>();
             if (!eq) {
                 return emplace_val_based_on_eq(false);
             }
@@ -2727,7 +2859,7 @@ template <IsDefVisitor V> class ComptExprSolver {
             return std::nullopt;
         }
 
-        return context.emplace_exec(ExecConst{context.type_has_contract(tid, did)}, span, true);
+        return emplace_scratch_exec(ExecConst{context.type_has_contract(tid, did)}, span, true);
     }
 
     // TODO: doesn't handle generic args
@@ -2743,7 +2875,7 @@ template <IsDefVisitor V> class ComptExprSolver {
                                        DiagnosticSubCode{.sub_code = diag_code::not_a_function});
             return {};
         }
-        DefVariantField var_field_def = def.as<DefVariantField>();
+        DefVariantField var_field_def = def.as<DefVariantField>(context);
         const ast_slice_of_exprs_t args = fn_call_expr->expr.fn_call.args;
         if (args.len != var_field_def.members.len()) {
             const auto d0 = context.emplace_diagnostic_with_message_value(
@@ -2754,7 +2886,8 @@ template <IsDefVisitor V> class ComptExprSolver {
                     .expected_sid = context.symbol_id(std::to_string(var_field_def.members.len())),
                     .got_sid = context.symbol_id(std::to_string(args.len))});
             const auto d1 = context.emplace_diagnostic_with_message_value(
-                context.def(variant_field_did).span, diag_code::declared_here, diag_type::note,
+                context.def(variant_field_did).span(context), diag_code::declared_here,
+                diag_type::note,
                 DiagnosticSymbolBeforeMessage{.sid = context.def(variant_field_did).name});
             context.link_diagnostic(d0, d1);
             return {};
@@ -2763,7 +2896,7 @@ template <IsDefVisitor V> class ComptExprSolver {
         llvm::SmallVector<ExecId> member_init_vec;
         for (size_t i = 0; i < args.len; i++) {
             const ast_expr_t* arg = args.start[i];
-            TypeId tid = context.def(var_field_def.members.get(i)).as<DefVariable>().type_id;
+            TypeId tid = context.def(var_field_def.members.get(i)).as<DefVariable>(context).type_id;
             OptId<ExecId> maybe_eid = solve_expr(fid, scope, arg, tid);
             if (maybe_eid.empty()) {
                 cooked = true;
@@ -2774,17 +2907,17 @@ template <IsDefVisitor V> class ComptExprSolver {
         if (cooked) {
             const Def& def = context.def(variant_field_did);
             context.force_link_diagnostic(context.emplace_diagnostic_with_message_value(
-                def.span, diag_code::declared_here, diag_type::note,
+                def.span(context), diag_code::declared_here, diag_type::note,
                 DiagnosticSymbolBeforeMessage{.sid = def.name}));
         }
-        const auto member_inits = context.freeze_id_vec(member_init_vec);
+        const auto member_inits = context.freeze_scratch_exec_ids(member_init_vec);
         const Span span{context, fid, fn_call_expr};
-        ExecId field_init = context.emplace_compt_exec(
+        ExecId field_init = emplace_scratch_compt_exec(
             ExecVariantFieldInit{.member_inits = member_inits,
                                  .variant_field_def_id = variant_field_did},
             span);
 
-        return context.emplace_compt_exec(
+        return emplace_scratch_compt_exec(
             ExecExprVariantInit{.payload_init = field_init,
                                 .variant_def_id = context.def(variant_field_did).parent.as_id(),
                                 .active_member_idx = context.def(variant_field_did).member_idx},
@@ -2801,9 +2934,9 @@ template <IsDefVisitor V> class ComptExprSolver {
                                        DiagnosticSubCode{.sub_code = diag_code::not_a_variant});
             return {};
         }
-        const ExecExprVariantInit var_init = exec.as<ExecExprVariantInit>();
+        const ExecExprVariantInit var_init = exec.as<ExecExprVariantInit>(context);
         const auto ordered_variant_fields
-            = context.def(var_init.variant_def_id).as<DefVariant>().ordered_members;
+            = context.def(var_init.variant_def_id).as<DefVariant>(context).ordered_members;
         if (pattern_expr->type != AST_EXPR_VARIANT_DECOMP) {
             return {}; // poisoned
         }
@@ -2846,7 +2979,7 @@ template <IsDefVisitor V> class ComptExprSolver {
         const auto active_member
             = context.def_id(ordered_variant_fields.get(var_init.active_member_idx));
 
-        return context.emplace_compt_exec(
+        return emplace_scratch_compt_exec(
             ExecConst{active_member == hopefully_var_field},
             Span::combine(context.exec(eid).span, Span{context, fid, pattern_expr}));
     }
@@ -2871,7 +3004,7 @@ template <IsDefVisitor V> class ComptExprSolver {
 
         bool valid_branches_and_exhaustive = false;
         if (ty.holds<TypeVariant>()) {
-            const auto variant_did = ty.as<TypeVariant>().def_id;
+            const auto variant_did = ty.as<TypeVariant>(context).def_id;
             valid_branches_and_exhaustive
                 = valid_exhaustive_match_for_variant(*this, scope, fid, variant_did, match_expr);
         }
@@ -0,0 +1,62 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#include "compiler/hir/compt_stack.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+
+namespace hir {
+
+namespace {
+
+/// roughly the stack pointer of the caller, stacks grow down on every supported target
+[[gnu::noinline]] uintptr_t stack_position() {
+    volatile char probe = 0;
+    return reinterpret_cast<uintptr_t>(&probe);
+}
+
+} // namespace
+
+size_t ComptStack::used_bytes() const noexcept {
+    assert(active());
+    return base - stack_position();
+}
+
+bool ComptStack::run_erased(size_t limit_bytes, void (*fn)(void*), void* data) {
+    assert(!active());
+    // stack sizes must be page multiples, and 64 KiB is one for every page size in use
+    constexpr size_t GRANULE = size_t{64} << 10;
+    const size_t stack_bytes = (limit_bytes + RED_ZONE_BYTES + GRANULE - 1) / GRANULE * GRANULE;
+    pthread_attr_t attr;
+    if (pthread_attr_init(&attr) != 0) {
+        return false;
+    }
+    limit = limit_bytes;
+    Task task{.stack = this, .fn = fn, .data = data};
+    pthread_t thread;
+    const bool made = pthread_attr_setstacksize(&attr, stack_bytes) == 0
+                      && pthread_create(&thread, &attr, &ComptStack::run_task, &task) == 0;
+    pthread_attr_destroy(&attr);
+    if (!made) {
+        return false;
+    }
+    pthread_join(thread, nullptr);
+    return true;
+}
+
+void* ComptStack::run_task(void* task) {
+    const Task& t = *static_cast<Task*>(task);
+    t.stack->base = stack_position();
+    t.fn(t.data);
+    t.stack->base = 0;
+    return nullptr;
+}
+
+} // namespace hir
@@ -0,0 +1,60 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#ifndef COMPILER_HIR_COMPT_STACK_HPP
+#define COMPILER_HIR_COMPT_STACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace hir {
+
+/**
+ * hir::ComptStack, the stack tree-walked compt calls recurse on
+ * - the outermost walked call runs on a thread whose stack is a fresh heap mapping sized by
+ * Context::compt_stack_bytes, and that thread is joined before the call returns, so nothing ever
+ * runs concurrently with the compiler
+ * - every nested walked call checks how much of that stack is in use, so walked recursion is
+ * bounded by --compt-stack's bytes just like the vm's frames are, rather than by a frame count
+ */
+class ComptStack {
+  public:
+    /// headroom past the limit for what a call does between checks (its body's own expr
+    /// recursion, resolving the defs it names, reporting its overflow)
+    static constexpr size_t RED_ZONE_BYTES = size_t{1} << 20;
+
+    /// whether the caller is already running on a compt stack
+    [[nodiscard]] bool active() const noexcept { return base != 0; }
+    /// runs fn to completion on a fresh stack holding limit_bytes of calls, false (w/o running
+    /// it) if no such stack could be made
+    template <typename F> [[nodiscard]] bool run(size_t limit_bytes, F&& fn) {
+        return run_erased(
+            limit_bytes, [](void* f) { (*static_cast<std::remove_reference_t<F>*>(f))(); }, &fn);
+    }
+    /// bytes in use on the active stack
+    [[nodiscard]] size_t used_bytes() const noexcept;
+    /// false once the active stack's calls hold its limit, so another one doesn't fit
+    [[nodiscard]] bool has_room() const noexcept { return used_bytes() < limit; }
+
+  private:
+    struct Task {
+        ComptStack* stack;
+        void (*fn)(void*);
+        void* data;
+    };
+    uintptr_t base = 0; // first frame on the active stack, 0 if there isn't one
+    size_t limit = 0;
+
+    [[nodiscard]] bool run_erased(size_t limit_bytes, void (*fn)(void*), void* data);
+    static void* run_task(void* task);
+};
+
+} // namespace hir
+
+#endif // !COMPILER_HIR_COMPT_STACK_HPP
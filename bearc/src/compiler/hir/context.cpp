@@ -23,16 +23,21 @@
 #include "compiler/hir/type.hpp"
 #include "compiler/parser/token_eaters.h"
 #include "compiler/token.h"
+#include "utils/alloc_phase.hpp"
+#include "utils/alloc_stats.h"
 #include "utils/ansi_codes.h"
 #include "utils/data_arena.hpp"
 #include "utils/log.hpp"
+#include "utils/mapu32u32.h"
 #include "llvm/ADT/SmallVector.h"
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <cstring>
 #include <filesystem>
 #include <iostream>
 #include <iso646.h>
+#include <memory>
 #include <optional>
 #include <stddef.h>
 #include <string_view>
@@ -45,6 +50,7 @@ static constexpr size_t DEFAULT_CANONICAL_GEN_ARGS_ARENA_CAP = 0x10000;
 static constexpr size_t DEFAULT_ID_MAP_ARENA_CAP
     = 0x8000; // increase if any other top level maps need to be mades
 static constexpr size_t DEFAULT_TEMP_SCOPE_ARENA_CAP = 0x10000;
+static constexpr size_t DEFAULT_DEF_INDEX_ARENA_CAP = 0x10000;
 static constexpr size_t DEFAULT_SYM_TO_FILE_ID_MAP_CAP = 0x80;
 static constexpr size_t DEFAULT_SCOPE_VEC_CAP = 0x80;
 static constexpr size_t DEFAULT_FILE_VEC_CAP = 0x80;
@@ -52,8 +58,12 @@ static constexpr size_t DEFAULT_FILE_AST_VEC_CAP = DEFAULT_FILE_VEC_CAP;
 static constexpr size_t DEFAULT_FILE_ID_VEC_CAP = 0x200;
 static constexpr size_t DEFAULT_SYMBOL_VEC_CAP = 0x800;
 static constexpr size_t DEFAULT_EXEC_VEC_CAP = 0x800;
+static constexpr size_t DEFAULT_SCRATCH_EXEC_VEC_CAP = 0x200;
+static constexpr size_t DEFAULT_SCRATCH_DEF_CAP = 0x100;
 static constexpr size_t DEFAULT_DEF_CAP = 0x800;
 static constexpr size_t DEFAULT_TYPE_VEC_CAP = 0x400;
+/// per alternative, most exec/type kinds are rare so this is kept small
+static constexpr size_t DEFAULT_PAYLOAD_TABLE_CAP = 0x100;
 static constexpr size_t DEFAULT_CANONICAL_TYPE_VEC_CAP = 0x100;
 static constexpr size_t DEFAULT_GENERIC_ARG_VEC_CAP = 0x400;
 static constexpr HirSize EXPECTED_HIGH_NUM_IMPORTS = 128;
@@ -75,14 +85,27 @@ Context::Context(const bearc_args_t& args, instances instances)
       scope_arena{DEFAULT_SCOPE_ARENA_CAP}, scopes{DEFAULT_SCOPE_VEC_CAP},
       temp_scope_arena{std::make_unique<DataArena>(DEFAULT_TEMP_SCOPE_ARENA_CAP)},
       symbol_storage_arena{DEFAULT_SYMBOL_ARENA_CAP}, symbol_map_arena{DEFAULT_SYMBOL_ARENA_CAP},
-      str_to_symbol_id_map{symbol_map_arena}, symbol_ids{DEFAULT_SYMBOL_VEC_CAP},
-      symbols{DEFAULT_SYMBOL_VEC_CAP}, exec_ids{DEFAULT_EXEC_VEC_CAP}, execs{DEFAULT_EXEC_VEC_CAP},
-      def_ids{DEFAULT_DEF_CAP}, defs{DEFAULT_DEF_CAP}, def_resol_states{DEFAULT_DEF_CAP},
+      str_to_symbol_id_map{symbol_map_arena, symbol_storage_arena},
+      symbol_ids{DEFAULT_SYMBOL_VEC_CAP}, symbols{DEFAULT_SYMBOL_VEC_CAP},
+      exec_ids{DEFAULT_EXEC_VEC_CAP}, exec_payloads{DEFAULT_PAYLOAD_TABLE_CAP},
+      execs{DEFAULT_EXEC_VEC_CAP}, exec_types{DEFAULT_EXEC_VEC_CAP},
+      scratch_exec_payloads{DEFAULT_PAYLOAD_TABLE_CAP}, scratch_execs{DEFAULT_SCRATCH_EXEC_VEC_CAP},
+      scratch_exec_types{DEFAULT_SCRATCH_EXEC_VEC_CAP},
+      scratch_exec_ids{DEFAULT_SCRATCH_EXEC_VEC_CAP}, scratch_defs{DEFAULT_SCRATCH_DEF_CAP},
+      scratch_def_colds{DEFAULT_SCRATCH_DEF_CAP},
+      scratch_def_mention_states{DEFAULT_SCRATCH_DEF_CAP},
+      def_ids{DEFAULT_DEF_CAP}, defs{DEFAULT_DEF_CAP},
+      def_index_storage_arena{DEFAULT_DEF_INDEX_ARENA_CAP},
+      def_index_map_arena{DEFAULT_DEF_INDEX_ARENA_CAP},
+      def_index{def_index_map_arena, def_index_storage_arena}, def_colds{DEFAULT_DEF_CAP},
+      def_resol_states{DEFAULT_DEF_CAP},
       def_ast_nodes(DEFAULT_DEF_CAP), def_mention_states{DEFAULT_DEF_CAP},
       def_to_scope_for_types{id_map_arena, DEFAULT_DEF_CAP},
       def_to_scope_for_funcs{id_map_arena, DEFAULT_DEF_CAP}, ordered_def_slices{DEFAULT_DEF_CAP},
       def_to_ordered_def_slice_id{id_map_arena, DEFAULT_DEF_SLICE_COUNT}, type_ids{DEFAULT_DEF_CAP},
-      types{DEFAULT_TYPE_VEC_CAP}, canonical_to_type_id(DEFAULT_CANONICAL_TYPE_VEC_CAP),
+      type_payloads{DEFAULT_PAYLOAD_TABLE_CAP}, types{DEFAULT_TYPE_VEC_CAP},
+      canonical_to_type_id(DEFAULT_CANONICAL_TYPE_VEC_CAP),
+      canonical_type_names(DEFAULT_CANONICAL_TYPE_VEC_CAP),
       canonical_type_table_arena{DEFAULT_CANONICAL_TYPE_ARENA_CAP},
       canonical_type_table(*this, canonical_type_table_arena, DEFAULT_CANONICAL_TT_CAP),
       generic_arg_ids{DEFAULT_GENERIC_ARG_VEC_CAP}, generic_args{DEFAULT_GENERIC_ARG_VEC_CAP},
@@ -99,6 +122,11 @@ Context::Context(const bearc_args_t& args, instances instances)
 
     one_instance_status = false; // we exist now
 
+    for (size_t i = 0; i < BUILTIN_TYPE_COUNT; i++) {
+        builtin_type_ids[i] = emplace_fresh_type(
+            TypeBuiltin{.type = static_cast<builtin_type>(i)}, Span::generated(), false);
+    }
+
     // this may only fail in horribly malfored arguments in test cases
     assert(args.input_file_name);
 
@@ -117,21 +145,31 @@ Context::Context(const bearc_args_t& args, instances instances)
 
     // search imports to build all asts
     this->explore_imports(root_id);
+    record_mem_phase("lex + parse");
     // tally parser errors
-    for (FileId id = files.rbegin_id(); id != files.rend_id(); --id) {
-        File& f = files.at(id);
-        const FileAst& ast = file_asts.cat(f.ast_id);
-        if (!has_flag(CLI_FLAG_PARSE_ONLY)) {
-            FileAstVisitor visitor{*this, id};
-            visitor.register_top_level_declarations();
+    {
+        AllocPhaseScope register_phase{ALLOC_PHASE_REGISTER};
+        for (FileId id = files.rbegin_id(); id != files.rend_id(); --id) {
+            File& f = files.at(id);
+            const FileAst& ast = file_asts.cat(f.ast_id);
+            if (!has_flag(CLI_FLAG_PARSE_ONLY)) {
+                FileAstVisitor visitor{*this, id};
+                visitor.register_top_level_declarations();
+            }
+            this->note_cnt += ast.diagnostic_count() - ast.error_count();
+            this->fatal_error_cnt += ast.error_count();
         }
-        this->note_cnt += ast.diagnostic_count() - ast.error_count();
-        this->fatal_error_cnt += ast.error_count();
     }
     if (has_flag(CLI_FLAG_PARSE_ONLY)) {
         return;
     }
-    TopLevelDefVisitor{*this}.resolve_top_level_definitions();
+    freeze_module_scopes();
+    record_mem_phase("register declarations");
+    {
+        AllocPhaseScope resolve_phase{ALLOC_PHASE_RESOLVE};
+        TopLevelDefVisitor{*this}.resolve_top_level_definitions();
+    }
+    record_mem_phase("resolve + compt");
 }
 
 int Context::diagnostic_count() const noexcept {
@@ -150,23 +188,18 @@ bool Context::compact_diagnostics_enabled() const noexcept { return compact_diag
 
 bool Context::has_flag(cli_flag_e flag) const noexcept { return args.flags[flag]; }
 
+size_t Context::compt_stack_bytes() const noexcept {
+    return args.compt_stack_kib != 0 ? size_t{args.compt_stack_kib} << 10
+                                     : ComptVm::DEFAULT_STACK_BYTES;
+}
+
 SymbolId Context::symbol_id(std::string_view sv) { return symbol_id(sv.data(), sv.length()); }
 SymbolId Context::symbol_id(const token_t* tkn) { return symbol_id(tkn->start, tkn->len); }
 SymbolId Context::symbol_id(const char* start, size_t len) {
-    OptId<SymbolId> maybe_symbol = str_to_symbol_id_map.atn(start, len);
-    if (maybe_symbol.has_value()) {
-        return maybe_symbol.as_id();
-    }
-    char* sym_data = this->symbol_storage_arena.alloc_as<char*>(len + 1); // +1 for null-term
-    memcpy(sym_data, start, len);
-    sym_data[len] = '\0'; // null-term
-
-    // make sym
-    SymbolId sym_id = this->symbols.emplace_and_get_id(std::string_view{sym_data, len});
-    // register sym into map for future fast and cosistent access
-    str_to_symbol_id_map.emplace(sym_data, sym_id);
-    // give sym_id now that it's fully interned
-    return sym_id;
+    // one hash + probe, the map copies new symbols into symbol_storage_arena (null-termed)
+    return str_to_symbol_id_map.intern(start, len, [this](std::string_view interned) {
+        return this->symbols.emplace_and_get_id(interned);
+    });
 }
 SymbolId Context::concat_symbols(SymbolId sid1, SymbolId sid2) {
     std::string buf{};
@@ -202,6 +235,13 @@ FileId Context::file(SymbolId path_symbol) {
     FileAstId ast_id = this->file_asts.emplace_and_get_id(symbol_id_to_cstr(path_symbol));
     // ^^^^^^^^^^^^^^^^^^
     FileId file_id = this->files.emplace_and_get_id(path_symbol, ast_id);
+    // give the file its own range of the src address space, one past its end included
+    const size_t src_size = file_asts.cat(ast_id).src()->size;
+    assert(next_file_base + src_size < HIR_SIZE_MAX && "src address space exhausted");
+    file_bases.push_back(next_file_base);
+    file_line_starts.emplace_back();
+    file_scope_spans.emplace_back();
+    next_file_base += static_cast<HirSize>(src_size) + 1;
     /// store this mapping for future detection
     this->symbol_id_to_file_id_map.insert(path_symbol, file_id);
     /// bump necessary things that are track id-wise for files
@@ -236,7 +276,7 @@ void Context::report_cycle(llvm::SmallVectorImpl<FileId>& import_stack,
                            const token_t* import_path_tkn) {
     // gonna be imported in the previous thing, so top of import stack
     FileId imported_in = import_stack[import_stack.size() - 1];
-    emplace_diagnostic(Span{imported_in, ast(imported_in).buffer(), import_path_tkn},
+    emplace_diagnostic(Span{*this, imported_in, import_path_tkn},
                        diag_code::cyclical_import, diag_type::warning,
                        DiagnosticImportStack{freeze_id_vec(import_stack)});
 }
@@ -341,6 +381,13 @@ void Context::try_print_info() {
             std::cout << ansi_reset() << "\n";
         }
     }
+    if (has_flag(CLI_FLAG_MEM_STATS)) {
+        MemStatsReport report = mem_stats();
+        report.phases = mem_phases;
+        report.print(std::cout);
+        std::cout.flush();
+        alloc_stats_print(stdout); // no-op unless built w/ ALLOC_STATS
+    }
     // 3. print diagnostics last (so always seen first in terminal)
     if (!has_flag(CLI_FLAG_SILENT)) {
         // go thru each file ast to print info
@@ -357,7 +404,7 @@ void Context::try_print_info() {
                 if (prev_diag.has_value()) {
                     auto curr = diagnostics.cat(d);
                     auto prev = diagnostics.cat(prev_diag.as_id());
-                    print_file = curr.span.file_id != prev.span.file_id;
+                    print_file = curr.span.file_id(*this) != prev.span.file_id(*this);
                 }
                 */
                 print_diagnostic(d /*, print_file*/);
@@ -417,7 +464,7 @@ OptId<FileId> Context::try_file_from_import_statement(FileId importer_id,
     // DNE guard
     auto maybe_path = resolve_on_import_path(path, parent, &this->args);
     if (!maybe_path.has_value()) {
-        emplace_diagnostic(Span(importer_id, ast(importer_id).buffer(), path_tkn),
+        emplace_diagnostic(Span(*this, importer_id, path_tkn),
                            diag_code::imported_file_dne, diag_type::error);
         return OptId<FileId>{};
     }
@@ -427,24 +474,58 @@ OptId<FileId> Context::try_file_from_import_statement(FileId importer_id,
 DefId Context::register_top_level_def(SymbolId name, bool pub, bool compt, bool statik,
                                       bool generic, Span span, ast_stmt_t* stmt,
                                       OptId<DefId> parent) {
-    DefId def = defs.emplace_and_get_id(DefUnevaluated{}, name, pub, compt, statik, generic, span,
-                                        parent);
+    DefId def = defs.emplace_and_get_id(emplace_def_cold(DefUnevaluated{}, span), DefUnevaluated{},
+                                        name, pub, compt, statik, generic, parent);
     def_resol_states.bump(Def::resol_state::top_level_visited);
     def_ast_nodes.bump(stmt);
     def_mention_states.bump(Def::mention_state::unmentioned);
+    def_index.insert(parent, symbol(name), def);
     return def;
 }
 
+DefId Context::emplace_def_cold(const DefValue& value, Span span) {
+    const DefId id = def_colds.emplace_and_get_id(DefCold{value, span});
+    assert(id.val() == defs.size() + 1 && "[hir::Context] a def's cold half must share its id");
+    return id;
+}
+
+DefCold& Def::cold(Context& ctx) noexcept { return ctx.def_cold(self); }
+
+const DefCold& Def::cold(const Context& ctx) const noexcept { return ctx.def_cold(self); }
+
 DefId Context::register_compt_def(SymbolId name, Span span, DefId parent, DefValue value) {
-    DefId def = defs.emplace_and_get_id(value, name, true, true, true, false, span, parent);
+    DefId def = defs.emplace_and_get_id(emplace_def_cold(value, span), value, name, true, true,
+                                        true, false, parent);
     def_resol_states.bump(Def::resol_state::resolved);
     def_ast_nodes.bump();
     def_mention_states.bump(Def::mention_state::unmentioned);
     return def;
 }
 
+DefId Context::make_compt_param_def(SymbolId name, Span span, DefId parent,
+                                    const DefValue& value) {
+    if (free_scratch_defs.empty()) {
+        const DefId did{static_cast<HirId>(scratch_defs.size() + 1) | SCRATCH_DEF_BIT};
+        scratch_defs.bump(did, value, name, true, true, true, false, parent);
+        scratch_def_colds.bump(DefCold{value, span});
+        scratch_def_mention_states.bump(Def::mention_state::unmentioned);
+        return did;
+    }
+    const DefId did = free_scratch_defs.back();
+    free_scratch_defs.pop_back();
+    const DefId idx{did.val() & ~SCRATCH_DEF_BIT};
+    // the hot record's name is const, so the released def is replaced outright
+    Def* def = &scratch_defs.at(idx);
+    std::destroy_at(def);
+    std::construct_at(def, did, value, name, true, true, true, false, parent);
+    scratch_def_colds.at(idx) = DefCold{value, span};
+    scratch_def_mention_states.at(idx) = Def::mention_state::unmentioned;
+    return did;
+}
+
 DefId Context::register_def(SymbolId name, Span span, DefId parent, DefValue value) {
-    DefId def = defs.emplace_and_get_id(value, name, true, false, false, false, span, parent);
+    DefId def = defs.emplace_and_get_id(emplace_def_cold(value, span), value, name, true, false,
+                                        false, false, parent);
     def_resol_states.bump(Def::resol_state::resolved);
     def_ast_nodes.bump();
     def_mention_states.bump(Def::mention_state::unmentioned);
@@ -453,25 +534,145 @@ DefId Context::register_def(SymbolId name, Span span, DefId parent, DefValue val
 
 void Context::insert_variable(ScopeId scope_id, SymbolId sid, DefId did) {
     scopes.at(scope_id).insert_variable(sid, did);
+    bump_path_memo_epoch();
 }
 
 void Context::insert_type(ScopeId scope_id, SymbolId sid, DefId did) {
     scopes.at(scope_id).insert_type(sid, did);
+    bump_path_memo_epoch();
+}
+
+void Context::insert_namespace(ScopeId scope_id, SymbolId sid, DefId did) {
+    scopes.at(scope_id).insert_namespace(sid, did);
+    bump_path_memo_epoch();
+}
+
+void Context::insert_compt_param(ScopeId temp_scope_id, SymbolId sid, DefId did) {
+    scopes.at(temp_scope_id).insert_variable(sid, did);
+}
+
+void Context::bump_path_memo_epoch() noexcept {
+    path_memo_cnt = 0;
+    frozen_look_up_cnt = 0;
+    if (++path_memo_epoch == 0) { // wrapped, so old slots could look live again
+        std::fill(path_memo.begin(), path_memo.end(), PathMemoSlot{});
+        std::fill(frozen_look_ups.begin(), frozen_look_ups.end(), FrozenLookUpSlot{});
+        path_memo_epoch = 1;
+    }
 }
 
-[[nodiscard]] IdHashMap<DefId, ScopeId>& Context::defs_to_scopes_for_types() {
+[[nodiscard]] const IdHashMap<DefId, ScopeId>& Context::defs_to_scopes_for_types() const {
     return def_to_scope_for_types;
 }
 
+void Context::register_type_scope(DefId def, ScopeId scope) {
+    def_to_scope_for_types.insert(def, scope);
+    bump_path_memo_epoch();
+}
+
 [[nodiscard]] DefId Context::begin_def_id() const { return defs.begin_id(); }
 [[nodiscard]] DefId Context::end_def_id() const { return defs.end_id(); }
 
 ExecId Context::emplace_exec(const ExecValue& value, Span span, bool should_be_compt) {
+    exec_types.bump();
     return execs.emplace_and_get_id(*this, value, span, should_be_compt);
 }
 
-ExecId Context::emplace_compt_exec(const ExecValue& value, Span span) {
-    return execs.emplace_and_get_id(*this, value, span, true);
+ExecId Context::emplace_scratch_exec(const ExecValue& value, Span span, bool should_be_compt) {
+    scratch_exec_types.bump();
+    const ExecId local = scratch_execs.emplace_and_get_id(*this, value, span, should_be_compt,
+                                                          /*scratch*/ true);
+    assert(!is_scratch_exec(local) && "[hir::Context] scratch region overflowed");
+    return ExecId{local.val() | SCRATCH_EXEC_BIT};
+}
+
+OptId<TypeId> Context::cached_exec_type(ExecId id) const {
+    if (is_scratch_exec(id)) {
+        return scratch_exec_types.cat(ExecId{id.val() & ~SCRATCH_EXEC_BIT});
+    }
+    return exec_types.cat(id);
+}
+
+void Context::cache_exec_type(ExecId id, TypeId tid) {
+    if (is_scratch_exec(id)) {
+        scratch_exec_types.at(ExecId{id.val() & ~SCRATCH_EXEC_BIT}) = tid;
+        return;
+    }
+    exec_types.at(id) = tid;
+}
+
+void Context::begin_scratch_generation() noexcept {
+    if (scratch_generation_depth++ == 0) {
+        ++scratch_generation_epoch;
+    }
+}
+
+void Context::end_scratch_generation() noexcept {
+    assert(scratch_generation_depth > 0);
+    if (--scratch_generation_depth == 0) {
+        scratch_execs.clear();
+        scratch_exec_payloads.clear();
+        scratch_exec_types.clear();
+        scratch_exec_ids.clear();
+        scratch_defs.clear();
+        scratch_def_colds.clear();
+        scratch_def_mention_states.clear();
+        free_scratch_defs.clear();
+    }
+}
+
+IdSlice<ExecId> Context::freeze_scratch_exec_ids(const llvm::SmallVectorImpl<ExecId>& vec) {
+    const IdSlice<ExecId> slice = scratch_exec_ids.freeze_small_vec(vec);
+    return IdSlice<ExecId>{IdIdx<ExecId>{slice.first().val() | SCRATCH_EXEC_BIT}, slice.len()};
+}
+
+ExecId Context::promote_scratch_exec(ExecId id) {
+    if (!is_scratch_exec(id)) {
+        return id; // e.g. a def's compt value that was referred to directly
+    }
+    const Exec& scratch = exec(id);
+    ExecValue value = scratch.value(*this);
+
+    auto promote_slice = [this](IdSlice<ExecId> slice) {
+        llvm::SmallVector<ExecId> promoted;
+        promoted.reserve(slice.len());
+        for (HirSize i = 0; i < slice.len(); i++) {
+            promoted.push_back(promote_scratch_exec(exec_id(slice.get(i))));
+        }
+        return freeze_id_vec(promoted);
+    };
+
+    // compt evaluation only ever produces values, so only value kinds can refer to other execs
+    std::visit(
+        [&](auto& alt) {
+            using T = std::decay_t<decltype(alt)>;
+            if constexpr (std::is_same_v<T, ExecExprListLiteral>) {
+                alt.elems = promote_slice(alt.elems);
+            } else if constexpr (std::is_same_v<T, ExecExprStructInit>) {
+                alt.member_inits = promote_slice(alt.member_inits);
+            } else if constexpr (std::is_same_v<T, ExecVariantFieldInit>) {
+                alt.member_inits = promote_slice(alt.member_inits);
+            } else if constexpr (std::is_same_v<T, ExecExprStructMemberInit>) {
+                alt.value = promote_scratch_exec(alt.value);
+            } else if constexpr (std::is_same_v<T, ExecExprUnionInit>) {
+                alt.member_init = promote_scratch_exec(alt.member_init);
+            } else if constexpr (std::is_same_v<T, ExecExprVariantInit>) {
+                alt.payload_init = promote_scratch_exec(alt.payload_init);
+            } else {
+                assert((is_any_of_v<T, ExecExprComptConstant, ExecFnPtr, ExecExprClosure>)
+                       && "[hir::Context] promoting a scratch exec that isn't a compt value");
+            }
+        },
+        value);
+    // the promoted value keeps its type, so it isn't inferred again
+    const OptId<TypeId> tid = cached_exec_type(id);
+    const ExecId promoted = emplace_exec(value, scratch.span, scratch.compt);
+    exec_types.at(promoted) = tid;
+    return promoted;
+}
+
+OptId<ExecId> Context::promote_scratch_exec(OptId<ExecId> id) {
+    return id.has_value() ? OptId<ExecId>{promote_scratch_exec(id.as_id())} : id;
 }
 
 FileAst& Context::ast(FileId file_id) { return file_asts.at(files.at(file_id).ast_id); }
@@ -480,6 +681,89 @@ const FileAst& Context::ast(FileId file_id) const {
     return file_asts.cat(files.cat(file_id).ast_id);
 }
 
+HirSize Context::file_base(FileId file_id) const { return file_bases[file_id.val() - 1]; }
+
+FileId Context::file_at(HirSize pos) const {
+    assert(!file_bases.empty() && pos >= file_bases.front());
+    auto after = std::upper_bound(file_bases.begin(), file_bases.end(), pos);
+    return FileId{static_cast<HirId>(after - file_bases.begin())}; // ids are 1-offset
+}
+
+const std::vector<HirSize>& Context::line_starts_of(FileId file_id) const {
+    std::vector<HirSize>& line_starts = file_line_starts[file_id.val() - 1];
+    if (line_starts.empty()) {
+        const src_buffer_t* src = ast(file_id).src();
+        line_starts.push_back(0);
+        for (size_t i = 0; i < src->size; i++) {
+            if (src->data[i] == '\n') {
+                line_starts.push_back(static_cast<HirSize>(i + 1));
+            }
+        }
+    }
+    return line_starts;
+}
+
+SrcLoc Context::src_loc_at(HirSize pos) const {
+    const FileId fid = file_at(pos);
+    const std::vector<HirSize>& line_starts = line_starts_of(fid);
+    const HirSize local = pos - file_base(fid);
+    auto after = std::upper_bound(line_starts.begin(), line_starts.end(), local);
+    const auto line = static_cast<HirSize>(after - line_starts.begin() - 1);
+    return SrcLoc{.line = line, .col = local - line_starts[line]};
+}
+
+HirSize Context::pos_at(FileId file_id, SrcLoc loc) const {
+    const std::vector<HirSize>& line_starts = line_starts_of(file_id);
+    const HirSize line = std::min(loc.line, static_cast<HirSize>(line_starts.size() - 1));
+    // a col past the line's end stops at its newline, or at EOF on the last line, rather than
+    // spilling into the next line or file
+    const HirSize line_end = (line + 1 < line_starts.size())
+                                 ? line_starts[line + 1] - 1
+                                 : static_cast<HirSize>(ast(file_id).src()->size);
+    const HirSize col = std::min(loc.col, line_end - line_starts[line]);
+    return file_base(file_id) + line_starts[line] + col;
+}
+
+void Context::record_scope_span(Span span, ScopeId scope) {
+    FileScopeSpans& index = file_scope_spans[file_at(span.pos).val() - 1];
+    index.entries.push_back(ScopeSpanEntry{span.pos, span.len, scope, UINT32_MAX});
+    index.sorted = false;
+}
+
+ScopeId Context::innermost_scope_at(HirSize pos) const {
+    FileScopeSpans& index = file_scope_spans[file_at(pos).val() - 1];
+    std::vector<ScopeSpanEntry>& entries = index.entries;
+    if (!index.sorted) {
+        // outer before inner on a shared start, then link each entry to its enclosing one
+        std::sort(entries.begin(), entries.end(),
+                  [](const ScopeSpanEntry& a, const ScopeSpanEntry& b) {
+                      return a.pos < b.pos || (a.pos == b.pos && a.len > b.len);
+                  });
+        llvm::SmallVector<uint32_t> open{};
+        for (uint32_t i = 0; i < entries.size(); i++) {
+            const HirSize end = entries[i].pos + entries[i].len;
+            while (!open.empty() && entries[open.back()].pos + entries[open.back()].len < end) {
+                open.pop_back();
+            }
+            entries[i].parent = open.empty() ? UINT32_MAX : open.back();
+            open.push_back(i);
+        }
+        index.sorted = true;
+    }
+    // the last span starting at or before pos is the innermost one that could contain it, if it
+    // doesn't then only the spans enclosing it still can
+    auto after = std::upper_bound(
+        entries.begin(), entries.end(), pos,
+        [](HirSize p, const ScopeSpanEntry& entry) { return p < entry.pos; });
+    auto idx = static_cast<uint32_t>(after - entries.begin()) - 1;
+    for (; idx != UINT32_MAX; idx = entries[idx].parent) {
+        if (pos < entries[idx].pos + entries[idx].len) {
+            return entries[idx].scope;
+        }
+    }
+    return root_scope();
+}
+
 ScopeId Context::get_or_make_root_scope() {
     if (scopes.size() == 0) {
         return make_scope(std::nullopt);
@@ -499,7 +783,7 @@ ScopeId Context::make_scope(OptId<ScopeId> parent_scope) {
 }
 
 ScopeId Context::make_small_scope(OptId<ScopeId> parent_scope) {
-    static constexpr size_t CAP = 0x8;
+    static constexpr size_t CAP = 0x0; // stays in the inline tables until it outgrows them
     return make_scope(parent_scope, CAP);
 }
 
@@ -512,16 +796,34 @@ ScopeId Context::make_scope(OptId<ScopeId> parent_scope, HirSize capacity) {
     return scopes.emplace_and_get_id(parent_scope, capacity, scope_arena);
 }
 
+ScopeId Context::make_scope(OptId<ScopeId> parent_scope, Scope::Sizes sizes) {
+    return scopes.emplace_and_get_id(parent_scope, sizes, scope_arena);
+}
+
 ScopeId Context::make_compt_func_temp_scope(ScopeId parent_scope, HirSize capacity) {
+    if (!free_temp_scopes.empty()) {
+        const ScopeId reused = free_temp_scopes.back();
+        free_temp_scopes.pop_back();
+        scopes.at(reused).recycle(parent_scope, capacity);
+        return reused;
+    }
+    ++temp_scope_cnt;
     return scopes.emplace_and_get_id(parent_scope, capacity, *temp_scope_arena,
                                      Scope::storage::variables);
 }
 
+void Context::release_compt_func_temp_scope(ScopeId temp_scope) {
+    scopes.cat(temp_scope).for_each_local_variable(
+        [this](Scope::Entry e) { free_scratch_defs.push_back(e.val()); });
+    free_temp_scopes.push_back(temp_scope);
+}
+
 DefId Context::register_generated_deftype(ScopeId scope, SymbolId name, TypeId type_id,
                                           DefId parent, Span span) {
-    auto did = defs.emplace_and_get_id(DefDeftype{.type = type_id}, name, false, false, false,
-                                       false, span, parent);
-    this->scope(scope).insert_type(name, did);
+    const DefValue value = DefDeftype{.type = type_id};
+    auto did = defs.emplace_and_get_id(emplace_def_cold(value, span), value, name, false, false,
+                                       false, false, parent);
+    insert_type(scope, name, did);
     def_resol_states.bump(Def::resol_state::resolved);
     def_ast_nodes.bump();
     def_mention_states.bump(Def::mention_state::unmentioned);
@@ -538,6 +840,7 @@ bool Context::relinquish_temp_scopes() {
     if (chunk_size > ((chunk_cap >> 1) + (chunk_cap >> 2) + (chunk_cap >> 3) + (chunk_cap >> 4))) {
         temp_scope_arena
             = std::make_unique<DataArena>(chunk_cap); // frees old arena and gives us another
+        free_temp_scopes.clear(); // their tables lived in the old arena
         return true;
     }
     return false;
@@ -564,12 +867,32 @@ void Context::handle_bump_diag_counts(diag_code code, diag_type type) {
     }
 }
 
+void Context::suggest_name_for(DiagnosticId diag, ScopeId scope, IdSlice<SymbolId> path,
+                               Span span) {
+    if (path.len() != 1) {
+        return; // a qualified name's prefix may itself be what's broken
+    }
+    // fold in the names of every def registered since the last suggestion
+    for (; suggester_def_cnt < defs.size(); suggester_def_cnt++) {
+        symbol_suggester.insert(*this, defs.cat(DefId{suggester_def_cnt + 1}).name);
+    }
+    const OptId<SymbolId> suggestion
+        = symbol_suggester.suggest(*this, scope, symbol_id(path.get(0)));
+    if (suggestion.empty()) {
+        return;
+    }
+    const DiagnosticId help = emplace_diagnostic_with_message_value(
+        span, diag_code::did_you_mean, diag_type::help,
+        DiagnosticSymbolAfterMessage{.sid = suggestion.as_id()});
+    link_diagnostic(diag, help);
+}
+
 DiagnosticId Context::emplace_diagnostic(Span span, diag_code code, diag_type type,
                                          OptId<DiagnosticId> next) {
     DiagnosticId id = diagnostics.emplace_and_get_id(span, code, type, next);
     diagnostics_used.bump();
     if (!span.is_generated()) {
-        file_to_diagnostics.at(span.file_id).emplace_back(id);
+        file_to_diagnostics.at(span.file_id(*this)).emplace_back(id);
     }
     handle_bump_diag_counts(code, type);
     return id;
@@ -580,7 +903,7 @@ DiagnosticId Context::emplace_diagnostic(Span span, diag_code code, diag_type ty
     DiagnosticId id = diagnostics.emplace_and_get_id(span, code, type, value, next);
     diagnostics_used.bump();
     if (!span.is_generated()) {
-        file_to_diagnostics.at(span.file_id).emplace_back(id);
+        file_to_diagnostics.at(span.file_id(*this)).emplace_back(id);
     }
     handle_bump_diag_counts(code, type);
     return id;
@@ -592,7 +915,7 @@ DiagnosticId Context::emplace_diagnostic(Span span, diag_code code, diag_type ty
     DiagnosticId id = diagnostics.emplace_and_get_id(span, code, type, message_value, value, next);
     diagnostics_used.bump();
     if (!span.is_generated()) {
-        file_to_diagnostics.at(span.file_id).emplace_back(id);
+        file_to_diagnostics.at(span.file_id(*this)).emplace_back(id);
     }
     handle_bump_diag_counts(code, type);
     return id;
@@ -606,7 +929,7 @@ DiagnosticId Context::emplace_diagnostic_with_message_value(Span span, diag_code
                                                      DiagnosticNoOtherInfo{}, next);
     diagnostics_used.bump();
     if (!span.is_generated()) {
-        file_to_diagnostics.at(span.file_id).emplace_back(id);
+        file_to_diagnostics.at(span.file_id(*this)).emplace_back(id);
     }
     handle_bump_diag_counts(code, type);
     return id;
@@ -626,7 +949,7 @@ void Context::print_diagnostic(DiagnosticId diag_id, bool print_file) {
         // only print next's file if it differs
         Span next_span = diagnostics.cat(diag.next.as_id()).span;
         bool print_next_file
-            = !next_span.is_generated() && (diag.span.file_id != next_span.file_id);
+            = !next_span.is_generated() && (diag.span.file_id(*this) != next_span.file_id(*this));
         print_diagnostic(diag.next.as_id(), print_next_file);
     } else if (!compact_diagnostics_enabled()) {
         std::cout << '\n'; // this makes it so there's a new line between the start and end of
@@ -646,19 +969,38 @@ void Context::force_link_diagnostic(DiagnosticId diag) {
     diagnostics.at(DiagnosticId{prev_val}).set_next(diag);
 }
 
-Def& Context::def(DefId def_id) { return defs.at(def_id); }
+Def& Context::def(DefId def_id) {
+    if (is_scratch_def(def_id)) {
+        return scratch_defs.at(DefId{def_id.val() & ~SCRATCH_DEF_BIT});
+    }
+    return defs.at(def_id);
+}
+
+DefCold& Context::def_cold(DefId def_id) {
+    if (is_scratch_def(def_id)) {
+        return scratch_def_colds.at(DefId{def_id.val() & ~SCRATCH_DEF_BIT});
+    }
+    return def_colds.at(def_id);
+}
+
+const DefCold& Context::def_cold(DefId def_id) const {
+    if (is_scratch_def(def_id)) {
+        return scratch_def_colds.cat(DefId{def_id.val() & ~SCRATCH_DEF_BIT});
+    }
+    return def_colds.cat(def_id);
+}
 
 const Def& Context::try_func_def(DefId def_id) const { return def(try_func_did(def_id)); }
 
 DefId Context::try_func_did(DefId def_id) const {
     const Def& def = this->def(def_id);
     if (def.holds<DefVariable>()) {
-        DefVariable var = def.as<DefVariable>();
+        DefVariable var = def.as<DefVariable>(*this);
         if (var.compt_value.has_value()) {
             ExecId compt_val = var.compt_value.as_id();
             const Exec& compt_exec = exec(compt_val);
             if (compt_exec.holds<ExecFnPtr>()) {
-                return compt_exec.as<ExecFnPtr>().func_def_id;
+                return compt_exec.as<ExecFnPtr>(*this).func_def_id;
             }
         }
     }
@@ -682,20 +1024,32 @@ IdSlice<DefId> Context::ordered_defs_for(DefId def_id) {
     return ordered_def_slices.cat(maybe_odef_slice_id.as_id());
 }
 
-Def::resol_state Context::resol_state_of(DefId def) const { return def_resol_states.cat(def); }
+Def::resol_state Context::resol_state_of(DefId def) const {
+    // a compt param is made w/ its value already solved
+    return is_scratch_def(def) ? Def::resol_state::resolved : def_resol_states.cat(def);
+}
 
 void Context::set_resol_state_of(DefId def, Def::resol_state resol_state) {
+    assert(!is_scratch_def(def) && "[hir::Context] compt params are always resolved");
     def_resol_states.at(def) = resol_state;
 }
 
 Def::mention_state Context::mention_state_of(DefId def) const {
+    if (is_scratch_def(def)) {
+        return scratch_def_mention_states.cat(DefId{def.val() & ~SCRATCH_DEF_BIT});
+    }
     return def_mention_states.cat(def);
 }
 void Context::promote_mention_state_of(DefId def, Def::mention_state new_mention_state) {
     // only promote (when current is less than new)
-    if (mention_state_of(def) < new_mention_state) {
-        def_mention_states.at(def) = new_mention_state;
+    if (mention_state_of(def) >= new_mention_state) {
+        return;
+    }
+    if (is_scratch_def(def)) {
+        scratch_def_mention_states.at(DefId{def.val() & ~SCRATCH_DEF_BIT}) = new_mention_state;
+        return;
     }
+    def_mention_states.at(def) = new_mention_state;
 }
 
 ScopeId Context::scope_for_top_level_def(DefId def_id) const {
@@ -703,13 +1057,13 @@ ScopeId Context::scope_for_top_level_def(DefId def_id) const {
     if (hopefully_scope.has_value()) {
         return hopefully_scope.as_id();
     }
-    ERR(def(def_id).span.as_sv(*this));
+    ERR(def(def_id).span(*this).as_sv(*this));
     assert(false && "tried to get a scope for a top level def that was incompatible");
     return root_scope();
 }
 
 [[nodiscard]] const ast_stmt_t* Context::def_ast_node(DefId def_id) const {
-    return def_ast_nodes.cat(def_id);
+    return is_scratch_def(def_id) ? nullptr : def_ast_nodes.cat(def_id);
 }
 
 [[nodiscard]] bool Context::is_struct_def(DefId def_id) const {
@@ -720,12 +1074,12 @@ OptId<ScopeId> Context::try_scope_for_top_level_def(DefId def_id) const {
     const auto& def = defs.cat(def_id);
     // no parent means parent scope is root scope
     if (def.holds<DefModule>()) {
-        return def.as<DefModule>().scope;
+        return def.as<DefModule>(*this).scope;
     }
     if (def.holds<DefDeftype>()) {
-        const Type& type = this->type(try_decay_ref(def.as<DefDeftype>().type));
+        const Type& type = this->type(try_decay_ref(def.as<DefDeftype>(*this).type));
         if (type.holds<TypeStruct>()) {
-            return def_to_scope_for_types.at(type.as<TypeStruct>().def_id);
+            return def_to_scope_for_types.at(type.as<TypeStruct>(*this).def_id);
         }
     }
     // hopefully found
@@ -738,7 +1092,9 @@ bool Context::is_top_level_def_with_associated_scope(DefId def_id) const {
            || decl_type == AST_STMT_STRUCT_DEF || decl_type == AST_STMT_UNION_DEF;
 }
 
-FileId Context::def_to_file_id(DefId def) const { return defs.cat(def).span.file_id; }
+FileId Context::def_to_file_id(DefId def) const {
+    return this->def(def).span(*this).file_id(*this);
+}
 
 Span Context::make_def_name_span(DefId def, const ast_stmt_t* stmt) const {
     auto fid = def_to_file_id(def);
@@ -746,7 +1102,7 @@ Span Context::make_def_name_span(DefId def, const ast_stmt_t* stmt) const {
     if (!maybe_name.has_value()) {
         assert(false && "failed to get name for an AST declaration");
     }
-    return Span(fid, ast(fid).buffer(), maybe_name.value());
+    return Span(*this, fid, maybe_name.value());
 }
 
 Span Context::make_top_level_def_name_span(DefId def) const {
@@ -758,14 +1114,14 @@ Type& Context::type(IdIdx<TypeId> ididx) { return type(type_ids.at(ididx)); }
 const Type& Context::type(TypeId id) const {
     const Type* t = &types.cat(id);
     while (t->holds<TypeDeftype>()) {
-        t = &types.cat(t->as<TypeDeftype>().true_type);
+        t = &types.cat(t->as<TypeDeftype>(*this).true_type);
     }
     return *t;
 }
 Type& Context::type(TypeId id) {
     Type* t = &types.at(id);
     while (t->holds<TypeDeftype>()) {
-        t = &types.at(t->as<TypeDeftype>().true_type);
+        t = &types.at(t->as<TypeDeftype>(*this).true_type);
     }
     return *t;
 }
@@ -773,7 +1129,7 @@ Type& Context::type(TypeId id) {
 TypeId Context::try_decay_ref(TypeId tid) const {
     const Type& type = this->type(tid);
     if (type.holds<TypeRef>()) {
-        return type.as<TypeRef>().inner;
+        return type.as<TypeRef>(*this).inner;
     }
     return tid;
 }
@@ -792,24 +1148,142 @@ Type& Context::type_as_mentioned(IdIdx<TypeId> ididx) {
 [[nodiscard]] Type& Context::type_as_mentioned(TypeId id) { return types.at(id); }
 TypeId Context::type_id(IdIdx<TypeId> tid) const { return type_ids.cat(tid); }
 CanonicalTypeId Context::emplace_and_get_canonical_type_id(TypeId first_structural_type_id) {
+    std::ignore = canonical_type_names.emplace_and_get_id(OptId<SymbolId>{});
     return canonical_to_type_id.emplace_and_get_id(first_structural_type_id);
 }
 
+SymbolId Context::type_name(TypeId tid) {
+    OptId<SymbolId>& name = canonical_type_names.at(type(tid).canonical);
+    if (name.empty()) {
+        name = symbol_id(type_to_string(*this, tid));
+    }
+    return name.as_id();
+}
+
+SymbolId Context::type_name_as_mentioned(TypeId tid) {
+    // deftype names aren't part of the canonical type, so those mentions are rendered each time
+    if (contains_deftype(*this, tid)) {
+        return symbol_id(type_to_string_as_mentioned(*this, tid));
+    }
+    return type_name(tid);
+}
+
 TypeId Context::emplace_type(const TypeValue& value, Span span, bool mut) {
-    TypeId tid = types.emplace_and_get_id(value, span, mut);
+    // mut types are skipped since the type resolver may still strip their mut in place
+    if (!span.is_generated() || mut) {
+        return emplace_fresh_type(value, span, mut);
+    }
+    if (const auto* builtin = std::get_if<TypeBuiltin>(&value)) {
+        return builtin_type_id(builtin->type);
+    }
+    return intern_generated_type(value);
+}
+
+void Context::strip_type_mut(TypeId tid) {
+    Type& true_type = type(tid);
+    Type& mentioned = type_as_mentioned(tid);
+    if (!true_type.mut && !mentioned.mut) {
+        return;
+    }
+    true_type.mut = false;
+    mentioned.mut = false;
+    true_type.canonical = canonical_type_table.canonical(tid);
+    mentioned.canonical = true_type.canonical;
+}
+
+TypeId Context::emplace_fresh_type(const TypeValue& value, Span span, bool mut) {
+    TypeId tid = types.emplace_and_get_id(*this, value, span, mut);
     // set canonical
     types.at(tid).canonical = canonical_type_table.canonical(tid);
     return tid;
 }
-[[nodiscard]] const Exec& Context::exec(ExecId id) const { return execs.cat(id); }
 
-[[nodiscard]] const Def& Context::def(DefId id) const { return defs.cat(id); }
+// every type alternative is plain ids and scalars w/o padding, so its bytes are its identity
+template <typename T> static uint32_t hash_type_alt(const T& alt, size_t tag) {
+    if constexpr (std::is_empty_v<T>) {
+        return static_cast<uint32_t>(hash_bytes(&tag, sizeof(tag)));
+    } else {
+        static_assert(std::has_unique_object_representations_v<T>);
+        return static_cast<uint32_t>(hash_bytes(&alt, sizeof(T)) ^ (tag * 0x9e3779b97f4a7c15ULL));
+    }
+}
+
+static bool same_type_value(const Context& ctx, const Type& type, const TypeValue& value) {
+    return type.visit(ctx, [&value](const auto& alt) {
+        using T = std::decay_t<decltype(alt)>;
+        if (!std::holds_alternative<T>(value)) {
+            return false;
+        }
+        if constexpr (std::is_empty_v<T>) {
+            return true;
+        } else {
+            return std::memcmp(&alt, &std::get<T>(value), sizeof(T)) == 0;
+        }
+    });
+}
+
+TypeId Context::intern_generated_type(const TypeValue& value) {
+    if ((type_intern_cnt + 1) * 2 > type_intern_table.size()) {
+        grow_type_intern_table();
+    }
+    const size_t tag = value.index();
+    const uint32_t hash
+        = std::visit([tag](const auto& alt) { return hash_type_alt(alt, tag); }, value);
+    const size_t mask = type_intern_table.size() - 1;
+    size_t idx = hash & mask;
+    for (; type_intern_table[idx].tid.val() != HIR_ID_NONE; idx = (idx + 1) & mask) {
+        const TypeInternSlot& slot = type_intern_table[idx];
+        if (slot.hash != hash) {
+            continue;
+        }
+        if (same_type_value(*this, types.cat(slot.tid), value)) {
+            return slot.tid;
+        }
+    }
+    const TypeId tid = emplace_fresh_type(value, Span::generated(), false);
+    type_intern_table[idx] = TypeInternSlot{hash, tid};
+    ++type_intern_cnt;
+    return tid;
+}
+
+void Context::grow_type_intern_table() {
+    static constexpr size_t MIN_CAP = 64;
+    const size_t cap = type_intern_table.empty() ? MIN_CAP : type_intern_table.size() * 2;
+    std::vector<TypeInternSlot> old = std::move(type_intern_table);
+    type_intern_table.assign(cap, TypeInternSlot{0, TypeId{}});
+    for (const TypeInternSlot& slot : old) {
+        if (slot.tid.val() == HIR_ID_NONE) {
+            continue;
+        }
+        size_t idx = slot.hash & (cap - 1);
+        while (type_intern_table[idx].tid.val() != HIR_ID_NONE) {
+            idx = (idx + 1) & (cap - 1);
+        }
+        type_intern_table[idx] = slot;
+    }
+}
+[[nodiscard]] const Exec& Context::exec(ExecId id) const {
+    if (is_scratch_exec(id)) {
+        return scratch_execs.cat(ExecId{id.val() & ~SCRATCH_EXEC_BIT});
+    }
+    return execs.cat(id);
+}
 
-[[nodiscard]] const Exec& Context::exec(IdIdx<ExecId> id) const {
-    return execs.cat(exec_ids.cat(id));
+[[nodiscard]] const Def& Context::def(DefId id) const {
+    if (is_scratch_def(id)) {
+        return scratch_defs.cat(DefId{id.val() & ~SCRATCH_DEF_BIT});
+    }
+    return defs.cat(id);
 }
 
-ExecId Context::exec_id(IdIdx<ExecId> id) const { return exec_ids.cat(id); }
+[[nodiscard]] const Exec& Context::exec(IdIdx<ExecId> id) const { return exec(exec_id(id)); }
+
+ExecId Context::exec_id(IdIdx<ExecId> id) const {
+    if ((id.val() & SCRATCH_EXEC_BIT) != 0) {
+        return scratch_exec_ids.cat(IdIdx<ExecId>{id.val() & ~SCRATCH_EXEC_BIT});
+    }
+    return exec_ids.cat(id);
+}
 
 [[nodiscard]] const Scope& Context::scope(ScopeId sid) const { return scopes.cat(sid); }
 
@@ -821,9 +1295,9 @@ ExecId Context::exec_id(IdIdx<ExecId> id) const { return exec_ids.cat(id); }
         return did;
     }
     if (d.holds<DefDeftype>()) {
-        const Type& t = type(d.as<DefDeftype>().type);
+        const Type& t = type(d.as<DefDeftype>(*this).type);
         if (t.holds<TypeStruct>()) {
-            return t.as<TypeStruct>().def_id;
+            return t.as<TypeStruct>(*this).def_id;
         }
     }
     return {};
@@ -835,9 +1309,9 @@ ExecId Context::exec_id(IdIdx<ExecId> id) const { return exec_ids.cat(id); }
         return did;
     }
     if (d.holds<DefDeftype>()) {
-        const Type& t = type(d.as<DefDeftype>().type);
+        const Type& t = type(d.as<DefDeftype>(*this).type);
         if (t.holds<TypeUnion>()) {
-            return t.as<TypeUnion>().def_id;
+            return t.as<TypeUnion>(*this).def_id;
         }
     }
     return {};
@@ -849,9 +1323,9 @@ ExecId Context::exec_id(IdIdx<ExecId> id) const { return exec_ids.cat(id); }
         return did;
     }
     if (d.holds<DefDeftype>()) {
-        const Type& t = type(d.as<DefDeftype>().type);
+        const Type& t = type(d.as<DefDeftype>(*this).type);
         if (t.holds<TypeVariant>()) {
-            return t.as<TypeVariant>().def_id;
+            return t.as<TypeVariant>(*this).def_id;
         }
     }
     return {};
@@ -869,6 +1343,56 @@ OptId<DefId> Context::look_up_namespace(ScopeId scope, SymbolId sid) const {
     return Scope::look_up_namespace(*this, scope, sid);
 }
 
+OptId<DefId> Context::look_up_frozen(ScopeId scope, SymbolId sid, scope_kind kind) const {
+    if ((frozen_look_up_cnt + 1) * 2 > frozen_look_ups.size()) {
+        grow_frozen_look_ups();
+    }
+    const std::array<uint32_t, 3> key{scope.val(), sid.val(), static_cast<uint32_t>(kind)};
+    const auto hash = static_cast<uint32_t>(hash_bytes(key.data(), sizeof(key)));
+    const size_t mask = frozen_look_ups.size() - 1;
+    size_t idx = hash & mask;
+    for (; frozen_look_ups[idx].epoch == path_memo_epoch; idx = (idx + 1) & mask) {
+        const FrozenLookUpSlot& slot = frozen_look_ups[idx];
+        if (slot.hash == hash && slot.scope == scope && slot.symbol == sid && slot.kind == kind) {
+            return slot.did;
+        }
+    }
+    const OptId<DefId> did = Scope::look_up_unflattened(*this, scope, sid, kind);
+    frozen_look_ups[idx] = FrozenLookUpSlot{path_memo_epoch, hash, scope, sid, kind, did};
+    ++frozen_look_up_cnt;
+    return did;
+}
+
+void Context::grow_frozen_look_ups() const {
+    static constexpr size_t MIN_CAP = 64;
+    const size_t cap = frozen_look_ups.empty() ? MIN_CAP : frozen_look_ups.size() * 2;
+    std::vector<FrozenLookUpSlot> old = std::move(frozen_look_ups);
+    frozen_look_ups.assign(cap, FrozenLookUpSlot{});
+    const size_t mask = cap - 1;
+    for (const FrozenLookUpSlot& slot : old) {
+        if (slot.epoch != path_memo_epoch) {
+            continue;
+        }
+        size_t idx = slot.hash & mask;
+        while (frozen_look_ups[idx].epoch == path_memo_epoch) {
+            idx = (idx + 1) & mask;
+        }
+        frozen_look_ups[idx] = slot;
+    }
+}
+
+void Context::freeze_module_scopes() {
+    if (scopes.size() == 0) {
+        return;
+    }
+    scopes.at(root_scope()).freeze();
+    for (DefId did = defs.begin_id(); did != defs.end_id(); ++did) {
+        if (defs.cat(did).holds<DefModule>()) {
+            scopes.at(defs.cat(did).as<DefModule>(*this).scope).freeze();
+        }
+    }
+}
+
 OptId<DefId> Context::look_up_scoped(auto F, ScopeId scope, IdSlice<SymbolId> id_slice,
                                      Span id_span) {
     ScopeId curr_scope = scope;
@@ -886,7 +1410,7 @@ OptId<DefId> Context::look_up_scoped(auto F, ScopeId scope, IdSlice<SymbolId> id
                                  IdSlice<SymbolId>{id_slice.begin(),
                                                    sidx.val() + 1 - id_slice.begin().val()},
                                  id_span))
-                             .as<DefModule>()
+                             .as<DefModule>(*this)
                              .scope;
         } else if (auto maybe_type = look_up_type(curr_scope, sid); maybe_type.has_value()) {
             curr_scope = scope_for_top_level_def(guard_hid_type(
@@ -899,20 +1423,162 @@ OptId<DefId> Context::look_up_scoped(auto F, ScopeId scope, IdSlice<SymbolId> id
     return OptId<DefId>{};
 }
 
+static uint32_t path_memo_hash(IdSlice<SymbolId> path, ScopeId scope, scope_kind kind) {
+    const std::array<uint32_t, 4> key{path.begin().val(), path.len(), scope.val(),
+                                      static_cast<uint32_t>(kind)};
+    return static_cast<uint32_t>(hash_bytes(key.data(), sizeof(key)));
+}
+
+OptId<DefId> Context::look_up_scoped_memoized(scope_kind kind, auto F, ScopeId scope,
+                                              IdSlice<SymbolId> id_slice, Span id_span) {
+    if ((path_memo_cnt + 1) * 2 > path_memo.size()) {
+        grow_path_memo();
+    }
+    const uint32_t hash = path_memo_hash(id_slice, scope, kind);
+    const uint32_t generation = this->scope(scope).generation();
+    const size_t mask = path_memo.size() - 1;
+    size_t idx = hash & mask;
+    for (; path_memo[idx].epoch == path_memo_epoch; idx = (idx + 1) & mask) {
+        const PathMemoSlot& slot = path_memo[idx];
+        if (slot.hash == hash && slot.path == id_slice && slot.scope == scope
+            && slot.scope_generation == generation && slot.kind == kind) {
+            return slot.did;
+        }
+    }
+    const size_t diag_cnt = diagnostics.size();
+    const OptId<DefId> maybe_did = look_up_scoped(F, scope, id_slice, id_span);
+    // a hidden def is reported at every mention, so those look ups always run in full
+    if (maybe_did.has_value() && diagnostics.size() == diag_cnt) {
+        path_memo[idx] = PathMemoSlot{path_memo_epoch, hash, id_slice, scope, generation, kind,
+                                      maybe_did.as_id()};
+        ++path_memo_cnt;
+    }
+    return maybe_did;
+}
+
+void Context::grow_path_memo() {
+    static constexpr size_t MIN_CAP = 64;
+    const size_t cap = path_memo.empty() ? MIN_CAP : path_memo.size() * 2;
+    std::vector<PathMemoSlot> old = std::move(path_memo);
+    path_memo.assign(cap, PathMemoSlot{});
+    const size_t mask = cap - 1;
+    for (const PathMemoSlot& slot : old) {
+        if (slot.epoch != path_memo_epoch) {
+            continue;
+        }
+        size_t idx = slot.hash & mask;
+        while (path_memo[idx].epoch == path_memo_epoch) {
+            idx = (idx + 1) & mask;
+        }
+        path_memo[idx] = slot;
+    }
+}
+
+static uint64_t compt_call_memo_hash(DefId func, const llvm::SmallVectorImpl<uint64_t>& key) {
+    return hash_bytes(key.data(), key.size() * sizeof(uint64_t)) ^ hash_uint32(func.val());
+}
+
+size_t Context::compt_call_memo_idx(DefId func, const llvm::SmallVectorImpl<uint64_t>& key,
+                                    uint64_t hash) const {
+    const size_t mask = compt_call_memo.size() - 1;
+    size_t idx = hash & mask;
+    for (; compt_call_memo[idx].func.has_value(); idx = (idx + 1) & mask) {
+        const ComptCallMemoSlot& slot = compt_call_memo[idx];
+        if (slot.hash == hash && slot.func.as_id() == func && slot.key_len == key.size()
+            && std::equal(key.begin(), key.end(), compt_call_memo_keys.begin() + slot.key_start)) {
+            break;
+        }
+    }
+    return idx;
+}
+
+std::optional<ComptCallOutcome>
+Context::memoized_compt_call(DefId func, const llvm::SmallVectorImpl<uint64_t>& key) const {
+    if (compt_call_memo_cnt == 0) {
+        return std::nullopt;
+    }
+    const ComptCallMemoSlot& slot
+        = compt_call_memo[compt_call_memo_idx(func, key, compt_call_memo_hash(func, key))];
+    if (slot.func.empty()
+        || (slot.outcome.poisoned() && slot.poison_epoch != scratch_generation_epoch)) {
+        return std::nullopt;
+    }
+    return slot.outcome;
+}
+
+void Context::memoize_compt_call(DefId func, const llvm::SmallVectorImpl<uint64_t>& key,
+                                 const ExecConst& value) {
+    memoize_compt_call(func, key, ComptCallOutcome{.value = value, .exec = {}});
+}
+
+void Context::memoize_compt_call(DefId func, const llvm::SmallVectorImpl<uint64_t>& key,
+                                 OptId<ExecId> result) {
+    assert((result.empty() || !is_scratch_exec(result.as_id()))
+           && "[hir::Context] a memoized compt call must outlive the scratch generation");
+    memoize_compt_call(func, key, ComptCallOutcome{.value = std::nullopt, .exec = result});
+}
+
+void Context::memoize_compt_call(DefId func, const llvm::SmallVectorImpl<uint64_t>& key,
+                                 const ComptCallOutcome& outcome) {
+    if ((compt_call_memo_cnt + 1) * 2 > compt_call_memo.size()) {
+        grow_compt_call_memo();
+    }
+    const uint64_t hash = compt_call_memo_hash(func, key);
+    ComptCallMemoSlot& slot = compt_call_memo[compt_call_memo_idx(func, key, hash)];
+    if (slot.func.has_value()) {
+        // a result stands (a recursive call may have already recorded it), a stale poison doesn't
+        if (slot.outcome.poisoned() && slot.poison_epoch != scratch_generation_epoch) {
+            slot.outcome = outcome;
+            slot.poison_epoch = scratch_generation_epoch;
+        }
+        return;
+    }
+    slot = ComptCallMemoSlot{hash,
+                             OptId<DefId>{func},
+                             static_cast<uint32_t>(compt_call_memo_keys.size()),
+                             static_cast<uint32_t>(key.size()),
+                             outcome,
+                             scratch_generation_epoch};
+    compt_call_memo_keys.insert(compt_call_memo_keys.end(), key.begin(), key.end());
+    ++compt_call_memo_cnt;
+}
+
+void Context::grow_compt_call_memo() {
+    static constexpr size_t MIN_CAP = 64;
+    const size_t cap = compt_call_memo.empty() ? MIN_CAP : compt_call_memo.size() * 2;
+    std::vector<ComptCallMemoSlot> old = std::move(compt_call_memo);
+    compt_call_memo.assign(cap, ComptCallMemoSlot{});
+    const size_t mask = cap - 1;
+    for (const ComptCallMemoSlot& slot : old) {
+        if (slot.func.empty()) {
+            continue;
+        }
+        size_t idx = slot.hash & mask;
+        while (compt_call_memo[idx].func.has_value()) {
+            idx = (idx + 1) & mask;
+        }
+        compt_call_memo[idx] = slot;
+    }
+}
+
 OptId<DefId> Context::look_up_scoped_variable(ScopeId scope, IdSlice<SymbolId> id_slice,
                                               Span id_span) {
-    return look_up_scoped(
+    return look_up_scoped_memoized(
+        scope_kind::variable,
         [this](ScopeId scope, SymbolId sid) { return look_up_variable(scope, sid); }, scope,
         id_slice, id_span);
 }
 
 OptId<DefId> Context::look_up_scoped_type(ScopeId scope, IdSlice<SymbolId> id_slice, Span id_span) {
-    return look_up_scoped([this](ScopeId scope, SymbolId sid) { return look_up_type(scope, sid); },
-                          scope, id_slice, id_span);
+    return look_up_scoped_memoized(
+        scope_kind::type,
+        [this](ScopeId scope, SymbolId sid) { return look_up_type(scope, sid); }, scope, id_slice,
+        id_span);
 }
 OptId<DefId> Context::look_up_scoped_namespace(ScopeId scope, IdSlice<SymbolId> id_slice,
                                                Span id_span) {
-    return look_up_scoped(
+    return look_up_scoped_memoized(
+        scope_kind::namespacee,
         [this](ScopeId scope, SymbolId sid) { return look_up_namespace(scope, sid); }, scope,
         id_slice, id_span);
 }
@@ -930,7 +1596,7 @@ DefId Context::guard_hid(auto F, ScopeId scope, DefId did, IdSlice<SymbolId> id_
             DiagnosticIdentifierBeforeMessage{.sid_slice = id_slice});
 
         auto d1 = emplace_diagnostic_with_message_value(
-            defin.span, diag_code::declared_here, diag_type::note,
+            defin.span(*this), diag_code::declared_here, diag_type::note,
             DiagnosticIdentifierBeforeMessage{.sid_slice = id_slice});
 
         link_diagnostic(d0, d1);
@@ -965,7 +1631,7 @@ OptId<DefId> Context::look_up_scoped_bypassing_visibility(auto F, ScopeId scope,
             return maybe;
         }
         if (auto maybe_mod = look_up_namespace(curr_scope, sid); maybe_mod.has_value()) {
-            curr_scope = def(maybe_mod.as_id()).as<DefModule>().scope;
+            curr_scope = def(maybe_mod.as_id()).as<DefModule>(*this).scope;
         } else if (auto maybe_type = look_up_type(curr_scope, sid); maybe_type.has_value()) {
             curr_scope = scope_for_top_level_def(maybe_type.as_id());
         }
@@ -996,13 +1662,13 @@ OptId<DefId> Context::look_up_member_var_guarding_hid(const Def& struct_def, Sym
                                                       Span id_span, ScopeId local_scope) {
     assert(struct_def.holds<DefStruct>());
     auto maybe_def
-        = Scope::look_up_local_variable(*this, struct_def.as<DefStruct>().scope, symbol_id);
+        = Scope::look_up_local_variable(*this, struct_def.as<DefStruct>(*this).scope, symbol_id);
     if (maybe_def.empty()) {
         auto d0 = emplace_diagnostic_with_message_value(
             id_span, diag_code::id_does_not_name_a_member_variable_of, diag_type::error,
             DiagnosticSymbolAfterMessage{.sid = struct_def.name});
         auto d1 = emplace_diagnostic_with_message_value(
-            struct_def.span, diag_code::declared_here, diag_type::note,
+            struct_def.span(*this), diag_code::declared_here, diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = struct_def.name});
         link_diagnostic(d0, d1);
         return std::nullopt;
@@ -1013,7 +1679,7 @@ OptId<DefId> Context::look_up_member_var_guarding_hid(const Def& struct_def, Sym
             id_span, diag_code::id_does_not_name_a_member_variable_of, diag_type::error,
             DiagnosticSymbolAfterMessage{.sid = struct_def.name});
         auto d1 = emplace_diagnostic_with_message_value(
-            def.span, diag_code::declared_here, diag_type::note,
+            def.span(*this), diag_code::declared_here, diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = def.name});
         link_diagnostic(d0, d1);
         return std::nullopt;
@@ -1023,17 +1689,17 @@ OptId<DefId> Context::look_up_member_var_guarding_hid(const Def& struct_def, Sym
             id_span, diag_code::id_names_a_static_mem_thru_dot_for, diag_type::error,
             DiagnosticSymbolAfterMessage{.sid = struct_def.name});
         auto d1 = emplace_diagnostic_with_message_value(
-            def.span, diag_code::declared_here, diag_type::note,
+            def.span(*this), diag_code::declared_here, diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = def.name});
         link_diagnostic(d0, d1);
         return std::nullopt;
     }
-    if (!def.pub && !scope_has_parent(local_scope, struct_def.as<DefStruct>().scope)) {
+    if (!def.pub && !scope_has_parent(local_scope, struct_def.as<DefStruct>(*this).scope)) {
         auto d0 = emplace_diagnostic_with_message_value(
             id_span, diag_code::is_declared_hid, diag_type::error,
             DiagnosticSymbolBeforeMessage{.sid = symbol_id});
         auto d1 = emplace_diagnostic_with_message_value(
-            def.span, diag_code::declared_here, diag_type::note,
+            def.span(*this), diag_code::declared_here, diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = symbol_id});
         link_diagnostic(d0, d1);
     }
@@ -1044,13 +1710,13 @@ OptId<DefId> Context::look_up_member_function_guarding_hid(const Def& struct_def
                                                            SymbolId symbol_id, Span id_span,
                                                            ScopeId local_scope) {
     auto maybe_def
-        = Scope::look_up_local_variable(*this, struct_def.as<DefStruct>().scope, symbol_id);
+        = Scope::look_up_local_variable(*this, struct_def.as<DefStruct>(*this).scope, symbol_id);
     if (maybe_def.empty()) {
         auto d0 = emplace_diagnostic_with_message_value(
             id_span, diag_code::id_does_not_name_a_method_of, diag_type::error,
             DiagnosticSymbolAfterMessage{.sid = struct_def.name});
         auto d1 = emplace_diagnostic_with_message_value(
-            struct_def.span, diag_code::declared_here, diag_type::note,
+            struct_def.span(*this), diag_code::declared_here, diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = struct_def.name});
         link_diagnostic(d0, d1);
         return std::nullopt;
@@ -1061,17 +1727,17 @@ OptId<DefId> Context::look_up_member_function_guarding_hid(const Def& struct_def
             id_span, diag_code::id_does_not_name_a_method_of, diag_type::error,
             DiagnosticSymbolAfterMessage{.sid = struct_def.name});
         auto d1 = emplace_diagnostic_with_message_value(
-            def.span, diag_code::declared_here, diag_type::note,
+            def.span(*this), diag_code::declared_here, diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = def.name});
         link_diagnostic(d0, d1);
         return std::nullopt;
     }
-    if (!def.pub && !scope_has_parent(local_scope, struct_def.as<DefStruct>().scope)) {
+    if (!def.pub && !scope_has_parent(local_scope, struct_def.as<DefStruct>(*this).scope)) {
         auto d0 = emplace_diagnostic_with_message_value(
             id_span, diag_code::is_declared_hid, diag_type::error,
             DiagnosticSymbolBeforeMessage{.sid = symbol_id});
         auto d1 = emplace_diagnostic_with_message_value(
-            def.span, diag_code::declared_here, diag_type::note,
+            def.span(*this), diag_code::declared_here, diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = symbol_id});
         link_diagnostic(d0, d1);
     }
@@ -1082,7 +1748,7 @@ OptId<DefId> Context::look_up_member_function_no_diag_except_hid(const Def& stru
                                                                  SymbolId symbol_id, Span id_span,
                                                                  ScopeId local_scope) {
     auto maybe_def
-        = Scope::look_up_local_variable(*this, struct_def.as<DefStruct>().scope, symbol_id);
+        = Scope::look_up_local_variable(*this, struct_def.as<DefStruct>(*this).scope, symbol_id);
     if (maybe_def.empty()) {
         return std::nullopt;
     }
@@ -1090,12 +1756,12 @@ OptId<DefId> Context::look_up_member_function_no_diag_except_hid(const Def& stru
     if (!def.holds<DefFunction>()) {
         return std::nullopt;
     }
-    if (!def.pub && !scope_has_parent(local_scope, struct_def.as<DefStruct>().scope)) {
+    if (!def.pub && !scope_has_parent(local_scope, struct_def.as<DefStruct>(*this).scope)) {
         auto d0 = emplace_diagnostic_with_message_value(
             id_span, diag_code::is_declared_hid, diag_type::error,
             DiagnosticSymbolBeforeMessage{.sid = symbol_id});
         auto d1 = emplace_diagnostic_with_message_value(
-            def.span, diag_code::declared_here, diag_type::note,
+            def.span(*this), diag_code::declared_here, diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = symbol_id});
         link_diagnostic(d0, d1);
     }
@@ -1106,7 +1772,7 @@ OptId<DefId> Context::look_up_member_var_no_diag_except_hid(const Def& struct_de
                                                             SymbolId symbol_id, Span id_span,
                                                             ScopeId local_scope) {
     auto maybe_def
-        = Scope::look_up_local_variable(*this, struct_def.as<DefStruct>().scope, symbol_id);
+        = Scope::look_up_local_variable(*this, struct_def.as<DefStruct>(*this).scope, symbol_id);
     if (maybe_def.empty()) {
         return std::nullopt;
     }
@@ -1114,12 +1780,12 @@ OptId<DefId> Context::look_up_member_var_no_diag_except_hid(const Def& struct_de
     if (!def.holds<DefVariable>()) {
         return std::nullopt;
     }
-    if (!def.pub && !scope_has_parent(local_scope, struct_def.as<DefStruct>().scope)) {
+    if (!def.pub && !scope_has_parent(local_scope, struct_def.as<DefStruct>(*this).scope)) {
         auto d0 = emplace_diagnostic_with_message_value(
             id_span, diag_code::is_declared_hid, diag_type::error,
             DiagnosticSymbolBeforeMessage{.sid = symbol_id});
         auto d1 = emplace_diagnostic_with_message_value(
-            def.span, diag_code::declared_here, diag_type::note,
+            def.span(*this), diag_code::declared_here, diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = symbol_id});
         link_diagnostic(d0, d1);
     }
@@ -1179,11 +1845,11 @@ bool Context::scope_has_parent(ScopeId local_scope, ScopeId possible_parent) con
                 && symbol_id<"len">() == symbol_id(id_slice.get(1))) {
                 const auto did = maybe_did.as_id();
                 const Def& d = def(did);
-                if (d.holds<DefVariable>() && d.as<DefVariable>().compt_value.has_value()) {
+                if (d.holds<DefVariable>() && d.as<DefVariable>(*this).compt_value.has_value()) {
                     TopLevelDefVisitor def_vis{*this};
                     ComptExprSolver<TopLevelDefVisitor> solver{*this, def_vis};
                     const OptId<TypeId> maybe_tid
-                        = solver.infer_type_from_exec(d.as<DefVariable>().compt_value.as_id());
+                        = solver.infer_type_from_exec(d.as<DefVariable>(*this).compt_value.as_id());
                     if (maybe_tid.has_value()) {
                         const auto ty = type(maybe_tid.as_id());
                         // this is a compt list literal
@@ -1202,10 +1868,10 @@ bool Context::scope_has_parent(ScopeId local_scope, ScopeId possible_parent) con
             const Def& def = this->def(did);
             // try get chained structs
             if (def.holds<DefVariable>()) {
-                const DefVariable var_def = def.as<DefVariable>();
-                const Type& type = this->type(try_decay_ref(def.as<DefVariable>().type_id));
+                const DefVariable var_def = def.as<DefVariable>(*this);
+                const Type& type = this->type(try_decay_ref(def.as<DefVariable>(*this).type_id));
                 if (type.holds<TypeStruct>()) {
-                    curr_did = type.as<TypeStruct>().def_id;
+                    curr_did = type.as<TypeStruct>(*this).def_id;
                 } else if (var_def.compt_value.has_value()) {
                     TopLevelDefVisitor def_vis{*this};
                     ComptExprSolver<TopLevelDefVisitor> solver{*this, def_vis};
@@ -1213,7 +1879,7 @@ bool Context::scope_has_parent(ScopeId local_scope, ScopeId possible_parent) con
                         = solver.infer_type_from_exec(var_def.compt_value.as_id());
                     if (maybe_tid.has_value()
                         && this->type(maybe_tid.as_id()).holds<TypeStruct>()) {
-                        curr_did = this->type(maybe_tid.as_id()).as<TypeStruct>().def_id;
+                        curr_did = this->type(maybe_tid.as_id()).as<TypeStruct>(*this).def_id;
                     } else {
                         return false;
                     }
@@ -1235,7 +1901,7 @@ bool Context::scope_has_parent(ScopeId local_scope, ScopeId possible_parent) con
                 id_span, diag_code::is_declared_hid, diag_type::error,
                 DiagnosticIdentifierBeforeMessage{.sid_slice = id_slice});
             auto d1 = emplace_diagnostic_with_message_value(
-                deffy.span, diag_code::declared_here, diag_type::note,
+                deffy.span(*this), diag_code::declared_here, diag_type::note,
                 DiagnosticIdentifierBeforeMessage{.sid_slice = id_slice});
             link_diagnostic(d0, d1);
         }
@@ -1255,16 +1921,48 @@ bool Context::scope_has_parent(ScopeId local_scope, ScopeId possible_parent) con
 }
 
 IdSlice<SymbolId> Context::symbol_slice(token_ptr_slice_t token_slice) {
+    if ((symbol_slice_memo_cnt + 1) * 2 > symbol_slice_memo.size()) {
+        grow_symbol_slice_memo();
+    }
+    const size_t mask = symbol_slice_memo.size() - 1;
+    size_t idx = hash_bytes(static_cast<const void*>(&token_slice.start), sizeof(token_t**)) & mask;
+    for (; symbol_slice_memo[idx].tokens; idx = (idx + 1) & mask) {
+        const SymbolSliceMemoSlot& slot = symbol_slice_memo[idx];
+        if (slot.tokens == token_slice.start && slot.slice.len() == token_slice.len) {
+            return slot.slice;
+        }
+    }
     llvm::SmallVector<SymbolId> vec{};
     for (size_t i = 0; i < token_slice.len; i++) {
         const token_t* tkn = token_slice.start[i];
         vec.push_back(symbol_id(tkn));
     }
-    return freeze_id_vec(vec);
+    const IdSlice<SymbolId> slice = intern_id_vec(vec);
+    symbol_slice_memo[idx] = SymbolSliceMemoSlot{token_slice.start, slice};
+    ++symbol_slice_memo_cnt;
+    return slice;
+}
+
+void Context::grow_symbol_slice_memo() {
+    static constexpr size_t MIN_CAP = 64;
+    const size_t cap = symbol_slice_memo.empty() ? MIN_CAP : symbol_slice_memo.size() * 2;
+    std::vector<SymbolSliceMemoSlot> old = std::move(symbol_slice_memo);
+    symbol_slice_memo.assign(cap, SymbolSliceMemoSlot{nullptr, IdSlice<SymbolId>{}});
+    const size_t mask = cap - 1;
+    for (const SymbolSliceMemoSlot& slot : old) {
+        if (!slot.tokens) {
+            continue;
+        }
+        size_t idx = hash_bytes(static_cast<const void*>(&slot.tokens), sizeof(token_t**)) & mask;
+        while (symbol_slice_memo[idx].tokens) {
+            idx = (idx + 1) & mask;
+        }
+        symbol_slice_memo[idx] = slot;
+    }
 }
 
 ScopeId Context::containing_scope(DefId did) const {
-    auto maybe_parent = defs.cat(did).parent;
+    auto maybe_parent = def(did).parent;
     // ----- base cases (parent w/ scope)---------
     if (!maybe_parent.has_value()) {
         return root_scope();
@@ -1272,10 +1970,10 @@ ScopeId Context::containing_scope(DefId did) const {
     DefId parent_id = maybe_parent.as_id();
     const Def& par_def = def(parent_id);
     if (par_def.holds<DefModule>()) {
-        return par_def.as<DefModule>().scope;
+        return par_def.as<DefModule>(*this).scope;
     }
     if (par_def.holds<DefScopeWrapper>()) {
-        return par_def.as<DefScopeWrapper>().scope;
+        return par_def.as<DefScopeWrapper>(*this).scope;
     }
     auto maybe_structure = try_scope_for_top_level_def(parent_id);
     if (maybe_structure.has_value()) {
@@ -1294,7 +1992,7 @@ OptId<ScopeId> Context::func_to_scope(DefId did) { return def_to_scope_for_funcs
 
 Span Context::name_span_for_def(DefId did) const {
     const Def& def = this->def(did);
-    return Span{*this, def.span.file_id,
+    return Span{*this, def.span(*this).file_id(*this),
                 FileAstVisitor::name_of_ast_decl(def_ast_node(did)).value()};
 }
 
@@ -1357,7 +2055,8 @@ bool Context::report_invalid_return_type(TypeId return_tid) {
             ty.span, diag_code::replace_occurences_of_var_with_an_explicit_type, diag_type::help));
         return true;
     }
-    if (canon_ty.holds<TypeBuiltin>() && canon_ty.as<TypeBuiltin>().type == builtin_type::voidd) {
+    if (canon_ty.holds<TypeBuiltin>()
+        && canon_ty.as<TypeBuiltin>(*this).type == builtin_type::voidd) {
         dlinker.link(emplace_diagnostic_with_message_value(
             ty.span, diag_code::invalid_return_type, diag_type::error,
             DiagnosticTypeAfterMessage{.tid = return_tid}));
@@ -1401,7 +2100,7 @@ IdSlice<SymbolId> Context::try_singly_qualified_name(DefId did) {
 
     sids.push_back(def.name);
 
-    return freeze_id_vec(sids);
+    return intern_id_vec(sids);
 }
 
 bool Context::check_variant_field_has_parent(DefId variant_field_did, DefId variant_did,
@@ -1417,7 +2116,7 @@ bool Context::check_variant_field_has_parent(DefId variant_field_did, DefId vari
                                      .after_sid = def(def(variant_field_did).parent.as_id()).name},
                                  DiagnosticInfoNoPreview{});
         const auto d2 = emplace_diagnostic_with_message_value(
-            def(def(variant_field_did).parent.as_id()).span, diag_code::declared_here,
+            def(def(variant_field_did).parent.as_id()).span(*this), diag_code::declared_here,
             diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = def(def(variant_field_did).parent.as_id()).name});
         link_diagnostic(d0, d1);
@@ -1438,22 +2137,22 @@ bool Context::func_sigs_match_for_contract(DefId did1, DefId did2) {
 
     OptId<DefId> struct_did{};
     if (def1.holds<DefFunction>()) {
-        param_tids1 = def1.as<DefFunction>().param_types;
-        return_tid1 = def1.as<DefFunction>().return_type;
+        param_tids1 = def1.as<DefFunction>(*this).param_types;
+        return_tid1 = def1.as<DefFunction>(*this).return_type;
         struct_did = def1.parent; // since the function's parent_should be a struct
     } else if (def1.holds<DefFunctionPrototype>()) {
-        param_tids1 = def1.as<DefFunctionPrototype>().param_types;
-        return_tid1 = def1.as<DefFunctionPrototype>().return_type;
+        param_tids1 = def1.as<DefFunctionPrototype>(*this).param_types;
+        return_tid1 = def1.as<DefFunctionPrototype>(*this).return_type;
     } else {
         return false;
     }
     if (def2.holds<DefFunction>()) {
-        param_tids2 = def2.as<DefFunction>().param_types;
-        return_tid2 = def2.as<DefFunction>().return_type;
+        param_tids2 = def2.as<DefFunction>(*this).param_types;
+        return_tid2 = def2.as<DefFunction>(*this).return_type;
         struct_did = def2.parent; // since the function's parent_should be a struct
     } else if (def2.holds<DefFunctionPrototype>()) {
-        param_tids2 = def2.as<DefFunctionPrototype>().param_types;
-        return_tid2 = def2.as<DefFunctionPrototype>().return_type;
+        param_tids2 = def2.as<DefFunctionPrototype>(*this).param_types;
+        return_tid2 = def2.as<DefFunctionPrototype>(*this).return_type;
     } else {
         return false;
     }
@@ -1499,20 +2198,20 @@ DiagRange Context::report_function_disagreement_with_contract(DefId contract_fn_
     OptId<TypeId> fn_return_tid;
 
     if (contracts_def.holds<DefFunction>()) {
-        ct_param_tids = contracts_def.as<DefFunction>().param_types;
-        ct_return_tid = contracts_def.as<DefFunction>().return_type;
+        ct_param_tids = contracts_def.as<DefFunction>(*this).param_types;
+        ct_return_tid = contracts_def.as<DefFunction>(*this).return_type;
     } else if (contracts_def.holds<DefFunctionPrototype>()) {
-        ct_param_tids = contracts_def.as<DefFunctionPrototype>().param_types;
-        ct_return_tid = contracts_def.as<DefFunctionPrototype>().return_type;
+        ct_param_tids = contracts_def.as<DefFunctionPrototype>(*this).param_types;
+        ct_return_tid = contracts_def.as<DefFunctionPrototype>(*this).return_type;
     } else {
         return {};
     }
     if (fn_def.holds<DefFunction>()) {
-        fn_param_tids = fn_def.as<DefFunction>().param_types;
-        fn_return_tid = fn_def.as<DefFunction>().return_type;
+        fn_param_tids = fn_def.as<DefFunction>(*this).param_types;
+        fn_return_tid = fn_def.as<DefFunction>(*this).return_type;
     } else if (fn_def.holds<DefFunctionPrototype>()) {
-        fn_param_tids = fn_def.as<DefFunctionPrototype>().param_types;
-        fn_return_tid = fn_def.as<DefFunctionPrototype>().return_type;
+        fn_param_tids = fn_def.as<DefFunctionPrototype>(*this).param_types;
+        fn_return_tid = fn_def.as<DefFunctionPrototype>(*this).return_type;
     } else {
         return {};
     }
@@ -1576,13 +2275,13 @@ OptId<TypeId> Context::self_type_for_fn(ScopeId scope, const ast_stmt_fn_decl_t*
 
         if (maybe_did.has_value()) {
             auto def = this->def(maybe_did.as_id());
-            TypeId self_tid = def.as<DefDeftype>().type;
+            TypeId self_tid = def.as<DefDeftype>(*this).type;
             const auto& ty = type(self_tid);
             // if mut then we actually need to ensure we're mut
             if (fn_decl->is_mut) {
                 // we have to emplace a new type in this case since we can't mutate the original
                 if (!ty.mut) {
-                    self_tid = emplace_type(ty.value, ty.span, true); // mut
+                    self_tid = emplace_type(ty.value(*this), ty.span, true); // mut
                 }
             }
             // make a reference
@@ -1601,7 +2300,7 @@ bool Context::struct_has_contract(DefId struct_did, DefId contract_did) {
     }
     const SymbolId contract_sid = contract_def.name;
     auto maybe_corresponding_contract_did
-        = Scope::look_up_local_type(*this, struct_def.as<DefStruct>().scope, contract_sid);
+        = Scope::look_up_local_type(*this, struct_def.as<DefStruct>(*this).scope, contract_sid);
 
     return maybe_corresponding_contract_did.has_value()
            && contract_did == maybe_corresponding_contract_did.as_id();
@@ -1613,7 +2312,7 @@ bool Context::type_has_contract(TypeId tid, DefId contract_did) {
     if (!ty.holds<TypeStruct>()) {
         return false;
     }
-    return struct_has_contract(ty.as<TypeStruct>().def_id, contract_did);
+    return struct_has_contract(ty.as<TypeStruct>(*this).def_id, contract_did);
 }
 
 bool Context::inferable_as_struct(TypeId tid1, TypeId tid2, DefId struct_did) const {
@@ -1634,7 +2333,7 @@ bool Context::inferable_as_struct(TypeId tid1, TypeId tid2, DefId struct_did) co
         if (!t2.holds<TypeStruct>()) {
             return false;
         }
-        if (t2.as<TypeStruct>().def_id != struct_did) {
+        if (t2.as<TypeStruct>(*this).def_id != struct_did) {
             return false;
         }
     }
@@ -1643,7 +2342,7 @@ bool Context::inferable_as_struct(TypeId tid1, TypeId tid2, DefId struct_did) co
         if (!t1.holds<TypeStruct>()) {
             return false;
         }
-        if (t1.as<TypeStruct>().def_id != struct_did) {
+        if (t1.as<TypeStruct>(*this).def_id != struct_did) {
             return false;
         }
     }
@@ -1656,19 +2355,20 @@ bool Context::type_matches_struct_def(TypeId tid, DefId did) {
     if (!ty.holds<TypeStruct>()) {
         return false;
     }
-    return ty.as<TypeStruct>().def_id == did; // only matches if did is also a struct, of course
+    // only matches if did is also a struct, of course
+    return ty.as<TypeStruct>(*this).def_id == did;
 }
 
 OptId<CanonicalComptArgsId> Context::generic_args_for_def(DefId did) {
     const Def& d = def(did);
     if (d.holds<DefFunction>()) {
-        return d.as<DefFunction>().maybe_generic_args;
+        return d.as<DefFunction>(*this).maybe_generic_args;
     }
     if (d.holds<DefVariant>()) {
-        return d.as<DefVariant>().maybe_generic_args;
+        return d.as<DefVariant>(*this).maybe_generic_args;
     }
     if (d.holds<DefStruct>()) {
-        return d.as<DefStruct>().maybe_generic_args;
+        return d.as<DefStruct>(*this).maybe_generic_args;
     }
     return {};
 }
@@ -1681,4 +2381,155 @@ OptId<DefId> Context::linear_name_match_in_def_slice(IdSlice<DefId> defs, Symbol
     }
     return {};
 }
+void Context::record_mem_phase(const char* phase) {
+    if (has_flag(CLI_FLAG_MEM_STATS)) {
+        mem_phases.push_back(mem_stats().total(phase));
+    }
+}
+
+MemStatsReport Context::mem_stats() const {
+    MemStatsReport report;
+    auto& rows = report.structures;
+
+    // arenas, w/ the tables allocated from them listed right below as nested rows
+    rows.push_back(mem_stat_of_arena("id_map_arena", id_map_arena.stats(), 0));
+    rows.push_back(mem_stat_of_map("symbol_id_to_file_id_map", symbol_id_to_file_id_map,
+                                   sizeof(flatmapu32u32_slot_t) + 1));
+    rows.push_back(mem_stat_of_map("def_to_scope_for_types", def_to_scope_for_types,
+                                   sizeof(flatmapu32u32_slot_t) + 1));
+    rows.push_back(mem_stat_of_map("def_to_scope_for_funcs", def_to_scope_for_funcs,
+                                   sizeof(flatmapu32u32_slot_t) + 1));
+    rows.push_back(mem_stat_of_map("def_to_ordered_def_slice_id", def_to_ordered_def_slice_id,
+                                   sizeof(flatmapu32u32_slot_t) + 1));
+
+    MemStat scope_tables{"scope tables", 0, 0, 0, true};
+    for (const Scope& scope : scopes) {
+        scope_tables.reserved += scope.table_bytes();
+        scope_tables.used += scope.used_table_bytes();
+        scope_tables.count += scope.entry_count();
+    }
+    rows.push_back(mem_stat_of_arena("scope_arena", scope_arena.stats(), scopes.size()));
+    rows.push_back(std::move(scope_tables));
+    rows.push_back(mem_stat_of_arena("temp_scope_arena", temp_scope_arena->stats(), 0));
+
+    rows.push_back(
+        mem_stat_of_arena("symbol_storage_arena", symbol_storage_arena.stats(), symbols.size()));
+    rows.push_back(mem_stat_of_arena("symbol_map_arena", symbol_map_arena.stats(), 0));
+    rows.push_back(
+        mem_stat_of_map("str_to_symbol_id_map", str_to_symbol_id_map, sizeof(strintern_slot_t)));
+    rows.push_back(mem_stat_of_arena("def_index_storage_arena", def_index_storage_arena.stats(),
+                                     def_index.size()));
+    rows.push_back(mem_stat_of_arena("def_index_map_arena", def_index_map_arena.stats(), 0));
+    rows.push_back(
+        mem_stat_of_map("def_index fqn map", def_index.fqn_map(), sizeof(strintern_slot_t)));
+    rows.push_back(mem_stat_of_arena("canonical_type_table_arena",
+                                     canonical_type_table_arena.stats(),
+                                     canonical_type_table.size()));
+    rows.push_back(MemStat{"type_intern_table",
+                           type_intern_table.capacity() * sizeof(TypeInternSlot),
+                           type_intern_cnt * sizeof(TypeInternSlot), type_intern_cnt});
+    rows.push_back(mem_stat_of_arena("generic_args_arena", generic_args_arena.stats(), 0));
+    rows.push_back(mem_stat_of_arena("canonical_generic_args_table_arena",
+                                     canonical_generic_args_table_arena.stats(), 0));
+
+    // dense vectors (shallow, so e.g. llvm::SmallVector spill storage isn't counted)
+    rows.push_back(mem_stat_of_vec("file_ids", file_ids));
+    rows.push_back(mem_stat_of_vec("files", files));
+    rows.push_back(mem_stat_of_vec("file_asts", file_asts));
+    rows.push_back(mem_stat_of_vec("importer_to_importees", importer_to_importees));
+    rows.push_back(mem_stat_of_vec("importee_to_importers", importee_to_importers));
+    rows.push_back(mem_stat_of_vec("file_to_diagnostics", file_to_diagnostics));
+    // per-file line and scope span indexes, each row sums the outer vector and every file's own
+    MemStat line_starts{"file_line_starts",
+                        file_line_starts.capacity() * sizeof(std::vector<HirSize>),
+                        file_line_starts.size() * sizeof(std::vector<HirSize>), 0};
+    for (const std::vector<HirSize>& starts : file_line_starts) {
+        line_starts.reserved += starts.capacity() * sizeof(HirSize);
+        line_starts.used += starts.size() * sizeof(HirSize);
+        line_starts.count += starts.size();
+    }
+    rows.push_back(std::move(line_starts));
+    MemStat scope_spans{"file_scope_spans", file_scope_spans.capacity() * sizeof(FileScopeSpans),
+                        file_scope_spans.size() * sizeof(FileScopeSpans), 0};
+    for (const FileScopeSpans& spans : file_scope_spans) {
+        scope_spans.reserved += spans.entries.capacity() * sizeof(ScopeSpanEntry);
+        scope_spans.used += spans.entries.size() * sizeof(ScopeSpanEntry);
+        scope_spans.count += spans.entries.size();
+    }
+    rows.push_back(std::move(scope_spans));
+    rows.push_back(mem_stat_of_vec("scopes", scopes));
+    rows.push_back(mem_stat_of_vec("symbol_ids", symbol_ids));
+    rows.push_back(mem_stat_of_vec("symbols", symbols));
+    rows.push_back(mem_stat_of_vec("exec_ids", exec_ids));
+    rows.push_back(mem_stat_of_vec("execs", execs));
+    rows.push_back(mem_stat_of_vec("exec_payloads", exec_payloads));
+    rows.push_back(mem_stat_of_vec("exec_types", exec_types));
+    rows.push_back(mem_stat_of_vec("scratch_execs", scratch_execs));
+    rows.push_back(mem_stat_of_vec("scratch_exec_types", scratch_exec_types));
+    rows.push_back(mem_stat_of_vec("scratch_exec_payloads", scratch_exec_payloads));
+    rows.push_back(mem_stat_of_vec("scratch_exec_ids", scratch_exec_ids));
+    rows.push_back(mem_stat_of_vec("scratch_defs", scratch_defs));
+    rows.push_back(mem_stat_of_vec("scratch_def_colds", scratch_def_colds));
+    rows.push_back(mem_stat_of_vec("scratch_def_mention_states", scratch_def_mention_states));
+    rows.push_back(MemStat{"free_scratch_defs", free_scratch_defs.capacity() * sizeof(DefId),
+                           free_scratch_defs.size() * sizeof(DefId), free_scratch_defs.size()});
+    rows.push_back(mem_stat_of_vec("def_ids", def_ids));
+    rows.push_back(mem_stat_of_vec("defs", defs));
+    rows.push_back(MemStat{"def_index", def_index.reserved_bytes(), def_index.used_bytes(),
+                           def_index.size()});
+    rows.push_back(mem_stat_of_vec("symbol_suggester", symbol_suggester));
+    rows.push_back(MemStat{"compt_call_memo",
+                           (compt_call_memo.capacity() * sizeof(ComptCallMemoSlot))
+                               + (compt_call_memo_keys.capacity() * sizeof(uint64_t)),
+                           (compt_call_memo_cnt * sizeof(ComptCallMemoSlot))
+                               + (compt_call_memo_keys.size() * sizeof(uint64_t)),
+                           compt_call_memo_cnt});
+    rows.push_back(MemStat{"compt_programs", compt_program_table.reserved_bytes(),
+                           compt_program_table.used_bytes(), compt_program_table.size()});
+    rows.push_back(MemStat{"symbol_slice_memo",
+                           symbol_slice_memo.capacity() * sizeof(SymbolSliceMemoSlot),
+                           symbol_slice_memo_cnt * sizeof(SymbolSliceMemoSlot),
+                           symbol_slice_memo_cnt});
+    // only the current epoch's slots are live, so stale ones count as reserved but not used
+    rows.push_back(MemStat{"path_memo", path_memo.capacity() * sizeof(PathMemoSlot),
+                           path_memo_cnt * sizeof(PathMemoSlot), path_memo_cnt});
+    // caches misses as well as hits, and shares path_memo's epochs
+    rows.push_back(MemStat{"frozen_look_ups",
+                           frozen_look_ups.capacity() * sizeof(FrozenLookUpSlot),
+                           frozen_look_up_cnt * sizeof(FrozenLookUpSlot), frozen_look_up_cnt});
+    rows.push_back(mem_stat_of_vec("def_colds", def_colds));
+    rows.push_back(mem_stat_of_vec("def_resol_states", def_resol_states));
+    rows.push_back(mem_stat_of_vec("def_ast_nodes", def_ast_nodes));
+    rows.push_back(mem_stat_of_vec("def_mention_states", def_mention_states));
+    rows.push_back(mem_stat_of_vec("ordered_def_slices", ordered_def_slices));
+    rows.push_back(mem_stat_of_vec("type_ids", type_ids));
+    rows.push_back(mem_stat_of_vec("types", types));
+    rows.push_back(mem_stat_of_vec("type_payloads", type_payloads));
+    rows.push_back(mem_stat_of_vec("canonical_to_type_id", canonical_to_type_id));
+    rows.push_back(mem_stat_of_vec("canonical_type_names", canonical_type_names));
+    rows.push_back(mem_stat_of_vec("generic_arg_ids", generic_arg_ids));
+    rows.push_back(mem_stat_of_vec("generic_args", generic_args));
+    rows.push_back(mem_stat_of_vec("canonical_generic_args_id_to_def_id_map",
+                                   canonical_generic_args_id_to_def_id_map));
+    rows.push_back(mem_stat_of_vec("canonical_generic_args_to_first_instance",
+                                   canonical_generic_args_to_first_instance));
+    rows.push_back(mem_stat_of_vec("generic_arg_id_slices", generic_arg_id_slices));
+    rows.push_back(mem_stat_of_vec("diagnostics", diagnostics));
+    rows.push_back(mem_stat_of_vec("diagnostics_used", diagnostics_used));
+
+    // per file: ast arena + token vector + src buffer
+    for (const FileAst& fast : file_asts) {
+        const arena_stats_t arena = fast.arena_stats();
+        const vector_t& tokens = fast.tokens();
+        const size_t src_size = fast.src()->size;
+        report.files.push_back(MemStat{
+            fast.file_name(),
+            arena.reserved + (tokens.capacity * tokens.elem_size) + src_size,
+            arena.used + (tokens.size * tokens.elem_size) + src_size,
+            tokens.size,
+        });
+    }
+    return report;
+}
+
 } // namespace hir
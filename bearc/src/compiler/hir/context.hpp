@@ -12,6 +12,8 @@
 #include "cli/args.h"
 #include "compiler/ast/stmt.h"
 #include "compiler/hir/arena_str_hash_map.hpp"
+#include "compiler/hir/compt_bytecode.hpp"
+#include "compiler/hir/compt_stack.hpp"
 #include "compiler/hir/def.hpp"
 #include "compiler/hir/def_visitor.hpp"
 #include "compiler/hir/diagnostic.hpp"
@@ -20,18 +22,30 @@
 #include "compiler/hir/generic.hpp"
 #include "compiler/hir/id_hash_map.hpp"
 #include "compiler/hir/indexing.hpp"
+#include "compiler/hir/mem_stats.hpp"
 #include "compiler/hir/node_vector.hpp"
 #include "compiler/hir/scope.hpp"
+#include "compiler/hir/symbol_index.hpp"
+#include "compiler/hir/symbol_suggester.hpp"
 #include "compiler/hir/type.hpp"
 #include "compiler/token.h"
 #include "utils/data_arena.hpp"
 #include "llvm/ADT/SmallVector.h"
+#include <array>
 #include <cstdint>
 #include <filesystem>
 #include <type_traits>
+#include <vector>
 
 namespace hir {
 
+/// a memoized pure compt call's outcome, see Context::memoized_compt_call
+struct ComptCallOutcome {
+    std::optional<ExecConst> value; // a constant result, kept out of the exec tables
+    OptId<ExecId> exec;             // any other result, as a permanent exec
+    [[nodiscard]] bool poisoned() const noexcept { return !value.has_value() && exec.empty(); }
+};
+
 /**
  * primary data container for hir structures
  * - this model allows for IDs and ID slices with no pointers
@@ -67,6 +81,40 @@ class Context {
     [[nodiscard]] const char* file_name(FileId id) const;
     [[nodiscard]] FileAst& ast(FileId file_id);
     [[nodiscard]] const FileAst& ast(FileId file_id) const;
+    /// payload storage backing Exec::as/visit/value, see hir::PayloadTables
+    [[nodiscard]] PayloadTables<ExecValue>& exec_payload_tables() noexcept { return exec_payloads; }
+    [[nodiscard]] const PayloadTables<ExecValue>& exec_payload_tables() const noexcept {
+        return exec_payloads;
+    }
+    /// payload storage backing scratch execs, emptied whenever a scratch generation ends
+    [[nodiscard]] PayloadTables<ExecValue>& scratch_exec_payload_tables() noexcept {
+        return scratch_exec_payloads;
+    }
+    [[nodiscard]] const PayloadTables<ExecValue>& scratch_exec_payload_tables() const noexcept {
+        return scratch_exec_payloads;
+    }
+    /// payload storage backing Type::as/visit/value, see hir::PayloadTables
+    [[nodiscard]] PayloadTables<TypeValue>& type_payload_tables() noexcept { return type_payloads; }
+    [[nodiscard]] const PayloadTables<TypeValue>& type_payload_tables() const noexcept {
+        return type_payloads;
+    }
+    /// global src offset of a file's first byte, see hir::Span
+    [[nodiscard]] HirSize file_base(FileId file_id) const;
+    /// file owning a global src offset
+    [[nodiscard]] FileId file_at(HirSize pos) const;
+    /// line/col of a global src offset, builds the owning file's line index on first use
+    [[nodiscard]] SrcLoc src_loc_at(HirSize pos) const;
+    /// global src offset of a 0-indexed line/col in a file, the inverse of src_loc_at
+    /// - out of range lines clamp to the last one, cols to the line's end (EOF on the last line)
+    [[nodiscard]] HirSize pos_at(FileId file_id, SrcLoc loc) const;
+    /// records the src a scope covers so position queries can find it, see innermost_scope_at
+    void record_scope_span(Span span, ScopeId scope);
+    /// innermost recorded scope whose src contains a global src offset, the root scope if none
+    /// - binary search over the owning file's scope spans, which are sorted on the first query
+    /// after a record
+    [[nodiscard]] ScopeId innermost_scope_at(HirSize pos) const;
+    /// workspace-wide index of top-level defs by fully qualified or partial name, for tooling
+    [[nodiscard]] const SymbolIndex& symbol_index() const noexcept { return def_index; }
 
     // ------ scoping -----------
     [[nodiscard]] ScopeId get_or_make_root_scope();
@@ -76,7 +124,17 @@ class Context {
     [[nodiscard]] ScopeId make_small_scope(OptId<ScopeId> parent_scope);
     [[nodiscard]] ScopeId make_medium_scope(OptId<ScopeId> parent_scope);
     [[nodiscard]] ScopeId make_scope(OptId<ScopeId> parent_scope, HirSize capacity);
+    // makes a named scope presized from the number of entries the AST says it will hold
+    [[nodiscard]] ScopeId make_scope(OptId<ScopeId> parent_scope, Scope::Sizes sizes);
+    // reuses a released temp scope when there is one, so steady-state compt calls allocate nothing
     [[nodiscard]] ScopeId make_compt_func_temp_scope(ScopeId parent_scope, HirSize capacity);
+    // hands a returning compt call's temp scope back for the next call to reuse, along w/ the
+    // param defs it holds (see make_compt_param_def)
+    void release_compt_func_temp_scope(ScopeId temp_scope);
+    [[nodiscard]] size_t scope_count() const noexcept { return scopes.size(); }
+    /// temp scopes ever allocated rather than reused, i.e. the deepest compt call chain so far
+    /// (plus any abandoned by relinquish_temp_scopes)
+    [[nodiscard]] size_t compt_temp_scope_count() const noexcept { return temp_scope_cnt; }
 
     // generate a deftype and insert into the provided scoep
     // - this will forward all references of some identifer to an arbitrary type
@@ -91,6 +149,9 @@ class Context {
     [[nodiscard]] OptId<DefId> look_up_variable(ScopeId scope, SymbolId sid) const;
     [[nodiscard]] OptId<DefId> look_up_type(ScopeId scope, SymbolId sid) const;
     [[nodiscard]] OptId<DefId> look_up_namespace(ScopeId scope, SymbolId sid) const;
+    /// chain look up starting at a frozen (fully registered) scope, served from a flattened cache
+    /// of earlier answers, misses included, that is dropped whenever any scope gains an entry
+    [[nodiscard]] OptId<DefId> look_up_frozen(ScopeId scope, SymbolId sid, scope_kind kind) const;
 
     [[nodiscard]] OptId<DefId> look_up_scoped(auto F, ScopeId scope, IdSlice<SymbolId> id_slice,
                                               Span id_span);
@@ -195,6 +256,9 @@ class Context {
                                                        OptId<DiagnosticId> next
                                                        = OptId<DiagnosticId>{});
     void link_diagnostic(DiagnosticId diag, DiagnosticId next);
+    /// links a `did you mean` help to an unresolved-name diagnostic if a visible name is close to
+    /// the unresolved one, only for bare (unqualified) names
+    void suggest_name_for(DiagnosticId diag, ScopeId scope, IdSlice<SymbolId> path, Span span);
 
     // only use when this diagnostic is known to follow another diagnostic but the previous
     // diagnostic's id is unavailable
@@ -207,10 +271,26 @@ class Context {
     [[nodiscard]] CanonicalTypeId
     emplace_and_get_canonical_type_id(TypeId first_structural_type_id);
     /// emplaces a type, setting its CanonicalTypeId, and returning its TypeId
+    /// - generated immutable types have no mention to point at, so structurally identical ones are
+    /// interned and share a TypeId (builtins map straight to builtin_type_id)
     [[nodiscard]] TypeId emplace_type(const TypeValue& value, Span span, bool mut);
+    /// the rendered name of a type (bypassing deftypes), cached per canonical type
+    [[nodiscard]] SymbolId type_name(TypeId tid);
+    /// the rendered name of a type as mentioned, sharing type_name's cache when it has no deftypes
+    [[nodiscard]] SymbolId type_name_as_mentioned(TypeId tid);
+    /// makes a type immutable in place, both as mentioned and past its deftypes
+    /// - canonical ids are cached per type and hashed w/ mut, so this re-canonicalizes it too
+    void strip_type_mut(TypeId tid);
+    /// the preallocated, generated and immutable TypeId of a builtin
+    [[nodiscard]] TypeId builtin_type_id(builtin_type type) const noexcept {
+        return builtin_type_ids[static_cast<size_t>(type)];
+    }
 
     /// accessfor for a def thru a DefId
     Def& def(DefId def_id);
+    /// a def's payload and span, see Def::value and Def::span
+    [[nodiscard]] DefCold& def_cold(DefId def_id);
+    [[nodiscard]] const DefCold& def_cold(DefId def_id) const;
 
     /// trys to access a direct function def or a compt function ptr
     /// basically, if a value is a know compt variable pointing to some known function, we will get
@@ -238,18 +318,94 @@ class Context {
 
     DefId register_def(SymbolId name, Span span, DefId parent, DefValue value = DefUnevaluated{});
 
+    /// a param of a compt call in flight, like register_compt_def, but made in the scratch
+    /// region (see SCRATCH_DEF_BIT), reusing one released w/ an earlier call's temp scope when
+    /// there is one
+    /// - nothing may hold onto the DefId past release_compt_func_temp_scope
+    [[nodiscard]] DefId make_compt_param_def(SymbolId name, Span span, DefId parent,
+                                             const DefValue& value);
+
+    /// scope insertions go through these so that memoized look ups are invalidated
     void insert_variable(ScopeId scope_id, SymbolId sid, DefId did);
     void insert_type(ScopeId scope_id, SymbolId sid, DefId did);
+    void insert_namespace(ScopeId scope_id, SymbolId sid, DefId did);
+    /// insert a param into a compt func temp scope fresh from make_compt_func_temp_scope
+    /// - nothing has been looked up from such a scope yet, so no memoized look up is invalidated
+    void insert_compt_param(ScopeId temp_scope_id, SymbolId sid, DefId did);
+    /// memoized outcome of a pure compt call to func w/ args canonicalized into key (see
+    /// ComptExprSolver), a poisoned one means the call already failed in the current outermost
+    /// scratch generation
+    [[nodiscard]] std::optional<ComptCallOutcome>
+    memoized_compt_call(DefId func, const llvm::SmallVectorImpl<uint64_t>& key) const;
+    /// records a constant result of a pure compt call, nothing is emplaced for it
+    void memoize_compt_call(DefId func, const llvm::SmallVectorImpl<uint64_t>& key,
+                            const ExecConst& value);
+    /// records any other outcome of a pure compt call, a result must be a permanent exec
+    /// - none poisons the call until the outermost scratch generation ends, so its errors are
+    /// only reported once per top-level compt expr, a failure may not depend on the args alone
+    /// (e.g. on what's resolved so far), so it can't be kept any longer than that
+    void memoize_compt_call(DefId func, const llvm::SmallVectorImpl<uint64_t>& key,
+                            OptId<ExecId> result);
+    [[nodiscard]] size_t compt_call_memo_size() const noexcept { return compt_call_memo_cnt; }
+    /// bytecode for pure compt functions, see ComptVm
+    [[nodiscard]] ComptProgramTable& compt_programs() noexcept { return compt_program_table; }
+    [[nodiscard]] const ComptProgramTable& compt_programs() const noexcept {
+        return compt_program_table;
+    }
+    /// bytes a single compt call's frames may hold, --compt-stack or ComptVm's default
+    /// - bounds both the vm's frames and the stack tree-walked calls recurse on (see compt_stack)
+    [[nodiscard]] size_t compt_stack_bytes() const noexcept;
+    /// the stack tree-walked compt calls recurse on, see ComptStack
+    [[nodiscard]] ComptStack& compt_stack() noexcept { return compt_walk_stack; }
 
     // should only be used for types
-    [[nodiscard]] IdHashMap<DefId, ScopeId>& defs_to_scopes_for_types();
+    [[nodiscard]] const IdHashMap<DefId, ScopeId>& defs_to_scopes_for_types() const;
+    /// gives a type def its member scope, like the insert_* wrappers this invalidates memoized
+    /// look ups, since qualified look ups step thru type scopes
+    void register_type_scope(DefId def, ScopeId scope);
 
-    template <typename... Args> [[nodiscard]] ExecId register_exec(Args&&... args) {
-        return execs.emplace_and_get_id(std::forward<Args>(args)...);
-    }
     [[nodiscard]] ExecId emplace_exec(const ExecValue& value, Span span, bool should_be_compt);
 
-    [[nodiscard]] ExecId emplace_compt_exec(const ExecValue& value, Span span);
+    // ----- scratch execs ------
+    // compt evaluation emplaces its intermediates into a scratch region instead of the permanent
+    // exec table, only the final value gets promoted. the region is emptied once the outermost
+    // scratch generation ends, so ExecIds into it must not outlive their generation
+
+    /// ExecIds w/ this bit set index the scratch region
+    static constexpr HirId SCRATCH_EXEC_BIT = HirId{1} << 31;
+
+    [[nodiscard]] static bool is_scratch_exec(ExecId id) noexcept {
+        return (id.val() & SCRATCH_EXEC_BIT) != 0;
+    }
+
+    [[nodiscard]] ExecId emplace_scratch_exec(const ExecValue& value, Span span,
+                                              bool should_be_compt);
+
+    /// DefIds w/ this bit set index the scratch defs, i.e. the params of compt calls in flight,
+    /// which are dropped w/ the generation like scratch execs
+    static constexpr HirId SCRATCH_DEF_BIT = HirId{1} << 31;
+
+    [[nodiscard]] static bool is_scratch_def(DefId id) noexcept {
+        return (id.val() & SCRATCH_DEF_BIT) != 0;
+    }
+
+    /// freeze the element ids of a compt intermediate into the scratch region, so the slice is
+    /// dropped w/ its generation, promote_scratch_exec refreezes it into the permanent exec_ids
+    [[nodiscard]] IdSlice<ExecId> freeze_scratch_exec_ids(const llvm::SmallVectorImpl<ExecId>& vec);
+
+    /// generations nest, the scratch region is reset only when the outermost one ends
+    void begin_scratch_generation() noexcept;
+    void end_scratch_generation() noexcept;
+
+    /// deep-copy a scratch exec (and every scratch exec it refers to) into the permanent exec
+    /// table, permanent ExecIds are returned as-is
+    [[nodiscard]] ExecId promote_scratch_exec(ExecId id);
+    [[nodiscard]] OptId<ExecId> promote_scratch_exec(OptId<ExecId> id);
+
+    /// the type inferred for an exec, if it has been cached yet
+    [[nodiscard]] OptId<TypeId> cached_exec_type(ExecId id) const;
+    /// cache an exec's inferred type, scratch execs drop theirs w/ their generation
+    void cache_exec_type(ExecId id, TypeId tid);
 
     // ----- info viewing ------
 
@@ -267,6 +423,9 @@ class Context {
                          const token_t* import_path_tkn);
     /// prints info based on cli-flags
     void try_print_info();
+    /// walks every arena, vector, and table owned by the context (and each file's ast), used for
+    /// --mem-stats
+    [[nodiscard]] MemStatsReport mem_stats() const;
 
     // converters
     [[nodiscard]] SymbolId symbol_id(IdIdx<SymbolId> sididx) const;
@@ -421,6 +580,29 @@ class Context {
         }
     }
 
+    // like freeze_id_vec, but equal sequences share one interned slice, so == on two interned
+    // slices compares their contents in O(1)
+    template <IsId I>
+    [[nodiscard]] IdSlice<I> intern_id_vec(const llvm::SmallVectorImpl<I>& vec)
+        requires is_any_of_v<I, TypeId, ExecId, DefId, GenericArgId, FileId, SymbolId>
+    {
+        if constexpr (std::is_same_v<I, TypeId>) {
+            return type_ids.intern_small_vec(vec);
+        } else if constexpr (std::is_same_v<I, ExecId>) {
+            return exec_ids.intern_small_vec(vec);
+        } else if constexpr (std::is_same_v<I, DefId>) {
+            return def_ids.intern_small_vec(vec);
+        } else if constexpr (std::is_same_v<I, GenericArgId>) {
+            return generic_arg_ids.intern_small_vec(vec);
+        } else if constexpr (std::is_same_v<I, FileId>) {
+            return file_ids.intern_small_vec(vec);
+        } else if constexpr (std::is_same_v<I, SymbolId>) {
+            return symbol_ids.intern_small_vec(vec);
+        } else {
+            static_assert(false, "try to intern a vector of an unconsidered hir::Id type");
+        }
+    }
+
   private:
     // containers:
     // ~~~~~~~~~~~~~~~~~ file stuff ~~~~~~~~~~~~~~~~~~~
@@ -429,6 +611,28 @@ class Context {
     DataArena id_map_arena;
     IdHashMap<SymbolId, FileId> symbol_id_to_file_id_map;
     NodeVector<FileAst> file_asts;
+    /// FileId - 1 -> global src offset of the file's first byte, ascending since files are never
+    /// reordered, so the owner of an offset is a binary search away
+    std::vector<HirSize> file_bases;
+    /// 0 is reserved for generated spans
+    HirSize next_file_base = 1;
+    /// FileId - 1 -> local offsets of each line's first byte, empty until first needed
+    mutable std::vector<std::vector<HirSize>> file_line_starts;
+    [[nodiscard]] const std::vector<HirSize>& line_starts_of(FileId file_id) const;
+    /// a scope's src, entries of a file nest like the scopes they cover
+    struct ScopeSpanEntry {
+        HirSize pos;
+        HirSize len;
+        ScopeId scope;
+        /// idx of the nearest entry enclosing this one, filled in by sorting
+        uint32_t parent;
+    };
+    /// per-file interval index of scope spans, parallel to file_bases
+    struct FileScopeSpans {
+        std::vector<ScopeSpanEntry> entries;
+        bool sorted = true;
+    };
+    mutable std::vector<FileScopeSpans> file_scope_spans;
 
     /// FileId -> IdSlice<FileId> since all importees are always known when lowering a given file
     IdVecMap<FileId, IdSlice<FileId>> importer_to_importees;
@@ -442,6 +646,9 @@ class Context {
     DataArena scope_arena;
     NodeVector<Scope> scopes;
     std::unique_ptr<DataArena> temp_scope_arena;
+    /// released temp scopes, reused LIFO so recursion reuses the frames it just unwound
+    std::vector<ScopeId> free_temp_scopes;
+    size_t temp_scope_cnt = 0;
     // ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
     /// const char* -> hir::SymbolId
     DataArena symbol_storage_arena;
@@ -451,11 +658,40 @@ class Context {
     NodeVector<Symbol> symbols;
 
     IdVector<ExecId> exec_ids;
+    /// per-kind storage of each exec's ExecValue
+    PayloadTables<ExecValue> exec_payloads;
     NodeVector<Exec> execs;
+    /// inferred type of each exec, none until first inferred
+    IdVecMap<ExecId, OptId<TypeId>> exec_types;
+    /// compt intermediates, see emplace_scratch_exec
+    PayloadTables<ExecValue> scratch_exec_payloads;
+    NodeVector<Exec> scratch_execs;
+    IdVecMap<ExecId, OptId<TypeId>> scratch_exec_types;
+    /// IdIdxs w/ SCRATCH_EXEC_BIT set index this, see freeze_scratch_exec_ids
+    IdVector<ExecId> scratch_exec_ids;
+    /// compt call params, see make_compt_param_def, indexed w/o SCRATCH_DEF_BIT
+    NodeVector<Def> scratch_defs;
+    IdVecMap<DefId, DefCold> scratch_def_colds;
+    IdVecMap<DefId, Def::mention_state> scratch_def_mention_states;
+    /// scratch defs released w/ their temp scope
+    std::vector<DefId> free_scratch_defs;
+    HirSize scratch_generation_depth = 0;
+    /// bumped whenever an outermost scratch generation begins
+    uint32_t scratch_generation_epoch = 0;
 
     // ~~~~ defs ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     IdVector<DefId> def_ids;
     NodeVector<Def> defs;
+    /// names of defs, indexed lazily for suggest_name_for
+    SymbolSuggester symbol_suggester;
+    /// defs whose names symbol_suggester already holds
+    HirSize suggester_def_cnt = 0;
+    /// FQN + prefix index over top-level defs, filled in as each is registered
+    DataArena def_index_storage_arena;
+    DataArena def_index_map_arena;
+    SymbolIndex def_index;
+    /// payload + span of each def, indexed by the same DefId
+    IdVecMap<DefId, DefCold> def_colds;
 
     /// indicated whether this node is unvisited, visited during top-level resolution, or resolved
     IdVecMap<DefId, Def::resol_state> def_resol_states; // index with DefId
@@ -468,6 +704,74 @@ class Context {
     /// for tracking DefId -> ScopeId for structs during the top level resolution
     IdHashMap<DefId, ScopeId> def_to_scope_for_types;
 
+    /// interned symbol slices of AST id chains, keyed by the chain's token ptr array
+    struct SymbolSliceMemoSlot {
+        token_t* const* tokens; // null marks an empty slot
+        IdSlice<SymbolId> slice;
+    };
+    std::vector<SymbolSliceMemoSlot> symbol_slice_memo;
+    size_t symbol_slice_memo_cnt = 0;
+    void grow_symbol_slice_memo();
+
+    /// defs found by look_up_scoped_*, keyed by (path, starting scope, kind)
+    /// - a slot is only live during the epoch it was filled in, and every scope insertion starts a
+    /// new epoch, so shadowing defs registered later are never missed
+    struct PathMemoSlot {
+        uint32_t epoch; // a slot from an older epoch counts as empty
+        uint32_t hash;
+        IdSlice<SymbolId> path;
+        ScopeId scope;
+        uint32_t scope_generation; // a recycled temp scope is a different scope
+        scope_kind kind;
+        DefId did;
+    };
+    std::vector<PathMemoSlot> path_memo;
+    size_t path_memo_cnt = 0;
+    uint32_t path_memo_epoch = 1;
+    void bump_path_memo_epoch() noexcept;
+
+    /// answers of look_up_frozen keyed by (starting scope, symbol, kind), shares path_memo_epoch
+    struct FrozenLookUpSlot {
+        uint32_t epoch; // a slot from an older epoch counts as empty
+        uint32_t hash;
+        ScopeId scope;
+        SymbolId symbol;
+        scope_kind kind;
+        OptId<DefId> did;
+    };
+    mutable std::vector<FrozenLookUpSlot> frozen_look_ups;
+    mutable size_t frozen_look_up_cnt = 0;
+    void grow_frozen_look_ups() const;
+    /// freezes the root and every module scope, once all files are registered
+    void freeze_module_scopes();
+    void grow_path_memo();
+
+    /// outcomes of pure compt calls keyed by (function, canonical args), see memoized_compt_call
+    /// - keys are never removed since a compt function's result never changes, and each key's
+    /// words are appended to compt_call_memo_keys
+    struct ComptCallMemoSlot {
+        uint64_t hash;
+        OptId<DefId> func; // none for an empty slot
+        uint32_t key_start;
+        uint32_t key_len;
+        ComptCallOutcome outcome;
+        uint32_t poison_epoch; // the scratch_generation_epoch a poisoned call failed in
+    };
+    std::vector<ComptCallMemoSlot> compt_call_memo;
+    std::vector<uint64_t> compt_call_memo_keys;
+    size_t compt_call_memo_cnt = 0;
+    void grow_compt_call_memo();
+    /// idx of func + key's slot, or of the empty slot it would go in
+    [[nodiscard]] size_t compt_call_memo_idx(DefId func, const llvm::SmallVectorImpl<uint64_t>& key,
+                                             uint64_t hash) const;
+    void memoize_compt_call(DefId func, const llvm::SmallVectorImpl<uint64_t>& key,
+                            const ComptCallOutcome& outcome);
+    /// lazily compiled, see compt_programs
+    ComptProgramTable compt_program_table;
+    ComptStack compt_walk_stack;
+    [[nodiscard]] OptId<DefId> look_up_scoped_memoized(scope_kind kind, auto F, ScopeId scope,
+                                                       IdSlice<SymbolId> id_slice, Span id_span);
+
     IdHashMap<DefId, ScopeId> def_to_scope_for_funcs;
 
     // for storing ordered defs (namely ordered member definitions)
@@ -478,11 +782,26 @@ class Context {
 
     // types ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     IdVector<TypeId> type_ids;
+    /// per-kind storage of each type's TypeValue
+    PayloadTables<TypeValue> type_payloads;
     NodeVector<Type> types;
 
+    /// generated immutable types, open addressing w/ linear probing over a power of two sized table
+    struct TypeInternSlot {
+        uint32_t hash;
+        TypeId tid; // none marks an empty slot
+    };
+    std::vector<TypeInternSlot> type_intern_table;
+    size_t type_intern_cnt = 0;
+    std::array<TypeId, BUILTIN_TYPE_COUNT> builtin_type_ids;
+    [[nodiscard]] TypeId emplace_fresh_type(const TypeValue& value, Span span, bool mut);
+    [[nodiscard]] TypeId intern_generated_type(const TypeValue& value);
+    void grow_type_intern_table();
     // maps a canonical type back to its first TypeId mention so the type's structure can be rebuilt
     // even if only its canonical value is known
     IdVecMap<CanonicalTypeId, TypeId> canonical_to_type_id;
+    // lazily rendered type names, in lockstep w/ canonical_to_type_id
+    IdVecMap<CanonicalTypeId, OptId<SymbolId>> canonical_type_names;
     DataArena canonical_type_table_arena;
     CanonicalTypeTable canonical_type_table;
 
@@ -530,6 +849,12 @@ class Context {
     const bearc_args_t& args;
     bool compact_diagnostics = false;
 
+    // snapshots taken after each phase when --mem-stats is passed
+    std::vector<MemPhaseStat> mem_phases;
+    void record_mem_phase(const char* phase);
+
+    /// emplaces a def's cold half, returning the DefId its hot record must be emplaced under
+    [[nodiscard]] DefId emplace_def_cold(const DefValue& value, Span span);
     [[nodiscard]] FileId provide_root_file(const char* file_name);
     /// forceably emplaces ast, not checking if it has already been processed. This function is
     /// wrapped by file handling logic and should thus not be used directly anywhere else
@@ -540,6 +865,17 @@ class Context {
                                                                const ast_stmt_t* import_statement);
 };
 
+/// helper class that keeps a scratch exec generation open for as long as it lives
+class ScratchGeneration {
+    Context& ctx;
+
+  public:
+    explicit ScratchGeneration(Context& ctx) : ctx{ctx} { ctx.begin_scratch_generation(); }
+    ~ScratchGeneration() { ctx.end_scratch_generation(); }
+    ScratchGeneration(const ScratchGeneration&) = delete;
+    ScratchGeneration& operator=(const ScratchGeneration&) = delete;
+};
+
 } // namespace hir
 
 #endif
@@ -9,6 +9,8 @@
 #include "compiler/hir/context_database.hpp"
 #include "compiler/hir/indexing.hpp"
 #include <optional>
+#include <string_view>
+#include <vector>
 
 using namespace hir;
 
@@ -51,6 +53,28 @@ ContextDatabase::query_def_id(const std::vector<std::string>& def_path) {
         .mod_id = maybe_mod, .type_id = maybe_type, .variable_id = maybe_variable};
 }
 
+hir::OptId<hir::DefId> ContextDatabase::query_def_id_by_fqn(std::string_view fqn) const {
+    return ctx->symbol_index().at_fqn(fqn);
+}
+
+std::vector<hir::DefId> ContextDatabase::search_defs(std::string_view prefix, size_t limit) const {
+    const SymbolIndex& index = ctx->symbol_index();
+    auto found = prefix.find(SymbolIndex::SEPARATOR) != std::string_view::npos
+                     ? index.with_fqn_prefix(prefix, limit)
+                     : index.with_name_prefix(prefix, limit);
+    return {found.begin(), found.end()};
+}
+
 int ContextDatabase::diagnostic_count() const noexcept { return ctx->diagnostic_count(); }
 
 hir::Exec ContextDatabase::exec(hir::ExecId eid) const { return ctx->exec(eid); }
+
+const hir::Context& ContextDatabase::context() const noexcept { return *ctx; }
+
+hir::MemStatsReport ContextDatabase::mem_stats() const { return ctx->mem_stats(); }
+
+hir::SrcLoc ContextDatabase::src_loc(hir::Span span) const { return ctx->src_loc_at(span.pos); }
+
+hir::ScopeId ContextDatabase::scope_at(hir::FileId file, hir::SrcLoc loc) const {
+    return ctx->innermost_scope_at(ctx->pos_at(file, loc));
+}
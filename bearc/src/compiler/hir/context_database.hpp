@@ -35,10 +35,29 @@ class ContextDatabase {
 
     [[nodiscard]] DefIdQueryResult query_def_id(const std::vector<std::string>& def_path);
 
+    /// top-level def by fully qualified name, e.g. `"foo..Bar"`, w/o walking any scopes
+    [[nodiscard]] hir::OptId<hir::DefId> query_def_id_by_fqn(std::string_view fqn) const;
+
+    /// up to limit top-level defs whose fully qualified name starts w/ prefix if it's qualified
+    /// (has a `..`), else whose own name does, e.g. for completion or go-to-symbol
+    [[nodiscard]] std::vector<hir::DefId> search_defs(std::string_view prefix,
+                                                      size_t limit = 64) const;
+
     [[nodiscard]] hir::Exec exec(hir::ExecId eid) const;
 
+    /// for reading node payloads, e.g. `exec.as<hir::ExecConst>(db.context())`
+    [[nodiscard]] const hir::Context& context() const noexcept;
+
     [[nodiscard]] int diagnostic_count() const noexcept;
 
+    [[nodiscard]] hir::MemStatsReport mem_stats() const;
+
+    [[nodiscard]] hir::SrcLoc src_loc(hir::Span span) const;
+
+    /// innermost scope containing a 0-indexed line/col of a file, e.g. for hover or completion
+    /// at a cursor, the root scope if no narrower scope does
+    [[nodiscard]] hir::ScopeId scope_at(hir::FileId file, hir::SrcLoc loc) const;
+
   private:
     std::unique_ptr<const bearc_args> args;
     std::unique_ptr<hir::Context> ctx;
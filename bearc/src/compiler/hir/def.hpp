@@ -12,7 +12,9 @@
 #include "compiler/hir/indexing.hpp"
 #include "compiler/hir/span.hpp"
 #include "compiler/hir/variant_helpers.hpp"
+#include <cassert>
 #include <cstdint>
+#include <optional>
 #include <utility>
 #include <variant>
 
@@ -143,8 +145,20 @@ enum class abi_lang : uint8_t {
     c,
 };
 
+/// cold half of a definition: its payload and location, which are only needed once a def has
+/// been found, so they're kept out of the hot records that lookups and parent walks scan
+struct DefCold {
+    DefValue value;
+    Span span;
+};
+
+class Context;
+
 /// main exec structure, corresponds to an hir_exec_id_t
-struct Def : NodeWithVariantValue<Def> {
+/// - this is the hot record (name, parent, kind and flags), the payload and span live in a DefCold
+/// the context keeps at the same DefId (see Context::def_cold), so anything touching them goes
+/// through the context, like a PayloadNode's payload
+struct Def {
     /// represents the resolution state corresponding to an hir::DefId
     enum class resol_state : uint8_t {
         unvisited = 0,
@@ -176,10 +190,13 @@ struct Def : NodeWithVariantValue<Def> {
     };
 
     using id_type = DefId;
-    /// underlying structure
-    DefValue value;
-    /// span in src
-    const Span span;
+    using value_type = DefValue;
+
+  private:
+    /// this def's own id, which is also where its DefCold lives
+    DefId self;
+
+  public:
     /// id corresponding to the interned identifier
     const SymbolId name;
     /// parent's definition, if any
@@ -187,45 +204,98 @@ struct Def : NodeWithVariantValue<Def> {
     static constexpr HirSize UNORDERED = HIR_SIZE_MAX;
     /// indicates member's order in a struct, equals NOT_ORDERED if unordered
     HirSize member_idx = UNORDERED;
+
+  private:
+    /// mirrors the cold value's index() so kind checks never leave the hot record
+    uint8_t kind;
+
+  public:
     /// indicates pub (true) or hid (false) visibility
-    const bool pub = false;
+    const bool pub : 1;
     /// indicates compt (compile-time)
-    const bool compt = false;
+    const bool compt : 1;
     /// indicates static (storage duration)
-    const bool statik = false;
+    const bool statik : 1;
     /// indicates generic
-    const bool generic = false;
+    const bool generic : 1;
     /// indicates alignment preference, 0 = default alignment
     const uint8_t alignment_preference = 0;
     /// indicates ABI
     const abi_lang abi = abi_lang::native;
 
-    Def(DefValue value, SymbolId name, bool pub, bool compt, bool statik, bool generic, Span span,
-        OptId<DefId> parent, enum abi_lang abi = abi_lang::native)
-        : value{value}, span{span}, name{name}, parent{parent}, pub{pub}, compt{compt},
-          statik{statik}, generic{generic}, abi{abi} {}
-
-    Def(DefValue value, SymbolId name, bool pub, bool compt, bool statik, bool generic, Span span,
-        OptId<DefId> parent, uint8_t alignment_preference, enum abi_lang abi = abi_lang::native)
-        : value{value}, span{span}, name{name}, parent{parent}, pub{pub}, compt{compt},
-          statik{statik}, generic{generic}, alignment_preference{alignment_preference}, abi{abi} {}
+    Def(DefId self, const DefValue& value, SymbolId name, bool pub, bool compt, bool statik,
+        bool generic, OptId<DefId> parent, enum abi_lang abi = abi_lang::native)
+        : self{self}, name{name}, parent{parent}, kind{index_of(value)}, pub{pub},
+          compt{compt}, statik{statik}, generic{generic}, abi{abi} {}
 
-    Def(DefValue value, SymbolId name, bool pub, bool compt, bool statik, bool generic, Span span,
-        OptId<DefId> parent, uint8_t alignment_preference, HirSize member_idx,
+    Def(DefId self, const DefValue& value, SymbolId name, bool pub, bool compt, bool statik,
+        bool generic, OptId<DefId> parent, uint8_t alignment_preference,
         enum abi_lang abi = abi_lang::native)
-        : value{value}, span{span}, name{name}, parent{parent}, member_idx{member_idx}, pub{pub},
+        : self{self}, name{name}, parent{parent}, kind{index_of(value)}, pub{pub},
           compt{compt}, statik{statik}, generic{generic},
+          alignment_preference{alignment_preference}, abi{abi} {}
+
+    Def(DefId self, const DefValue& value, SymbolId name, bool pub, bool compt, bool statik,
+        bool generic, OptId<DefId> parent, uint8_t alignment_preference, HirSize member_idx,
+        enum abi_lang abi = abi_lang::native)
+        : self{self}, name{name}, parent{parent}, member_idx{member_idx}, kind{index_of(value)},
+          pub{pub}, compt{compt}, statik{statik}, generic{generic},
           alignment_preference{alignment_preference}, abi{abi} {
         // ordered statik is malformed
         assert(!(is_ordered() && statik));
     }
 
-    Def(SymbolId name, bool pub, Span span)
-        : value{DefUnevaluated{}}, span{span}, name{name}, pub{pub} {}
-
-    void set_value(DefValue value) { this->value = value; }
+    void set_value(Context& ctx, DefValue value) {
+        DefCold& c = cold(ctx);
+        c.value = std::move(value);
+        kind = index_of(c.value);
+    }
     bool is_ordered() const noexcept { return member_idx != UNORDERED; };
+
+    /// underlying structure (cold)
+    [[nodiscard]] const DefValue& value(const Context& ctx) const noexcept {
+        return cold(ctx).value;
+    }
+    /// span in src (cold)
+    [[nodiscard]] const Span& span(const Context& ctx) const noexcept { return cold(ctx).span; }
+
+    // same interface as PayloadNode, kind checks only read the hot tag
+    template <typename T> bool holds() const noexcept { return kind == index_of<T>(); }
+    template <typename... Ts> bool holds_any_of() const noexcept { return (holds<Ts>() || ...); }
+    template <typename T> T& as(Context& ctx) noexcept {
+        assert(holds<T>());
+        return std::get<T>(cold(ctx).value);
+    }
+    template <typename T> const T& as(const Context& ctx) const noexcept {
+        assert(holds<T>());
+        return std::get<T>(cold(ctx).value);
+    }
+    template <typename T> bool holds_same(const Def& other) const noexcept {
+        return holds<T>() && other.template holds<T>();
+    }
+    bool holds_same_variant_type(const Def& other) const noexcept { return kind == other.kind; }
+    template <typename... Ts> bool hold_same_any_of(const Def& other) const noexcept {
+        return holds_any_of<Ts...>() && other.template holds_any_of<Ts...>();
+    }
+    template <typename T> decltype(auto) visit(const Context& ctx, T&& visitor) const {
+        return std::visit(visitor, cold(ctx).value);
+    }
+    template <typename T> std::optional<T> try_as(const Context& ctx) const noexcept {
+        return holds<T>() ? std::optional<T>{std::get<T>(cold(ctx).value)} : std::nullopt;
+    }
+
+  private:
+    [[nodiscard]] DefCold& cold(Context& ctx) noexcept;
+    [[nodiscard]] const DefCold& cold(const Context& ctx) const noexcept;
+    static uint8_t index_of(const DefValue& value) noexcept {
+        return static_cast<uint8_t>(value.index());
+    }
+    template <typename T> static constexpr uint8_t index_of() {
+        return static_cast<uint8_t>(variant_index_v<T, DefValue>);
+    }
 };
+// hot record stays small enough that a def scan touches ~2.5 defs per cache line
+static_assert(sizeof(Def) <= 24, "hir::Def grew, move the new field into DefCold");
 
 } // namespace hir
 
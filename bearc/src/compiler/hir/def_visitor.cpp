@@ -87,7 +87,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
 
     const ast_stmt* stmt = context.def_ast_node(did);
     ScopeId scope = context.containing_scope(did);
-    Span span = context.def(did).span;
+    Span span = context.def(did).span(context);
 
     auto parent_is_struct = [this](const Def& def) {
         return (def.parent.has_value()) ? context.is_struct_def(def.parent.as_id()) : false;
@@ -98,7 +98,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
     case AST_STMT_VAR_DECL: {
         Def& def = context.def(did);
         OptId<TypeId> maybe_tid = TypeResolver<TopLevelDefVisitor>{context, *this}.resolve_type(
-            span.file_id, scope, stmt->stmt.var_decl.type, parent_is_struct(def));
+            span.file_id(context), scope, stmt->stmt.var_decl.type, parent_is_struct(def));
         if (!maybe_tid.has_value()) {
             goto cleanup;
         }
@@ -106,7 +106,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
         check_to_err_when_compt_is_not_mut(maybe_tid.as_id(), def);
         if (def.compt) {
             context.emplace_diagnostic_with_message_value(
-                def.span, diag_code::a_compt_variable_should_be_explicitly_initialized,
+                def.span(context), diag_code::a_compt_variable_should_be_explicitly_initialized,
                 diag_type::error, DiagnosticSymbolBeforeMessage{.sid = def.name});
         }
         // error when struct member does not have an explicit type
@@ -118,7 +118,8 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
                 type.span, diag_code::should_have_explicit_type, diag_type::error,
                 DiagnosticStructMemberSymBeforeMsg{.mem_sid = def.name});
         };
-        def.set_value(DefVariable{.type_id = maybe_tid.as_id(), .compt_value = std::nullopt});
+        def.set_value(context,
+                      DefVariable{.type_id = maybe_tid.as_id(), .compt_value = std::nullopt});
         // TODO handle invalid non-initialized statements
         // search for default value/default method
         break;
@@ -126,7 +127,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
     case AST_STMT_VAR_INIT_DECL: {
         const auto var_init_decl = stmt->stmt.var_init_decl;
         OptId<TypeId> maybe_tid = TypeResolver<TopLevelDefVisitor>{context, *this}.resolve_type(
-            span.file_id, scope, var_init_decl.type,
+            span.file_id(context), scope, var_init_decl.type,
             parent_is_struct(context.def(did))); // needs layout info if parent is struct
         if (!maybe_tid.has_value()) {
             goto cleanup; // maybe set a special value to indicate error differently
@@ -142,7 +143,8 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
 
         auto maybe_compt_eid
             = ComptExprSolver(context, *this)
-                  .solve_expr(span.file_id, scope, stmt->stmt.var_init_decl.rhs, maybe_tid.as_id());
+                  .solve_top_level_expr(span.file_id(context), scope,
+                                        stmt->stmt.var_init_decl.rhs, maybe_tid.as_id());
 
         // error when struct member does not have an explicit type
         if (!context.def(did).statik && parent_is_struct(context.def(did)) && type_contains_var) {
@@ -164,12 +166,12 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
             }
         };
 
-        context.def(did).set_value(
+        context.def(did).set_value(context,
             DefVariable{.type_id = maybe_tid.as_id(), .compt_value = maybe_compt_eid});
         // check poison /not init
         if (context.def(did).compt && var_init_decl.assign_op->type == TOK_ASSIGN_MOVE) {
             auto d0 = context.emplace_diagnostic(
-                Span{context, context.def(did).span.file_id, var_init_decl.assign_op},
+                Span{context, context.def_to_file_id(did), var_init_decl.assign_op},
                 diag_code::compt_vars_should_not_be_move_initialized, diag_type::error);
             if (maybe_compt_eid.has_value()) {
                 auto d1 = context.emplace_diagnostic(
@@ -184,7 +186,8 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
         if (!maybe_compt_eid.has_value()) {
             if (!context.def(did).compt && var_init_decl.rhs->type != AST_EXPR_STATIC_ASSERT) {
                 context.emplace_diagnostic(
-                    Span{context, context.def(did).span.file_id, stmt->stmt.var_init_decl.rhs},
+                    Span{context, context.def(did).span(context).file_id(context),
+                         stmt->stmt.var_init_decl.rhs},
                     diag_code::all_runtime_glob_and_mem_vars_need_compt_init, diag_type::note,
                     DiagnosticInfoDontDisplayFile{});
             }
@@ -207,7 +210,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
             context.emplace_type(
                 TypeStruct{.def_id = did, .gen_args_slice = {}, .maybe_canon_gen_args_id = {}},
                 Span::generated(), false),
-            did, Span{context, context.def(did).span.file_id, strct.name});
+            did, Span{context, context.def(did).span(context).file_id(context), strct.name});
         // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
         IdSlice<DefId> ordered_defs = context.ordered_defs_for(did);
@@ -224,7 +227,8 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
             if (contract->type != AST_EXPR_ID) {
                 continue;
             }
-            Span ctr_span{context, context.def(did).span.file_id, contract->expr.id.slice};
+            Span ctr_span{context, context.def(did).span(context).file_id(context),
+                          contract->expr.id.slice};
             auto maybe_contract_did = context.look_up_scoped_type(
                 scope, context.symbol_slice(contract->expr.id.slice), ctr_span);
             if (maybe_contract_did.empty()) {
@@ -242,7 +246,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
                     ctr_span, diag_code::invalid_contract, diag_type::error,
                     DiagnosticSubCode{.sub_code = diag_code::not_a_contract});
                 dlinker.link(d);
-                auto d1 = context.emplace_diagnostic(context.def(did).span,
+                auto d1 = context.emplace_diagnostic(context.def(did).span(context),
                                                      diag_code::declared_here, diag_type::note);
                 dlinker.link(d1);
                 continue;
@@ -269,9 +273,9 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
             contract_dids.push_back(contract_did);
         }
 
-        auto contracts = context.freeze_id_vec(contract_dids);
+        auto contracts = context.intern_id_vec(contract_dids);
 
-        context.def(did).set_value(DefStruct{
+        context.def(did).set_value(context, DefStruct{
             .scope = structs_scope,
             .ordered_members = ordered_defs,
             /* .contracts = */
@@ -289,7 +293,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
         auto sid_slice = context.symbol_slice(use.id);
         // to be used as the name
         const token_t* last_symbol = use.id.start[use.id.len - 1];
-        Span id_span{span.file_id, context.ast(span.file_id).buffer(), use.id.start[0],
+        Span id_span{context, span.file_id(context), use.id.start[0],
                      last_symbol};
 
         // by default, look up a mod (a namespace). If `use mod` was NOT explicitly specified, then
@@ -307,20 +311,21 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
             auto code = only_look_for_mod ? diag_code::use_of_undeclared_mod
                                           : diag_code::use_of_undeclared_identifier;
 
-            context.emplace_diagnostic_with_message_value(
+            auto d0 = context.emplace_diagnostic_with_message_value(
                 id_span, code, diag_type::error,
                 DiagnosticIdentifierAfterMessage{.sid_slice = sid_slice});
+            context.suggest_name_for(d0, scope, sid_slice, id_span);
 
             break; // don't insert!
         }
         ScopeId scope_into_which_to_insert = context.containing_scope(did);
         // insert base name into containing scope
         if (used_mod) {
-            context.scope(scope_into_which_to_insert)
-                .insert_namespace(context.symbol_id(last_symbol), used_did.as_id());
+            context.insert_namespace(scope_into_which_to_insert, context.symbol_id(last_symbol),
+                                     used_did.as_id());
         } else {
-            context.scope(scope_into_which_to_insert)
-                .insert_type(context.symbol_id(last_symbol), used_did.as_id());
+            context.insert_type(scope_into_which_to_insert, context.symbol_id(last_symbol),
+                                used_did.as_id());
         }
         break;
     }
@@ -329,18 +334,19 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
             goto cleanup; // already malformed during parsing
         }
         OptId<TypeId> maybe_type = TypeResolver<TopLevelDefVisitor>{context, *this}.resolve_type(
-            span.file_id, scope, stmt->stmt.deftype.aliased_type_expr->expr.type_expr.type);
+            span.file_id(context), scope,
+            stmt->stmt.deftype.aliased_type_expr->expr.type_expr.type);
         if (!maybe_type.has_value()) {
             goto cleanup;
         }
 
-        context.def(did).set_value(DefDeftype{.type = maybe_type.as_id()});
+        context.def(did).set_value(context, DefDeftype{.type = maybe_type.as_id()});
 
         break;
     }
     case AST_STMT_FN_PROTOTYPE: {
         const ast_stmt_fn_decl fn_decl = stmt->stmt.fn_prototype;
-        const auto fid = context.def(did).span.file_id;
+        const auto fid = context.def(did).span(context).file_id(context);
 
         OptId<TypeId> maybe_self_type = context.self_type_for_fn(scope, &fn_decl, context.def(did));
         DefFunction::ParamResolResult params_res
@@ -369,19 +375,20 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
             // guard run-time func with `var` typed params
             if (func_is_runtime
                 && !(parent_is_contract(context.def(did)) && (didx == params.begin()))
-                && TypeTransformer<TypeContainsVar>{context}(param_def.as<DefVariable>().type_id)) {
-                const Span ty_span = context.type(param_def.as<DefVariable>().type_id).span;
+                && TypeTransformer<TypeContainsVar>{context}(
+                    param_def.as<DefVariable>(context).type_id)) {
+                const Span ty_span = context.type(param_def.as<DefVariable>(context).type_id).span;
                 auto d0 = context.emplace_diagnostic(
                     ty_span, diag_code::type_deduction_not_legal_here, diag_type::error);
                 auto d1 = context.emplace_diagnostic(
-                    param_def.span, diag_code::non_compt_function_params_must_have_explicit_types,
-                    diag_type::note);
+                    param_def.span(context),
+                    diag_code::non_compt_function_params_must_have_explicit_types, diag_type::note);
                 context.link_diagnostic(d0, d1);
             }
-            type_vec.push_back(param_def.as<DefVariable>().type_id);
+            type_vec.push_back(param_def.as<DefVariable>(context).type_id);
         }
 
-        auto param_types = context.freeze_id_vec(type_vec);
+        auto param_types = context.intern_id_vec(type_vec);
 
         auto return_tid
             = (fn_decl.return_type)
@@ -392,7 +399,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
             context.report_invalid_return_type(return_tid.as_id());
         }
 
-        context.def(did).set_value(DefFunctionPrototype{.params = params,
+        context.def(did).set_value(context, DefFunctionPrototype{.params = params,
                                                         .param_types = param_types,
                                                         .return_type = return_tid,
                                                         .takes_self = maybe_self_type.has_value()});
@@ -402,7 +409,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
     case AST_STMT_FN_DECL: {
         const ast_stmt_fn_decl fn_decl = stmt->stmt.fn_decl;
         Def& def = context.def(did);
-        const auto fid = def.span.file_id;
+        const auto fid = def.span(context).file_id(context);
 
         if (def.compt && fn_decl.is_mut) {
             Span span = Span::find_between_tokens(context, fid, fn_decl.kw, fn_decl.name.start[0]);
@@ -446,7 +453,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
                 assert(param_def.holds<DefVariable>());
 
                 if (didx == params.begin() && !takes_self && parent_is_struct(context.def(did))
-                    && context.type_matches_struct_def(param_def.as<DefVariable>().type_id,
+                    && context.type_matches_struct_def(param_def.as<DefVariable>(context).type_id,
                                                        def.parent.as_id())) {
                     takes_self = true;
                 }
@@ -454,12 +461,13 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
                 // guard run-time func with `var` typed params
                 if (func_is_runtime
                     && TypeTransformer<TypeContainsVar>{context}(
-                        param_def.as<DefVariable>().type_id)) {
-                    const Span ty_span = context.type(param_def.as<DefVariable>().type_id).span;
+                        param_def.as<DefVariable>(context).type_id)) {
+                    const Span ty_span
+                        = context.type(param_def.as<DefVariable>(context).type_id).span;
                     auto d0 = context.emplace_diagnostic(
                         ty_span, diag_code::type_deduction_not_legal_here, diag_type::error);
                     auto d1 = context.emplace_diagnostic(
-                        param_def.span,
+                        param_def.span(context),
                         diag_code::non_compt_function_params_must_have_explicit_types,
                         diag_type::note);
                     auto d2 = context.emplace_diagnostic(
@@ -469,10 +477,10 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
                     context.link_diagnostic(d0, d1);
                     context.link_diagnostic(d1, d2);
                 }
-                type_vec.push_back(param_def.as<DefVariable>().type_id);
+                type_vec.push_back(param_def.as<DefVariable>(context).type_id);
             }
 
-            const IdSlice<TypeId> param_types = context.freeze_id_vec(type_vec);
+            const IdSlice<TypeId> param_types = context.intern_id_vec(type_vec);
 
             const OptId<TypeId> return_tid
                 = (fn_decl.return_type)
@@ -483,7 +491,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
             }
 
             // handle methods explicitly
-            def.set_value(DefFunction{.params = params,
+            def.set_value(context, DefFunction{.params = params,
                                       .param_types = param_types,
                                       .return_type = return_tid,
                                       .body = std::nullopt,
@@ -503,12 +511,13 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
         context.register_generated_deftype(
             contract_scope, context.symbol_id<"Self">(),
             context.emplace_type(TypeVar{}, Span::generated(), false), did,
-            Span{context, context.def(did).span.file_id, stmt->stmt.contract_decl.name});
+            Span{context, context.def_to_file_id(did), stmt->stmt.contract_decl.name});
         IdSlice<DefId> ordered_fns = context.ordered_defs_for(did);
         for (auto didx = ordered_fns.begin(); didx != ordered_fns.end(); ++didx) {
             visit_as_transparent(context.def_id(didx));
         }
-        context.def(did).set_value(DefContract{.funcs = ordered_fns, .scope = contract_scope});
+        context.def(did).set_value(context,
+                                   DefContract{.funcs = ordered_fns, .scope = contract_scope});
         break;
     }
     case AST_STMT_UNION_DEF: {
@@ -517,7 +526,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
         for (auto didx = members.begin(); didx != members.end(); didx++) {
             visit_as_dependent(context.def_id(didx));
         }
-        context.def(did).set_value(
+        context.def(did).set_value(context,
             DefUnion{.scope = context.scope_for_top_level_def(did), .ordered_members = members});
 
         break;
@@ -531,7 +540,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
         for (auto didx = members.begin(); didx != members.end(); didx++) {
             visit_as_dependent(context.def_id(didx));
         }
-        context.def(did).set_value(DefVariant{
+        context.def(did).set_value(context, DefVariant{
             .scope = context.scope_for_top_level_def(did),
             .ordered_members = members,
             .orginal = {},
@@ -551,7 +560,7 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
             if (!param->valid) {
                 continue;
             }
-            const auto fid = context.def(did).span.file_id;
+            const auto fid = context.def(did).span(context).file_id(context);
             const auto maybe_tid
                 = TypeResolver{context, *this}.resolve_type(fid, scope, param->type);
             if (maybe_tid.empty()) {
@@ -563,9 +572,9 @@ DefId TopLevelDefVisitor::resolve_def(DefId did) {
                 context.def(did).parent.as_id(), DefVariable{.type_id = tid}));
         }
 
-        IdSlice<DefId> members = context.freeze_id_vec(param_vec);
+        IdSlice<DefId> members = context.intern_id_vec(param_vec);
 
-        context.def(did).set_value(
+        context.def(did).set_value(context,
             DefVariantField{.scope = context.scope_for_top_level_def(did), .members = members});
         break;
     }
@@ -661,7 +670,8 @@ OptId<DefId> TopLevelDefVisitor::resolve_param(FileId fid, ScopeId scope, DefId
                                                TypeId tid, SymbolId name, Span span) {
     auto param_did = context.register_compt_def(name, span, func_def);
 
-    context.def(param_did).set_value(DefVariable{.type_id = tid, .compt_value = std::nullopt});
+    context.def(param_did).set_value(context,
+                                     DefVariable{.type_id = tid, .compt_value = std::nullopt});
 
     return param_did;
 }
@@ -673,7 +683,7 @@ TopLevelDefVisitor::resolve_params(FileId fid, ScopeId scope, DefId func_def,
     llvm::SmallVector<DefId> vec;
 
     auto freeze_params = [this, &vec](bool poisoned) {
-        return DefFunction::ParamResolResult{.params = context.freeze_id_vec(vec),
+        return DefFunction::ParamResolResult{.params = context.intern_id_vec(vec),
                                              .poisoned = poisoned};
     };
 
@@ -705,10 +715,10 @@ bool TopLevelDefVisitor::try_satisfy_contract(DefId struct_did, DefId contract_d
 
     const Def& struct_def = context.def(struct_did);
     assert(struct_def.holds<DefStruct>());
-    DefStruct strukt = struct_def.as<DefStruct>();
+    DefStruct strukt = struct_def.as<DefStruct>(context);
     const Def& contract_def = context.def(contract_did);
     assert(contract_def.holds<DefContract>());
-    DefContract contract = contract_def.as<DefContract>();
+    DefContract contract = contract_def.as<DefContract>(context);
 
     ScopeId struct_scope = strukt.scope;
 
@@ -733,7 +743,7 @@ bool TopLevelDefVisitor::try_satisfy_contract(DefId struct_did, DefId contract_d
                                                               .contract_name = contract_def.name});
             dlinker.link(d);
             dlinker.link(context.emplace_diagnostic_with_message_value(
-                ct_func_def.span, diag_code::declared_in_contract_here, diag_type::note,
+                ct_func_def.span(context), diag_code::declared_in_contract_here, diag_type::note,
                 DiagnosticSymbolBeforeMessage{.sid = ct_func_def.name}));
             cooked = true;
             continue;
@@ -747,7 +757,8 @@ bool TopLevelDefVisitor::try_satisfy_contract(DefId struct_did, DefId contract_d
 
         if (!matching_def.holds<DefFunction>()) {
             auto d = context.emplace_diagnostic(
-                matching_def.span, diag_code::only_message_value_is_meaningful, diag_type::error,
+                matching_def.span(context), diag_code::only_message_value_is_meaningful,
+                diag_type::error,
                 DiagnosticStructDoesNotDefineBlankForContract{.struct_name = struct_def.name,
                                                               .func_name = ct_func_def.name,
                                                               .contract_name = contract_def.name},
@@ -759,10 +770,10 @@ bool TopLevelDefVisitor::try_satisfy_contract(DefId struct_did, DefId contract_d
 
         if (contract_def.compt && !matching_def.compt) {
             dlinker.link(context.emplace_diagnostic_with_message_value(
-                matching_def.span, diag_code::should_be_declared_compt, diag_type::error,
+                matching_def.span(context), diag_code::should_be_declared_compt, diag_type::error,
                 DiagnosticSymbolBeforeMessage{.sid = matching_def.name}));
             dlinker.link(context.emplace_diagnostic_with_message_value(
-                ct_func_def.span, diag_code::declared_in_contract_here, diag_type::note,
+                ct_func_def.span(context), diag_code::declared_in_contract_here, diag_type::note,
                 DiagnosticSymbolBeforeMessage{.sid = ct_func_def.name}));
         }
 
@@ -780,7 +791,7 @@ bool TopLevelDefVisitor::try_satisfy_contract(DefId struct_did, DefId contract_d
                 context.report_function_disagreement_with_contract(ct_func_did, matched_fn_did));
 
             dlinker.link(context.emplace_diagnostic_with_message_value(
-                ct_func_def.span, diag_code::declared_in_contract_here, diag_type::note,
+                ct_func_def.span(context), diag_code::declared_in_contract_here, diag_type::note,
                 DiagnosticSymbolBeforeMessage{.sid = ct_func_def.name}));
 
             cooked = true;
@@ -788,7 +799,7 @@ bool TopLevelDefVisitor::try_satisfy_contract(DefId struct_did, DefId contract_d
     }
     if (cooked) {
         dlinker.link(context.emplace_diagnostic_with_message_value(
-            contract_def.span, diag_code::declared_here, diag_type::note,
+            contract_def.span(context), diag_code::declared_here, diag_type::note,
             DiagnosticSymbolBeforeMessage{.sid = contract_def.name}));
     }
     return cooked;
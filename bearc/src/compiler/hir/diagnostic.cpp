@@ -316,6 +316,8 @@ const char* Diagnostic::message_for_code(enum diag_code c) {
         return "match expression is not exhaustive";
     case diag_code::does_not_consider:
         return "does not consider";
+    case diag_code::did_you_mean:
+        return "did you mean";
     }
 
     std::unreachable();
@@ -349,8 +351,8 @@ const char* Diagnostic::accent_color_for_type(enum diag_type t) {
     return "";
 }
 
-void Diagnostic::print_line(const auto& printable) const {
-    std::cout << "  " << std::setw(width(span.line)) << "" << "  | " << printable << '\n';
+void Diagnostic::print_line(int line_width, const auto& printable) {
+    std::cout << "  " << std::setw(line_width) << "" << "  | " << printable << '\n';
 }
 
 void Diagnostic::print_line_with_number(HirSize line, const auto& printable) const {
@@ -359,19 +361,19 @@ void Diagnostic::print_line_with_number(HirSize line, const auto& printable) con
 
 std::string Diagnostic::line(int min_width) const {
     std::stringstream ss;
-    ss << "  " << std::setw(std::max(min_width, width((span.line)))) << "" << "  | ";
+    ss << "  " << std::setw(min_width) << "" << "  | ";
     return ss.str();
 }
 
 std::string Diagnostic::diag(int min_width) const {
     std::stringstream ss;
-    ss << "  " << std::setw(std::max(min_width, width((span.line)))) << "" << "  \\";
+    ss << "  " << std::setw(min_width) << "" << "  \\";
     return ss.str();
 }
 
 std::string Diagnostic::line_with_number(HirSize line, int min_width) const {
     std::stringstream ss;
-    ss << "  " << std::setw(std::max(min_width, width((span.line)))) << line << "  | ";
+    ss << "  " << std::setw(min_width) << line << "  | ";
     return ss.str();
 }
 
@@ -395,12 +397,13 @@ void Diagnostic::print_info_value(Context& context, HirSize min_width,
                                        << ansi_reset();
         };
         int idx = 0;
+        const int line_width = width(span.line(context));
         std::cout << '\n';
         for (auto fid = IdIdx<FileId>{files.begin().val() + 1}; fid != files.end(); ++fid) {
-            print_line(stream_trace(context.file_id(fid), idx).str());
+            print_line(line_width, stream_trace(context.file_id(fid), idx).str());
             idx++;
         }
-        print_line(stream_trace(context.file_id(files.first()), idx).str());
+        print_line(line_width, stream_trace(context.file_id(files.first()), idx).str());
     };
 
     auto arrow_helper = [this, min_width, more_than_one_line]() {
@@ -436,9 +439,9 @@ void Diagnostic::print_info_value(Context& context, HirSize min_width,
 }
 
 void Diagnostic::print_multiline(Context& context, bool print_file) const {
-    const char* file_name = span.is_generated() ? "" : context.file_name(span.file_id);
-    auto adjusted_line = span.line + 1;
-    auto adjusted_col = span.col + 1;
+    const char* file_name = span.is_generated() ? "" : context.file_name(span.file_id(context));
+    auto adjusted_line = span.line(context) + 1;
+    auto adjusted_col = span.col(context) + 1;
     const char* accent_color = accent_color_for_type(type);
     std::string complex_message_str{};
     if (has_complex_message()) {
@@ -473,7 +476,7 @@ void Diagnostic::print_multiline(Context& context, bool print_file) const {
 
     const char* src_buf_span_start = span_start; // start here before adjusting
     size_t src_buf_span_len = span.len;
-    const char* src_buf_start = context.ast(span.file_id).buffer();
+    const char* src_buf_start = context.ast(span.file_id(context)).buffer();
     // find start of src
     while (src_buf_span_start > src_buf_start && *src_buf_span_start != '\n') {
         --src_buf_span_start;
@@ -658,7 +661,7 @@ void Diagnostic::build_complex_message(Context& ctx, std::string& str) const {
         }
         str += '`';
         str += color;
-        str += type_to_string(ctx, tid);
+        str += ctx.symbol(ctx.type_name(tid));
         str += ansi_bold_reset();
         str += '`';
     };
@@ -161,6 +161,7 @@ enum class diag_code : uint8_t {
     duplicate_match_pattern,
     match_expression_is_not_exhaustive,
     does_not_consider,
+    did_you_mean,
 
     count, // this must be last,
 
@@ -321,7 +322,7 @@ struct Diagnostic : NodeWithVariantValue<Diagnostic> {
     static const char* accent_color_for_type(enum diag_type t);
     void print_info_value(Context& context, HirSize min_width, bool more_than_one_line) const;
     void print_multiline(Context& context, bool print_file) const;
-    void print_line(const auto& printable) const;
+    static void print_line(int line_width, const auto& printable);
     void print_line_with_number(HirSize line, const auto& printable) const;
     [[nodiscard]] std::string line(int min_width) const;
     [[nodiscard]] std::string diag(int min_width) const;
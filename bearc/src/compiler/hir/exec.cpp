@@ -964,8 +964,8 @@ std::optional<ExecConst> ExecConst::try_down_convert_to(builtin_type type) const
     return none();
 }
 
-Exec::Exec(Context& ctx, ExecValue value, Span span, bool should_be_compt)
-    : value{value}, span{span} {
+Exec::Exec(Context& ctx, const ExecValue& value, Span span, bool should_be_compt, bool scratch)
+    : PayloadNode{ctx, value, scratch}, span{span} {
     bool truely_compt = can_be_compt(ctx);
     if (should_be_compt && !truely_compt) {
         ctx.emplace_diagnostic(span, diag_code::cannot_resolve_value_at_compt, diag_type::error);
@@ -985,8 +985,8 @@ bool Exec::is_equivalent(const Context& ctx, ExecId eid1, ExecId eid2) {
         return false;
     }
     if (e1.holds_same<ExecConst>(e2)) {
-        const ExecConst& lit1 = e1.as<ExecConst>();
-        const ExecConst& lit2 = e2.as<ExecConst>();
+        const ExecConst& lit1 = e1.as<ExecConst>(ctx);
+        const ExecConst& lit2 = e2.as<ExecConst>(ctx);
         return lit1.variant_value_equals(lit2);
     }
     return false;
@@ -1070,7 +1070,48 @@ bool Exec::can_be_compt(const Context& ctx) {
         [&](const ExecExprVariantInit&) -> bool { return true; },
         [&](const ExecVariantFieldInit&) -> bool { return true; },
     };
-    return visit(vs);
+    return visit(ctx, vs);
+}
+
+PayloadTables<ExecValue>& Exec::payloads(Context& ctx, bool scratch) {
+    return scratch ? ctx.scratch_exec_payload_tables() : ctx.exec_payload_tables();
+}
+
+const PayloadTables<ExecValue>& Exec::payloads(const Context& ctx, bool scratch) {
+    return scratch ? ctx.scratch_exec_payload_tables() : ctx.exec_payload_tables();
+}
+
+ExecConst ExecConst::from_literal(Context& ctx, const token_t* tkn) {
+    switch (tkn->type) {
+    case TOK_CHAR_LIT:
+        return ExecConst{tkn->val.character};
+    // try as i32 if possible
+    case TOK_INT_LIT: {
+        const ExecConst value{tkn->val.signed_integral};
+        return value.try_safe_convert_to(builtin_type::i32).value_or(value);
+    }
+    // try as i32 and then i64 if possible
+    case TOK_UINT_LIT: {
+        const ExecConst value{tkn->val.unsigned_integral};
+        auto maybe_signed = value.try_safe_convert_to(builtin_type::i32);
+        if (!maybe_signed.has_value()) {
+            maybe_signed = value.try_safe_convert_to(builtin_type::i64);
+        }
+        return maybe_signed.value_or(value);
+    }
+    case TOK_FLOAT_LIT:
+        return ExecConst{tkn->val.floating};
+    case TOK_STR_LIT:
+        return ExecConst{ctx.symbol_id_for_str_lit_tkn(tkn)};
+    case TOK_BOOL_LIT_FALSE:
+        return ExecConst{false};
+    case TOK_BOOL_LIT_TRUE:
+        return ExecConst{true};
+    case TOK_NULL_LIT:
+        return ExecConst{nullptr};
+    default:
+        std::unreachable();
+    }
 }
 
 SymbolId ExecConst::to_symbol_id(Context& ctx) const {
@@ -11,6 +11,7 @@
 
 #include "compiler/hir/exec_ops.hpp"
 #include "compiler/hir/indexing.hpp"
+#include "compiler/hir/payload_tables.hpp"
 #include "compiler/hir/span.hpp"
 #include "compiler/hir/type.hpp"
 #include "compiler/hir/variant_helpers.hpp"
@@ -151,6 +152,10 @@ struct ExecExprComptConstant : NodeWithVariantValue<ExecExprComptConstant> {
 
     ExecExprComptConstant(ConstantValue constval) : value{constval} {}
 
+    /// the value of a literal token, an int literal is an i32 (or i64 for a uint literal) when it
+    /// fits
+    [[nodiscard]] static ExecExprComptConstant from_literal(Context& ctx, const token_t* tkn);
+
     [[nodiscard]] std::optional<ExecExprComptConstant> try_up_convert_to(builtin_type type) const;
     [[nodiscard]] std::optional<ExecExprComptConstant> try_down_convert_to(builtin_type type) const;
 
@@ -348,18 +353,24 @@ using ExecValue = std::variant<
     ExecExprMatch, ExecExprMatchBranch, ExecFnPtr, ExecVariantFieldInit>;
 
 /// main exec structure, corresponds to an hir::ExecId
-struct Exec : NodeWithVariantValue<Exec> {
+/// - the ExecValue itself lives in the context's exec payload tables, reach it w/ as/visit/value
+/// - scratch execs (compt intermediates) keep their payloads in the scratch tables instead
+struct Exec : PayloadNode<Exec, ExecValue> {
     using id_type = ExecId;
     using value_type = ExecValue;
-    ExecValue value;
-    const Span span;
     bool compt;
-    Exec(Context& ctx, ExecValue value, Span span, bool should_be_compt);
+    const Span span;
+    Exec(Context& ctx, const ExecValue& value, Span span, bool should_be_compt,
+         bool scratch = false);
     static bool is_equivalent(const Context& ctx, ExecId eid1, ExecId eid2);
+    [[nodiscard]] static PayloadTables<ExecValue>& payloads(Context& ctx, bool scratch);
+    [[nodiscard]] static const PayloadTables<ExecValue>& payloads(const Context& ctx,
+                                                                  bool scratch);
 
   private:
     bool can_be_compt(const Context& ctx);
 };
+static_assert(sizeof(Exec) <= 16, "hir::Exec grew, keep payloads in the payload tables");
 
 } // namespace hir
 
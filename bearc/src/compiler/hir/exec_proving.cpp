@@ -35,37 +35,38 @@ bool equivalent_exec(const Context& ctx, ExecId eid1, ExecId eid2) {
                 return false;
             }
 
-            if (t.union_def_id != other.as<ExecExprUnionInit>().union_def_id) {
+            if (t.union_def_id != other.as<ExecExprUnionInit>(ctx).union_def_id) {
                 return false;
             }
 
-            if (t.active_member_idx != other.as<ExecExprUnionInit>().active_member_idx) {
+            if (t.active_member_idx != other.as<ExecExprUnionInit>(ctx).active_member_idx) {
                 return false;
             }
 
-            return equivalent_exec(ctx, t.member_init, other.as<ExecExprUnionInit>().member_init);
+            return equivalent_exec(ctx, t.member_init,
+                                   other.as<ExecExprUnionInit>(ctx).member_init);
         },
         [&other, &ctx](const ExecExprVariantInit& t) -> bool {
             if (!other.holds<ExecExprVariantInit>()) {
                 return false;
             }
-            if (t.variant_def_id != other.as<ExecExprVariantInit>().variant_def_id) {
+            if (t.variant_def_id != other.as<ExecExprVariantInit>(ctx).variant_def_id) {
                 return false;
             }
 
-            if (t.active_member_idx != other.as<ExecExprVariantInit>().active_member_idx) {
+            if (t.active_member_idx != other.as<ExecExprVariantInit>(ctx).active_member_idx) {
                 return false;
             }
 
             return equivalent_exec(ctx, t.payload_init,
-                                   other.as<ExecExprVariantInit>().payload_init);
+                                   other.as<ExecExprVariantInit>(ctx).payload_init);
         },
         [&other, &ctx](const ExecExprStructInit& t) -> bool {
             if (!other.holds<ExecExprStructInit>()) {
                 return false;
             }
 
-            const auto o = other.as<ExecExprStructInit>();
+            const auto o = other.as<ExecExprStructInit>(ctx);
 
             if (t.struct_def_id != o.struct_def_id) {
                 return false;
@@ -91,7 +92,7 @@ bool equivalent_exec(const Context& ctx, ExecId eid1, ExecId eid2) {
                 return false;
             }
 
-            const auto o = other.as<ExecExprStructMemberInit>();
+            const auto o = other.as<ExecExprStructMemberInit>(ctx);
 
             if (t.field_def != o.field_def) {
                 return false;
@@ -100,11 +101,11 @@ bool equivalent_exec(const Context& ctx, ExecId eid1, ExecId eid2) {
             return equivalent_exec(ctx, t.value, o.value);
         },
         [](const ExecExprVariable& t) -> bool { return false; },
-        [&other](const ExecExprComptConstant& t) -> bool {
+        [&other, &ctx](const ExecExprComptConstant& t) -> bool {
             if (!other.holds<ExecExprComptConstant>()) {
                 return false;
             }
-            const auto o = other.as<ExecExprComptConstant>();
+            const auto o = other.as<ExecExprComptConstant>(ctx);
             if (!o.holds_same_variant_type(t)) {
                 return false;
             }
@@ -116,7 +117,7 @@ bool equivalent_exec(const Context& ctx, ExecId eid1, ExecId eid2) {
                 return false;
             }
 
-            const auto o = other.as<ExecExprListLiteral>();
+            const auto o = other.as<ExecExprListLiteral>(ctx);
 
             if (o.len() != t.len()) {
                 return false;
@@ -161,7 +162,7 @@ bool equivalent_exec(const Context& ctx, ExecId eid1, ExecId eid2) {
         [](const ExecVariantFieldInit& t) -> bool { return false; },
     };
 
-    return ctx.exec(eid1).visit(vs);
+    return ctx.exec(eid1).visit(ctx, vs);
 }
 
 bool possibly_equivalent_exec(const Context& ctx, ExecId eid1, ExecId eid2) {
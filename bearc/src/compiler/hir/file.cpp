@@ -22,6 +22,8 @@ FileAst::~FileAst() { ast_destroy(&this->ast); }
 const src_buffer* FileAst::src() const noexcept { return &this->ast.src_buffer; }
 const compiler_error_list_t& FileAst::error_list() const noexcept { return this->ast.error_list; }
 const ast_stmt_t* FileAst::root() const noexcept { return this->ast.file_stmt_root_node; }
+const vector_t& FileAst::tokens() const noexcept { return this->ast.tokens; }
+arena_stats_t FileAst::arena_stats() const noexcept { return ::arena_stats(&this->ast.arena); }
 void FileAst::pretty_print() const { pretty_print_stmt(this->root()); }
 void FileAst::print_all_errors(bool compact) const {
     compiler_error_list_print_all(&this->ast.error_list, compact);
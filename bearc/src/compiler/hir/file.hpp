@@ -37,6 +37,10 @@ class FileAst {
     const char* file_name() const noexcept;
     const compiler_error_list_t& error_list() const noexcept;
     const ast_stmt_t* root() const noexcept;
+    /// vector_t of token_t
+    const vector_t& tokens() const noexcept;
+    /// accounting for the arena holding this file's ast nodes
+    arena_stats_t arena_stats() const noexcept;
     void pretty_print() const;
     void print_all_errors(bool compact) const;
     void print_token_table() const;
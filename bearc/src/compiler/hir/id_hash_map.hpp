@@ -11,12 +11,13 @@
 
 #include "compiler/hir/indexing.hpp"
 #include "utils/data_arena.hpp"
-#include "utils/mapu32u32.h"
+#include "utils/flatmapu32u32.h"
 #include <assert.h>
 #include <cstddef>
 namespace hir {
 
 // a hashmap optimized for Id storage, based on an internal arena that is not owned
+// - flat open-addressing table, see utils/flatmapu32u32.h
 template <hir::IsId K, hir::IsId V>
 // should be the case given the constraints of hir::Id concept, but
 // just be extra sure since this will otherwise implode
@@ -24,7 +25,7 @@ template <hir::IsId K, hir::IsId V>
 class IdHashMap {
 
     DataArena& arena;
-    mapu32u32_t map;
+    flatmapu32u32_t map;
 
   public:
     IdHashMap(const IdHashMap&) = delete;
@@ -32,43 +33,51 @@ class IdHashMap {
     IdHashMap& operator=(const IdHashMap&) = delete;
     IdHashMap& operator=(IdHashMap&&) = default;
     IdHashMap(DataArena& arena, size_t capacity)
-        : arena(arena), map(mapu32u32_create_from_arena(capacity, arena.arena())) {}
+        : arena(arena), map(flatmapu32u32_create_from_arena(capacity, arena.arena())) {}
     void insert(K key, V value) {
         assert((key.val() != HIR_ID_NONE) && "tried to insert a key with value HIR_ID_NONE");
-        mapu32u32_insert(&map, key.val(), value.val());
+        flatmapu32u32_insert(&map, key.val(), value.val());
     }
+    /// presize so that elem_cnt entries fit without rehashing mid-insertion
+    void reserve(size_t elem_cnt) { flatmapu32u32_reserve(&map, static_cast<uint32_t>(elem_cnt)); }
     /// returns false if key is not found
-    bool remove(K key) { return mapu32u32_remove(&map, key.val()); }
+    bool remove(K key) { return flatmapu32u32_remove(&map, key.val()); }
     /// returns an optional id by value
     OptId<V> at(K key) const {
-        auto* value = mapu32u32_cat(&map, key.val());
+        auto* value = flatmapu32u32_cat(&map, key.val());
         if (value == nullptr) {
             return OptId<V>{};
         }
         return OptId<V>{V{*value}};
     }
-    bool contains(K key) { return mapu32u32_at(&map, key.val()) != 0; }
+    bool contains(K key) const { return flatmapu32u32_contains(&map, key.val()); }
+    [[nodiscard]] size_t size() const noexcept { return map.size; }
+    [[nodiscard]] size_t capacity() const noexcept { return map.capacity; }
+    /// bytes of the live table (older tables left behind by growth still sit in the arena)
+    [[nodiscard]] size_t table_bytes() const noexcept {
+        return (map.capacity * (sizeof(flatmapu32u32_slot_t) + 1)) + FLATMAPU32U32_GROUP_WIDTH;
+    }
 
     class Entry {
         K key_;
         V val_;
 
       public:
-        K key() const noexcept { return *key_; }
-        V val() const noexcept { return *val_; }
+        K key() const noexcept { return key_; }
+        V val() const noexcept { return val_; }
         Entry(K key, V val) : key_(key), val_(val) {}
     };
 
     struct Iter {
         using iterator_category = std::forward_iterator_tag;
 
-        Iter(const mapu32u32_t* map) noexcept : it{mapu32u32_iter_begin(map)} {}
-        Iter(const mapu32u32_iter_t raw_it) noexcept : it{raw_it} {}
+        Iter(const flatmapu32u32_t* map) noexcept : it{flatmapu32u32_iter_begin(map)} {}
+        Iter(const flatmapu32u32_iter_t raw_it) noexcept : it{raw_it} {}
 
         Entry operator*() const noexcept { return Entry{K{it.curr->key}, V{it.curr->val}}; }
 
         Iter& operator++() noexcept {
-            mapu32u32_iter_next(&it);
+            flatmapu32u32_iter_next(&it);
             return *this;
         }
 
@@ -79,9 +88,9 @@ class IdHashMap {
         }
 
         static Iter end() noexcept {
-            return Iter{mapu32u32_iter_t{
+            return Iter{flatmapu32u32_iter_t{
                 .map = nullptr,
-                .bucket_idx = 0,
+                .idx = 0,
                 .curr = nullptr,
             }};
         }
@@ -92,7 +101,7 @@ class IdHashMap {
         friend bool operator!=(const Iter& a, const Iter& b) noexcept { return !(a == b); }
 
       private:
-        mapu32u32_iter_t it;
+        flatmapu32u32_iter_t it;
     };
     Iter iter() { return Iter{&map}; }
     Iter begin() const noexcept { return Iter{&map}; }
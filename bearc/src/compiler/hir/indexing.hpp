@@ -187,6 +187,12 @@ template <hir::IsId T> class IdSlice {
     [[nodiscard]] constexpr IdIdx<T> begin() const noexcept { return first_; }
 
     [[nodiscard]] constexpr IdIdx<T> end() const noexcept { return IdIdx<T>{first_.val() + len_}; }
+
+    /// compares where the slices point, which equals comparing contents when both slices were
+    /// interned (see hir::IdVector::intern_small_vec)
+    friend constexpr bool operator==(IdSlice a, IdSlice b) {
+        return a.first_ == b.first_ && a.len_ == b.len_;
+    }
 };
 
 using OrderedDefSliceId = Id<IdSlice<DefId>>;
@@ -42,7 +42,8 @@ bool valid_exhaustive_match_for_variant(S& solver, ScopeId scope, FileId fid, De
 
     assert(variant_def.holds<DefVariant>());
 
-    IdSet<DefId> used_variant_fields{arena, 2 * variant_def.as<DefVariant>().ordered_members.len()};
+    IdSet<DefId> used_variant_fields{
+        arena, 2 * variant_def.as<DefVariant>(context).ordered_members.len()};
 
     const ast_slice_of_exprs_t branches = match_expr->expr.match_expr.branches;
 
@@ -125,7 +126,7 @@ bool valid_exhaustive_match_for_variant(S& solver, ScopeId scope, FileId fid, De
         }
     }
 
-    const auto variant_fields = variant_def.as<DefVariant>().ordered_members;
+    const auto variant_fields = variant_def.as<DefVariant>(context).ordered_members;
 
     if (!else_pattern && !(used_variant_fields.size() == variant_fields.len())) {
         Span span{context, fid, match_expr};
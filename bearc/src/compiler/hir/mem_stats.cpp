@@ -0,0 +1,91 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#include "compiler/hir/mem_stats.hpp"
+#include "utils/ansi_codes.h"
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace hir {
+
+MemPhaseStat MemStatsReport::total(const char* phase) const noexcept {
+    MemPhaseStat sum{phase, 0, 0};
+    for (const auto& rows : {&structures, &files}) {
+        for (const MemStat& row : *rows) {
+            if (!row.nested) {
+                sum.reserved += row.reserved;
+                sum.used += row.used;
+            }
+        }
+    }
+    return sum;
+}
+
+/// bytes in a short human-readable form
+static std::string fmt_bytes(size_t bytes) {
+    static constexpr const char* units[] = {"B", "KiB", "MiB", "GiB"};
+    double val = static_cast<double>(bytes);
+    size_t unit = 0;
+    while (val >= 1024.0 && unit + 1 < sizeof(units) / sizeof(units[0])) {
+        val /= 1024.0;
+        ++unit;
+    }
+    std::ostringstream ss;
+    if (unit == 0) {
+        ss << bytes << ' ' << units[unit];
+    } else {
+        ss << std::fixed << std::setprecision(1) << val << ' ' << units[unit];
+    }
+    return ss.str();
+}
+
+static constexpr int NAME_WIDTH = 44;
+static constexpr int COL_WIDTH = 12;
+
+static void print_header(std::ostream& out, const char* title, bool with_count) {
+    out << ansi_bold_reset() << std::left << std::setw(NAME_WIDTH) << title << std::right
+        << std::setw(COL_WIDTH) << "reserved" << std::setw(COL_WIDTH) << "used";
+    if (with_count) {
+        out << std::setw(COL_WIDTH) << "count";
+    }
+    out << ansi_reset() << '\n';
+}
+
+static void print_row(std::ostream& out, const MemStat& row) {
+    // nested rows are indented under the arena that backs them
+    const std::string name = row.nested ? "  " + row.name : row.name;
+    out << std::left << std::setw(NAME_WIDTH) << name << std::right << std::setw(COL_WIDTH)
+        << fmt_bytes(row.reserved) << std::setw(COL_WIDTH) << fmt_bytes(row.used)
+        << std::setw(COL_WIDTH) << row.count << '\n';
+}
+
+void MemStatsReport::print(std::ostream& out) const {
+    print_header(out, "structures", true);
+    for (const MemStat& row : structures) {
+        print_row(out, row);
+    }
+    print_header(out, "files (ast arena + tokens + src)", true);
+    for (const MemStat& row : files) {
+        print_row(out, row);
+    }
+    print_header(out, "phases (running totals)", false);
+    for (const MemPhaseStat& phase : phases) {
+        out << std::left << std::setw(NAME_WIDTH) << phase.phase << std::right
+            << std::setw(COL_WIDTH) << fmt_bytes(phase.reserved) << std::setw(COL_WIDTH)
+            << fmt_bytes(phase.used) << '\n';
+    }
+    const MemPhaseStat sum = total("total");
+    out << ansi_bold_reset() << std::left << std::setw(NAME_WIDTH) << sum.phase << std::right
+        << std::setw(COL_WIDTH) << fmt_bytes(sum.reserved) << std::setw(COL_WIDTH)
+        << fmt_bytes(sum.used) << ansi_reset() << '\n';
+}
+
+} // namespace hir
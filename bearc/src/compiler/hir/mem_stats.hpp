@@ -0,0 +1,69 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#ifndef COMPILER_HIR_MEM_STATS_HPP
+#define COMPILER_HIR_MEM_STATS_HPP
+
+#include "utils/arena.h"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hir {
+
+/// reserved vs used bytes of one structure (or file) and how many elements it holds
+struct MemStat {
+    std::string name;
+    size_t reserved;
+    size_t used;
+    size_t count;
+    /// whether this structure's storage lives inside an arena already reported, if so it's listed
+    /// for detail but not added to the totals again
+    bool nested = false;
+};
+
+/// running totals of everything the Context owns, snapshotted after a compilation phase
+struct MemPhaseStat {
+    const char* phase;
+    size_t reserved;
+    size_t used;
+};
+
+/// what --mem-stats prints
+struct MemStatsReport {
+    std::vector<MemStat> structures;
+    std::vector<MemStat> files;
+    std::vector<MemPhaseStat> phases;
+
+    /// sums all non-nested structures and files
+    [[nodiscard]] MemPhaseStat total(const char* phase) const noexcept;
+    void print(std::ostream& out) const;
+};
+
+/// a row for an arena w/ its element count supplied by the caller
+[[nodiscard]] inline MemStat mem_stat_of_arena(std::string name, arena_stats_t stats,
+                                               size_t count) {
+    return MemStat{std::move(name), stats.reserved, stats.used, count};
+}
+
+/// a row for any IdVecMap-like container exposing reserved_bytes/used_bytes/size
+template <typename C> [[nodiscard]] MemStat mem_stat_of_vec(std::string name, const C& c) {
+    return MemStat{std::move(name), c.reserved_bytes(), c.used_bytes(), c.size()};
+}
+
+/// a row for any hash map exposing table_bytes/size, always nested in its backing arena
+template <typename M>
+[[nodiscard]] MemStat mem_stat_of_map(std::string name, const M& m, size_t slot_size) {
+    return MemStat{std::move(name), m.table_bytes(), m.size() * slot_size, m.size(), true};
+}
+
+} // namespace hir
+
+#endif
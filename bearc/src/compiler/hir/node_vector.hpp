@@ -10,8 +10,20 @@
 #define COMPILER_HIR_NODE_VECTOR_HPP
 
 #include "compiler/hir/indexing.hpp"
+#include "utils/strintern.h" // for hash_bytes
 #include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
 #include <utility>
 #include <vector>
 namespace hir {
@@ -21,69 +33,320 @@ concept Node = hir::IsId<typename T::id_type>;
 /// Maps an hir::Id to any type
 /// - this should be used for linear indexing where each contiguous Id that exists will correspond
 /// to exactly one value..
+/// - storage is chunked: values live in power-of-two sized chunks, each one past the first as large
+/// as all before it, and growing only ever adds a chunk, so a value never moves once emplaced and
+/// references into the map stay valid across later emplaces (e.g. while recursively resolving)
+/// - chunk bases are kept inline, so an access costs one load into the chunk, like a vector's
+/// - access is unchecked in release builds and asserted in debug builds
 template <hir::IsId I, typename V> class IdVecMap {
-  protected:
-    std::vector<V> vec;
-
-  private:
     static constexpr HirId OFFSET = 1;
+    static constexpr unsigned MIN_CHUNK_BITS = 6;
+    static constexpr unsigned ID_BITS = std::numeric_limits<HirId>::digits;
+
+    /// each chunk's address pulled back by its first idx, so the value at idx lives at
+    /// `biases[slot_of(idx)] + idx * sizeof(V)` w/o a per-chunk offset to subtract
+    /// - slotted by the leading zeros of the chunk's idxs rather than by the chunk's index, so a
+    /// lookup is a bit scan then this load, w/o rebasing the scan to a chunk index in between
+    std::array<uintptr_t, ID_BITS> biases{};
+    unsigned chunk_cnt = 0;
+    /// the free slots of the chunk push writes into and the idx that chunk ends at, so a push
+    /// only looks at the chunk table when it crosses into the next chunk
+    /// - the size is derived from these, so a push bumps a single ptr, like a vector's
+    V* tail = nullptr;
+    V* tail_end = nullptr;
+    size_t tail_end_idx = 0;
+    /// log2 of the first chunk's size
+    unsigned chunk_bits;
+
+    [[nodiscard]] static unsigned bits_for(size_t capacity) noexcept {
+        const unsigned bits = std::bit_width(std::max<size_t>(capacity, 1) - 1);
+        return std::max(bits, MIN_CHUNK_BITS);
+    }
+
+    /// the slot in biases of idx's chunk, idx's leading zeros w/ every idx of the first chunk
+    /// sharing one slot
+    /// - or-ing in the first chunk's mask (and 1, which it always covers) keeps the operand
+    /// provably nonzero, so no branch guards the bit scan
+    [[nodiscard]] unsigned slot_of(size_t idx) const noexcept {
+        const HirId first_mask = (HirId{1} << chunk_bits) - 1;
+        return std::countl_zero(static_cast<HirId>(idx) | first_mask | 1);
+    }
+    /// 0 for the first chunk, then the chunk k whose idxs are [2^(bits + k - 1), 2^(bits + k))
+    [[nodiscard]] unsigned chunk_of(size_t idx) const noexcept {
+        return ID_BITS - chunk_bits - slot_of(idx);
+    }
+    [[nodiscard]] uintptr_t& bias(unsigned chunk) noexcept {
+        return biases[ID_BITS - chunk_bits - chunk];
+    }
+    [[nodiscard]] uintptr_t bias(unsigned chunk) const noexcept {
+        return biases[ID_BITS - chunk_bits - chunk];
+    }
+    [[nodiscard]] size_t chunk_start(unsigned chunk) const noexcept {
+        return (chunk == 0) ? 0 : size_t{1} << (chunk_bits + chunk - 1);
+    }
+    [[nodiscard]] size_t chunk_len(unsigned chunk) const noexcept {
+        return size_t{1} << (chunk_bits + ((chunk == 0) ? 0 : chunk - 1));
+    }
+    [[nodiscard]] V* chunk_base(unsigned chunk) const noexcept {
+        return reinterpret_cast<V*>(bias(chunk) + (chunk_start(chunk) * sizeof(V)));
+    }
+
+    [[nodiscard]] V* locate(size_t idx) const noexcept {
+        return reinterpret_cast<V*>(biases[slot_of(idx)] + (idx * sizeof(V)));
+    }
+
+    void add_chunk() {
+        // chunk sizes double past the first, so the chunks up to slot 0 span every HirId
+        assert(chunk_bits + chunk_cnt <= ID_BITS && "[hir::IdVecMap] out of chunks\n");
+        const unsigned chunk = chunk_cnt;
+        V* mem = std::allocator<V>{}.allocate(chunk_len(chunk));
+        bias(chunk) = reinterpret_cast<uintptr_t>(mem) - (chunk_start(chunk) * sizeof(V));
+        ++chunk_cnt;
+    }
+
+    void destroy() noexcept {
+        for (size_t i = 0, n = size(); i < n; i++) {
+            locate(i)->~V();
+        }
+        for (unsigned chunk = 0; chunk < chunk_cnt; chunk++) {
+            std::allocator<V>{}.deallocate(chunk_base(chunk), chunk_len(chunk));
+        }
+        chunk_cnt = 0;
+        reset_tail();
+    }
+
+    void reset_tail() noexcept {
+        tail = nullptr;
+        tail_end = nullptr;
+        tail_end_idx = 0;
+    }
+    /// points the tail at the chunk holding idx size(), adding it if needed
+    void next_tail() {
+        const size_t idx = size();
+        const unsigned chunk = chunk_of(idx);
+        if (chunk == chunk_cnt) {
+            add_chunk();
+        }
+        tail = locate(idx);
+        tail_end = chunk_base(chunk) + chunk_len(chunk);
+        tail_end_idx = chunk_start(chunk) + chunk_len(chunk);
+    }
+
+    /// the values held by a chunk, clipped to size()
+    [[nodiscard]] V* run_end(unsigned chunk) const noexcept {
+        return chunk_base(chunk) + (std::min(size(), chunk_start(chunk) + chunk_len(chunk))
+                                    - chunk_start(chunk));
+    }
+
+  protected:
+    template <typename... Args> V& push(Args&&... args) {
+        if (tail == tail_end) [[unlikely]] {
+            next_tail();
+        }
+        V* slot = ::new (static_cast<void*>(tail)) V(std::forward<Args>(args)...);
+        ++tail;
+        return *slot;
+    }
+    /// 0-based element access, bypassing the 1-offset
+    [[nodiscard]] const V& nth(size_t idx) const noexcept {
+        assert(idx < size() && "[hir::IdVecMap] index out of range\n");
+        return *locate(idx);
+    }
 
   public:
-    explicit IdVecMap(HirSize capacity) : vec{} { vec.reserve(capacity + OFFSET); }
-    void reserve(HirSize size) { vec.reserve(size); }
-    [[nodiscard]] V& at(I id) {
-        assert(id.val() != HIR_ID_NONE && "[hir::IdVecMap::at] asked for an id of HIR_ID_NONE\n");
-        return vec.at(id.val() - OFFSET);
+    /// the first chunk is sized to fit `capacity` values, though only allocated on first use
+    explicit IdVecMap(HirSize capacity) : chunk_bits{bits_for(capacity)} {}
+    IdVecMap(const IdVecMap&) = delete;
+    IdVecMap& operator=(const IdVecMap&) = delete;
+    IdVecMap(IdVecMap&& other) noexcept
+        : biases{other.biases}, chunk_cnt{other.chunk_cnt}, tail{other.tail},
+          tail_end{other.tail_end}, tail_end_idx{other.tail_end_idx}, chunk_bits{other.chunk_bits} {
+        other.chunk_cnt = 0;
+        other.reset_tail();
+    }
+    IdVecMap& operator=(IdVecMap&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            biases = other.biases;
+            chunk_cnt = other.chunk_cnt;
+            tail = other.tail;
+            tail_end = other.tail_end;
+            tail_end_idx = other.tail_end_idx;
+            chunk_bits = other.chunk_bits;
+            other.chunk_cnt = 0;
+            other.reset_tail();
+        }
+        return *this;
     }
-    [[nodiscard]] const V& cat(I id) const {
-        assert(id.val() != HIR_ID_NONE && "[hir::IdVecMap::cat] asked for an id of HIR_ID_NONE\n");
-        return vec.at(id.val() - OFFSET);
+    ~IdVecMap() { destroy(); }
+
+    void reserve(HirSize size) {
+        while (capacity() < size) {
+            add_chunk();
+        }
+    }
+    /// destroys every value but keeps the chunks, so refilling doesn't allocate again
+    void clear() noexcept {
+        for (size_t i = 0, n = size(); i < n; i++) {
+            locate(i)->~V();
+        }
+        reset_tail();
+    }
+    [[nodiscard]] V& operator[](I id) noexcept {
+        assert(id.val() != HIR_ID_NONE && "[hir::IdVecMap] asked for an id of HIR_ID_NONE\n");
+        assert(id.val() - OFFSET < size() && "[hir::IdVecMap] id out of range\n");
+        return *locate(id.val() - OFFSET);
+    }
+    [[nodiscard]] const V& operator[](I id) const noexcept {
+        assert(id.val() != HIR_ID_NONE && "[hir::IdVecMap] asked for an id of HIR_ID_NONE\n");
+        assert(id.val() - OFFSET < size() && "[hir::IdVecMap] id out of range\n");
+        return *locate(id.val() - OFFSET);
     }
+    [[nodiscard]] V& at(I id) { return (*this)[id]; }
+    [[nodiscard]] const V& cat(I id) const { return (*this)[id]; }
     template <typename... Args>
     [[nodiscard("Id must be fetched or emplaced node is dead.")]] I
     emplace_and_get_id(Args&&... args) {
-        vec.emplace_back(std::forward<Args>(args)...);
-        return I{static_cast<HirId>(vec.size()) - 1
-                 + OFFSET}; // so just the size, but this is crucial
+        push(std::forward<Args>(args)...);
+        return I{static_cast<HirId>(size()) - 1 + OFFSET}; // so just the size, but this is crucial
     }
     template <typename... Args> I bump(Args&&... args) {
-        vec.emplace_back(std::forward<Args>(args)...);
-        return I{static_cast<HirId>(vec.size()) - 1
-                 + OFFSET}; // so just the size, but this is crucial
+        push(std::forward<Args>(args)...);
+        return I{static_cast<HirId>(size()) - 1 + OFFSET}; // so just the size, but this is crucial
     }
 
     [[nodiscard]] I begin_id() const { return I{1}; }
-    [[nodiscard]] I end_id() const { return I{static_cast<HirId>(vec.size() + OFFSET)}; }
-    [[nodiscard]] I rbegin_id() const { return I{static_cast<HirId>(vec.size() + OFFSET - 1)}; }
+    [[nodiscard]] I end_id() const { return I{static_cast<HirId>(size() + OFFSET)}; }
+    [[nodiscard]] I rbegin_id() const { return I{static_cast<HirId>(size() + OFFSET - 1)}; }
     [[nodiscard]] I rend_id() const { return I{0}; }
 
+    /// calls f(std::span<V>) on each contiguous run of values in id order, i.e. once per chunk
+    /// - prefer this to the iterators in hot loops, a run is a plain array the compiler can
+    /// vectorize a loop over
+    template <typename F> void for_each_run(F f) {
+        for (unsigned chunk = 0; chunk < chunk_cnt && chunk_start(chunk) < size(); chunk++) {
+            f(std::span<V>{chunk_base(chunk), run_end(chunk)});
+        }
+    }
+    template <typename F> void for_each_run(F f) const {
+        for (unsigned chunk = 0; chunk < chunk_cnt && chunk_start(chunk) < size(); chunk++) {
+            f(std::span<const V>{chunk_base(chunk), run_end(chunk)});
+        }
+    }
+
+    /// bidirectional iterator over the values in id order, walks a ptr within each run
+    template <bool Const> class basic_iterator {
+        using map_type = std::conditional_t<Const, const IdVecMap, IdVecMap>;
+        map_type* map;
+        V* ptr;
+        V* end; // of the run ptr is in
+        unsigned chunk;
+
+        basic_iterator(map_type* map, V* ptr, unsigned chunk)
+            : map{map}, ptr{ptr}, end{map->run_end(chunk)}, chunk{chunk} {}
+
+        friend IdVecMap;
+        friend basic_iterator<!Const>;
+
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = V;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const V*, V*>;
+        using reference = std::conditional_t<Const, const V&, V&>;
+
+        basic_iterator() : map{nullptr}, ptr{nullptr}, end{nullptr}, chunk{0} {}
+        // mutable -> const
+        operator basic_iterator<true>() const
+            requires(!Const)
+        {
+            return basic_iterator<true>{map, ptr, chunk};
+        }
+
+        reference operator*() const { return *ptr; }
+        pointer operator->() const { return ptr; }
+        basic_iterator& operator++() {
+            // the last run's end is the map's end(), so only step into a run that holds values
+            if (++ptr == end) [[unlikely]] {
+                if (chunk + 1 < map->chunk_cnt && map->chunk_start(chunk + 1) < map->size()) {
+                    ++chunk;
+                    ptr = map->chunk_base(chunk);
+                    end = map->run_end(chunk);
+                }
+            }
+            return *this;
+        }
+        basic_iterator operator++(int) {
+            basic_iterator prev = *this;
+            ++*this;
+            return prev;
+        }
+        basic_iterator& operator--() {
+            if (ptr == map->chunk_base(chunk)) {
+                --chunk;
+                end = map->run_end(chunk);
+                ptr = end;
+            }
+            --ptr;
+            return *this;
+        }
+        basic_iterator operator--(int) {
+            basic_iterator prev = *this;
+            --*this;
+            return prev;
+        }
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) {
+            return a.ptr == b.ptr;
+        }
+    };
+
     using value_type = V;
     using reference = V&;
     using const_reference = const V&;
-    using iterator = typename std::vector<V>::iterator;
-    using const_iterator = typename std::vector<V>::const_iterator;
-    using reverse_iterator = typename std::vector<V>::reverse_iterator;
-    using const_reverse_iterator = typename std::vector<V>::const_reverse_iterator;
-    using size_type = typename std::vector<V>::size_type;
-
-    [[nodiscard]] iterator begin() noexcept { return vec.begin(); }
-    [[nodiscard]] const_iterator begin() const noexcept { return vec.begin(); }
-    [[nodiscard]] const_iterator cbegin() const noexcept { return vec.cbegin(); }
-
-    [[nodiscard]] iterator end() noexcept { return vec.end(); }
-    [[nodiscard]] const_iterator end() const noexcept { return vec.end(); }
-    [[nodiscard]] const_iterator cend() const noexcept { return vec.cend(); }
-
-    [[nodiscard]] reverse_iterator rbegin() noexcept { return vec.rbegin(); }
-    [[nodiscard]] const_reverse_iterator rbegin() const noexcept { return vec.rbegin(); }
-    [[nodiscard]] const_reverse_iterator crbegin() const noexcept { return vec.crbegin(); }
-
-    [[nodiscard]] reverse_iterator rend() noexcept { return vec.rend(); }
-    [[nodiscard]] const_reverse_iterator rend() const noexcept { return vec.rend(); }
-    [[nodiscard]] const_reverse_iterator crend() const noexcept { return vec.crend(); }
-
-    [[nodiscard]] bool empty() const noexcept { return vec.empty(); }
-    [[nodiscard]] size_type size() const noexcept { return vec.size(); }
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using size_type = size_t;
+
+    [[nodiscard]] iterator begin() noexcept { return iterator{this, chunk_base(0), 0}; }
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return const_iterator{this, chunk_base(0), 0};
+    }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+
+    [[nodiscard]] iterator end() noexcept {
+        const unsigned last = (size() == 0) ? 0 : chunk_of(size() - 1);
+        return iterator{this, run_end(last), last};
+    }
+    [[nodiscard]] const_iterator end() const noexcept {
+        const unsigned last = (size() == 0) ? 0 : chunk_of(size() - 1);
+        return const_iterator{this, run_end(last), last};
+    }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    [[nodiscard]] reverse_iterator rbegin() noexcept { return reverse_iterator{end()}; }
+    [[nodiscard]] const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator{end()};
+    }
+    [[nodiscard]] const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+
+    [[nodiscard]] reverse_iterator rend() noexcept { return reverse_iterator{begin()}; }
+    [[nodiscard]] const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator{begin()};
+    }
+    [[nodiscard]] const_reverse_iterator crend() const noexcept { return rend(); }
+
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+    [[nodiscard]] size_type size() const noexcept {
+        return tail_end_idx - static_cast<size_t>(tail_end - tail);
+    }
+    [[nodiscard]] size_type capacity() const noexcept {
+        return (chunk_cnt == 0) ? 0 : size_t{1} << (chunk_bits + chunk_cnt - 1);
+    }
+    /// shallow, so heap storage owned by the values themselves isn't included
+    [[nodiscard]] size_t reserved_bytes() const noexcept { return capacity() * sizeof(V); }
+    [[nodiscard]] size_t used_bytes() const noexcept { return size() * sizeof(V); }
 };
 
 /// Models a vector of an hir::Node
@@ -95,19 +358,104 @@ template <Node T> class NodeVector : public IdVecMap<typename T::id_type, T> {
 /// Models a vector of an hir::IdIdx pointing to hir::Id
 template <hir::IsId I> class IdVector : public IdVecMap<typename hir::IdIdx<I>, I> {
     static constexpr HirSize OFFSET = 1;
+    static constexpr size_t INTERN_MIN_CAP = 64;
+
+    /// a previously interned slice, `len == 0` marks an empty slot since empty slices are never
+    /// stored
+    struct InternSlot {
+        uint32_t hash;
+        HirId first;
+        HirSize len;
+    };
+    /// open addressing w/ linear probing, power of two sized, allocated on first intern
+    std::vector<InternSlot> intern_table;
+    size_t intern_cnt = 0;
+
+    static_assert(std::is_trivially_copyable_v<I> && sizeof(I) == sizeof(HirId));
+
+    [[nodiscard]] static uint32_t hash_ids(const llvm::SmallVectorImpl<I>& svec) {
+        return static_cast<uint32_t>(hash_bytes(svec.data(), svec.size() * sizeof(I)));
+    }
+
+    [[nodiscard]] bool same_contents(const InternSlot& slot,
+                                     const llvm::SmallVectorImpl<I>& svec) const {
+        if (slot.len != svec.size()) {
+            return false;
+        }
+        for (HirSize i = 0; i < slot.len; i++) {
+            if (!(this->nth(slot.first - OFFSET + i) == svec[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void grow_intern_table() {
+        const size_t cap = intern_table.empty() ? INTERN_MIN_CAP : intern_table.size() * 2;
+        std::vector<InternSlot> old = std::move(intern_table);
+        intern_table.assign(cap, InternSlot{0, 0, 0});
+        for (const InternSlot& slot : old) {
+            if (slot.len == 0) {
+                continue;
+            }
+            size_t idx = slot.hash & (cap - 1);
+            while (intern_table[idx].len != 0) {
+                idx = (idx + 1) & (cap - 1);
+            }
+            intern_table[idx] = slot;
+        }
+    }
 
   public:
     explicit IdVector(HirSize capacity) : IdVecMap<typename hir::IdIdx<I>, I>(capacity) {}
     IdSlice<I> freeze_small_vec(const llvm::SmallVectorImpl<I>& svec) {
         // basically we're just allocating a contiguous chunk inside the vector so that we can copy
         // in the small vector into internal, permanent storage
-        IdIdx<I> first{static_cast<HirId>(this->vec.size() + OFFSET)};
+        IdIdx<I> first{static_cast<HirId>(this->size() + OFFSET)};
         for (const auto id : svec) {
-            this->vec.emplace_back(id);
+            this->push(id);
         }
         HirSize len = svec.size();
         return IdSlice<I>{first, len};
     }
+
+    /// like freeze_small_vec, but hands back the existing slice when the same sequence of ids has
+    /// been interned before, so equal interned slices share storage and compare equal w/ ==
+    /// - every empty sequence interns to the default IdSlice
+    /// - interned storage must never be written to thru an IdIdx, since it may be shared
+    IdSlice<I> intern_small_vec(const llvm::SmallVectorImpl<I>& svec) {
+        if (svec.empty()) {
+            return IdSlice<I>{};
+        }
+        if ((intern_cnt + 1) * 4 > intern_table.size() * 3) {
+            grow_intern_table();
+        }
+        const uint32_t hash = hash_ids(svec);
+        const size_t mask = intern_table.size() - 1;
+        size_t idx = hash & mask;
+        while (intern_table[idx].len != 0) {
+            const InternSlot& slot = intern_table[idx];
+            if (slot.hash == hash && same_contents(slot, svec)) {
+                return IdSlice<I>{IdIdx<I>{slot.first}, slot.len};
+            }
+            idx = (idx + 1) & mask;
+        }
+        const IdSlice<I> fresh = freeze_small_vec(svec);
+        intern_table[idx] = InternSlot{hash, fresh.first().val(), fresh.len()};
+        ++intern_cnt;
+        return fresh;
+    }
+
+    /// number of distinct slices interned so far
+    [[nodiscard]] size_t interned_count() const noexcept { return intern_cnt; }
+
+    // shadow IdVecMap's so the intern table is accounted for too
+    [[nodiscard]] size_t reserved_bytes() const noexcept {
+        return (this->capacity() * sizeof(I)) + (intern_table.capacity() * sizeof(InternSlot));
+    }
+    [[nodiscard]] size_t used_bytes() const noexcept {
+        return (this->size() * sizeof(I)) + (intern_cnt * sizeof(InternSlot));
+    }
 };
 
 } // namespace hir
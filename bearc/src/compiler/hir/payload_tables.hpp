@@ -0,0 +1,196 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+
+#ifndef COMPILER_HIR_PAYLOAD_TABLES_HPP
+#define COMPILER_HIR_PAYLOAD_TABLES_HPP
+
+#include "compiler/hir/indexing.hpp"
+#include "compiler/hir/node_vector.hpp"
+#include "compiler/hir/variant_helpers.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace hir {
+
+class Context;
+
+/**
+ * PayloadTables<std::variant<Ts...>>, dense per-alternative storage for the values of a variant
+ * - a node keeps a one-byte tag (the alternative's index) and a HirSize index into that
+ * alternative's table, so it no longer pays for the largest alternative
+ * - tables are IdVecMaps, so refs into them stay valid while more payloads are pushed
+ * - empty alternatives (e.g. ExecBreakStmt) are never stored, their index is always none
+ * - `clear` drops every payload but keeps the chunks, so a scratch region can be refilled for free
+ */
+template <typename Variant> class PayloadTables;
+
+template <typename... Ts> class PayloadTables<std::variant<Ts...>> {
+  public:
+    using variant_type = std::variant<Ts...>;
+    using tag_type = uint8_t;
+    static_assert(sizeof...(Ts) <= UINT8_MAX, "too many alternatives for a one-byte tag");
+
+    template <typename T>
+    static constexpr tag_type tag_of = static_cast<tag_type>(variant_index_v<T, variant_type>);
+
+  private:
+    template <typename T> using Table = IdVecMap<Id<T>, T>;
+    std::tuple<Table<Ts>...> tables;
+
+    template <typename T> [[nodiscard]] Table<T>& table() noexcept {
+        return std::get<variant_index_v<T, variant_type>>(tables);
+    }
+    template <typename T> [[nodiscard]] const Table<T>& table() const noexcept {
+        return std::get<variant_index_v<T, variant_type>>(tables);
+    }
+
+  public:
+    /// each table is sized for `capacity` payloads, allocated on its first push
+    explicit PayloadTables(HirSize capacity) : tables{Table<Ts>{capacity}...} {}
+
+    /// store a payload, returns its idx within T's table
+    template <typename T> [[nodiscard]] HirSize push(T&& value) {
+        using U = std::remove_cvref_t<T>;
+        if constexpr (std::is_empty_v<U>) {
+            return HIR_ID_NONE;
+        } else {
+            return table<U>().emplace_and_get_id(std::forward<T>(value)).val();
+        }
+    }
+
+    /// store whatever alternative `value` holds, returns its {tag, idx}
+    [[nodiscard]] std::pair<tag_type, HirSize> push_variant(const variant_type& value) {
+        const HirSize idx = std::visit([this](const auto& alt) { return push(alt); }, value);
+        return {static_cast<tag_type>(value.index()), idx};
+    }
+
+    template <typename T> [[nodiscard]] T& at(HirSize idx) noexcept {
+        if constexpr (std::is_empty_v<T>) {
+            static T empty{};
+            return empty;
+        } else {
+            return table<T>().at(Id<T>{idx});
+        }
+    }
+    template <typename T> [[nodiscard]] const T& cat(HirSize idx) const noexcept {
+        if constexpr (std::is_empty_v<T>) {
+            static const T empty{};
+            return empty;
+        } else {
+            return table<T>().cat(Id<T>{idx});
+        }
+    }
+
+    /// std::visit over the payload at {tag, idx}, the visitor's result type is taken from the
+    /// first alternative
+    template <typename F> decltype(auto) visit(tag_type tag, HirSize idx, F&& visitor) const {
+        using R = std::invoke_result_t<F&, const std::variant_alternative_t<0, variant_type>&>;
+        using Fn = R (*)(const PayloadTables&, HirSize, F&);
+        static constexpr Fn dispatch[] = {+[](const PayloadTables& self, HirSize i, F& f) -> R {
+            return f(self.template cat<Ts>(i));
+        }...};
+        return dispatch[tag](*this, idx, visitor);
+    }
+
+    /// rebuild the full variant, only for when a copy is really needed
+    [[nodiscard]] variant_type load(tag_type tag, HirSize idx) const {
+        return visit(tag, idx, [](const auto& alt) -> variant_type { return alt; });
+    }
+
+    /// drops every payload, any idx handed out before is dead afterwards
+    void clear() noexcept {
+        std::apply([](auto&... t) { (t.clear(), ...); }, tables);
+    }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return std::apply([](const auto&... t) { return (t.size() + ...); }, tables);
+    }
+    [[nodiscard]] size_t reserved_bytes() const noexcept {
+        return std::apply([](const auto&... t) { return (t.reserved_bytes() + ...); }, tables);
+    }
+    [[nodiscard]] size_t used_bytes() const noexcept {
+        return std::apply([](const auto&... t) { return (t.used_bytes() + ...); }, tables);
+    }
+};
+
+/**
+ * PayloadNode, CRTP base for a node whose variant value lives in PayloadTables
+ * - same interface as NodeWithVariantValue, kind checks only read the node's own tag while
+ * anything touching the payload goes through the context owning it (see `V::payloads`)
+ * - a node may live in a scratch region w/ its own tables, `V::payloads(ctx, scratch)` picks them
+ * - `payload` comes before `tag` so a derived node can pack a small field into the tail padding
+ */
+template <typename V, typename Variant> class PayloadNode {
+  public:
+    using tables_type = PayloadTables<Variant>;
+    using tag_type = typename tables_type::tag_type;
+
+  private:
+    HirSize payload;
+    tag_type tag;
+    bool scratch;
+
+    PayloadNode(Context& ctx, const Variant& value, bool scratch = false) : scratch{scratch} {
+        set_value(ctx, value);
+    }
+
+  public:
+    template <typename T> [[nodiscard]] bool holds() const noexcept {
+        return tag == tables_type::template tag_of<T>;
+    }
+    template <typename... Ts> [[nodiscard]] bool holds_any_of() const noexcept {
+        return (holds<Ts>() || ...);
+    }
+    template <typename T> [[nodiscard]] bool holds_same(const V& other) const noexcept {
+        return holds<T>() && other.template holds<T>();
+    }
+    [[nodiscard]] bool holds_same_variant_type(const V& other) const noexcept {
+        return tag == other.tag;
+    }
+    template <typename... Ts> [[nodiscard]] bool hold_same_any_of(const V& other) const noexcept {
+        return holds_any_of<Ts...>() && other.template holds_any_of<Ts...>();
+    }
+    /// whether the payload lives in the scratch tables
+    [[nodiscard]] bool in_scratch() const noexcept { return scratch; }
+
+    template <typename T> [[nodiscard]] T& as(Context& ctx) noexcept {
+        assert(holds<T>());
+        return V::payloads(ctx, scratch).template at<T>(payload);
+    }
+    template <typename T> [[nodiscard]] const T& as(const Context& ctx) const noexcept {
+        assert(holds<T>());
+        return V::payloads(ctx, scratch).template cat<T>(payload);
+    }
+    // try to get a as variant value type if holding T, else get empty
+    template <typename T> [[nodiscard]] std::optional<T> try_as(const Context& ctx) const noexcept {
+        return holds<T>() ? std::optional<T>{as<T>(ctx)} : std::nullopt;
+    }
+    template <typename F> decltype(auto) visit(const Context& ctx, F&& visitor) const {
+        return V::payloads(ctx, scratch).visit(tag, payload, std::forward<F>(visitor));
+    }
+    /// a copy of the whole variant value
+    [[nodiscard]] Variant value(const Context& ctx) const {
+        return V::payloads(ctx, scratch).load(tag, payload);
+    }
+    /// stores a new payload, the old one stays behind in its table
+    void set_value(Context& ctx, const Variant& value) {
+        std::tie(tag, payload) = V::payloads(ctx, scratch).push_variant(value);
+    }
+
+    friend V;
+};
+
+} // namespace hir
+
+#endif
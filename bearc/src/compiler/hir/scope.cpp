@@ -10,6 +10,7 @@
 #include "compiler/hir/context.hpp"
 #include "compiler/hir/indexing.hpp"
 #include "utils/data_arena.hpp"
+#include "utils/mapu32u32.h" // for hash_uint32
 #include <assert.h>
 #include <optional>
 #include <stddef.h>
@@ -32,6 +33,10 @@ Scope::Scope(size_t capacity, DataArena& arena)
     : arena(arena), namespaces(arena, capacity), variables(arena, capacity), types(arena, capacity),
       top_level(true) {}
 
+Scope::Scope(OptId<ScopeId> parent, Sizes sizes, DataArena& arena)
+    : parent_(parent), arena(arena), namespaces(arena, sizes.namespaces),
+      variables(arena, sizes.variables), types(arena, sizes.types), top_level(false) {}
+
 Scope::Scope(ScopeId parent, size_t capacity, DataArena& arena, storage storage)
     : parent_{parent}, arena(arena), namespaces(arena, 0),
       variables(arena, storage == storage::variables ? capacity : 0),
@@ -39,43 +44,54 @@ Scope::Scope(ScopeId parent, size_t capacity, DataArena& arena, storage storage)
     assert(storage == storage::variables);
 }
 
+uint64_t Scope::bloom_bits(SymbolId symbol) noexcept {
+    // two bits per symbol out of one mixed hash
+    const uint32_t hash = hash_uint32(symbol.val());
+    return (uint64_t{1} << (hash & 63)) | (uint64_t{1} << ((hash >> 6) & 63));
+}
+
+const ScopeIdMap& Scope::local_table(scope_kind kind) const noexcept {
+    switch (kind) {
+    case scope_kind::namespacee:
+        return namespaces;
+    case scope_kind::variable:
+        return variables;
+    case scope_kind::type:
+        break;
+    }
+    return types;
+}
+
 OptId<DefId> Scope::look_up_impl(const Context& context, ScopeId local_scope_id, SymbolId symbol,
-                                 scope_kind kind) {
+                                 scope_kind kind, bool flatten) {
 
     if (!local_scope_id.val()) {
         return std::nullopt;
     }
-    // init curr scope local scope
-    const Scope* local_scope = &context.scope(local_scope_id);
-    const Scope* curr_scope = local_scope;
     ScopeId curr_scope_id = local_scope_id;
-    // begin search logic
-    OptId<DefId> def{};
-
     // start walking scopes from local thru parents
-    while (!def.val()) {
-        curr_scope = &context.scope(curr_scope_id);
-        switch (kind) {
-        case scope_kind::namespacee:
-            def = curr_scope->namespaces.at(symbol);
-            break;
-        case scope_kind::variable:
-            def = curr_scope->variables.at(symbol);
-            break;
-        case scope_kind::type:
-            def = curr_scope->types.at(symbol);
-            break;
+    for (;;) {
+        const Scope& curr_scope = context.scope(curr_scope_id);
+        // the rest of the chain from a fully registered scope on is served flattened
+        if (flatten && curr_scope.frozen) {
+            return context.look_up_frozen(curr_scope_id, symbol, kind);
         }
-        if (def.val()) {
-            break; // hit, stop now since we allow shadowing
+        // levels that can't define symbol are skipped w/o a probe
+        if (curr_scope.may_define(kind, symbol)) {
+            if (OptId<DefId> def = curr_scope.local_table(kind).at(symbol); def.has_value()) {
+                return def; // hit, stop now since we allow shadowing
+            }
         }
-        const OptId<ScopeId> parent_scope_id = curr_scope->parent_;
-        if (parent_scope_id.empty()) {
-            break; // no more parents, stop traversing
+        if (curr_scope.parent_.empty()) {
+            return std::nullopt; // no more parents, stop traversing
         }
-        curr_scope_id = parent_scope_id.as_id();
+        curr_scope_id = curr_scope.parent_.as_id();
     }
-    return def;
+}
+
+OptId<DefId> Scope::look_up_unflattened(const Context& context, ScopeId local_scope_id,
+                                        SymbolId symbol, scope_kind kind) {
+    return look_up_impl(context, local_scope_id, symbol, kind, /*flatten*/ false);
 }
 
 OptId<DefId> Scope::look_up_namespace(const Context& context, ScopeId local_scope,
@@ -94,6 +110,7 @@ OptId<DefId> Scope::look_up_type(const Context& context, ScopeId local_scope, Sy
 
 /// insert symbol -> def into a named hir_scope
 void Scope::insert(SymbolId symbol, DefId def, scope_kind kind) {
+    blooms[static_cast<size_t>(kind)] |= bloom_bits(symbol);
     switch (kind) {
     case scope_kind::namespacee:
         this->namespaces.insert(symbol, def);
@@ -115,6 +132,22 @@ void Scope::insert_variable(SymbolId symbol, DefId def) {
 }
 void Scope::insert_type(SymbolId symbol, DefId def) { insert(symbol, def, scope_kind::type); }
 
+void Scope::recycle(ScopeId parent, size_t capacity) {
+    parent_ = parent;
+    namespaces.clear();
+    variables.clear();
+    types.clear();
+    blooms[0] = blooms[1] = blooms[2] = 0;
+    variables.reserve(capacity);
+    ++generation_;
+}
+
+void Scope::reserve_more(Sizes sizes) {
+    namespaces.reserve(namespaces.size() + sizes.namespaces);
+    variables.reserve(variables.size() + sizes.variables);
+    types.reserve(types.size() + sizes.types);
+}
+
 OptId<DefId> Scope::already_defines_variable(SymbolId symbol) const { return variables.at(symbol); }
 OptId<DefId> Scope::already_defines_type(SymbolId symbol) const { return types.at(symbol); }
 OptId<DefId> Scope::look_up_local_namespace(const Context& context, ScopeId local_scope,
@@ -9,8 +9,8 @@
 #ifndef COMPILER_HIR_SCOPE_HPP
 #define COMPILER_HIR_SCOPE_HPP
 
-#include "compiler/hir/id_hash_map.hpp"
 #include "compiler/hir/indexing.hpp"
+#include "compiler/hir/small_id_map.hpp"
 #include "utils/data_arena.hpp"
 #include <cstdint>
 
@@ -18,7 +18,8 @@ namespace hir {
 
 class Context;
 
-using ScopeIdMap = IdHashMap<SymbolId, DefId>;
+/// most scopes hold a few names, so tables start inline and only hash once they outgrow that
+using ScopeIdMap = SmallIdMap<SymbolId, DefId>;
 
 enum class scope_kind : uint8_t {
     namespacee,
@@ -48,15 +49,30 @@ class Scope {
     ScopeIdMap variables;
     /// structs, variants, unions, deftypes
     ScopeIdMap types;
+    /// 64-bit bloom filter over the SymbolIds of each local table, indexed by scope_kind, so a
+    /// scope-chain walk skips levels that can't define a name without probing their table
+    uint64_t blooms[3] = {0, 0, 0};
     const bool top_level;
+    /// set once a module scope is fully registered, see Context::look_up_frozen
+    bool frozen = false;
+    /// bumped each time a temp scope is recycled, so memos keyed by its ScopeId can tell uses apart
+    uint32_t generation_ = 0;
     void insert(SymbolId symbol, DefId def, scope_kind kind);
+    static uint64_t bloom_bits(SymbolId symbol) noexcept;
+    const ScopeIdMap& local_table(scope_kind kind) const noexcept;
     static OptId<DefId> look_up_impl(const Context& context, ScopeId local_scope_id,
-                                     SymbolId symbol, scope_kind kind);
+                                     SymbolId symbol, scope_kind kind, bool flatten = true);
 
   public:
     // this may need to be tuned for a balance between cache locality and limited rehashing
     static constexpr size_t DEFAULT_CAP = 0x100;
     using id_type = ScopeId;
+    /// expected number of local entries per table, e.g. counted from a block's decls
+    struct Sizes {
+        size_t namespaces = 0;
+        size_t variables = 0;
+        size_t types = 0;
+    };
     bool is_top_level() const { return top_level; };
     // constructs a non-top-level scope with a parent
     Scope(ScopeId parent, DataArena& arena);
@@ -68,6 +84,8 @@ class Scope {
     Scope(OptId<ScopeId> parent, size_t capacity, DataArena& arena);
     // constructs a top level scope with a given capacity
     Scope(size_t capacity, DataArena& arena);
+    // constructs a non-top-level scope presized per table
+    Scope(OptId<ScopeId> parent, Sizes sizes, DataArena& arena);
     enum class storage : uint8_t {
         variables,
         types,
@@ -83,6 +101,8 @@ class Scope {
     void insert_namespace(SymbolId symbol, DefId def);
     void insert_variable(SymbolId symbol, DefId def);
     void insert_type(SymbolId symbol, DefId def);
+    /// presize each table for that many more entries, e.g. when a module is reopened
+    void reserve_more(Sizes sizes);
 
     OptId<DefId> already_defines_variable(SymbolId symbol) const;
     OptId<DefId> already_defines_type(SymbolId symbol) const;
@@ -96,6 +116,38 @@ class Scope {
 
     [[nodiscard]] OptId<ScopeId> parent() const noexcept { return parent_; }
 
+    /// false if this scope definitely has no local entry for symbol of that kind
+    [[nodiscard]] bool may_define(scope_kind kind, SymbolId symbol) const noexcept {
+        const uint64_t bits = bloom_bits(symbol);
+        return (blooms[static_cast<size_t>(kind)] & bits) == bits;
+    }
+    /// marks a fully registered scope, chain look ups reaching it are then served flattened
+    void freeze() noexcept { frozen = true; }
+    [[nodiscard]] bool is_frozen() const noexcept { return frozen; }
+    /// empties a released temp scope for its next use, keeping any tables it already grew
+    void recycle(ScopeId parent, size_t capacity);
+    [[nodiscard]] uint32_t generation() const noexcept { return generation_; }
+    /// walks the scope chain from local_scope_id, never consulting the flattened cache
+    static OptId<DefId> look_up_unflattened(const Context& context, ScopeId local_scope_id,
+                                            SymbolId symbol, scope_kind kind);
+
+    /// number of local namespace, variable, and type entries
+    [[nodiscard]] size_t entry_count() const noexcept {
+        return namespaces.size() + variables.size() + types.size();
+    }
+    /// bytes of the three local tables
+    [[nodiscard]] size_t table_bytes() const noexcept {
+        return namespaces.table_bytes() + variables.table_bytes() + types.table_bytes();
+    }
+    /// bytes of the three local tables holding live entries
+    [[nodiscard]] size_t used_table_bytes() const noexcept {
+        return namespaces.used_bytes() + variables.used_bytes() + types.used_bytes();
+    }
+    /// whether all three local tables still fit inline
+    [[nodiscard]] bool is_inline() const noexcept {
+        return namespaces.is_inline() && variables.is_inline() && types.is_inline();
+    }
+
     using Entry = ScopeIdMap::Entry;
 
     /// call some functor F for each locally namespace defined in the scope
@@ -0,0 +1,229 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#ifndef COMPILER_HIR_SMALL_ID_MAP_HPP
+#define COMPILER_HIR_SMALL_ID_MAP_HPP
+
+#include "compiler/hir/indexing.hpp"
+#include "utils/data_arena.hpp"
+#include "utils/flatmapu32u32.h"
+#include <assert.h>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace hir {
+
+/**
+ * a small-size-optimized Id -> Id map w/ the same interface as IdHashMap
+ * - the first N entries live inline in an unsorted array that is scanned linearly, which beats
+ * hashing for the handful of names most block/struct scopes ever hold
+ * - inserting entry N + 1 spills everything into a flatmapu32u32_t from the (non-owned) arena, the
+ * inline array and the flat map share storage so the map never grows past one of them
+ * - a map constructed w/ a capacity > N is spilled up front, sized to hold that many entries
+ */
+template <hir::IsId K, hir::IsId V, uint32_t N = 4>
+    requires(sizeof(K) == 4 && sizeof(V) == 4 && N > 0)
+class SmallIdMap {
+
+    DataArena& arena;
+    /// number of used inline slots, only meaningful while !spilled
+    uint32_t small_size = 0;
+    bool spilled = false;
+    union {
+        flatmapu32u32_slot_t small[N];
+        flatmapu32u32_t map;
+    };
+
+    /// slot capacity for elem_cnt entries under the flat map's load factor
+    static size_t flat_capacity_for(size_t elem_cnt) {
+        return ((elem_cnt * FLATMAPU32U32_LOAD_FACTOR_DEN) + FLATMAPU32U32_LOAD_FACTOR_NUM - 1)
+                   / FLATMAPU32U32_LOAD_FACTOR_NUM
+               + 1;
+    }
+
+    /// moves the inline entries into a flat map sized for elem_cnt entries
+    void spill(size_t elem_cnt) {
+        flatmapu32u32_slot_t moved[N];
+        const uint32_t moved_cnt = small_size;
+        for (uint32_t i = 0; i < moved_cnt; i++) {
+            moved[i] = small[i];
+        }
+        map = flatmapu32u32_create_from_arena(flat_capacity_for(elem_cnt), arena.arena());
+        spilled = true;
+        for (uint32_t i = 0; i < moved_cnt; i++) {
+            flatmapu32u32_insert(&map, moved[i].key, moved[i].val);
+        }
+    }
+
+    /// idx of key's inline slot, or small_size if absent
+    uint32_t small_find(uint32_t key) const {
+        uint32_t i = 0;
+        while (i < small_size && small[i].key != key) {
+            ++i;
+        }
+        return i;
+    }
+
+    /// number of slot positions an iterator walks
+    uint32_t slot_span() const noexcept { return spilled ? map.capacity : small_size; }
+
+    /// first occupied slot position at or after idx
+    uint32_t skip_empty(uint32_t idx) const noexcept {
+        if (!spilled) {
+            return idx;
+        }
+        while (idx < map.capacity && map.ctrl[idx] == FLATMAPU32U32_CTRL_EMPTY) {
+            ++idx;
+        }
+        return idx;
+    }
+
+    const flatmapu32u32_slot_t& slot(uint32_t idx) const noexcept {
+        return spilled ? map.slots[idx] : small[idx];
+    }
+
+  public:
+    SmallIdMap(const SmallIdMap&) = delete;
+    SmallIdMap& operator=(const SmallIdMap&) = delete;
+    SmallIdMap(SmallIdMap&& other) noexcept
+        : arena(other.arena), small_size(other.small_size), spilled(other.spilled) {
+        if (spilled) {
+            map = other.map;
+        } else {
+            for (uint32_t i = 0; i < small_size; i++) {
+                small[i] = other.small[i];
+            }
+        }
+    }
+    /// capacity is the number of entries to presize for, anything <= N stays inline
+    SmallIdMap(DataArena& arena, size_t capacity) : arena(arena) {
+        if (capacity > N) {
+            spill(capacity);
+        }
+    }
+
+    void insert(K key, V value) {
+        assert((key.val() != HIR_ID_NONE) && "tried to insert a key with value HIR_ID_NONE");
+        if (spilled) {
+            flatmapu32u32_insert(&map, key.val(), value.val());
+            return;
+        }
+        const uint32_t idx = small_find(key.val());
+        if (idx < small_size) {
+            small[idx].val = value.val(); // if key already exists, update val
+            return;
+        }
+        if (small_size == N) {
+            spill(2 * static_cast<size_t>(N));
+            flatmapu32u32_insert(&map, key.val(), value.val());
+            return;
+        }
+        small[small_size++] = flatmapu32u32_slot_t{.key = key.val(), .val = value.val()};
+    }
+    /// presize so that elem_cnt entries fit without rehashing mid-insertion
+    void reserve(size_t elem_cnt) {
+        if (spilled) {
+            flatmapu32u32_reserve(&map, static_cast<uint32_t>(elem_cnt));
+        } else if (elem_cnt > N) {
+            spill(elem_cnt);
+        }
+    }
+    /// drops every entry, a spilled map keeps its table for reuse
+    void clear() {
+        if (spilled) {
+            flatmapu32u32_clear(&map);
+        } else {
+            small_size = 0;
+        }
+    }
+    /// returns false if key is not found
+    bool remove(K key) {
+        if (spilled) {
+            return flatmapu32u32_remove(&map, key.val());
+        }
+        const uint32_t idx = small_find(key.val());
+        if (idx == small_size) {
+            return false;
+        }
+        small[idx] = small[--small_size]; // unordered, so swap w/ the last
+        return true;
+    }
+    /// returns an optional id by value
+    OptId<V> at(K key) const {
+        if (spilled) {
+            auto* value = flatmapu32u32_cat(&map, key.val());
+            return value == nullptr ? OptId<V>{} : OptId<V>{V{*value}};
+        }
+        const uint32_t idx = small_find(key.val());
+        return idx == small_size ? OptId<V>{} : OptId<V>{V{small[idx].val}};
+    }
+    bool contains(K key) const { return at(key).has_value(); }
+    [[nodiscard]] bool is_inline() const noexcept { return !spilled; }
+    [[nodiscard]] size_t size() const noexcept { return spilled ? map.size : small_size; }
+    [[nodiscard]] size_t capacity() const noexcept { return spilled ? map.capacity : N; }
+    /// bytes of the live table, the inline array while not spilled (older flat tables left behind
+    /// by growth still sit in the arena)
+    [[nodiscard]] size_t table_bytes() const noexcept {
+        if (!spilled) {
+            return N * sizeof(flatmapu32u32_slot_t);
+        }
+        return (map.capacity * (sizeof(flatmapu32u32_slot_t) + 1)) + FLATMAPU32U32_GROUP_WIDTH;
+    }
+    /// bytes of table_bytes() that hold live entries
+    [[nodiscard]] size_t used_bytes() const noexcept {
+        return size() * (sizeof(flatmapu32u32_slot_t) + (spilled ? 1 : 0));
+    }
+
+    class Entry {
+        K key_;
+        V val_;
+
+      public:
+        K key() const noexcept { return key_; }
+        V val() const noexcept { return val_; }
+        Entry(K key, V val) : key_(key), val_(val) {}
+    };
+
+    struct Iter {
+        using iterator_category = std::forward_iterator_tag;
+
+        Iter(const SmallIdMap* owner, uint32_t idx) noexcept
+            : owner{owner}, idx{owner->skip_empty(idx)} {}
+
+        Entry operator*() const noexcept {
+            const flatmapu32u32_slot_t& s = owner->slot(idx);
+            return Entry{K{s.key}, V{s.val}};
+        }
+
+        Iter& operator++() noexcept {
+            idx = owner->skip_empty(idx + 1);
+            return *this;
+        }
+
+        Iter operator++(int) noexcept {
+            Iter tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        friend bool operator==(const Iter& a, const Iter& b) noexcept { return a.idx == b.idx; }
+        friend bool operator!=(const Iter& a, const Iter& b) noexcept { return !(a == b); }
+
+      private:
+        const SmallIdMap* owner;
+        uint32_t idx;
+    };
+    Iter iter() { return begin(); }
+    Iter begin() const noexcept { return Iter{this, 0}; }
+    Iter end() const noexcept { return Iter{this, slot_span()}; }
+};
+
+} // namespace hir
+
+#endif // !COMPILER_HIR_SMALL_ID_MAP_HPP
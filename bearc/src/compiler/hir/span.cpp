@@ -14,39 +14,44 @@
 #include <string_view>
 
 namespace hir {
-Span::Span(FileId file_id, const char* src, const token_t* tkn)
-    : start(tkn->start - src), len(tkn->len), file_id(file_id), line(tkn->loc.line),
-      col(tkn->loc.col) {}
 
-Span::Span(FileId file_id, const char* src, const token_t* first, const token_t* last)
-    : start(first->start - src), len((last->start + last->len) - first->start), file_id(file_id),
-      line(first->loc.line), col(first->loc.col) {}
+Span::Span(const Context& ctx, FileId file_id, const token_t* first, const token_t* last)
+    : pos(ctx.file_base(file_id) + (first->start - ctx.ast(file_id).buffer())),
+      len((last->start + last->len) - first->start) {}
 
-std::string_view Span::retrieve_from_buffer(const char* data, Span span) {
-    return std::string_view(data + span.start, span.len);
+[[nodiscard]] std::string_view Span::as_sv(const Context& context) const {
+    const FileId fid = file_id(context);
+    return std::string_view(context.ast(fid).buffer() + (pos - context.file_base(fid)), len);
 }
 
-[[nodiscard]] std::string_view Span::as_sv(const Context& context) const {
-    return retrieve_from_buffer(context.ast(file_id).buffer(), *this);
+FileId Span::file_id(const Context& context) const {
+    return is_generated() ? FileId{HIR_ID_NONE} : context.file_at(pos);
 }
 
-Span::Span(const Context& ctx, FileId file_id, const token_t* first, const token_t* last)
-    : Span(file_id, ctx.ast(file_id).buffer(), first, last) {}
+HirSize Span::start(const Context& context) const {
+    return is_generated() ? 0 : pos - context.file_base(context.file_at(pos));
+}
+
+HirSize Span::line(const Context& context) const {
+    return is_generated() ? 0 : context.src_loc_at(pos).line;
+}
+
+HirSize Span::col(const Context& context) const {
+    return is_generated() ? 0 : context.src_loc_at(pos).col;
+}
 
 Span::Span(const Context& ctx, FileId file_id, const ast_expr_t* expr)
     : Span(ctx, file_id, expr->first, expr->last) {}
 
 Span::Span(const Context& ctx, FileId file_id, const token_t* tkn)
-    : start(tkn->start - ctx.ast(file_id).buffer()), len(tkn->len), file_id(file_id),
-      line(tkn->loc.line), col(tkn->loc.col) {}
+    : Span(ctx, file_id, tkn, tkn) {}
 
 Span::Span(const Context& ctx, FileId file_id, token_ptr_slice_t token_slice)
     : Span(ctx, file_id, token_slice.start[0], token_slice.start[token_slice.len - 1]) {}
-Span Span::generated() { return Span{0, 0, FileId{HIR_ID_NONE}, 0, 0}; }
+Span Span::generated() { return Span{0, 0}; }
 
 Span Span::combine(Span span1, Span span2) {
-    return Span(span1.start, span2.start - span1.start + span2.len, span1.file_id, span1.line,
-                span1.col);
+    return Span(span1.pos, span2.pos - span1.pos + span2.len);
 }
 
 Span Span::find_between_tokens(const Context& ctx, FileId fid, const token_t* t1,
@@ -57,8 +62,9 @@ Span Span::find_between_tokens(const Context& ctx, FileId fid, const token_t* t1
 }
 
 Span Span::find_between_spans(const Context& ctx, FileId fid, Span s1, Span s2) {
-    assert(s1.file_id == s2.file_id);
-    const char* t1_c = retrieve_from_buffer(ctx.ast(fid).buffer(), s1).data();
+    assert(s1.file_id(ctx) == fid && s2.file_id(ctx) == fid);
+    const HirSize base = ctx.file_base(fid);
+    const char* t1_c = ctx.ast(fid).buffer() + (s1.pos - base);
     char c = *t1_c;
     HirSize len_from_left = 0;
     while (c = *t1_c, t1_c++, !is_whitespace(c)) {
@@ -69,7 +75,7 @@ Span Span::find_between_spans(const Context& ctx, FileId fid, Span s1, Span s2)
         t1_c--;
     }
 
-    const char* t2_c = retrieve_from_buffer(ctx.ast(fid).buffer(), s2).data();
+    const char* t2_c = ctx.ast(fid).buffer() + (s2.pos - base);
 
     c = *t2_c;
     HirSize len_from_right = 0;
@@ -77,9 +83,8 @@ Span Span::find_between_spans(const Context& ctx, FileId fid, Span s1, Span s2)
         len_from_right++;
     }
     static_assert(sizeof(size_t) == sizeof(const char*));
-    return Span{(s1.start + len_from_left + 1),
-                (s2.start - s1.start - len_from_left - len_from_right - 1), (s1.file_id), (s1.line),
-                (s1.col)};
+    return Span{(s1.pos + len_from_left + 1),
+                (s2.pos - s1.pos - len_from_left - len_from_right - 1)};
 }
 
 } // namespace hir
@@ -20,33 +20,48 @@ namespace hir {
 
 class Context;
 
+/// 0-indexed line/col of some src offset
+struct SrcLoc {
+    HirSize line;
+    HirSize col;
+};
+
+/**
+ * hir::Span, a view into the src of a compile in 8 bytes
+ * - every file gets a base in one context-wide src address space (see Context::file), so `pos`
+ * alone names both the file and the offset within it
+ * - the file is found by binary searching the file bases, line/col by binary searching that
+ * file's line index, both only done when asked for (mostly when printing diagnostics)
+ * - pos 0 is never handed to a file, so it marks generated spans
+ */
 class Span {
-    Span(HirSize start, HirSize len, FileId file_id, HirSize line, HirSize col) noexcept
-        : start(start), len(len), file_id(file_id), line(line), col(col) {};
+    Span(HirSize pos, HirSize len) noexcept : pos(pos), len(len) {};
 
   public:
-    HirSize start;
+    /// global offset of the first byte
+    HirSize pos;
     HirSize len;
-    FileId file_id;
-    HirSize line;
-    HirSize col;
-    /// constructs an hir::Span from an existing FileId and none-owned ptrs to a src buffer and a
-    /// token_t
-    Span(FileId file_id, const char* src, const token_t* tkn);
-    Span(FileId file_id, const char* src, const token_t* first, const token_t* last);
     Span(const Context& ctx, FileId file_id, token_ptr_slice_t token_slice);
     Span(const Context& ctx, FileId file_id, const token_t* first, const token_t* last);
     Span(const Context& ctx, FileId file_id, const ast_expr_t* expr);
     Span(const Context& ctx, FileId file_id, const token_t* tkn);
-    [[nodiscard]] static std::string_view retrieve_from_buffer(const char* data, Span span);
     [[nodiscard]] std::string_view as_sv(const Context& context) const;
+    /// file this span points into, none if generated
+    [[nodiscard]] FileId file_id(const Context& context) const;
+    /// offset from the start of this span's file
+    [[nodiscard]] HirSize start(const Context& context) const;
+    /// 0-indexed line in this span's file
+    [[nodiscard]] HirSize line(const Context& context) const;
+    /// 0-indexed col (in bytes) in this span's line
+    [[nodiscard]] HirSize col(const Context& context) const;
     static Span generated();
-    bool is_generated() const { return file_id.val() == HIR_ID_NONE; };
+    bool is_generated() const { return pos == 0; };
     static Span combine(Span span1, Span span2);
     static Span find_between_tokens(const Context& ctx, FileId fid, const token_t* t1,
                                     const token_t* t2);
     static Span find_between_spans(const Context& ctx, FileId fid, Span s1, Span s2);
 };
+static_assert(sizeof(Span) == 8, "hir::Span is embedded in every node, keep it packed");
 
 } // namespace hir
 
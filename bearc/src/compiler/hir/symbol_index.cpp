@@ -0,0 +1,102 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#include "compiler/hir/symbol_index.hpp"
+#include "compiler/hir/indexing.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+namespace hir {
+
+SymbolIndex::SymbolIndex(DataArena& table_arena, DataArena& str_arena)
+    : fqn_to_def{table_arena, str_arena} {}
+
+void SymbolIndex::insert(OptId<DefId> parent, std::string_view name, DefId def) {
+    // a parent missing from the index would silently file its children at the root
+    assert((!parent.has_value() || !fqn_of(parent.as_id()).empty())
+           && "[hir::SymbolIndex::insert] parent must be indexed before its children\n");
+    scratch.clear();
+    if (parent.has_value()) {
+        scratch.append(fqn_of(parent.as_id()));
+        scratch.append(SEPARATOR);
+    }
+    scratch.append(name);
+
+    std::string_view fqn{};
+    const DefId owner = fqn_to_def.intern(scratch.data(), scratch.size(), [&](std::string_view s) {
+        fqn = s; // the map's copy is stable, so it backs every view of this FQN
+        return def;
+    });
+    if (owner.val() != def.val()) {
+        fqn = fqn_of(owner);
+    }
+
+    if (def_fqns.size() < def.val()) {
+        def_fqns.resize(def.val());
+    }
+    def_fqns[def.val() - 1] = fqn;
+    by_fqn.entries.push_back(Entry{fqn, def});
+    by_name.entries.push_back(Entry{fqn.substr(fqn.size() - name.size()), def});
+}
+
+OptId<DefId> SymbolIndex::at_fqn(std::string_view fqn) const {
+    return fqn_to_def.atn(fqn.data(), fqn.size());
+}
+
+std::string_view SymbolIndex::fqn_of(DefId def) const {
+    return def.val() <= def_fqns.size() ? def_fqns[def.val() - 1] : std::string_view{};
+}
+
+llvm::SmallVector<DefId> SymbolIndex::with_fqn_prefix(std::string_view prefix,
+                                                      size_t limit) const {
+    return by_fqn.with_prefix(prefix, limit);
+}
+
+llvm::SmallVector<DefId> SymbolIndex::with_name_prefix(std::string_view prefix,
+                                                       size_t limit) const {
+    return by_name.with_prefix(prefix, limit);
+}
+
+size_t SymbolIndex::reserved_bytes() const noexcept {
+    return ((by_fqn.entries.capacity() + by_name.entries.capacity()) * sizeof(Entry))
+           + (def_fqns.capacity() * sizeof(std::string_view));
+}
+
+size_t SymbolIndex::used_bytes() const noexcept {
+    return ((by_fqn.entries.size() + by_name.entries.size()) * sizeof(Entry))
+           + (def_fqns.size() * sizeof(std::string_view));
+}
+
+void SymbolIndex::SortedRun::settle() {
+    if (sorted_cnt == entries.size()) {
+        return;
+    }
+    auto less = [](const Entry& a, const Entry& b) {
+        return a.key != b.key ? a.key < b.key : a.def.val() < b.def.val();
+    };
+    const auto mid = entries.begin() + static_cast<std::ptrdiff_t>(sorted_cnt);
+    // the tail is usually a single file's worth of defs, far smaller than what's already sorted
+    std::sort(mid, entries.end(), less);
+    std::inplace_merge(entries.begin(), mid, entries.end(), less);
+    sorted_cnt = entries.size();
+}
+
+llvm::SmallVector<DefId> SymbolIndex::SortedRun::with_prefix(std::string_view prefix,
+                                                             size_t limit) {
+    settle();
+    llvm::SmallVector<DefId> found;
+    auto it = std::lower_bound(entries.begin(), entries.end(), prefix,
+                               [](const Entry& e, std::string_view p) { return e.key < p; });
+    for (; it != entries.end() && found.size() < limit && it->key.starts_with(prefix); ++it) {
+        found.push_back(it->def);
+    }
+    return found;
+}
+
+} // namespace hir
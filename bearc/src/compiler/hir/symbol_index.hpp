@@ -0,0 +1,80 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#ifndef COMPILER_HIR_SYMBOL_INDEX_HPP
+#define COMPILER_HIR_SYMBOL_INDEX_HPP
+
+#include "compiler/hir/arena_str_hash_map.hpp"
+#include "compiler/hir/indexing.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include "utils/data_arena.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hir {
+
+/**
+ * hir::SymbolIndex, workspace-wide look up of top-level defs by name, for tooling
+ * - every def is keyed by its fully qualified name, e.g. `foo..Bar..baz`, in a string hash map
+ * whose interned copies double as the stable storage for each FQN
+ * - prefix queries binary search two sorted arrays, one over FQNs and one over the defs' own
+ * (last segment) names, then walk the matching run
+ * - inserts only append, the unsorted tail is sorted and merged in on the next query
+ */
+class SymbolIndex {
+  public:
+    static constexpr std::string_view SEPARATOR = "..";
+
+    SymbolIndex(DataArena& table_arena, DataArena& str_arena);
+
+    /// indexes def under parent's FQN (or at the root w/o a parent) + name, the first def to
+    /// claim an FQN keeps it
+    /// - parent must already be indexed, which holds since parents are registered first
+    void insert(OptId<DefId> parent, std::string_view name, DefId def);
+    /// first def indexed under exactly fqn
+    [[nodiscard]] OptId<DefId> at_fqn(std::string_view fqn) const;
+    /// FQN a def was indexed under, empty if it wasn't
+    [[nodiscard]] std::string_view fqn_of(DefId def) const;
+    /// up to limit defs whose FQN starts w/ prefix, in FQN order
+    [[nodiscard]] llvm::SmallVector<DefId> with_fqn_prefix(std::string_view prefix,
+                                                           size_t limit) const;
+    /// up to limit defs whose own name starts w/ prefix, in name order
+    [[nodiscard]] llvm::SmallVector<DefId> with_name_prefix(std::string_view prefix,
+                                                            size_t limit) const;
+    [[nodiscard]] size_t size() const noexcept { return by_fqn.entries.size(); }
+    /// bytes held by the sorted arrays and the per-def FQN table, the FQN map lives in arenas
+    [[nodiscard]] size_t reserved_bytes() const noexcept;
+    [[nodiscard]] size_t used_bytes() const noexcept;
+    [[nodiscard]] const StrIdHashMap<DefId>& fqn_map() const noexcept { return fqn_to_def; }
+
+  private:
+    struct Entry {
+        std::string_view key;
+        DefId def;
+    };
+    /// a sorted array w/ an unsorted tail of fresh inserts
+    struct SortedRun {
+        std::vector<Entry> entries;
+        size_t sorted_cnt = 0;
+        void settle();
+        llvm::SmallVector<DefId> with_prefix(std::string_view prefix, size_t limit);
+    };
+
+    StrIdHashMap<DefId> fqn_to_def;
+    /// DefId - 1 -> FQN, empty for defs that were never indexed
+    std::vector<std::string_view> def_fqns;
+    mutable SortedRun by_fqn;
+    mutable SortedRun by_name;
+    std::string scratch;
+};
+
+} // namespace hir
+
+#endif // !COMPILER_HIR_SYMBOL_INDEX_HPP
@@ -0,0 +1,108 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#include "compiler/hir/symbol_suggester.hpp"
+#include "compiler/hir/context.hpp"
+#include "compiler/hir/indexing.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+namespace hir {
+
+uint32_t SymbolSuggester::edit_distance(std::string_view a, std::string_view b) {
+    llvm::SmallVector<uint32_t, 32> prev(b.size() + 1);
+    llvm::SmallVector<uint32_t, 32> curr(b.size() + 1);
+    for (uint32_t j = 0; j <= b.size(); j++) {
+        prev[j] = j;
+    }
+    for (uint32_t i = 1; i <= a.size(); i++) {
+        curr[0] = i;
+        for (uint32_t j = 1; j <= b.size(); j++) {
+            const uint32_t sub = prev[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+            curr[j] = std::min({prev[j] + 1, curr[j - 1] + 1, sub});
+        }
+        std::swap(prev, curr);
+    }
+    return prev[b.size()];
+}
+
+void SymbolSuggester::insert(const Context& context, SymbolId symbol) {
+    if (nodes.empty()) {
+        nodes.push_back(Node{symbol, 0, NO_NODE, NO_NODE});
+        return;
+    }
+    const std::string_view name = context.symbol(symbol);
+    uint32_t curr = 0;
+    for (;;) {
+        const uint32_t dist = edit_distance(context.symbol(nodes[curr].symbol), name);
+        if (dist == 0) {
+            return; // symbols are interned, so this is the same name
+        }
+        uint32_t child = nodes[curr].first_child;
+        while (child != NO_NODE && nodes[child].dist_to_parent != dist) {
+            child = nodes[child].next_sibling;
+        }
+        if (child == NO_NODE) {
+            const auto idx = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(Node{symbol, dist, NO_NODE, nodes[curr].first_child});
+            nodes[curr].first_child = idx;
+            return;
+        }
+        curr = child;
+    }
+}
+
+static bool visible_from(const Context& context, ScopeId scope, SymbolId symbol) {
+    return context.look_up_variable(scope, symbol).has_value()
+           || context.look_up_type(scope, symbol).has_value()
+           || context.look_up_namespace(scope, symbol).has_value();
+}
+
+OptId<SymbolId> SymbolSuggester::suggest(const Context& context, ScopeId scope,
+                                         SymbolId name) const {
+    const std::string_view target = context.symbol(name);
+    // one or two letter names are usually placeholders, any name a typo away would be a guess
+    if (nodes.empty() || target.size() <= 2) {
+        return {};
+    }
+    // short names only tolerate a typo or two before any suggestion turns into noise
+    const uint32_t max_dist = (target.size() <= 3) ? 1 : (target.size() <= 6) ? 2 : 3;
+    const auto deadline = std::chrono::steady_clock::now() + QUERY_BUDGET;
+
+    OptId<SymbolId> best{};
+    uint32_t best_dist = max_dist + 1;
+    llvm::SmallVector<uint32_t, 32> pending{0};
+    uint32_t visited = 0;
+    while (!pending.empty() && best_dist > 1) {
+        // reading the clock is not free, so only check it every so often
+        if ((++visited & 0x1F) == 0 && std::chrono::steady_clock::now() > deadline) {
+            break;
+        }
+        const Node& node = nodes[pending.pop_back_val()];
+        const uint32_t dist = edit_distance(target, context.symbol(node.symbol));
+        if (dist != 0 && dist < best_dist && visible_from(context, scope, node.symbol)) {
+            best = OptId<SymbolId>{node.symbol};
+            best_dist = dist;
+        }
+        // only a strictly closer name is still worth finding
+        const uint32_t radius = best_dist - 1;
+        for (uint32_t child = node.first_child; child != NO_NODE;
+             child = nodes[child].next_sibling) {
+            const uint32_t edge = nodes[child].dist_to_parent;
+            if (edge + radius >= dist && edge <= dist + radius) {
+                pending.push_back(child);
+            }
+        }
+    }
+    return best;
+}
+
+} // namespace hir
@@ -0,0 +1,59 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#ifndef COMPILER_HIR_SYMBOL_SUGGESTER_HPP
+#define COMPILER_HIR_SYMBOL_SUGGESTER_HPP
+
+#include "compiler/hir/indexing.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace hir {
+
+class Context;
+
+/**
+ * hir::SymbolSuggester, `did you mean` candidates for unresolved names
+ * - a BK-tree over the distinct SymbolIds naming some def, keyed by Levenshtein distance, so a
+ * query only descends into the children the triangle inequality can't rule out
+ * - candidates must be visible from the querying scope (as a variable, type, or namespace)
+ * - every query has a hard time budget, past it the best candidate found so far is returned
+ */
+class SymbolSuggester {
+  public:
+    static constexpr std::chrono::microseconds QUERY_BUDGET{500};
+
+    /// adds a name, names already present are ignored
+    void insert(const Context& context, SymbolId symbol);
+    /// closest name visible from scope within a small edit distance of name, if any
+    [[nodiscard]] OptId<SymbolId> suggest(const Context& context, ScopeId scope,
+                                          SymbolId name) const;
+    [[nodiscard]] size_t size() const noexcept { return nodes.size(); }
+    [[nodiscard]] size_t reserved_bytes() const noexcept { return nodes.capacity() * sizeof(Node); }
+    [[nodiscard]] size_t used_bytes() const noexcept { return nodes.size() * sizeof(Node); }
+
+    /// Levenshtein distance between two names
+    static uint32_t edit_distance(std::string_view a, std::string_view b);
+
+  private:
+    /// children are kept as a sibling list, each remembering its distance to the parent
+    struct Node {
+        SymbolId symbol;
+        uint32_t dist_to_parent;
+        uint32_t first_child;
+        uint32_t next_sibling;
+    };
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+    std::vector<Node> nodes;
+};
+
+} // namespace hir
+
+#endif // !COMPILER_HIR_SYMBOL_SUGGESTER_HPP
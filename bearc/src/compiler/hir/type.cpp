@@ -17,36 +17,36 @@ namespace hir {
 
 template <ConsiderMut C> bool TypeComparator<C>::operator()(const Type& t1, const Type& t2) const {
     auto vs = Ovld{
-        [&t2](const TypeBuiltin& t) -> bool {
+        [this, &t2](const TypeBuiltin& t) -> bool {
             if (!t2.holds<TypeBuiltin>()) {
                 return false;
             }
-            return t.type == t2.as<TypeBuiltin>().type;
+            return t.type == t2.as<TypeBuiltin>(context).type;
         },
-        [&t2](const TypeStruct& t) -> bool {
+        [this, &t2](const TypeStruct& t) -> bool {
             if (!t2.holds<TypeStruct>()) {
                 return false;
             }
-            return t.def_id == t2.as<TypeStruct>().def_id;
+            return t.def_id == t2.as<TypeStruct>(context).def_id;
         },
-        [&t2](const TypeVariant& t) -> bool {
+        [this, &t2](const TypeVariant& t) -> bool {
             if (!t2.holds<TypeVariant>()) {
                 return false;
             }
-            return t.def_id == t2.as<TypeVariant>().def_id;
+            return t.def_id == t2.as<TypeVariant>(context).def_id;
         },
-        [&t2](const TypeUnion& t) -> bool {
+        [this, &t2](const TypeUnion& t) -> bool {
             if (!t2.holds<TypeUnion>()) {
                 return false;
             }
-            return t.def_id == t2.as<TypeUnion>().def_id;
+            return t.def_id == t2.as<TypeUnion>(context).def_id;
         },
         [&t2](const TypeDeftype&) -> bool { return t2.holds<TypeDeftype>(); },
-        [&t2](const TypeArr& t) -> bool {
+        [this, &t2](const TypeArr& t) -> bool {
             if (!t2.holds<TypeArr>()) {
                 return false;
             }
-            return t.canonical_size == t2.as<TypeArr>().canonical_size;
+            return t.canonical_size == t2.as<TypeArr>(context).canonical_size;
         },
         [&t2](const TypeSlice&) -> bool { return t2.holds<TypeSlice>(); },
         [&t2](const TypeRef&) -> bool { return t2.holds<TypeRef>(); },
@@ -56,18 +56,18 @@ template <ConsiderMut C> bool TypeComparator<C>::operator()(const Type& t1, cons
                 return false;
             }
             bool rt_match = false;
-            if (t.return_type.has_value() && t2.as<TypeFnPtr>().return_type.has_value()) {
+            if (t.return_type.has_value() && t2.as<TypeFnPtr>(context).return_type.has_value()) {
                 rt_match = context.equivalent_type(t.return_type.as_id(),
-                                                   t2.as<TypeFnPtr>().return_type.as_id());
+                                                   t2.as<TypeFnPtr>(context).return_type.as_id());
             } else {
-                rt_match = t.return_type.empty() && t2.as<TypeFnPtr>().return_type.empty();
+                rt_match = t.return_type.empty() && t2.as<TypeFnPtr>(context).return_type.empty();
             }
-            bool arity_match = t.param_types.len() == t2.as<TypeFnPtr>().param_types.len();
+            bool arity_match = t.param_types.len() == t2.as<TypeFnPtr>(context).param_types.len();
             if (!rt_match || !arity_match) {
                 return false;
             }
             auto t_start = t.param_types.begin();
-            auto t2_start = t2.as<TypeFnPtr>().param_types.begin();
+            auto t2_start = t2.as<TypeFnPtr>(context).param_types.begin();
             auto len
                 = t.param_types.len(); // guranteed to match since we already passed arity check
             // iterate thru params and return false on mismatch
@@ -90,7 +90,7 @@ template <ConsiderMut C> bool TypeComparator<C>::operator()(const Type& t1, cons
             return false;
         }
     }
-    return t1.visit(vs);
+    return t1.visit(context, vs);
 }
 
 template <ConsiderMut C> size_t TypeHasher<C>::operator()(const Type& t1) const {
@@ -142,7 +142,7 @@ template <ConsiderMut C> size_t TypeHasher<C>::operator()(const Type& t1) const
             return mix(0x12ULL ^ static_cast<size_t>(t.def_id.val()));
         }};
 
-    size_t h = t1.visit(vs);
+    size_t h = t1.visit(context, vs);
 
     if constexpr (considers_mut()) {
         if (t1.mut) {
@@ -273,7 +273,7 @@ template <ConsiderMut C> TypeToStringValue TypeToString<C>::operator()(const Typ
 
     };
 
-    t1.visit(vs);
+    t1.visit(context, vs);
 
     return val;
 }
@@ -299,7 +299,7 @@ template <TypeTransformerFunctor F> OptId<TypeId> TypeTransformer<F>::try_inner(
         [&](const TypeVariadic& t) -> OTid { return t.inner; },
         [&](const TypeVar&) -> OTid { return OTid{}; },
     };
-    return type.visit(vs);
+    return type.visit(context, vs);
 }
 template <TypeTransformerFunctor F> Type TypeTransformer<F>::get_type(TypeId tid) const noexcept {
     return context.type(tid);
@@ -401,78 +401,174 @@ template class TypeTransformer<TypeContainsVar>;
 template class TypeTransformer<TypeContainsDeftype>;
 
 CanonicalTypeTable::CanonicalTypeTable(Context& context, DataArena& arena, HirSize capacity)
-    : context(context), arena(arena), count{0} {
-    this->capacity = (capacity > DEFAULT_CAP) ? capacity : DEFAULT_CAP;
-    buckets = arena.alloc_as<Entry**>(this->capacity * sizeof(Entry*));
+    : context(context), arena(arena), slots{nullptr}, count{0}, capacity{0} {
+    size_t cap = DEFAULT_CAP;
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+    alloc_slots(cap);
+}
 
-    // zero-init buckets
-    memset(static_cast<void*>(buckets), 0, this->capacity * sizeof(Entry*));
+void CanonicalTypeTable::alloc_slots(size_t new_capacity) {
+    this->capacity = new_capacity;
+    this->slots = arena.alloc_as<Slot*>(new_capacity * sizeof(Slot));
+    for (size_t i = 0; i < new_capacity; i++) {
+        ::new (this->slots + i) Slot{0, TypeId{}, CanonicalTypeId{}};
+    }
 }
 
-size_t CanonicalTypeTable::hash(TypeId type) const {
-    return TypeTransformer<TypeHasher<considerer_type>>{context}(type);
+uint64_t CanonicalTypeTable::shallow_hash(const Type& type) const {
+    // https://xorshift.di.unimi.it/splitmix64.c
+    auto mix = +[](uint64_t x) {
+        x += 0x9e3779b97f4a7c15;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+        x ^= x >> 31;
+        return x;
+    };
+    // children are folded in by canonical id, which already covers their whole structure
+    auto child = [this, &mix](uint64_t h, TypeId tid) {
+        return mix(h ^ context.type(tid).canonical.val());
+    };
+    auto vs = Ovld{
+        [&](const TypeBuiltin& t) -> uint64_t {
+            return mix(0x01ULL ^ static_cast<size_t>(t.type));
+        },
+        [&](const TypeStruct& t) -> uint64_t { return mix(0x02ULL ^ t.def_id.val()); },
+        [&](const TypeDeftype&) -> uint64_t {
+            std::cout << "tried to directly hash a deftype, the table only sees true types" << '\n';
+            std::unreachable();
+            return 0ULL;
+        },
+        [&](const TypeArr& t) -> uint64_t {
+            return child(mix(0x04ULL ^ static_cast<size_t>(t.canonical_size)), t.inner);
+        },
+        [&](const TypeSlice& t) -> uint64_t { return child(mix(0x05ULL), t.inner); },
+        [&](const TypeRef& t) -> uint64_t { return child(mix(0x06ULL), t.inner); },
+        [&](const TypePtr& t) -> uint64_t { return child(mix(0x07ULL), t.inner); },
+        [&](const TypeFnPtr& t) -> uint64_t {
+            uint64_t h = mix(0x08ULL ^ t.param_types.len());
+            if (t.return_type.has_value()) {
+                h = child(h, t.return_type.as_id());
+            }
+            for (auto tidx = t.param_types.begin(); tidx != t.param_types.end(); tidx++) {
+                h = child(h, context.type_id(tidx));
+            }
+            return h;
+        },
+        [&](const TypeVariadic& t) -> uint64_t { return child(mix(0x09ULL), t.inner); },
+        [&](const TypeVar&) -> uint64_t { return mix(0x10ULL); },
+        [&](const TypeUnion& t) -> uint64_t { return mix(0x11ULL ^ t.def_id.val()); },
+        [&](const TypeVariant& t) -> uint64_t { return mix(0x12ULL ^ t.def_id.val()); }};
+
+    const uint64_t h = type.visit(context, vs);
+    return type.mut ? mix(h ^ 0x9e3779b97f4a7c15ULL) : h;
 }
 
-bool CanonicalTypeTable::same_structure(TypeId tid1, TypeId tid2) const {
-    return TypeTransformer<TypeComparator<considerer_type>>{context}(tid1, tid2);
+bool CanonicalTypeTable::same_shape(const Type& t1, const Type& t2) const {
+    if (t1.mut != t2.mut || !t1.holds_same_variant_type(t2)) {
+        return false;
+    }
+    auto same_child = [this](OptId<TypeId> tid1, OptId<TypeId> tid2) {
+        if (!tid1.has_value() || !tid2.has_value()) {
+            return tid1.has_value() == tid2.has_value();
+        }
+        return context.equivalent_type(tid1.as_id(), tid2.as_id());
+    };
+    auto vs = Ovld{
+        [&](const TypeBuiltin& t) { return t.type == t2.as<TypeBuiltin>(context).type; },
+        [&](const TypeStruct& t) { return t.def_id == t2.as<TypeStruct>(context).def_id; },
+        [&](const TypeVariant& t) { return t.def_id == t2.as<TypeVariant>(context).def_id; },
+        [&](const TypeUnion& t) { return t.def_id == t2.as<TypeUnion>(context).def_id; },
+        [&](const TypeDeftype&) { return true; },
+        [&](const TypeArr& t) {
+            const TypeArr& arr2 = t2.as<TypeArr>(context);
+            return t.canonical_size == arr2.canonical_size && same_child(t.inner, arr2.inner);
+        },
+        [&](const TypeSlice& t) { return same_child(t.inner, t2.as<TypeSlice>(context).inner); },
+        [&](const TypeRef& t) { return same_child(t.inner, t2.as<TypeRef>(context).inner); },
+        [&](const TypePtr& t) { return same_child(t.inner, t2.as<TypePtr>(context).inner); },
+        [&](const TypeFnPtr& t) {
+            const TypeFnPtr& fn2 = t2.as<TypeFnPtr>(context);
+            if (t.param_types.len() != fn2.param_types.len()
+                || !same_child(t.return_type, fn2.return_type)) {
+                return false;
+            }
+            for (HirSize i = 0; i < t.param_types.len(); i++) {
+                if (!same_child(context.type_id(t.param_types.begin().at(i)),
+                                context.type_id(fn2.param_types.begin().at(i)))) {
+                    return false;
+                }
+            }
+            return true;
+        },
+        [&](const TypeVariadic& t) {
+            return same_child(t.inner, t2.as<TypeVariadic>(context).inner);
+        },
+        [&](const TypeVar&) { return true; },
+    };
+    return t1.visit(context, vs);
 }
 
-size_t CanonicalTypeTable::index(size_t hash, size_t cap) { return hash & (cap - 1); }
-void CanonicalTypeTable::put_new_head_on_chain(Entry** chain, Entry* new_entry) {
-    assert(chain);
-    new_entry->next = *chain;
-    *chain = new_entry;
+size_t CanonicalTypeTable::probe(const Type& type, uint64_t hash) const {
+    const size_t mask = this->capacity - 1;
+    size_t idx = hash & mask;
+    for (;;) {
+        const Slot& slot = this->slots[idx];
+        if (slot.key_id.val() == HIR_ID_NONE) {
+            return idx;
+        }
+        if (slot.hash == hash && same_shape(context.type(slot.key_id), type)) {
+            return idx;
+        }
+        idx = (idx + 1) & mask;
+    }
 }
+
 void CanonicalTypeTable::rehash(size_t new_capacity) {
-    Entry** new_buckets = arena.alloc_as<Entry**>(sizeof(Entry*) * new_capacity);
-    memset(static_cast<void*>(new_buckets), 0, new_capacity * sizeof(Entry*));
-    for (size_t i = 0; i < this->capacity; i++) {
-        Entry* curr = this->buckets[i];
-        while (curr) {
-            Entry* next = curr->next;
-            // just move curr into the new chain
-            put_new_head_on_chain(new_buckets + index(curr->hash, new_capacity), curr);
-            curr = next;
+    const Slot* old_slots = this->slots;
+    const size_t old_capacity = this->capacity;
+    alloc_slots(new_capacity); // old slots stay behind in the arena
+    const size_t mask = new_capacity - 1;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].key_id.val() == HIR_ID_NONE) {
+            continue;
+        }
+        // stored hash, so no type is revisited here
+        size_t idx = old_slots[i].hash & mask;
+        while (this->slots[idx].key_id.val() != HIR_ID_NONE) {
+            idx = (idx + 1) & mask;
         }
+        this->slots[idx] = old_slots[i];
     }
-    this->capacity = new_capacity;
-    this->buckets = new_buckets; // don't delete old buckets since arena will clean up later
 }
 
 OptId<CanonicalTypeId> CanonicalTypeTable::at(TypeId tid) const {
-    size_t hash_val = hash(tid);
-    Entry* curr = this->buckets[index(hash_val, this->capacity)];
-    while (curr) {
-        if (hash_val == curr->hash && same_structure(curr->key_id, tid)) {
-            return curr->val;
-        }
-        curr = curr->next;
+    const Type& type = context.type(tid);
+    const Slot& slot = this->slots[probe(type, shallow_hash(type))];
+    if (slot.key_id.val() == HIR_ID_NONE) {
+        return OptId<CanonicalTypeId>{};
     }
-    return OptId<CanonicalTypeId>{};
+    return slot.val;
 }
 
-void CanonicalTypeTable::insert(TypeId tid, CanonicalTypeId cid) {
-    size_t hash_val = hash(tid);
-    Entry** chain = this->buckets + index(hash_val, this->capacity);
-    Entry* new_entry = arena.alloc_type<Entry>();
-    ::new (new_entry) Entry{tid, cid, hash_val, nullptr};
-    put_new_head_on_chain(chain, new_entry);
-    ++this->count;
-}
 CanonicalTypeId CanonicalTypeTable::canonical(TypeId tid) {
-    // already cid
-    OptId<CanonicalTypeId> maybe_cid = this->at(tid);
-    if (maybe_cid.has_value()) {
-        return maybe_cid.as_id();
+    const Type& type = context.type(tid);
+    const uint64_t hash = shallow_hash(type);
+    size_t idx = probe(type, hash);
+    if (this->slots[idx].key_id.val() != HIR_ID_NONE) {
+        return this->slots[idx].val;
     }
-    if (static_cast<double>(this->count + 1) > LOAD_FACTOR * static_cast<double>(this->capacity)) {
-        this->rehash(static_cast<size_t>(GROWTH_FACTOR * static_cast<double>(this->capacity)));
+    if ((this->count + 1) * LOAD_FACTOR_DEN > this->capacity * LOAD_FACTOR_NUM) {
+        this->rehash(this->capacity * 2);
+        idx = probe(type, hash);
     }
     // get new cid and set backward/forward pointing:
     // forward: tid -> cid (in this table)
     // backward: cid -> tid (first mention, for structural reversal of any abitrary cid)
-    CanonicalTypeId new_cid = context.emplace_and_get_canonical_type_id(tid);
-    this->insert(tid, new_cid);
+    const CanonicalTypeId new_cid = context.emplace_and_get_canonical_type_id(tid);
+    this->slots[idx] = Slot{hash, tid, new_cid};
+    ++this->count;
     return new_cid;
 }
 
@@ -517,7 +613,21 @@ const char* builtin_type_to_cstr(builtin_type t) {
     std::unreachable();
     return nullptr;
 }
+PayloadTables<TypeValue>& Type::payloads(Context& ctx, [[maybe_unused]] bool scratch) {
+    assert(!scratch);
+    return ctx.type_payload_tables();
+}
+
+const PayloadTables<TypeValue>& Type::payloads(const Context& ctx,
+                                               [[maybe_unused]] bool scratch) {
+    assert(!scratch);
+    return ctx.type_payload_tables();
+}
+
 bool Type::is_same(const Context& ctx, TypeId tid1, TypeId tid2) {
+    if (tid1 == tid2) {
+        return true; // common now that generated types are interned
+    }
     return ctx.type(tid1).canonical == ctx.type(tid2).canonical;
     // to check structurally:
     // return TypeTransformer<TypeComparator<DoConsiderMut>>{ctx}(tid1, tid2);
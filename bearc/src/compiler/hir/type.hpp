@@ -11,6 +11,7 @@
 
 #include "compiler/hir/exec_ops.hpp"
 #include "compiler/hir/indexing.hpp"
+#include "compiler/hir/payload_tables.hpp"
 #include "compiler/hir/span.hpp"
 #include "compiler/hir/variant_helpers.hpp"
 #include "utils/data_arena.hpp"
@@ -45,8 +46,9 @@ enum class builtin_type : uint8_t {
     voidd,
     str,
     nullpointer,
-    boolean,
+    boolean, // keep last, see BUILTIN_TYPE_COUNT
 };
+inline constexpr size_t BUILTIN_TYPE_COUNT = static_cast<size_t>(builtin_type::boolean) + 1;
 
 const char* builtin_type_to_cstr(builtin_type t);
 std::optional<builtin_type> id_tkn_slice_to_maybe_builtin(token_ptr_slice_t tkn_slice);
@@ -115,20 +117,25 @@ struct TypeVariadic {
 using TypeValue = std::variant<TypeBuiltin, TypeStruct, TypeDeftype, TypeArr, TypeSlice, TypeRef,
                                TypePtr, TypeFnPtr, TypeVariadic, TypeVar, TypeVariant, TypeUnion>;
 
-struct Type : NodeWithVariantValue<Type> {
+/// main type structure, corresponds to an hir::TypeId
+/// - the TypeValue itself lives in the context's type payload tables, reach it w/ as/visit/value
+struct Type : PayloadNode<Type, TypeValue> {
     using id_type = TypeId;
     using value_type = TypeValue;
-    TypeValue value;
+    bool mut;
     Span span;
     CanonicalTypeId canonical;
-    bool mut;
-    void set_value(TypeValue value) { this->value = value; }
     // compares identical types (including mut)
     static bool is_same(const Context& ctx, TypeId tid1, TypeId tid2);
     // canonical should get immediately set by context
-    Type(const TypeValue& value, Span span, bool mut)
-        : value{value}, span{span}, canonical{HIR_ID_NONE}, mut{mut} {}
+    Type(Context& ctx, const TypeValue& value, Span span, bool mut)
+        : PayloadNode{ctx, value}, mut{mut}, span{span}, canonical{HIR_ID_NONE} {}
+    /// types are never scratch, so there's only the one set of tables
+    [[nodiscard]] static PayloadTables<TypeValue>& payloads(Context& ctx, bool scratch);
+    [[nodiscard]] static const PayloadTables<TypeValue>& payloads(const Context& ctx,
+                                                                  bool scratch);
 };
+static_assert(sizeof(Type) <= 20, "hir::Type grew, keep payloads in the payload tables");
 
 template <class F>
 concept TypeTransformerFunctor = requires(F f, const Context& context, const Type& t1,
@@ -262,39 +269,49 @@ template <ConsiderMut C> class TypeToString {
     static consteval bool considers_mut() { return C::considers_mut(); }
 };
 
+/**
+ * maps type structures -> CanonicalTypeId
+ * - a type's children are already canonical by the time it's emplaced, so a type is hashed and
+ * compared by its own shape plus its children's cached canonical ids, making each lookup O(1)
+ * instead of a walk down the whole type
+ * - open addressing w/ linear probing, slots live in a non-owned arena (growth leaves the old slot
+ * array behind, like the other flat tables)
+ */
 class CanonicalTypeTable {
-    struct Entry {
+    /// `key_id` being none marks an empty slot
+    struct Slot {
+        /// shallow hash of the first mention's shape, reused on rehash
+        uint64_t hash;
         TypeId key_id;
         CanonicalTypeId val;
-        size_t hash;
-        Entry* next;
-        Entry(TypeId key_id, CanonicalTypeId val, size_t hash, Entry* next)
-            : key_id(key_id), val(val), hash(hash), next(next) {}
     };
     static constexpr size_t DEFAULT_CAP = 128;
-    static constexpr double LOAD_FACTOR = 1.25;
-    static constexpr size_t GROWTH_FACTOR = 2;
-    // internally, this consider mut recursively:
-    using considerer_type = DoConsiderMut;
+    /// max load is NUM/DEN
+    static constexpr size_t LOAD_FACTOR_NUM = 3;
+    static constexpr size_t LOAD_FACTOR_DEN = 4;
+    // mut is considered at every level since it's folded into each child's canonical id
     Context& context;
     DataArena& arena;
 
-    Entry** buckets;
+    Slot* slots;
     size_t count;
+    /// always a power of two
     size_t capacity;
 
+    void alloc_slots(size_t new_capacity);
     void rehash(size_t new_capacity);
-    bool same_structure(TypeId tid1, TypeId tid2) const;
-    size_t hash(TypeId type) const;
-    static size_t index(size_t hash, size_t cap);
-    static void put_new_head_on_chain(Entry** chain, Entry* new_entry);
-    // only use after at returns none to avoid duplicate inserts
-    void insert(TypeId tid, CanonicalTypeId cid);
+    uint64_t shallow_hash(const Type& type) const;
+    bool same_shape(const Type& t1, const Type& t2) const;
+    /// returns the idx of the slot matching type, or of the empty slot ending its probe run
+    size_t probe(const Type& type, uint64_t hash) const;
 
   public:
     CanonicalTypeTable(Context& context, DataArena& arena, HirSize capacity);
     OptId<CanonicalTypeId> at(TypeId tid) const;
+    /// the canonical id of the type at tid (bypassing deftypes), registering tid as the first
+    /// mention of its structure if it's new
     [[nodiscard]] CanonicalTypeId canonical(TypeId tid);
+    [[nodiscard]] size_t size() const noexcept { return count; }
 };
 
 // function to determine whether a type contains mut
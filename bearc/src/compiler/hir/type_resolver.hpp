@@ -57,7 +57,7 @@ template <IsDefVisitor V> class TypeResolver {
             return std::nullopt;
         }
 
-        Span id_span{fid, context.ast(fid).buffer(), type->type.base.id.start[0],
+        Span id_span{context, fid, type->type.base.id.start[0],
                      type->type.base.id.start[type->type.base.id.len - 1]};
 
         const auto sid_slice = context.symbol_slice(type->type.base.id);
@@ -73,10 +73,10 @@ template <IsDefVisitor V> class TypeResolver {
             const Def& def = context.def(did);
 
             if (def.holds<DefDeftype>()) {
-                const Type& orig_type = context.type(def.as<DefDeftype>().type);
+                const Type& orig_type = context.type(def.as<DefDeftype>(context).type);
 
                 // make the true type
-                TypeId new_tid = context.emplace_type(orig_type.value, span,
+                TypeId new_tid = context.emplace_type(orig_type.value(context), span,
                                                       mut); // rebind mut here
 
                 return context.emplace_type(TypeDeftype{.true_type = new_tid, .definition = did},
@@ -145,8 +145,7 @@ template <IsDefVisitor V> class TypeResolver {
         const bool outer_mut_as_written = type->type.ptr_ref.mut;
         const bool inner_mut_as_written = context.type(inner_tid).mut;
         // always make inner not mut since outer mut carries necessary mut info
-        context.type(inner_tid).mut = false;
-        context.type_as_mentioned(inner_tid).mut = false; // this corrects deftypes too
+        context.strip_type_mut(inner_tid); // this corrects deftypes too
 
         const TypeId outer_tid = context.emplace_type(TypeRef{.inner = inner_tid},
                                                       Span(context, fid, type->first, type->last),
@@ -198,8 +197,9 @@ template <IsDefVisitor V> class TypeResolver {
             return std::nullopt;
         }
 
-        auto maybe_size_exec = ComptExprSolver<V>{context, def_visitor}.solve_builtin_compt_expr(
-            fid, scope, type->type.arr.size_expr, builtin_type::usize, std::nullopt);
+        auto maybe_size_exec
+            = ComptExprSolver<V>{context, def_visitor}.solve_top_level_builtin_expr(
+                fid, scope, type->type.arr.size_expr, builtin_type::usize, std::nullopt);
 
         if (!maybe_size_exec.has_value()) {
             return OptId<TypeId>{};
@@ -207,7 +207,7 @@ template <IsDefVisitor V> class TypeResolver {
 
         const Exec& size_exec = context.exec(maybe_size_exec.as_id());
 
-        auto size = size_exec.template as<ExecConst>().template as<uint64_t>();
+        auto size = size_exec.template as<ExecConst>(context).template as<uint64_t>();
 
         // guard zero-size
         if (size == 0) {
@@ -258,7 +258,7 @@ template <IsDefVisitor V> class TypeResolver {
             tid_vec.push_back(maybe_tid.as_id());
         }
 
-        IdSlice<TypeId> param_tid_slice = context.freeze_id_vec(tid_vec);
+        IdSlice<TypeId> param_tid_slice = context.intern_id_vec(tid_vec);
 
         return context.emplace_type(
             TypeFnPtr{.param_types = param_tid_slice, .return_type = maybe_return_type},
@@ -290,7 +290,7 @@ template <IsDefVisitor V> class TypeResolver {
         }
 
         // make new type as to update span
-        return context.emplace_type(context.type(maybe_tid.as_id()).value,
+        return context.emplace_type(context.type(maybe_tid.as_id()).value(context),
                                     Span(context, fid, type->first, type->last),
                                     type->type.type_of.mut);
     }
@@ -356,7 +356,7 @@ template <IsDefVisitor V> class TypeResolver {
         const Type& type = context.type(context.try_decay_ref(tid));
 
         // make new type as to update span and remove mut
-        return context.emplace_type(type.value, span, false);
+        return context.emplace_type(type.value(context), span, false);
     }
 };
 
@@ -9,7 +9,9 @@
 #ifndef COMPILER_HIR_VARIANT_HELPERS_HPP
 #define COMPILER_HIR_VARIANT_HELPERS_HPP
 
+#include <cstddef>
 #include <optional>
+#include <type_traits>
 #include <variant>
 // visit helper
 template <class... Ts> struct Ovld : Ts... {
@@ -39,6 +41,23 @@ bool variant_equal(const std::variant<Ts...>& a, const std::variant<Ts...>& b) {
     return priv_impl_variant_helper::variant_equal_impl(a, b, std::index_sequence_for<Ts...>{});
 }
 
+/// index of alternative T within a std::variant, usable for compile-time tags
+template <typename T, typename Variant> struct variant_index;
+template <typename T, typename... Ts> struct variant_index<T, std::variant<Ts...>> {
+    static constexpr std::size_t value = [] {
+        constexpr bool matches[] = {std::is_same_v<T, Ts>...};
+        for (std::size_t i = 0; i < sizeof...(Ts); i++) {
+            if (matches[i]) {
+                return i;
+            }
+        }
+        return sizeof...(Ts);
+    }();
+    static_assert(value < sizeof...(Ts), "T is not an alternative of the variant");
+};
+template <typename T, typename Variant>
+inline constexpr std::size_t variant_index_v = variant_index<T, Variant>::value;
+
 // helper for structs with a subvalue that is a variant (see hir::Exec, hir::Def, etc. for examples)
 template <typename V> struct NodeWithVariantValue {
   private:
@@ -10,11 +10,19 @@
 #include "cli/args.h"
 #include "compiler/token.h"
 #include "string.h"
+#include "utils/alloc_stats.h"
 #include "utils/ansi_codes.h"
+#include "utils/arena.h"
+#include "utils/flatmapu32u32.h"
+#include "utils/mapu32u32.h"
+#include "utils/strintern.h"
 #include "utils/vector.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 bearc_args_t args;
 
@@ -31,6 +39,7 @@ int main(int argc, char** argv) {
     *((br_test_result_t*)vector_emplace_back(&results)) = test_parser();
     *((br_test_result_t*)vector_emplace_back(&results)) = test_hir();
     *((br_test_result_t*)vector_emplace_back(&results)) = test_context_db();
+    *((br_test_result_t*)vector_emplace_back(&results)) = test_utils();
     // ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
 
     printf("%s -----------------------------%s\n", ansi_bold_reset(), ansi_reset());
@@ -284,6 +293,144 @@ br_test_result_t test_hir(void) {
 
     char* args78[] = {"bearc", "tests/hir/78.br"};
     ASSERT_EQ_ERR_FROM_ARGS(args78, 21);
+    char* args80[] = {"bearc", "tests/hir/80.br"};
+    ASSERT_EQ_ERR_FROM_ARGS(args80, 16);
+    char* args81[] = {"bearc", "tests/hir/81.br"};
+    ASSERT_EQ_ERR_FROM_ARGS(args81, 2);
+    char* args82[] = {"bearc", "tests/hir/82.br"};
+    ASSERT_EQ_ERR_FROM_ARGS(args82, 3);
+    char* args83[] = {"bearc", "tests/hir/83.br"};
+    ASSERT_EQ_ERR_FROM_ARGS(args83, 0);
+    char* args84[] = {"bearc", "tests/hir/84.br"};
+    ASSERT_EQ_ERR_FROM_ARGS(args84, 0);
+    char* args85[] = {"bearc", "tests/hir/85.br"};
+    ASSERT_EQ_ERR_FROM_ARGS(args85, 0);
+
+    return TEST_RESULT;
+}
+
+// xorshift32, deterministic so failures are reproducible
+static uint32_t test_rand(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// runs random insert/remove/lookup ops against both the chained mapu32u32 (reference) and the
+// flat flatmapu32u32, returns true if they never disagreed
+static bool test_flatmap_differential(uint32_t seed, uint32_t key_range, uint32_t key_stride,
+                                      size_t op_cnt) {
+    arena_t arena = arena_create(1 << 16);
+    mapu32u32_t ref = mapu32u32_create_from_arena(4, &arena);
+    flatmapu32u32_t flat = flatmapu32u32_create_from_arena(4, &arena);
+    uint32_t state = seed;
+    bool ok = true;
+    for (size_t i = 0; i < op_cnt && ok; i++) {
+        const uint32_t op = test_rand(&state) % 10;
+        const uint32_t key = (test_rand(&state) % key_range) * key_stride;
+        if (op < 5) {
+            const uint32_t val = test_rand(&state);
+            mapu32u32_insert(&ref, key, val);
+            flatmapu32u32_insert(&flat, key, val);
+        } else if (op < 8) {
+            ok = mapu32u32_remove(&ref, key) == flatmapu32u32_remove(&flat, key);
+        } else {
+            const uint32_t* ref_val = mapu32u32_cat(&ref, key);
+            const uint32_t* flat_val = flatmapu32u32_cat(&flat, key);
+            ok = (ref_val == NULL) == (flat_val == NULL) && (!ref_val || *ref_val == *flat_val);
+        }
+        ok = ok && ref.size == flat.size;
+    }
+    // every iterated flat entry must agree w/ the reference, and cover all of it
+    uint32_t iterated = 0;
+    for (flatmapu32u32_iter_t it = flatmapu32u32_iter_begin(&flat); !flatmapu32u32_iter_end(&it);
+         flatmapu32u32_iter_next(&it)) {
+        const uint32_t* ref_val = mapu32u32_cat(&ref, it.curr->key);
+        ok = ok && ref_val && *ref_val == it.curr->val;
+        ++iterated;
+    }
+    ok = ok && iterated == ref.size;
+    arena_destroy(&arena);
+    return ok;
+}
+
+br_test_result_t test_utils(void) {
+    TEST_INIT("utils");
+
+    // dense small key space -> heavy removal churn and long backward shifts
+    TEST_ASSERT(test_flatmap_differential(0x9e3779b9U, 64, 1, 50000));
+    TEST_ASSERT(test_flatmap_differential(0x2545f491U, 4096, 1, 100000));
+    // strided keys share low bits before hashing
+    TEST_ASSERT(test_flatmap_differential(0x68e31da4U, 2048, 1024, 100000));
+    TEST_ASSERT(test_flatmap_differential(0xb5297a4dU, 1U << 20, 1, 100000));
+    // HIR_ID_NONE (0) is never a key, but the table itself shouldn't care
+    TEST_ASSERT(test_flatmap_differential(0x1b873593U, 3, 1, 1000));
+
+    // presizing means no rehash, so the slot array stays put
+    arena_t arena = arena_create(1 << 16);
+    flatmapu32u32_t flat = flatmapu32u32_create_from_arena(0, &arena);
+    flatmapu32u32_reserve(&flat, 1000);
+    const flatmapu32u32_slot_t* slots = flat.slots;
+    for (uint32_t i = 1; i <= 1000; i++) {
+        flatmapu32u32_insert(&flat, i, i * 2);
+    }
+    TEST_ASSERT(flat.slots == slots && flat.size == 1000);
+    TEST_ASSERT(*flatmapu32u32_cat(&flat, 500) == 1000 && !flatmapu32u32_contains(&flat, 1001));
+    arena_destroy(&arena);
+
+    // interner: ids survive growth, strs are stable null-terminated copies, lookups by len
+    arena_t table_arena = arena_create(1 << 16);
+    arena_t str_arena = arena_create(1 << 16);
+    strintern_t strs = strintern_create_from_arenas(0, &table_arena, &str_arena);
+    bool intern_ok = true;
+    char buf[32];
+    for (int32_t i = 0; i < 5000; i++) {
+        const int len = snprintf(buf, sizeof(buf), "sym_%d", i);
+        bool inserted = false;
+        strintern_slot_t* slot = strintern_intern(&strs, buf, (size_t)len, i, &inserted);
+        intern_ok = intern_ok && inserted && slot->val == i && strcmp(slot->str, buf) == 0;
+    }
+    for (int32_t i = 0; i < 5000; i++) {
+        const int len = snprintf(buf, sizeof(buf), "sym_%d", i);
+        bool inserted = true;
+        strintern_slot_t* slot = strintern_intern(&strs, buf, (size_t)len, -1, &inserted);
+        intern_ok = intern_ok && !inserted && slot->val == i;
+    }
+    TEST_ASSERT(intern_ok && strs.size == 5000);
+    // prefix of a present key is a different key
+    TEST_ASSERT(strintern_atn(&strs, "sym_12345", 4) == NULL);
+    TEST_ASSERT(*strintern_atn(&strs, "sym_12345", 5) == 1);
+    TEST_ASSERT(*strintern_atn(&strs, "sym_12345", 6) == 12);
+    for (int32_t i = 0; i < 5000; i += 2) {
+        const int len = snprintf(buf, sizeof(buf), "sym_%d", i);
+        intern_ok = intern_ok && strintern_remove(&strs, buf, (size_t)len);
+    }
+    for (int32_t i = 0; i < 5000; i++) {
+        const int len = snprintf(buf, sizeof(buf), "sym_%d", i);
+        const int32_t* val = strintern_viewn(&strs, buf, (size_t)len);
+        intern_ok = intern_ok && ((i % 2 == 0) ? val == NULL : (val && *val == i));
+    }
+    TEST_ASSERT(intern_ok && strs.size == 2500);
+    TEST_ASSERT(hash_bytes("abc", 3) != hash_bytes("abd", 3)
+                && hash_bytes("", 0) == hash_bytes("x", 0));
+    arena_destroy(&table_arena);
+    arena_destroy(&str_arena);
+
+#ifdef BEAR_ALLOC_STATS
+    // heap accounting: allocations are charged to whichever phase is current
+    const alloc_phase_e prev_phase = alloc_stats_set_phase(ALLOC_PHASE_COMPT);
+    const alloc_phase_stats_t before = alloc_stats_of_phase(ALLOC_PHASE_COMPT);
+    void* volatile block = malloc(100);
+    block = realloc(block, 200);
+    free(block);
+    const alloc_phase_stats_t after = alloc_stats_of_phase(ALLOC_PHASE_COMPT);
+    alloc_stats_set_phase(prev_phase);
+    TEST_ASSERT(after.mallocs == before.mallocs + 1 && after.reallocs == before.reallocs + 1
+                && after.frees == before.frees + 1 && after.bytes == before.bytes + 300);
+#endif
 
     return TEST_RESULT;
 }
@@ -9,7 +9,12 @@
 #include "tests/test.h"
 #include "compiler/hir/context_database.hpp"
 #include "compiler/hir/exec.hpp"
+#include "compiler/hir/type.hpp"
+#include <initializer_list>
+#include <span>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <vector>
 
 using SymSlice = std::vector<std::string>;
@@ -24,9 +29,10 @@ br_test_result_t test_context_db(void) {
         = [&br_test_result](ContextDatabase::DefQueryResult def, const ContextDatabase& db) {
               TEST_ASSERT(def.variable.has_value());
 
-              TEST_ASSERT(def.variable.value().as<DefVariable>().compt_value.has_value());
+              const auto& var = def.variable.value().as<DefVariable>(db.context());
+              TEST_ASSERT(var.compt_value.has_value());
 
-              auto exec = db.exec(def.variable.value().as<DefVariable>().compt_value.as_id());
+              auto exec = db.exec(var.compt_value.as_id());
 
               TEST_ASSERT(exec.holds<ExecConst>());
               return exec;
@@ -35,7 +41,7 @@ br_test_result_t test_context_db(void) {
     auto assert_compt = [&br_test_result, &econst](ContextDatabase& db, const char* name, bool b) {
         auto def = db.query_def({name});
         auto exec = econst(def, db);
-        TEST_ASSERT_EQ(b, exec.as<ExecConst>().as<bool>());
+        TEST_ASSERT_EQ(b, exec.as<ExecConst>(db.context()).as<bool>());
     };
 
     auto assert_no_compt_val = [&br_test_result](ContextDatabase& db, const char* name) {
@@ -47,7 +53,7 @@ br_test_result_t test_context_db(void) {
         }
         if (def.variable.value().holds<DefVariable>()) {
             TEST_ASSERT(def.variable.value().holds<DefVariable>());
-            TEST_ASSERT(def.variable.value().as<DefVariable>().compt_value.empty());
+            TEST_ASSERT(def.variable.value().as<DefVariable>(db.context()).compt_value.empty());
             return;
         }
         TEST_ASSERT(false);
@@ -60,15 +66,15 @@ br_test_result_t test_context_db(void) {
 
     auto def0 = db28.query_def({"e"});
     auto exec0 = econst(def0, db28);
-    TEST_ASSERT_EQ(0x10, exec0.as<ExecConst>().as<i32>());
+    TEST_ASSERT_EQ(0x10, exec0.as<ExecConst>(db28.context()).as<i32>());
 
     auto def1 = db28.query_def({"b1"});
     auto exec1 = econst(def1, db28);
-    TEST_ASSERT_EQ((0x11 | 0x10), exec1.as<ExecConst>().as<u8>());
+    TEST_ASSERT_EQ((0x11 | 0x10), exec1.as<ExecConst>(db28.context()).as<u8>());
 
     auto def2 = db28.query_def({"h2"});
     auto exec2 = econst(def2, db28);
-    TEST_ASSERT_EQ((0x1111 ^ 0x1001), exec2.as<ExecConst>().as<usize>());
+    TEST_ASSERT_EQ((0x1111 ^ 0x1001), exec2.as<ExecConst>(db28.context()).as<usize>());
 
     // TEST 2: BOOLEAN OPS
     const char* args1[] = {"bearc", "tests/hir/30.br"};
@@ -104,6 +110,317 @@ br_test_result_t test_context_db(void) {
     auto d3 = db44.query_def_id({"Foo", "a"});
     TEST_ASSERT(d3.variable_id.has_value());
 
+    // TEST 5: memory accounting
+    const hir::MemStatsReport mem = db44.mem_stats();
+    for (const hir::MemStat& row : mem.structures) {
+        TEST_ASSERT(row.used <= row.reserved);
+    }
+    TEST_ASSERT_EQ(static_cast<size_t>(1), mem.files.size());
+    TEST_ASSERT(mem.files[0].count > 0); // tokens
+    const hir::MemPhaseStat total = mem.total("total");
+    TEST_ASSERT(total.used > 0);
+    TEST_ASSERT(total.used <= total.reserved);
+
+    // TEST 6: slice interning
+    IdVector<SymbolId> sids{16};
+    llvm::SmallVector<SymbolId> abc{SymbolId{1}, SymbolId{2}, SymbolId{3}};
+    llvm::SmallVector<SymbolId> ab{SymbolId{1}, SymbolId{2}};
+    const IdSlice<SymbolId> abc0 = sids.intern_small_vec(abc);
+    const IdSlice<SymbolId> ab0 = sids.intern_small_vec(ab);
+    TEST_ASSERT(abc0 == sids.intern_small_vec(abc));
+    TEST_ASSERT(!(abc0 == ab0) && ab0 == sids.intern_small_vec(ab));
+    TEST_ASSERT(sids.intern_small_vec(llvm::SmallVector<SymbolId>{}) == IdSlice<SymbolId>{});
+    TEST_ASSERT_EQ(static_cast<size_t>(5), sids.size()); // no duplicate storage
+    for (HirId i = 0; i < 200; i++) { // force the intern table to grow
+        llvm::SmallVector<SymbolId> one{SymbolId{i + 10}};
+        std::ignore = sids.intern_small_vec(one);
+    }
+    TEST_ASSERT(abc0 == sids.intern_small_vec(abc) && sids.interned_count() == 202);
+    TEST_ASSERT(!(abc0 == sids.freeze_small_vec(abc))); // plain freezing still copies
+
+    // TEST 7: segmented storage keeps addresses stable across growth
+    IdVecMap<DefId, uint64_t> vals{4};
+    const DefId first_id = vals.emplace_and_get_id(7u);
+    const uint64_t* first_addr = &vals[first_id];
+    for (uint64_t i = 1; i < 1000; i++) {
+        std::ignore = vals.emplace_and_get_id(i * 3);
+    }
+    TEST_ASSERT(&vals[first_id] == first_addr && *first_addr == 7);
+    TEST_ASSERT(vals.cat(DefId{1000}) == 999 * 3 && vals.size() == 1000);
+    uint64_t sum = 0;
+    for (const uint64_t v : vals) {
+        sum += v;
+    }
+    TEST_ASSERT_EQ(static_cast<uint64_t>(7 + (3 * 999 * 1000 / 2)), sum);
+    TEST_ASSERT(*vals.rbegin() == 999 * 3 && *std::prev(vals.rend()) == 7);
+    uint64_t run_sum = 0;
+    size_t run_cnt = 0;
+    vals.for_each_run([&run_sum, &run_cnt](std::span<const uint64_t> run) {
+        for (const uint64_t v : run) {
+            run_sum += v;
+        }
+        ++run_cnt;
+    });
+    TEST_ASSERT(run_sum == sum && run_cnt > 1);
+
+    // TEST 8: hot def record reaches its cold payload + span
+    auto foo_a = db44.query_def({"Foo", "a"});
+    TEST_ASSERT(foo_a.variable.has_value() && foo_a.variable->holds<DefVariable>());
+    constexpr size_t var_idx = variant_index_v<DefVariable, DefValue>;
+    TEST_ASSERT(foo_a.variable->value(db44.context()).index() == var_idx);
+    const Span foo_a_span = foo_a.variable->span(db44.context());
+    TEST_ASSERT(!foo_a_span.is_generated() && foo_a_span.len > 0);
+
+    // TEST 9: packed spans resolve their line/col lazily
+    TEST_ASSERT_EQ(static_cast<size_t>(8), sizeof(Span));
+    const SrcLoc foo_a_loc = db44.src_loc(foo_a_span);
+    TEST_ASSERT_EQ(static_cast<HirSize>(3), foo_a_loc.line); // `i32 a = 42;`
+    TEST_ASSERT(foo_a_loc.col >= 4);
+
+    // TEST 10: exec/type nodes are a tag + payload idx, payloads live in per-kind side tables
+    TEST_ASSERT(sizeof(Exec) <= 16);
+    TEST_ASSERT(sizeof(Type) <= 20);
+    TEST_ASSERT(db28.context().exec_payload_tables().size() > 0);
+    TEST_ASSERT_EQ(0x10, exec0.as<ExecConst>(db28.context()).as<i32>()); // still reads back
+
+    // TEST 11: compt intermediates are scratch, params and element slices included, so the
+    // permanent tables don't grow w/ how much a compt expr computes
+    const char* args83[] = {"bearc", "--no-compt-vm", "tests/hir/83.br"};
+    const char* args84[] = {"bearc", "--no-compt-vm", "tests/hir/84.br"};
+    ContextDatabase db83{sizeof(args83) / sizeof(char*), args83};
+    ContextDatabase db84{sizeof(args84) / sizeof(char*), args84};
+    TEST_ASSERT_EQ(static_cast<u64>(20100),
+                   econst(db84.query_def({"_0"}), db84).as<ExecConst>(db84.context()).as<u64>());
+    auto row_count = [](const ContextDatabase& db, std::string_view name) {
+        for (const MemStat& row : db.context().mem_stats().structures) {
+            if (row.name == name) {
+                return row.count;
+            }
+        }
+        return ~size_t{0};
+    };
+    for (const char* name : {"defs", "execs", "exec_ids"}) {
+        TEST_ASSERT_EQ(row_count(db83, name), row_count(db84, name));
+    }
+    TEST_ASSERT_EQ(static_cast<size_t>(0), row_count(db84, "scratch_defs"));
+
+    // TEST 12: builtin types are preallocated once per context
+    const Context& ctx28 = db28.context();
+    const TypeId bool_tid = ctx28.builtin_type_id(builtin_type::boolean);
+    TEST_ASSERT(ctx28.type(bool_tid).holds<TypeBuiltin>());
+    TEST_ASSERT(ctx28.type(bool_tid).as<TypeBuiltin>(ctx28).type == builtin_type::boolean);
+    TEST_ASSERT(!(bool_tid == ctx28.builtin_type_id(builtin_type::u8)));
+
+    // TEST 13: a mentioned type shares its canonical id w/ the structurally identical builtin
+    const Context& ctx44 = db44.context();
+    const TypeId a_tid = foo_a.variable->as<DefVariable>(ctx44).type_id;
+    const TypeId i32_tid = ctx44.builtin_type_id(builtin_type::i32);
+    TEST_ASSERT(!(a_tid == i32_tid) && ctx44.equivalent_type(a_tid, i32_tid));
+    TEST_ASSERT(!ctx44.equivalent_type(a_tid, ctx44.builtin_type_id(builtin_type::u32)));
+
+    // TEST 14: rendered type names are interned, so `@type_to_str(Foo)` is Foo's own symbol
+    const char* args38[] = {"bearc", "tests/hir/38.br"};
+    ContextDatabase db38{sizeof(args38) / sizeof(char*), args38};
+    const SymbolId i_sid = econst(db38.query_def({"i"}), db38).as<ExecConst>(db38.context())
+                               .as<SymbolId>();
+    TEST_ASSERT(i_sid == db38.query_def({"Foo"}).type->name);
+    TEST_ASSERT(db38.context().symbol(i_sid) == "Foo");
+
+    // TEST 15: an exec's inferred type is cached, and survives promotion out of scratch
+    const char* args58[] = {"bearc", "tests/hir/58.br"};
+    ContextDatabase db58{sizeof(args58) / sizeof(char*), args58};
+    const Context& ctx58 = db58.context();
+    const auto bar_mem = db58.query_def({"Foo2", "bar"}).variable;
+    TEST_ASSERT(bar_mem.has_value() && bar_mem->as<DefVariable>(ctx58).compt_value.has_value());
+    const OptId<TypeId> bar_tid
+        = ctx58.cached_exec_type(bar_mem->as<DefVariable>(ctx58).compt_value.as_id());
+    TEST_ASSERT(bar_tid.has_value() && ctx58.type(bar_tid.as_id()).holds<TypeStruct>());
+    TEST_ASSERT(ctx58.type(bar_tid.as_id()).as<TypeStruct>(ctx58).def_id
+                == db58.query_def_id({"Bar"}).type_id.as_id());
+
+    // TEST 16: scope tables start as inline arrays and spill into a hash table past a threshold
+    DataArena small_arena{0x1000};
+    SmallIdMap<SymbolId, DefId> small_map{small_arena, 0};
+    for (HirId i = 1; i <= 4; i++) {
+        small_map.insert(SymbolId{i}, DefId{i * 2});
+    }
+    small_map.insert(SymbolId{2}, DefId{40}); // overwrite stays inline
+    TEST_ASSERT(small_map.is_inline() && small_map.at(SymbolId{2}).as_id() == DefId{40});
+    small_map.insert(SymbolId{5}, DefId{10});
+    TEST_ASSERT(!small_map.is_inline() && small_map.size() == 5);
+    TEST_ASSERT(small_map.at(SymbolId{1}).as_id() == DefId{2} && !small_map.contains(SymbolId{6}));
+    HirId key_sum = 0;
+    for (const auto e : small_map) {
+        key_sum += e.key().val();
+    }
+    TEST_ASSERT_EQ(static_cast<HirId>(15), key_sum);
+    TEST_ASSERT(!ctx44.scope(ctx44.root_scope()).is_inline()); // presized for a whole file
+
+    // TEST 17: registered module scopes are frozen, look ups thru them are flattened + filtered
+    const ScopeId root44 = ctx44.root_scope();
+    const SymbolId foo_sid = db44.query_def({"Foo"}).type->name;
+    const SymbolId a_sid = foo_a.variable->name;
+    TEST_ASSERT(ctx44.scope(root44).is_frozen());
+    TEST_ASSERT(ctx44.scope(root44).may_define(scope_kind::type, foo_sid));
+    const OptId<DefId> foo_type = ctx44.look_up_type(root44, foo_sid);
+    TEST_ASSERT(foo_type.as_id() == db44.query_def_id({"Foo"}).type_id.as_id());
+    TEST_ASSERT(ctx44.look_up_type(root44, foo_sid).as_id() == foo_type.as_id()); // cached
+    TEST_ASSERT(ctx44.look_up_variable(root44, a_sid).empty()); // only in Foo's own scope
+    TEST_ASSERT(ctx44.look_up_variable(root44, a_sid).empty());
+
+    // TEST 18: a returning compt call hands its temp scope to the next, so recursion stays bounded
+    const char* args85[] = {"bearc", "tests/hir/85.br"};
+    ContextDatabase db85{sizeof(args85) / sizeof(char*), args85};
+    // walk(300) down to walk(0) is the deepest chain
+    TEST_ASSERT_EQ(static_cast<size_t>(301), db85.context().compt_temp_scope_count());
+
+    // TEST 19: a src position maps to the innermost scope spanning it
+    const FileId file44{1};
+    const ScopeId foo_scope = db44.query_def({"Foo"}).type->as<DefStruct>(ctx44).scope;
+    const ScopeId bar_scope = db44.query_def({"Foo", "Bar"}).type->as<DefStruct>(ctx44).scope;
+    TEST_ASSERT(db44.scope_at(file44, SrcLoc{.line = 3, .col = 4}) == foo_scope); // `i32 a`
+    TEST_ASSERT(db44.scope_at(file44, SrcLoc{.line = 9, .col = 0}) == bar_scope);
+    TEST_ASSERT(db44.scope_at(file44, SrcLoc{.line = 12, .col = 0}) == root44); // `compt Foo foo`
+    // a col past the line's end stops at its newline, or at EOF on the last line
+    const HirSize line3_end = ctx44.pos_at(file44, SrcLoc{.line = 3, .col = 1000});
+    TEST_ASSERT_EQ(ctx44.pos_at(file44, SrcLoc{.line = 4, .col = 0}) - 1, line3_end);
+    TEST_ASSERT_EQ(static_cast<HirSize>(3), ctx44.src_loc_at(line3_end).line);
+    TEST_ASSERT(db44.scope_at(file44, SrcLoc{.line = 3, .col = 1000}) == foo_scope);
+    const auto src44_size = static_cast<HirSize>(ctx44.ast(file44).src()->size);
+    TEST_ASSERT_EQ(ctx44.file_base(file44) + src44_size,
+                   ctx44.pos_at(file44, SrcLoc{.line = 1000, .col = 1000}));
+
+    // TEST 20: an unresolved name gets a `did you mean` only if a visible name is close enough
+    const char* args79[] = {"bearc", "tests/hir/79.br"};
+    ContextDatabase db79{sizeof(args79) / sizeof(char*), args79};
+    TEST_ASSERT_EQ(2, db79.context().error_count());
+    TEST_ASSERT_EQ(1, db79.context().help_count());
+    TEST_ASSERT_EQ(static_cast<uint32_t>(2), SymbolSuggester::edit_distance("cuont", "count"));
+
+    // TEST 21: top-level defs are found by exact fully qualified name and by prefix
+    const auto foo_bar_id = db44.query_def_id({"Foo", "Bar"}).type_id;
+    TEST_ASSERT(db44.query_def_id_by_fqn("Foo..Bar").as_id() == foo_bar_id.as_id());
+    TEST_ASSERT(!db44.query_def_id_by_fqn("Foo..Baz").has_value());
+    const auto foo_members = db44.search_defs("Foo..");
+    TEST_ASSERT_EQ(static_cast<size_t>(3), foo_members.size()); // a, b, Bar
+    TEST_ASSERT(db44.search_defs("Ba").front() == foo_bar_id.as_id());
+    TEST_ASSERT_EQ(static_cast<size_t>(1), db44.search_defs("_", 1).size());
+
+    // TEST 22: each distinct pure compt call is solved once, a poisoned one is only reported once
+    // per top-level expr and doesn't stick past it
+    const char* args80[] = {"bearc", "tests/hir/80.br"};
+    ContextDatabase db80{sizeof(args80) / sizeof(char*), args80};
+    TEST_ASSERT_EQ(8, db80.context().error_count()); // inv(0) x3, then g in f(1..5)
+    // fib(0..90), inv(0), f(0..6), g(1..6)
+    TEST_ASSERT_EQ(static_cast<size_t>(105), db80.context().compt_call_memo_size());
+    TEST_ASSERT_EQ(static_cast<u32>(6), econst(db80.query_def({"_5"}), db80)
+                                            .as<ExecConst>(db80.context())
+                                            .as<u32>());
+
+    // TEST 23: the compt vm agrees w/ the tree-walker, which still reports every diagnostic
+    const char* args81[] = {"bearc", "tests/hir/81.br"};
+    const char* args81_no_vm[] = {"bearc", "--no-compt-vm", "tests/hir/81.br"};
+    ContextDatabase db81{sizeof(args81) / sizeof(char*), args81};
+    ContextDatabase db81_no_vm{sizeof(args81_no_vm) / sizeof(char*), args81_no_vm};
+    TEST_ASSERT_EQ(1, db81.context().error_count());
+    TEST_ASSERT_EQ(db81_no_vm.context().diagnostic_count(), db81.context().diagnostic_count());
+    for (const char* name : {"_0", "_1", "_2", "_3", "_4", "_5", "_6", "_10"}) {
+        const auto vm_val = econst(db81.query_def({name}), db81).as<ExecConst>(db81.context());
+        const auto walked_val = econst(db81_no_vm.query_def({name}), db81_no_vm)
+                                    .as<ExecConst>(db81_no_vm.context());
+        TEST_ASSERT(ExecConst::equal(vm_val, walked_val).value().as<bool>());
+    }
+    TEST_ASSERT_EQ(static_cast<size_t>(10), db81.context().compt_programs().size());
+    TEST_ASSERT_EQ(static_cast<size_t>(0), db81_no_vm.context().compt_programs().size());
+
+    // TEST 24: vm recursion is bounded by --compt-stack's bytes, not the C++ stack
+    const char* args82[] = {"bearc", "tests/hir/82.br"};
+    const char* args82_small[] = {"bearc", "--compt-stack", "64", "tests/hir/82.br"};
+    ContextDatabase db82{sizeof(args82) / sizeof(char*), args82};
+    ContextDatabase db82_small{sizeof(args82_small) / sizeof(char*), args82_small};
+    TEST_ASSERT_EQ(1, db82.context().error_count()); // only forever
+    TEST_ASSERT_EQ(static_cast<u64>(200010000),
+                   econst(db82.query_def({"_0"}), db82).as<ExecConst>(db82.context()).as<u64>());
+    // the vm's 20000 frames are memoized as constants, only _0's value became an exec
+    TEST_ASSERT_EQ(static_cast<size_t>(1), row_count(db82, "execs"));
+    TEST_ASSERT_EQ(static_cast<size_t>(64) << 10, db82_small.context().compt_stack_bytes());
+    TEST_ASSERT_EQ(2, db82_small.context().error_count()); // sum_to no longer fits either
+
+    // TEST 25: a def inserted into an enclosing scope shadows a path memoized before it
+    bearc_args_t args44_mut = parse_cli_args(sizeof(args3) / sizeof(char*),
+                                             const_cast<char**>(args3));
+    Context ctx44_mut{args44_mut};
+    auto path = [&ctx44_mut](std::initializer_list<std::string_view> names) {
+        llvm::SmallVector<SymbolId> sids;
+        for (std::string_view name : names) {
+            sids.push_back(ctx44_mut.symbol_id(name));
+        }
+        return ctx44_mut.intern_id_vec(sids);
+    };
+    const OptId<DefId> bar_did = ctx44_mut.look_up_scoped_type(
+        ctx44_mut.root_scope(), path({"Foo", "Bar"}), Span::generated());
+    TEST_ASSERT(bar_did.has_value());
+    const ScopeId bar_scope_mut = ctx44_mut.def(bar_did.as_id()).as<DefStruct>(ctx44_mut).scope;
+    const ScopeId block_scope = ctx44_mut.make_scope(bar_scope_mut);
+    const OptId<DefId> foo_b
+        = ctx44_mut.look_up_scoped_variable(block_scope, path({"b"}), Span::generated());
+    TEST_ASSERT(foo_b.has_value());
+    const SymbolId b_sid = ctx44_mut.symbol_id(std::string_view{"b"});
+    const DefId bar_b = ctx44_mut.register_def(b_sid, Span::generated(), bar_did.as_id());
+    ctx44_mut.insert_variable(bar_scope_mut, b_sid, bar_b);
+    const OptId<DefId> shadowing_b
+        = ctx44_mut.look_up_scoped_variable(block_scope, path({"b"}), Span::generated());
+    TEST_ASSERT(shadowing_b.has_value() && shadowing_b.as_id() == bar_b);
+    TEST_ASSERT(!(foo_b.as_id() == bar_b));
+
+    // TEST 26: structurally equal arrs, slices and ptrs share a canonical id, while a different
+    // size, inner type, kind or mut doesn't, and every id survives the table growing past 3/4 load
+    Context& tctx = ctx44_mut;
+    const Span mention = tctx.def(bar_did.as_id()).span(tctx); // not generated, so never interned
+    const TypeId i32_t = tctx.builtin_type_id(builtin_type::i32);
+    const TypeId u32_t = tctx.builtin_type_id(builtin_type::u32);
+    auto fresh = [&](const TypeValue& value, bool mut = false) {
+        return tctx.emplace_type(value, mention, mut);
+    };
+    auto arr_of = [&](TypeId inner, size_t size) {
+        return fresh(TypeArr{.inner = inner, .compt_size_expr = {}, .canonical_size = size});
+    };
+    const TypeId arr4 = arr_of(i32_t, 4);
+    TEST_ASSERT(!(arr4 == arr_of(i32_t, 4)) && tctx.equivalent_type(arr4, arr_of(i32_t, 4)));
+    TEST_ASSERT(!tctx.equivalent_type(arr4, arr_of(i32_t, 5)));
+    TEST_ASSERT(!tctx.equivalent_type(arr4, arr_of(u32_t, 4)));
+    const TypeId slice = fresh(TypeSlice{i32_t});
+    TEST_ASSERT(tctx.equivalent_type(slice, fresh(TypeSlice{i32_t})));
+    TEST_ASSERT(!tctx.equivalent_type(slice, fresh(TypeSlice{i32_t}, true)));
+    TEST_ASSERT(!tctx.equivalent_type(slice, fresh(TypeSlice{u32_t})));
+    const TypeId ptr = fresh(TypePtr{i32_t});
+    const TypeId mut_i32 = fresh(TypeBuiltin{builtin_type::i32}, true);
+    TEST_ASSERT(tctx.equivalent_type(ptr, fresh(TypePtr{i32_t})));
+    TEST_ASSERT(!tctx.equivalent_type(ptr, fresh(TypePtr{mut_i32})));
+    TEST_ASSERT(tctx.equivalent_type(fresh(TypePtr{mut_i32}), fresh(TypePtr{mut_i32})));
+    TEST_ASSERT(!tctx.equivalent_type(ptr, fresh(TypeRef{i32_t})));
+    // well past the table's default capacity, so it rehashes at least once
+    constexpr size_t grown_cnt = 0x800;
+    std::vector<TypeId> arrs;
+    for (size_t size = 0; size < grown_cnt; size++) {
+        arrs.push_back(arr_of(u32_t, size));
+    }
+    bool all_found = true;
+    for (size_t size = 0; size < grown_cnt; size++) {
+        const TypeId again = arr_of(u32_t, size);
+        all_found = all_found && tctx.type(again).canonical == tctx.type(arrs[size]).canonical;
+    }
+    TEST_ASSERT(all_found);
+    TEST_ASSERT(!(tctx.type(arrs[0]).canonical == tctx.type(arrs[grown_cnt - 1]).canonical));
+    TEST_ASSERT(tctx.equivalent_type(arr4, arr_of(i32_t, 4)));
+
+    // TEST 27: walked recursion (e.g. over struct params) is bounded by --compt-stack's bytes too
+    const char* args85_small[] = {"bearc", "--compt-stack", "64", "tests/hir/85.br"};
+    ContextDatabase db85_small{sizeof(args85_small) / sizeof(char*), args85_small};
+    TEST_ASSERT_EQ(static_cast<u64>(300),
+                   econst(db85.query_def({"_0"}), db85).as<ExecConst>(db85.context()).as<u64>());
+    TEST_ASSERT_EQ(1, db85_small.context().error_count());
+
     return TEST_RESULT;
 }
 
@@ -33,6 +33,7 @@ br_test_result_t test_parser(void);
 br_test_result_t test_hir(void);
 br_test_result_t test_total_init(void);
 br_test_result_t test_context_db(void);
+br_test_result_t test_utils(void);
 
 void test_tally(br_test_result_t* total, br_test_result_t* new_test);
 
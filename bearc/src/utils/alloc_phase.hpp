@@ -0,0 +1,26 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#ifndef UTILS_ALLOC_PHASE_HPP
+#define UTILS_ALLOC_PHASE_HPP
+
+#include "utils/alloc_stats.h"
+
+/// charges heap allocations to a phase for the lifetime of this object, then restores the previous
+/// phase (compiles to nothing unless built w/ ALLOC_STATS)
+class AllocPhaseScope {
+    alloc_phase_e prev;
+
+  public:
+    explicit AllocPhaseScope(alloc_phase_e phase) : prev{alloc_stats_set_phase(phase)} {}
+    AllocPhaseScope(const AllocPhaseScope&) = delete;
+    AllocPhaseScope& operator=(const AllocPhaseScope&) = delete;
+    ~AllocPhaseScope() { alloc_stats_set_phase(prev); }
+};
+
+#endif
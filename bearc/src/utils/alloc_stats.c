@@ -0,0 +1,258 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#include "utils/alloc_stats.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const char* alloc_phase_name(alloc_phase_e phase) {
+    static const char* const names[ALLOC_PHASE__NUM] = {
+        [ALLOC_PHASE_OTHER] = "other",       [ALLOC_PHASE_LEX] = "lex",
+        [ALLOC_PHASE_PARSE] = "parse",       [ALLOC_PHASE_REGISTER] = "register",
+        [ALLOC_PHASE_RESOLVE] = "resolve",   [ALLOC_PHASE_COMPT] = "compt",
+    };
+    return (phase < ALLOC_PHASE__NUM) ? names[phase] : "?";
+}
+
+#ifdef BEAR_ALLOC_STATS
+
+#if !defined(__GLIBC__)
+#error "ALLOC_STATS interposes malloc through glibc's __libc_* entry points, so it needs glibc"
+#endif
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// glibc's real allocator, which the definitions below forward to
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t cnt, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* ptr);
+
+// bearc is single-threaded, so plain counters are enough
+static alloc_phase_e curr_phase = ALLOC_PHASE_OTHER;
+static alloc_phase_stats_t phase_stats[ALLOC_PHASE__NUM];
+static size_t live_bytes;
+static size_t peak_live_bytes;
+
+alloc_phase_e alloc_stats_set_phase(alloc_phase_e phase) {
+    const alloc_phase_e prev = curr_phase;
+    curr_phase = phase;
+    return prev;
+}
+
+alloc_phase_stats_t alloc_stats_of_phase(alloc_phase_e phase) { return phase_stats[phase]; }
+
+static inline void alloc_stats_add_live(const void* ptr) {
+    live_bytes += malloc_usable_size((void*)ptr);
+    if (live_bytes > peak_live_bytes) {
+        peak_live_bytes = live_bytes;
+    }
+}
+
+static inline void alloc_stats_sub_live(const void* ptr) {
+    const size_t usable = malloc_usable_size((void*)ptr);
+    live_bytes = (usable > live_bytes) ? 0 : live_bytes - usable;
+}
+
+// --- sampled call sites ----------------------------------------------------
+
+#ifdef BEAR_ALLOC_STATS_BACKTRACE
+#include <execinfo.h>
+
+#define ALLOC_STATS_SITE_CAP 1024
+
+typedef struct {
+    void* frames[ALLOC_STATS_SITE_DEPTH];
+    int depth;
+    alloc_phase_e phase;
+    size_t samples;
+    size_t bytes;
+} alloc_site_t;
+
+// fixed storage, the sampler must never allocate itself
+static alloc_site_t sites[ALLOC_STATS_SITE_CAP];
+static size_t dropped_samples;
+static size_t sample_countdown = ALLOC_STATS_SAMPLE_PERIOD;
+static bool in_sample;
+
+// must stay a real frame called directly from the interposed function so that the caller of
+// malloc is always frame 2
+__attribute__((noinline)) static void alloc_stats_sample(size_t bytes) {
+    if (in_sample || --sample_countdown) {
+        return;
+    }
+    sample_countdown = ALLOC_STATS_SAMPLE_PERIOD;
+    in_sample = true; // backtrace may allocate the first time it's called (loading the unwinder)
+
+    enum { SKIP = 2 };
+    void* buf[ALLOC_STATS_SITE_DEPTH + SKIP];
+    const int n = backtrace(buf, ALLOC_STATS_SITE_DEPTH + SKIP) - SKIP;
+    if (n <= 0) {
+        in_sample = false;
+        return;
+    }
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < n; i++) {
+        hash = (hash ^ (uintptr_t)buf[SKIP + i]) * 0x100000001b3ULL;
+    }
+    uint32_t idx = (uint32_t)(hash ^ (hash >> 32)) & (ALLOC_STATS_SITE_CAP - 1);
+    for (uint32_t probes = 0; probes < ALLOC_STATS_SITE_CAP; probes++) {
+        alloc_site_t* site = &sites[idx];
+        if (site->depth == 0) {
+            site->depth = n;
+            site->phase = curr_phase;
+            for (int i = 0; i < n; i++) {
+                site->frames[i] = buf[SKIP + i];
+            }
+        }
+        bool same = site->depth == n;
+        for (int i = 0; same && i < n; i++) {
+            same = site->frames[i] == buf[SKIP + i];
+        }
+        if (same) {
+            ++site->samples;
+            site->bytes += bytes;
+            in_sample = false;
+            return;
+        }
+        idx = (idx + 1) & (ALLOC_STATS_SITE_CAP - 1);
+    }
+    ++dropped_samples; // table full
+    in_sample = false;
+}
+
+static void alloc_stats_print_sites(FILE* out) {
+    bool printed[ALLOC_STATS_SITE_CAP] = {0};
+    fprintf(out, "top allocation sites (1 in %d allocations sampled, %zu samples dropped):\n",
+            ALLOC_STATS_SAMPLE_PERIOD, dropped_samples);
+    for (int rank = 1; rank <= ALLOC_STATS_TOP_SITES; rank++) {
+        int best = -1;
+        for (int i = 0; i < ALLOC_STATS_SITE_CAP; i++) {
+            if (sites[i].depth && !printed[i] && (best < 0 || sites[i].bytes > sites[best].bytes)) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        printed[best] = true;
+        const alloc_site_t* site = &sites[best];
+        fprintf(out, "  #%d ~%zu allocations, ~%zu bytes, first seen in %s\n", rank,
+                site->samples * ALLOC_STATS_SAMPLE_PERIOD, site->bytes * ALLOC_STATS_SAMPLE_PERIOD,
+                alloc_phase_name(site->phase));
+        fflush(out);
+        backtrace_symbols_fd(site->frames, site->depth, fileno(out));
+    }
+}
+#else
+static inline void alloc_stats_sample(size_t bytes) { (void)bytes; }
+#endif
+
+void alloc_stats_print(FILE* out) {
+    fprintf(out, "%-12s%12s%12s%12s%16s\n", "heap phase", "mallocs", "reallocs", "frees",
+            "bytes");
+    alloc_phase_stats_t sum = {0, 0, 0, 0};
+    for (int p = 0; p < ALLOC_PHASE__NUM; p++) {
+        const alloc_phase_stats_t* s = &phase_stats[p];
+        fprintf(out, "%-12s%12zu%12zu%12zu%16zu\n", alloc_phase_name((alloc_phase_e)p), s->mallocs,
+                s->reallocs, s->frees, s->bytes);
+        sum.mallocs += s->mallocs;
+        sum.reallocs += s->reallocs;
+        sum.frees += s->frees;
+        sum.bytes += s->bytes;
+    }
+    fprintf(out, "%-12s%12zu%12zu%12zu%16zu\n", "total", sum.mallocs, sum.reallocs, sum.frees,
+            sum.bytes);
+    fprintf(out, "peak live heap: %zu bytes\n", peak_live_bytes);
+#ifdef BEAR_ALLOC_STATS_BACKTRACE
+    alloc_stats_print_sites(out);
+#endif
+}
+
+// --- interposed entry points -----------------------------------------------
+
+static inline void* alloc_stats_on_alloc(void* ptr, size_t bytes) {
+    if (ptr) {
+        ++phase_stats[curr_phase].mallocs;
+        phase_stats[curr_phase].bytes += bytes;
+        alloc_stats_add_live(ptr);
+    }
+    return ptr;
+}
+
+void* malloc(size_t size) {
+    void* ptr = alloc_stats_on_alloc(__libc_malloc(size), size);
+    alloc_stats_sample(size);
+    return ptr;
+}
+
+void* calloc(size_t cnt, size_t size) {
+    void* ptr = alloc_stats_on_alloc(__libc_calloc(cnt, size), cnt * size);
+    alloc_stats_sample(cnt * size);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) {
+    if (ptr) {
+        alloc_stats_sub_live(ptr);
+    }
+    void* fresh = __libc_realloc(ptr, size);
+    if (fresh) {
+        ++phase_stats[curr_phase].reallocs;
+        phase_stats[curr_phase].bytes += size;
+        alloc_stats_add_live(fresh);
+    } else if (ptr && size == 0) {
+        ++phase_stats[curr_phase].frees; // glibc frees on realloc(ptr, 0)
+    } else if (ptr) {
+        alloc_stats_add_live(ptr); // failed, ptr is untouched
+    }
+    alloc_stats_sample(size);
+    return fresh;
+}
+
+void free(void* ptr) {
+    if (ptr) {
+        ++phase_stats[curr_phase].frees;
+        alloc_stats_sub_live(ptr);
+    }
+    __libc_free(ptr);
+}
+
+// aligned variants (e.g. aligned operator new), so their frees aren't unmatched
+
+void* memalign(size_t alignment, size_t size) {
+    void* ptr = alloc_stats_on_alloc(__libc_memalign(alignment, size), size);
+    alloc_stats_sample(size);
+    return ptr;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    void* ptr = alloc_stats_on_alloc(__libc_memalign(alignment, size), size);
+    alloc_stats_sample(size);
+    return ptr;
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void* ptr = alloc_stats_on_alloc(__libc_memalign(alignment, size), size);
+    alloc_stats_sample(size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+#endif // BEAR_ALLOC_STATS
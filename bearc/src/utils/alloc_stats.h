@@ -0,0 +1,80 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#ifndef UTILS_ALLOC_STATS_H
+#define UTILS_ALLOC_STATS_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * heap allocation accounting, enabled by configuring w/ -DALLOC_STATS=ON (glibc only)
+ * - malloc/calloc/realloc/free (and the aligned variants) are interposed in the bearc executable
+ * and every call is charged to the phase that's current when it happens
+ * - w/ -DALLOC_STATS_BACKTRACE=ON, every ALLOC_STATS_SAMPLE_PERIOD-th allocation also records its
+ * call stack so the hottest allocation sites can be listed
+ * - when disabled, everything here is a no-op
+ */
+
+/// every nth allocation is sampled when backtraces are enabled
+#define ALLOC_STATS_SAMPLE_PERIOD 64
+/// return addresses kept per sampled call site
+#define ALLOC_STATS_SITE_DEPTH 6
+/// how many sites alloc_stats_print lists
+#define ALLOC_STATS_TOP_SITES 10
+
+typedef enum alloc_phase {
+    ALLOC_PHASE_OTHER = 0,
+    ALLOC_PHASE_LEX,
+    ALLOC_PHASE_PARSE,
+    ALLOC_PHASE_REGISTER,
+    ALLOC_PHASE_RESOLVE,
+    ALLOC_PHASE_COMPT,
+    ALLOC_PHASE__NUM,
+} alloc_phase_e;
+
+typedef struct alloc_phase_stats {
+    size_t mallocs;
+    size_t reallocs;
+    size_t frees;
+    /// requested bytes, summed over mallocs and reallocs
+    size_t bytes;
+} alloc_phase_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef BEAR_ALLOC_STATS
+/// sets the phase new allocations are charged to, returns the previous one
+alloc_phase_e alloc_stats_set_phase(alloc_phase_e phase);
+/// counters for a phase so far
+alloc_phase_stats_t alloc_stats_of_phase(alloc_phase_e phase);
+/// prints per-phase counters, peak live heap, and (if sampled) the top call sites
+void alloc_stats_print(FILE* out);
+#else
+static inline alloc_phase_e alloc_stats_set_phase(alloc_phase_e phase) {
+    (void)phase;
+    return ALLOC_PHASE_OTHER;
+}
+static inline alloc_phase_stats_t alloc_stats_of_phase(alloc_phase_e phase) {
+    (void)phase;
+    alloc_phase_stats_t none = {0, 0, 0, 0};
+    return none;
+}
+static inline void alloc_stats_print(FILE* out) { (void)out; }
+#endif
+
+/// name of a phase for reports
+const char* alloc_phase_name(alloc_phase_e phase);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! UTILS_ALLOC_STATS_H
@@ -101,3 +101,13 @@ void arena_log_debug_info(arena_t* arena) {
     }
     printf("total # of chunks: %zu\n", chunk_num);
 }
+
+arena_stats_t arena_stats(const arena_t* arena) {
+    arena_stats_t stats = {.reserved = 0, .used = 0, .chunk_cnt = 0};
+    for (const arena_chunk_t* curr = arena->head; curr; curr = curr->next) {
+        stats.reserved += sizeof(arena_chunk_t) + curr->cap;
+        stats.used += curr->used;
+        stats.chunk_cnt++;
+    }
+    return stats;
+}
@@ -20,3 +20,5 @@ void DataArena::log_debug_info() { arena_log_debug_info(&this->arena_); }
 arena_t* DataArena::arena() { return &this->arena_; }
 
 size_t DataArena::first_chunk_size() const noexcept { return arena_.head->used; }
+
+arena_stats_t DataArena::stats() const noexcept { return arena_stats(&arena_); }
@@ -40,6 +40,8 @@ class DataArena {
     } /// returns the chunk size (in bytes)
     size_t chunk_cap() const noexcept;
     size_t first_chunk_size() const noexcept;
+    /// reserved/used bytes across all chunks
+    arena_stats_t stats() const noexcept;
     /// for testing purposes
     void log_debug_info();
 };
@@ -0,0 +1,239 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#include "utils/flatmapu32u32.h"
+#include "utils/mapu32u32.h" // for hash_uint32
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// --- private helpers -------------------------------------------------------
+
+static inline uint32_t flatmap_round_up_pow2(uint32_t x) {
+    uint32_t cap = FLATMAPU32U32_MINIMUM_CAPACITY;
+    while (cap < x) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+/// smallest capacity that fits elem_cnt under the load factor
+static inline uint32_t flatmap_capacity_for(uint32_t elem_cnt) {
+    uint64_t needed = (((uint64_t)elem_cnt * FLATMAPU32U32_LOAD_FACTOR_DEN)
+                       + FLATMAPU32U32_LOAD_FACTOR_NUM - 1)
+                      / FLATMAPU32U32_LOAD_FACTOR_NUM;
+    // always leave at least one empty slot so probes terminate
+    return flatmap_round_up_pow2((uint32_t)needed + 1);
+}
+
+static inline uint8_t flatmap_h2(uint32_t hash) { return (uint8_t)(hash >> 25); }
+
+static inline uint32_t flatmap_ctz(uint32_t x) { return (uint32_t)__builtin_ctz(x); }
+
+/// bitmask of the slots in the group starting at ctrl whose ctrl byte equals h2
+static inline uint32_t flatmap_group_match(const uint8_t* ctrl, uint8_t h2) {
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < FLATMAPU32U32_GROUP_WIDTH; i++) {
+        mask |= (uint32_t)(ctrl[i] == h2) << i;
+    }
+    return mask;
+#endif
+}
+
+/// bitmask of the empty slots in the group starting at ctrl (empty is the only ctrl w/ high bit)
+static inline uint32_t flatmap_group_match_empty(const uint8_t* ctrl) {
+#if defined(__SSE2__)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < FLATMAPU32U32_GROUP_WIDTH; i++) {
+        mask |= (uint32_t)(ctrl[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+/// sets a ctrl byte, keeping the mirrored tail in sync for groups that wrap past the end
+static inline void flatmap_set_ctrl(flatmapu32u32_t* map, uint32_t idx, uint8_t val) {
+    map->ctrl[idx] = val;
+    if (idx < FLATMAPU32U32_GROUP_WIDTH) {
+        map->ctrl[map->capacity + idx] = val;
+    }
+}
+
+static void flatmap_alloc_arrays(flatmapu32u32_t* map, uint32_t capacity) {
+    map->capacity = capacity;
+    map->ctrl = (uint8_t*)arena_alloc(map->arena, capacity + FLATMAPU32U32_GROUP_WIDTH);
+    memset(map->ctrl, FLATMAPU32U32_CTRL_EMPTY, capacity + FLATMAPU32U32_GROUP_WIDTH);
+    map->slots = (flatmapu32u32_slot_t*)arena_alloc(map->arena,
+                                                    capacity * sizeof(flatmapu32u32_slot_t));
+}
+
+/// returns the slot idx holding key, or UINT32_MAX if not present
+static uint32_t flatmap_find(const flatmapu32u32_t* map, uint32_t key) {
+    const uint32_t hash = hash_uint32(key);
+    const uint8_t h2 = flatmap_h2(hash);
+    const uint32_t mask = map->capacity - 1;
+    uint32_t pos = hash & mask;
+    for (;;) {
+        const uint8_t* group = map->ctrl + pos;
+        uint32_t matches = flatmap_group_match(group, h2);
+        while (matches) {
+            const uint32_t idx = (pos + flatmap_ctz(matches)) & mask;
+            if (map->slots[idx].key == key) {
+                return idx;
+            }
+            matches &= matches - 1;
+        }
+        // linear probing: the key's run ends at the first empty slot
+        if (flatmap_group_match_empty(group)) {
+            return UINT32_MAX;
+        }
+        pos = (pos + FLATMAPU32U32_GROUP_WIDTH) & mask;
+    }
+}
+
+/// places a key known to be absent into the first empty slot of its probe run
+static void flatmap_insert_unique(flatmapu32u32_t* map, uint32_t key, uint32_t val) {
+    const uint32_t hash = hash_uint32(key);
+    const uint32_t mask = map->capacity - 1;
+    uint32_t pos = hash & mask;
+    uint32_t empties;
+    while (!(empties = flatmap_group_match_empty(map->ctrl + pos))) {
+        pos = (pos + FLATMAPU32U32_GROUP_WIDTH) & mask;
+    }
+    const uint32_t idx = (pos + flatmap_ctz(empties)) & mask;
+    flatmap_set_ctrl(map, idx, flatmap_h2(hash));
+    map->slots[idx].key = key;
+    map->slots[idx].val = val;
+    ++map->size;
+}
+
+// --- public api ------------------------------------------------------------
+
+flatmapu32u32_t flatmapu32u32_create_from_arena(size_t capacity, arena_t* arena) {
+    flatmapu32u32_t map;
+    map.arena = arena;
+    map.size = 0;
+    flatmap_alloc_arrays(&map, flatmap_round_up_pow2((uint32_t)capacity));
+    return map;
+}
+
+void flatmapu32u32_clear(flatmapu32u32_t* map) {
+    memset(map->ctrl, FLATMAPU32U32_CTRL_EMPTY, map->capacity + FLATMAPU32U32_GROUP_WIDTH);
+    map->size = 0;
+}
+
+void flatmapu32u32_insert(flatmapu32u32_t* map, uint32_t key, uint32_t val) {
+    const uint32_t idx = flatmap_find(map, key);
+    if (idx != UINT32_MAX) {
+        map->slots[idx].val = val; // if key already exists, update val
+        return;
+    }
+    if ((uint64_t)(map->size + 1) * FLATMAPU32U32_LOAD_FACTOR_DEN
+        > (uint64_t)map->capacity * FLATMAPU32U32_LOAD_FACTOR_NUM) {
+        flatmapu32u32_rehash(map, 2 * map->capacity);
+    }
+    flatmap_insert_unique(map, key, val);
+}
+
+bool flatmapu32u32_remove(flatmapu32u32_t* map, uint32_t key) {
+    uint32_t hole = flatmap_find(map, key);
+    if (hole == UINT32_MAX) {
+        return false;
+    }
+    const uint32_t mask = map->capacity - 1;
+    // backward shift: pull later members of the run into the hole as long as that doesn't move
+    // them in front of their home slot, so no tombstone is ever needed
+    uint32_t curr = (hole + 1) & mask;
+    while (map->ctrl[curr] != FLATMAPU32U32_CTRL_EMPTY) {
+        const uint32_t home = hash_uint32(map->slots[curr].key) & mask;
+        if (((curr - home) & mask) >= ((curr - hole) & mask)) {
+            map->slots[hole] = map->slots[curr];
+            flatmap_set_ctrl(map, hole, map->ctrl[curr]);
+            hole = curr;
+        }
+        curr = (curr + 1) & mask;
+    }
+    flatmap_set_ctrl(map, hole, FLATMAPU32U32_CTRL_EMPTY);
+    --map->size;
+    return true;
+}
+
+void flatmapu32u32_rehash(flatmapu32u32_t* map, uint32_t new_capacity) {
+    new_capacity = flatmap_round_up_pow2(new_capacity);
+    if (new_capacity < flatmap_capacity_for(map->size) || new_capacity == map->capacity) {
+        return; // guard
+    }
+    const uint8_t* old_ctrl = map->ctrl;
+    const flatmapu32u32_slot_t* old_slots = map->slots;
+    const uint32_t old_capacity = map->capacity;
+
+    flatmap_alloc_arrays(map, new_capacity);
+    map->size = 0;
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old_ctrl[i] != FLATMAPU32U32_CTRL_EMPTY) {
+            flatmap_insert_unique(map, old_slots[i].key, old_slots[i].val);
+        }
+    }
+}
+
+void flatmapu32u32_reserve(flatmapu32u32_t* map, uint32_t elem_cnt) {
+    const uint32_t needed = flatmap_capacity_for(elem_cnt);
+    if (needed > map->capacity) {
+        flatmapu32u32_rehash(map, needed);
+    }
+}
+
+uint32_t* flatmapu32u32_at(flatmapu32u32_t* map, uint32_t key) {
+    const uint32_t idx = flatmap_find(map, key);
+    return (idx == UINT32_MAX) ? NULL : &map->slots[idx].val;
+}
+
+const uint32_t* flatmapu32u32_cat(const flatmapu32u32_t* map, uint32_t key) {
+    const uint32_t idx = flatmap_find(map, key);
+    return (idx == UINT32_MAX) ? NULL : &map->slots[idx].val;
+}
+
+bool flatmapu32u32_contains(const flatmapu32u32_t* map, uint32_t key) {
+    return flatmap_find(map, key) != UINT32_MAX;
+}
+
+flatmapu32u32_iter_t flatmapu32u32_iter_begin(const flatmapu32u32_t* map) {
+    flatmapu32u32_iter_t iter = {.map = map, .idx = 0, .curr = NULL};
+    while (iter.idx < map->capacity && map->ctrl[iter.idx] == FLATMAPU32U32_CTRL_EMPTY) {
+        ++iter.idx;
+    }
+    if (iter.idx < map->capacity) {
+        iter.curr = &map->slots[iter.idx];
+    }
+    return iter;
+}
+
+const flatmapu32u32_slot_t* flatmapu32u32_iter_next(flatmapu32u32_iter_t* iter) {
+    if (!iter->curr) {
+        return iter->curr; // end
+    }
+    ++iter->idx;
+    while (iter->idx < iter->map->capacity
+           && iter->map->ctrl[iter->idx] == FLATMAPU32U32_CTRL_EMPTY) {
+        ++iter->idx;
+    }
+    iter->curr = (iter->idx < iter->map->capacity) ? &iter->map->slots[iter->idx] : NULL;
+    return iter->curr;
+}
+
+bool flatmapu32u32_iter_end(flatmapu32u32_iter_t* iter) { return iter->curr == NULL; }
@@ -0,0 +1,106 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#ifndef UTILS_FLATMAPU32U32_H
+#define UTILS_FLATMAPU32U32_H
+
+#include "utils/arena.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// number of ctrl bytes probed at once (one SSE2 register)
+#define FLATMAPU32U32_GROUP_WIDTH 16
+/// must be >= FLATMAPU32U32_GROUP_WIDTH so the mirrored ctrl tail never wraps twice
+#define FLATMAPU32U32_MINIMUM_CAPACITY 16
+/// max load is NUM/DEN, kept low enough for linear probing runs to stay short
+#define FLATMAPU32U32_LOAD_FACTOR_NUM 3
+#define FLATMAPU32U32_LOAD_FACTOR_DEN 4
+
+/// ctrl byte for an empty slot, full slots store the top 7 bits of the hash (high bit clear)
+#define FLATMAPU32U32_CTRL_EMPTY ((uint8_t)0x80)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// a slot in the flat uint32_t to uint32_t map, stored inline
+typedef struct {
+    uint32_t key;
+    uint32_t val;
+} flatmapu32u32_slot_t;
+
+/**
+ * flatmapu32u32_t, as in flat uint32_t -> uint32_t map
+ * - open addressing w/ linear probing, keys and values are stored inline in one slot array
+ * - a parallel ctrl byte array holds a 7-bit hash fragment per slot so a whole group of 16 slots
+ * can be filtered w/ one SIMD compare (scalar fallback when SSE2 is unavailable)
+ * - deletion uses backward shifting, so there are no tombstones and probe runs never degrade
+ * - arrays live in a non-owned arena, so growth leaves the old arrays behind in the arena (just
+ * like the chained mapu32u32_t does with its buckets)
+ */
+typedef struct {
+    /// capacity + FLATMAPU32U32_GROUP_WIDTH bytes, the tail mirrors the first group
+    uint8_t* ctrl;
+    flatmapu32u32_slot_t* slots;
+    /// always a power of two
+    uint32_t capacity;
+    uint32_t size;
+    arena_t* arena;
+} flatmapu32u32_t;
+
+/// create a flatmapu32u32 w/ at least `capacity` slots from an arena
+flatmapu32u32_t flatmapu32u32_create_from_arena(size_t capacity, arena_t* arena);
+
+/// drop every elem but keep the current arrays, so refilling it up to capacity allocates nothing
+void flatmapu32u32_clear(flatmapu32u32_t* map);
+
+/// insert an elem {key, value} destructively/will override anything at the location
+void flatmapu32u32_insert(flatmapu32u32_t* map, uint32_t key, uint32_t val);
+
+/// remove an elem at the provided key, returns false if it was not found
+bool flatmapu32u32_remove(flatmapu32u32_t* map, uint32_t key);
+
+/// rehash the map with a different capacity (rounded up to a power of two), does nothing if the
+/// capacity would not fit the current elems
+void flatmapu32u32_rehash(flatmapu32u32_t* map, uint32_t new_capacity);
+
+/// presize so that `elem_cnt` elems in total fit without another rehash
+void flatmapu32u32_reserve(flatmapu32u32_t* map, uint32_t elem_cnt);
+
+/// returns a mut ptr to the value at a provided key, invalidated by insert/remove/rehash
+uint32_t* flatmapu32u32_at(flatmapu32u32_t* map, uint32_t key);
+
+/// returns a view/const ptr to the value at a provided key
+const uint32_t* flatmapu32u32_cat(const flatmapu32u32_t* map, uint32_t key);
+
+/// - returns true if the map contains the key, else returns false
+bool flatmapu32u32_contains(const flatmapu32u32_t* map, uint32_t key);
+
+/**
+ * iterator for flatmapu32u32_t
+ * access current element as `curr`
+ * - removing while iterating may shift a not-yet-visited slot behind the iter, so don't
+ */
+typedef struct {
+    const flatmapu32u32_t* map;
+    uint32_t idx;
+    const flatmapu32u32_slot_t* curr;
+} flatmapu32u32_iter_t;
+/// returns an iter set at the start of the map
+flatmapu32u32_iter_t flatmapu32u32_iter_begin(const flatmapu32u32_t* map);
+/// increment a flatmapu32u32_iter_t
+const flatmapu32u32_slot_t* flatmapu32u32_iter_next(flatmapu32u32_iter_t* iter);
+/// indicates that the iter at the end
+bool flatmapu32u32_iter_end(flatmapu32u32_iter_t* iter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! UTILS_FLATMAPU32U32_H
@@ -0,0 +1,236 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#include "utils/strintern.h"
+#include "utils/arena.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// --- hashing (wyhash final4 construction) ----------------------------------
+
+static const uint64_t wy_secret[4] = {0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+                                      0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL};
+
+// 64x64 -> 128 multiply, low half into *a and high half into *b
+static inline void wy_mum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    const uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    const uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t wy_mix(uint64_t a, uint64_t b) {
+    wy_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t wy_r8(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t wy_r4(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint64_t wy_r3(const uint8_t* p, size_t k) {
+    return (((uint64_t)p[0]) << 16) | (((uint64_t)p[k >> 1]) << 8) | p[k - 1];
+}
+
+uint64_t hash_bytes(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t seed = wy_mix(wy_secret[0], wy_secret[1]);
+    uint64_t a;
+    uint64_t b;
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (wy_r4(p) << 32) | wy_r4(p + ((len >> 3) << 2));
+            b = (wy_r4(p + len - 4) << 32) | wy_r4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = wy_r3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do {
+                seed = wy_mix(wy_r8(p) ^ wy_secret[1], wy_r8(p + 8) ^ seed);
+                see1 = wy_mix(wy_r8(p + 16) ^ wy_secret[2], wy_r8(p + 24) ^ see1);
+                see2 = wy_mix(wy_r8(p + 32) ^ wy_secret[3], wy_r8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = wy_mix(wy_r8(p) ^ wy_secret[1], wy_r8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wy_r8(p + i - 16);
+        b = wy_r8(p + i - 8);
+    }
+    a ^= wy_secret[1];
+    b ^= seed;
+    wy_mum(&a, &b);
+    return wy_mix(a ^ wy_secret[0] ^ len, b ^ wy_secret[1]);
+}
+
+// --- private helpers -------------------------------------------------------
+
+static inline uint32_t strintern_round_up_pow2(size_t x) {
+    uint32_t cap = STRINTERN_MINIMUM_CAPACITY;
+    while (cap < x) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+static inline bool strintern_over_load(uint32_t size, uint32_t capacity) {
+    return (uint64_t)size * STRINTERN_LOAD_FACTOR_DEN
+           > (uint64_t)capacity * STRINTERN_LOAD_FACTOR_NUM;
+}
+
+static void strintern_alloc_slots(strintern_t* map, uint32_t capacity) {
+    map->capacity = capacity;
+    map->slots
+        = (strintern_slot_t*)arena_alloc(map->table_arena, capacity * sizeof(strintern_slot_t));
+    memset(map->slots, 0, capacity * sizeof(strintern_slot_t));
+}
+
+/// returns the idx of key's slot, or of the empty slot ending its probe run if absent
+static uint32_t strintern_probe(const strintern_t* map, const char* key, uint32_t len,
+                                uint64_t hash) {
+    const uint32_t mask = map->capacity - 1;
+    uint32_t idx = (uint32_t)hash & mask;
+    for (;;) {
+        const strintern_slot_t* slot = &map->slots[idx];
+        if (!slot->str) {
+            return idx;
+        }
+        // cheap rejections first, only then touch the bytes
+        if (slot->hash == hash && slot->len == len && memcmp(slot->str, key, len) == 0) {
+            return idx;
+        }
+        idx = (idx + 1) & mask;
+    }
+}
+
+// --- public api ------------------------------------------------------------
+
+strintern_t strintern_create_from_arenas(size_t capacity, arena_t* table_arena,
+                                         arena_t* str_arena) {
+    strintern_t map;
+    map.size = 0;
+    map.table_arena = table_arena;
+    map.str_arena = str_arena;
+    strintern_alloc_slots(&map, strintern_round_up_pow2(capacity));
+    return map;
+}
+
+strintern_slot_t* strintern_intern(strintern_t* map, const char* key, size_t len, int32_t val,
+                                   bool* inserted) {
+    const uint64_t hash = hash_bytes(key, len);
+    uint32_t idx = strintern_probe(map, key, (uint32_t)len, hash);
+    if (map->slots[idx].str) {
+        *inserted = false;
+        return &map->slots[idx];
+    }
+    if (strintern_over_load(map->size + 1, map->capacity)) {
+        strintern_rehash(map, 2 * (size_t)map->capacity);
+        idx = strintern_probe(map, key, (uint32_t)len, hash);
+    }
+    char* fresh_key = arena_alloc(map->str_arena, len + 1); // +1 for null-term
+    memcpy(fresh_key, key, len);
+    fresh_key[len] = '\0';
+
+    strintern_slot_t* slot = &map->slots[idx];
+    slot->hash = hash;
+    slot->str = fresh_key;
+    slot->len = (uint32_t)len;
+    slot->val = val;
+    ++map->size;
+    *inserted = true;
+    return slot;
+}
+
+void strintern_emplace(strintern_t* map, const char* key, size_t len, int32_t val) {
+    bool inserted;
+    strintern_intern(map, key, len, val, &inserted)->val = val; // override if already present
+}
+
+int32_t* strintern_atn(strintern_t* map, const char* key, size_t len) {
+    const uint32_t idx = strintern_probe(map, key, (uint32_t)len, hash_bytes(key, len));
+    return map->slots[idx].str ? &map->slots[idx].val : NULL;
+}
+
+const int32_t* strintern_viewn(const strintern_t* map, const char* key, size_t len) {
+    const uint32_t idx = strintern_probe(map, key, (uint32_t)len, hash_bytes(key, len));
+    return map->slots[idx].str ? &map->slots[idx].val : NULL;
+}
+
+bool strintern_remove(strintern_t* map, const char* key, size_t len) {
+    uint32_t hole = strintern_probe(map, key, (uint32_t)len, hash_bytes(key, len));
+    if (!map->slots[hole].str) {
+        return false;
+    }
+    const uint32_t mask = map->capacity - 1;
+    // backward shift, see flatmapu32u32_remove
+    uint32_t curr = (hole + 1) & mask;
+    while (map->slots[curr].str) {
+        const uint32_t home = (uint32_t)map->slots[curr].hash & mask;
+        if (((curr - home) & mask) >= ((curr - hole) & mask)) {
+            map->slots[hole] = map->slots[curr];
+            hole = curr;
+        }
+        curr = (curr + 1) & mask;
+    }
+    memset(&map->slots[hole], 0, sizeof(strintern_slot_t));
+    --map->size;
+    return true;
+}
+
+void strintern_rehash(strintern_t* map, size_t new_capacity) {
+    const uint32_t capacity = strintern_round_up_pow2(new_capacity);
+    if (capacity == map->capacity || strintern_over_load(map->size + 1, capacity)) {
+        return; // guard
+    }
+    const strintern_slot_t* old_slots = map->slots;
+    const uint32_t old_capacity = map->capacity;
+    strintern_alloc_slots(map, capacity);
+    const uint32_t mask = capacity - 1;
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (!old_slots[i].str) {
+            continue;
+        }
+        // stored hash, so the string bytes are never read here
+        uint32_t idx = (uint32_t)old_slots[i].hash & mask;
+        while (map->slots[idx].str) {
+            idx = (idx + 1) & mask;
+        }
+        map->slots[idx] = old_slots[i];
+    }
+}
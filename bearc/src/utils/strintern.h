@@ -0,0 +1,91 @@
+//     /                              /
+//    /                              /
+//   /_____  _____  _____  _____    /  _____   _  _  _____
+//  /     / /____  /____/ /____/   /  /____/  /\  / /  __
+// /_____/ /____  /    / /   \    /  /    /  /  \/ /____/
+// Copyright (C) 2025-2026 Zachary Mahan
+// Licensed under the GNU GPL v3. See LICENSE for details.
+
+#ifndef UTILS_STRINTERN_H
+#define UTILS_STRINTERN_H
+
+#include "utils/arena.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define STRINTERN_MINIMUM_CAPACITY 16
+/// max load is NUM/DEN
+#define STRINTERN_LOAD_FACTOR_NUM 3
+#define STRINTERN_LOAD_FACTOR_DEN 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// a slot in the interner, `str == NULL` marks an empty slot
+typedef struct {
+    /// full 64-bit hash, checked before len and bytes and reused on rehash
+    uint64_t hash;
+    /// null-terminated copy living in the string arena
+    const char* str;
+    uint32_t len;
+    int32_t val;
+} strintern_slot_t;
+
+/**
+ * strintern_t, a string interner mapping strings -> int32_t
+ * - open addressing w/ linear probing and backward shift deletion (no tombstones)
+ * - each slot stores the 64-bit hash of its string, so probes compare hash and length before ever
+ * touching string bytes, and rehashing never re-reads string data
+ * - interned strings are copied back to back into `str_arena`, while the slot array lives in
+ * `table_arena`, so growth doesn't fragment the strings; neither arena is owned
+ */
+typedef struct {
+    strintern_slot_t* slots;
+    /// always a power of two
+    uint32_t capacity;
+    uint32_t size;
+    arena_t* table_arena;
+    arena_t* str_arena;
+} strintern_t;
+
+/// create a strintern w/ at least `capacity` slots
+strintern_t strintern_create_from_arenas(size_t capacity, arena_t* table_arena,
+                                         arena_t* str_arena);
+
+/**
+ * look up key, interning a copy of it w/ `val` if it's not present yet
+ * - `*inserted` is set to whether this call interned the key
+ * - the returned slot is valid until the next insertion/removal, so a caller may set its val right
+ * after interning (e.g. once an id for the interned str is known)
+ */
+strintern_slot_t* strintern_intern(strintern_t* map, const char* key, size_t len, int32_t val,
+                                   bool* inserted);
+
+/// insert an elem {key, value} destructively/will override anything at the location
+void strintern_emplace(strintern_t* map, const char* key, size_t len, int32_t val);
+
+/// returns a mut ptr to the value at a provided key of some length (does not have to be
+/// null-terminated), or NULL
+int32_t* strintern_atn(strintern_t* map, const char* key, size_t len);
+
+/// returns a view/const ptr to the value at a provided key of some length, or NULL
+const int32_t* strintern_viewn(const strintern_t* map, const char* key, size_t len);
+
+/// remove an elem at the provided key, returns false if it was not found (the string bytes stay in
+/// the string arena)
+bool strintern_remove(strintern_t* map, const char* key, size_t len);
+
+/// rehash w/ a different capacity (rounded up to a power of two), does nothing if the capacity
+/// would not fit the current elems
+void strintern_rehash(strintern_t* map, size_t new_capacity);
+
+/// 64-bit wyhash-style hash of some bytes
+uint64_t hash_bytes(const void* data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! UTILS_STRINTERN_H
@@ -0,0 +1,10 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# usage: ./bench.sh [--csv] [--reps N] [--min-ops N] [corpus dirs or .br files...]
+# always a Release build, since Debug numbers are meaningless
+
+rm -rf build
+cmake -S . -B build -DCMAKE_BUILD_TYPE=Release -DBENCH=ON
+cmake --build build -j"$(nproc)" --target bench
+./build/bearc/bench "$@"